@@ -9,11 +9,31 @@ OBJS= \
 	${objsdir}/KompexSQLiteBlob.o \
 	${objsdir}/KompexSQLiteStatement.o \
 	${objsdir}/KompexSQLiteDatabase.o \
+	${objsdir}/KompexSQLiteStatementCache.o \
+	${objsdir}/KompexSQLiteColumnLookup.o \
+	${objsdir}/KompexSQLiteBulkInserter.o \
+	${objsdir}/KompexSQLiteTransactionBatch.o \
+	${objsdir}/KompexSQLiteConnectionPool.o \
+	${objsdir}/KompexSQLiteWalCheckpointer.o \
+	${objsdir}/KompexSQLiteLatencyHistogram.o \
+	${objsdir}/KompexSQLiteProfiler.o \
+	${objsdir}/KompexSQLiteStatementStatistics.o \
+	${objsdir}/KompexSQLiteDatabaseStatistics.o \
+	${objsdir}/KompexSQLiteSavepoint.o \
+	${objsdir}/KompexSQLiteGroupCommitWriter.o \
+	${objsdir}/KompexSQLiteAsyncExecutor.o \
+	${objsdir}/KompexSQLiteAllocator.o \
+	${objsdir}/KompexSQLitePageCache.o \
+	${objsdir}/KompexSQLiteCountingVfs.o \
+	${objsdir}/KompexSQLiteSortKey.o \
 	${objsdir}/sqlite3.o
 
 # C Compiler Flags
 CFLAGS= -fPIC -MMD -MP
 
+# C++ Compiler Flags
+CXXFLAGS= -std=c++11
+
 # CC Compiler Flags
 CPPFLAGS= -DKOMPEX_SQLITEWRAPPER_EXPORT -DKOMPEX_SQLITEWRAPPER_DYN -fPIC -MMD -MP -I${includedir}
 
@@ -40,6 +60,57 @@ ${objsdir}/KompexSQLiteStatement.o: ${srcdir}/KompexSQLiteStatement.cpp
 ${objsdir}/KompexSQLiteDatabase.o: ${srcdir}/KompexSQLiteDatabase.cpp 
 	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
 
+${objsdir}/KompexSQLiteStatementCache.o: ${srcdir}/KompexSQLiteStatementCache.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteColumnLookup.o: ${srcdir}/KompexSQLiteColumnLookup.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteBulkInserter.o: ${srcdir}/KompexSQLiteBulkInserter.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteTransactionBatch.o: ${srcdir}/KompexSQLiteTransactionBatch.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteConnectionPool.o: ${srcdir}/KompexSQLiteConnectionPool.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteWalCheckpointer.o: ${srcdir}/KompexSQLiteWalCheckpointer.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteLatencyHistogram.o: ${srcdir}/KompexSQLiteLatencyHistogram.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteProfiler.o: ${srcdir}/KompexSQLiteProfiler.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteStatementStatistics.o: ${srcdir}/KompexSQLiteStatementStatistics.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteDatabaseStatistics.o: ${srcdir}/KompexSQLiteDatabaseStatistics.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteSavepoint.o: ${srcdir}/KompexSQLiteSavepoint.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteGroupCommitWriter.o: ${srcdir}/KompexSQLiteGroupCommitWriter.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteAsyncExecutor.o: ${srcdir}/KompexSQLiteAsyncExecutor.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteAllocator.o: ${srcdir}/KompexSQLiteAllocator.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLitePageCache.o: ${srcdir}/KompexSQLitePageCache.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteCountingVfs.o: ${srcdir}/KompexSQLiteCountingVfs.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
+${objsdir}/KompexSQLiteSortKey.o: ${srcdir}/KompexSQLiteSortKey.cpp 
+	$(COMPILE.cc) ${CXXFLAGS} -MF $@.d -o $@ $^
+
 ${objsdir}/sqlite3.o: ${srcdir}/sqlite3.c 
 	$(COMPILE.c) ${CFLAGS} -MF $@.d -o $@ $^
 
@@ -0,0 +1,68 @@
+# Include project Makefile
+include Makefile
+
+# Source Directories
+testsrcdir=${top_srcdir}/test
+benchsrcdir=${top_srcdir}/bench
+
+# Output Directories
+testbindir=${builddir}/test
+benchbindir=${builddir}/bench
+
+# Test Programs
+TESTS= \
+	${testbindir}/KompexSQLiteStatementCacheTest \
+	${testbindir}/KompexSQLiteColumnLookupTest \
+	${testbindir}/KompexSQLiteRowCursorTest \
+	${testbindir}/KompexSQLiteValueTest \
+	${testbindir}/KompexSQLiteTransactionBatchTest \
+	${testbindir}/KompexSQLiteWalCheckpointerTest \
+	${testbindir}/KompexSQLiteSaveToFileTest \
+	${testbindir}/KompexSQLiteDatabaseStatisticsTest \
+	${testbindir}/KompexSQLiteProfilerTest \
+	${testbindir}/KompexSQLiteGroupCommitWriterTest \
+	${testbindir}/KompexSQLiteFunctionTest \
+	${testbindir}/KompexSQLiteSortKeyTest \
+	${testbindir}/KompexSQLiteBulkInserterTest \
+	${testbindir}/KompexSQLiteConnectionPoolTest \
+	${testbindir}/KompexSQLitePageCacheTest \
+	${testbindir}/KompexSQLiteAsyncExecutorTest \
+	${testbindir}/KompexSQLiteStatementStatisticsTest \
+	${testbindir}/KompexSQLiteCountingVfsTest \
+	${testbindir}/KompexSQLiteAllocatorTest
+
+# Benchmark Programs
+BENCHMARKS= \
+	${benchbindir}/KompexSQLiteColumnAccessBenchmark \
+	${benchbindir}/KompexSQLiteTextScanBenchmark \
+	${benchbindir}/KompexSQLiteDuplicateKeyBenchmark \
+	${benchbindir}/KompexSQLiteAllocatorBenchmark \
+	${benchbindir}/KompexSQLiteAggregateBenchmark \
+	${benchbindir}/KompexSQLiteSortKeyBenchmark
+
+# C++ Compiler Flags
+CXXFLAGS= -std=c++11 -O2
+
+# CC Compiler Flags
+CPPFLAGS= -I${includedir} -I${testsrcdir} -I${benchsrcdir}
+
+# Link Libraries and Options
+LDLIBSOPTIONS= ${prelibdir}/lib${PRODUCT_NAME}.a -lpthread -ldl
+
+# Build Targets
+.build-tests: .pre-build ${TESTS}
+
+.run-tests: .build-tests
+	@for test in ${TESTS}; do $$test || exit 1; done
+
+.build-benchmarks: .pre-build ${BENCHMARKS}
+
+.pre-build:
+	$(MKDIR) -p ${testbindir}
+	$(MKDIR) -p ${benchbindir}
+
+${testbindir}/%: ${testsrcdir}/%.cpp ${prelibdir}/lib${PRODUCT_NAME}.a
+	$(LINK.cc) -o $@ $< ${LDLIBSOPTIONS}
+
+${benchbindir}/%: ${benchsrcdir}/%.cpp ${prelibdir}/lib${PRODUCT_NAME}.a
+	$(LINK.cc) -o $@ $< ${LDLIBSOPTIONS}
@@ -0,0 +1,128 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Variance per group: a C++ aggregate inside SQLite (CreateAggregateFunction()) against streaming
+// all rows out with FetchRow() and aggregating them in the client. The built-in avg() shows the
+// cost of the GROUP BY itself. Usage: KompexSQLiteAggregateBenchmark [rows] [groups]
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <unordered_map>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteBenchmarkHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	//! Variance with Welford's algorithm
+	struct Variance
+	{
+		Variance(): count(0), mean(0.0), squares(0.0) {}
+
+		void Step(double value)
+		{
+			++count;
+			double delta = value - mean;
+			mean += delta / count;
+			squares += delta * (value - mean);
+		}
+
+		double Final() const {return count > 1 ? squares / (count - 1) : 0.0;}
+
+		int64 count;
+		double mean;
+		double squares;
+	};
+
+	//! Runs the function once and prints the time per row.
+	template<class F>
+	void MeasureQuery(const char *name, unsigned long rowCount, F function)
+	{
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		function();
+		Benchmark::Report(name, rowCount, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long rowCount = argc > 1 ? std::strtoul(argv[1], 0, 10) : 5000000;
+	unsigned long groupCount = argc > 2 ? std::strtoul(argv[2], 0, 10) : 1000;
+
+	SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+	db.CreateAggregateFunction("variance", Variance(), true);
+
+	SQLiteStatement statement(&db);
+	statement.SqlStatement("CREATE TABLE benchmark(grp INTEGER, value REAL)");
+	std::ostringstream insert;
+	insert << "WITH RECURSIVE sequence(x) AS (SELECT 0 UNION ALL SELECT x + 1 FROM sequence WHERE x + 1 < " << rowCount << ") "
+		<< "INSERT INTO benchmark SELECT x % " << groupCount << ", (x * 7919 % 10007) / 10.0 FROM sequence";
+	statement.SqlStatement(insert.str());
+
+	std::cout << rowCount << " rows in " << groupCount << " groups" << std::endl;
+
+	// without an index GROUP BY sorts all rows; with a covering index the groups are read in order
+	for(int round = 0; round < 2; ++round)
+	{
+		if(round == 1)
+		{
+			statement.SqlStatement("CREATE INDEX benchmark_grp ON benchmark(grp, value)");
+			std::cout << "with covering index on (grp, value)" << std::endl;
+		}
+
+		MeasureQuery("built-in avg()", rowCount, [&]()
+		{
+			double sum = 0.0;
+			statement.Sql("SELECT grp, avg(value) FROM benchmark GROUP BY grp");
+			while(statement.FetchRow())
+				sum += statement.GetColumnDouble(1);
+			statement.FreeQuery();
+			Benchmark::DoNotOptimize(sum);
+		});
+
+		MeasureQuery("C++ aggregate in SQLite", rowCount, [&]()
+		{
+			double sum = 0.0;
+			statement.Sql("SELECT grp, variance(value) FROM benchmark GROUP BY grp");
+			while(statement.FetchRow())
+				sum += statement.GetColumnDouble(1);
+			statement.FreeQuery();
+			Benchmark::DoNotOptimize(sum);
+		});
+
+		MeasureQuery("client-side aggregation (FetchRow())", rowCount, [&]()
+		{
+			std::unordered_map<int64, Variance> groups;
+			statement.Sql("SELECT grp, value FROM benchmark");
+			while(statement.FetchRow())
+				groups[statement.GetColumnInt64(0)].Step(statement.GetColumnDouble(1));
+			statement.FreeQuery();
+
+			double sum = 0.0;
+			for(std::unordered_map<int64, Variance>::const_iterator iter = groups.begin(); iter != groups.end(); ++iter)
+				sum += iter->second.Final();
+			Benchmark::DoNotOptimize(sum);
+		});
+	}
+
+	return 0;
+}
@@ -0,0 +1,100 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Statement and row buffer churn of SQLite with the system allocator, the size-class pool
+// and the thread-caching pool. Every thread uses its own in-memory database and prepares,
+// executes and finalizes an INSERT and a SELECT per operation, so that most allocations
+// are short-lived; ns/op is the wall time divided by the operations of one thread.
+// Usage: KompexSQLiteAllocatorBenchmark [operations per thread] [threads]
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "KompexSQLiteAllocator.h"
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteBenchmarkHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	void RunOperations(unsigned long operationCount)
+	{
+		SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		SQLiteStatement statement(&db);
+		statement.SqlStatement("CREATE TABLE benchmark(id INTEGER PRIMARY KEY, name TEXT)");
+
+		std::string name;
+		int64 sum = 0;
+		for(unsigned long i = 0; i < operationCount; ++i)
+		{
+			// text of 1 to 200 bytes
+			name.assign(1 + i % 200, 'x');
+			statement.Sql("INSERT INTO benchmark(name) VALUES(?)");
+			statement.BindString(1, name);
+			statement.ExecuteAndFree();
+
+			statement.Sql("SELECT length(name) FROM benchmark WHERE id = ?");
+			statement.BindInt64(1, db.GetLastInsertRowId());
+			if(statement.FetchRow())
+				sum += statement.GetColumnInt64(0);
+			statement.FreeQuery();
+		}
+		Benchmark::DoNotOptimize(sum);
+	}
+
+	void MeasureAllocator(SQLiteAllocator::AllocatorType type, const char *name, unsigned long operationCount, unsigned int threadCount)
+	{
+		// the allocator can only be replaced while SQLite isn't initialized
+		sqlite3_shutdown();
+		SQLiteAllocator::Install(type);
+
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for(unsigned int i = 0; i < threadCount; ++i)
+			threads.push_back(std::thread(RunOperations, operationCount));
+		for(std::vector<std::thread>::iterator iter = threads.begin(); iter != threads.end(); ++iter)
+			iter->join();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		Benchmark::Report(name, operationCount, seconds);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long operationCount = argc > 1 ? std::strtoul(argv[1], 0, 10) : 100000;
+	unsigned int threadCount = argc > 2 ? static_cast<unsigned int>(std::strtoul(argv[2], 0, 10)) : 4;
+
+	// SQLite serializes all allocations with a mutex while the memory statistics are enabled
+	sqlite3_config(SQLITE_CONFIG_MEMSTATUS, 0);
+
+	std::cout << operationCount << " operations per thread" << std::endl;
+	for(unsigned int threads = 1; threads <= threadCount; threads *= 2)
+	{
+		std::cout << threads << " thread(s)" << std::endl;
+		MeasureAllocator(SQLiteAllocator::ALLOCATOR_SYSTEM, "system allocator", operationCount, threads);
+		MeasureAllocator(SQLiteAllocator::ALLOCATOR_POOL, "size-class pool", operationCount, threads);
+		MeasureAllocator(SQLiteAllocator::ALLOCATOR_THREAD_CACHING, "thread-caching pool", operationCount, threads);
+	}
+
+	return 0;
+}
@@ -0,0 +1,70 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteBenchmarkHelper_H
+#define KompexSQLiteBenchmarkHelper_H
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+namespace Kompex
+{
+	//! Minimal helpers for the benchmark programs in bench/.\n
+	//! The benchmarks are not run by "make test"; build them with "make bench" and run them on an idle machine.
+	namespace Benchmark
+	{
+		//! Prints the time per operation and the total time.
+		inline void Report(const char *name, unsigned long operations, double seconds)
+		{
+			std::cout << std::left << std::setw(48) << name << std::right << std::setw(12) << std::fixed << std::setprecision(1)
+				<< (operations > 0 ? seconds * 1e9 / operations : 0.0) << " ns/op" << std::setw(12) << std::setprecision(3)
+				<< seconds << " s" << std::endl;
+		}
+
+		//! Runs a function the given number of times and prints the time per call.\n
+		//! Returns the total time in seconds.
+		template<class F>
+		double Measure(const char *name, unsigned long iterations, F function)
+		{
+			std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+			for(unsigned long i = 0; i < iterations; ++i)
+				function(i);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			Report(name, iterations, seconds);
+			return seconds;
+		}
+
+		//! Returns the sink of DoNotOptimize().
+		inline const void *volatile &GetSink()
+		{
+			static const void *volatile sink = 0;
+			return sink;
+		}
+
+		//! Prevents that the compiler optimizes a computed value away.
+		template<class T>
+		void DoNotOptimize(const T &value)
+		{
+			GetSink() = &value;
+		}
+	}
+};
+
+#endif // KompexSQLiteBenchmarkHelper_H
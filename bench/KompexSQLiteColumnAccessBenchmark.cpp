@@ -0,0 +1,131 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Column access on a 20-column result: by column number, by column name and by
+// column numbers which were resolved once with GetColumnNumber().
+
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteBenchmarkHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	const int columnCount = 20;
+
+	std::string GetColumnName(int column)
+	{
+		std::ostringstream name;
+		name << "column_" << column;
+		return name.str();
+	}
+
+	//! Runs the query once for every iteration and reads all columns of all rows with the given function.
+	template<class F>
+	void MeasureScan(SQLiteDatabase &db, const char *name, unsigned long rowCount, F readRow)
+	{
+		SQLiteStatement statement(&db);
+		statement.SqlCached("SELECT * FROM benchmark");
+		Benchmark::Measure(name, rowCount, [&](unsigned long)
+		{
+			if(!statement.FetchRow())
+			{
+				statement.Reset();
+				statement.FetchRow();
+			}
+			readRow(statement);
+		});
+		statement.FreeQuery();
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long rowCount = argc > 1 ? std::strtoul(argv[1], 0, 10) : 1000000;
+
+	SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+	SQLiteStatement statement(&db);
+
+	std::ostringstream createTable, insert;
+	createTable << "CREATE TABLE benchmark(";
+	insert << "INSERT INTO benchmark VALUES(";
+	for(int i = 0; i < columnCount; ++i)
+	{
+		createTable << (i > 0 ? ", " : "") << GetColumnName(i) << " INTEGER";
+		insert << (i > 0 ? ", " : "") << "?";
+	}
+	createTable << ")";
+	insert << ")";
+
+	statement.SqlStatement(createTable.str());
+	statement.BeginTransaction();
+	statement.Sql(insert.str());
+	for(int row = 0; row < 10000; ++row)
+	{
+		for(int i = 0; i < columnCount; ++i)
+			statement.BindInt(i + 1, row + i);
+		statement.Execute();
+		statement.Reset();
+	}
+	statement.FreeQuery();
+	statement.CommitTransaction();
+
+	std::vector<std::string> names;
+	for(int i = 0; i < columnCount; ++i)
+		names.push_back(GetColumnName(i));
+
+	std::cout << rowCount << " rows with " << columnCount << " columns" << std::endl;
+
+	MeasureScan(db, "column number", rowCount, [&](const SQLiteStatement &stmt)
+	{
+		int sum = 0;
+		for(int i = 0; i < columnCount; ++i)
+			sum += stmt.GetColumnInt(i);
+		Benchmark::DoNotOptimize(sum);
+	});
+
+	MeasureScan(db, "column name", rowCount, [&](const SQLiteStatement &stmt)
+	{
+		int sum = 0;
+		for(int i = 0; i < columnCount; ++i)
+			sum += stmt.GetColumnInt(names[i]);
+		Benchmark::DoNotOptimize(sum);
+	});
+
+	std::vector<int> columns;
+	MeasureScan(db, "column number resolved by GetColumnNumber()", rowCount, [&](const SQLiteStatement &stmt)
+	{
+		if(columns.empty())
+		{
+			for(int i = 0; i < columnCount; ++i)
+				columns.push_back(stmt.GetColumnNumber(names[i]));
+		}
+
+		int sum = 0;
+		for(int i = 0; i < columnCount; ++i)
+			sum += stmt.GetColumnInt(columns[i]);
+		Benchmark::DoNotOptimize(sum);
+	});
+
+	return 0;
+}
@@ -0,0 +1,102 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Duplicate-key inserts on a PRIMARY KEY: the throwing API (Execute() and Reset() throw a
+// SQLiteException on the constraint violation) against the status API (TryExecute(), TryReset()).
+// A run with unique keys shows the cost of the insert itself.
+
+#include <cstdlib>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteException.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteBenchmarkHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	const int existingKeys = 1000;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long insertCount = argc > 1 ? std::strtoul(argv[1], 0, 10) : 200000;
+
+	SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+	SQLiteStatement statement(&db);
+	statement.SqlStatement("CREATE TABLE benchmark(id INTEGER PRIMARY KEY, name TEXT)");
+	statement.BeginTransaction();
+	statement.Sql("INSERT INTO benchmark VALUES(?, 'existing')");
+	for(int key = 0; key < existingKeys; ++key)
+	{
+		statement.BindInt(1, key);
+		statement.Execute();
+		statement.Reset();
+	}
+	statement.FreeQuery();
+	statement.CommitTransaction();
+
+	std::cout << insertCount << " inserts" << std::endl;
+
+	SQLiteStatement insert(&db);
+	insert.Sql("INSERT INTO benchmark VALUES(?, 'new')");
+
+	int failures = 0;
+	Benchmark::Measure("duplicate key, exceptions", insertCount, [&](unsigned long i)
+	{
+		insert.BindInt(1, static_cast<int>(i % existingKeys));
+		try
+		{
+			insert.Execute();
+		}
+		catch(SQLiteException&)
+		{
+			++failures;
+		}
+		// sqlite3_reset() reports the error of the failed step again
+		try
+		{
+			insert.Reset();
+		}
+		catch(SQLiteException&)
+		{
+		}
+	});
+	Benchmark::DoNotOptimize(failures);
+
+	failures = 0;
+	Benchmark::Measure("duplicate key, status", insertCount, [&](unsigned long i)
+	{
+		insert.TryBindInt(1, static_cast<int>(i % existingKeys));
+		if(insert.TryExecute().IsConstraintViolation())
+			++failures;
+		insert.TryReset();
+	});
+	Benchmark::DoNotOptimize(failures);
+
+	Benchmark::Measure("unique key, status", insertCount, [&](unsigned long i)
+	{
+		insert.TryBindInt(1, static_cast<int>(existingKeys + i));
+		insert.TryExecute();
+		insert.TryReset();
+	});
+
+	insert.FreeQuery();
+	return 0;
+}
@@ -0,0 +1,80 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+// ORDER BY in natural order: a collation which is called for every comparison (CreateCollation())
+// against a sort key column (AddSortKeyColumn()), which is sorted with memcmp() or read from its index.
+// The binary ORDER BY name shows the cost of the sort itself. Usage: KompexSQLiteSortKeyBenchmark [rows]
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteSortKey.h"
+#include "KompexSQLiteBenchmarkHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	//! Runs the query once and prints the time per row.
+	void MeasureQuery(const char *name, unsigned long rowCount, SQLiteStatement &statement, const std::string &sql)
+	{
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		int64 length = 0;
+		statement.Sql(sql);
+		while(statement.FetchRow())
+			length += statement.GetColumnBytes(0);
+		statement.FreeQuery();
+		Benchmark::DoNotOptimize(length);
+		Benchmark::Report(name, rowCount, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long rowCount = argc > 1 ? std::strtoul(argv[1], 0, 10) : 10000000;
+
+	SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+	db.CreateCollation("natural_order", &SQLiteSortKey::CompareNaturalOrder);
+	db.CreateSortKeyFunction("natural_key", &SQLiteSortKey::NaturalOrder);
+
+	SQLiteStatement statement(&db);
+	statement.SqlStatement("CREATE TABLE file(name TEXT)");
+	std::ostringstream insert;
+	insert << "WITH RECURSIVE sequence(x) AS (SELECT 0 UNION ALL SELECT x + 1 FROM sequence WHERE x + 1 < " << rowCount << ") "
+		<< "INSERT INTO file SELECT 'img_' || (x * 7919 % 1000) || '_part' || (x * 104729 % " << rowCount << ") || '.jpg' FROM sequence";
+	statement.SqlStatement(insert.str());
+
+	std::cout << rowCount << " rows" << std::endl;
+
+	MeasureQuery("ORDER BY name (binary)", rowCount, statement, "SELECT name FROM file ORDER BY name");
+	MeasureQuery("ORDER BY name COLLATE natural_order", rowCount, statement, "SELECT name FROM file ORDER BY name COLLATE natural_order");
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	db.AddSortKeyColumn("file", "name", "name_key", "natural_key", false);
+	Benchmark::Report("AddSortKeyColumn() without index", rowCount, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+	MeasureQuery("ORDER BY name_key (sort)", rowCount, statement, "SELECT name FROM file ORDER BY name_key");
+
+	startTime = std::chrono::steady_clock::now();
+	statement.SqlStatement("CREATE INDEX file_name_key ON file(name_key)");
+	Benchmark::Report("CREATE INDEX on the sort key", rowCount, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+	MeasureQuery("ORDER BY name_key (index)", rowCount, statement, "SELECT name FROM file ORDER BY name_key");
+
+	return 0;
+}
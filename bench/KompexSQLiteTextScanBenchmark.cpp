@@ -0,0 +1,113 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Text scan with GetColumnString(), AppendColumnString() into a reused buffer and
+// GetColumnTextView(); prints the time and the number of heap allocations per row.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteBenchmarkHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	std::atomic<unsigned long> allocationCount(0);
+}
+
+void *operator new(std::size_t size)
+{
+	++allocationCount;
+	if(void *memory = std::malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+	std::free(memory);
+}
+
+namespace
+{
+	//! Scans all rows once and reads the text column with the given function.
+	template<class F>
+	void MeasureScan(SQLiteDatabase &db, const char *name, unsigned long rowCount, F readRow)
+	{
+		SQLiteStatement statement(&db);
+		statement.Sql("SELECT payload FROM benchmark");
+
+		unsigned long allocationsBefore = allocationCount;
+		Benchmark::Measure(name, rowCount, [&](unsigned long)
+		{
+			statement.FetchRow();
+			readRow(statement);
+		});
+		unsigned long allocations = allocationCount - allocationsBefore;
+		statement.FreeQuery();
+
+		std::cout << "    " << static_cast<double>(allocations) / rowCount << " allocations per row" << std::endl;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long rowCount = argc > 1 ? std::strtoul(argv[1], 0, 10) : 10000000;
+
+	SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+	SQLiteStatement statement(&db);
+	statement.SqlStatement("CREATE TABLE benchmark(payload TEXT)");
+	statement.BeginTransaction();
+	statement.Sql("INSERT INTO benchmark VALUES(?)");
+	for(unsigned long row = 0; row < rowCount; ++row)
+	{
+		statement.BindString(1, "a text which is longer than the small string buffer of std::string");
+		statement.Execute();
+		statement.Reset();
+	}
+	statement.FreeQuery();
+	statement.CommitTransaction();
+
+	std::cout << rowCount << " rows" << std::endl;
+
+	MeasureScan(db, "GetColumnString()", rowCount, [](const SQLiteStatement &stmt)
+	{
+		std::string text = stmt.GetColumnString(0);
+		Benchmark::DoNotOptimize(text);
+	});
+
+	std::string buffer;
+	MeasureScan(db, "AppendColumnString() into a reused buffer", rowCount, [&](const SQLiteStatement &stmt)
+	{
+		buffer.clear();
+		stmt.AppendColumnString(0, buffer);
+		Benchmark::DoNotOptimize(buffer);
+	});
+
+	MeasureScan(db, "GetColumnTextView()", rowCount, [](const SQLiteStatement &stmt)
+	{
+		SQLiteTextView text = stmt.GetColumnTextView(0);
+		Benchmark::DoNotOptimize(text);
+	});
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteAllocator_H
+#define KompexSQLiteAllocator_H
+
+#include <cstddef>
+#include <vector>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+
+namespace Kompex
+{
+	//! Allocation counters of one size class of the SQLiteAllocator.
+	struct SQLiteAllocatorStatistics
+	{
+		//! Usable size of the blocks in bytes; 0 for allocations which are too large for the size classes
+		size_t blockSize;
+		//! Number of allocations
+		uint64 allocations;
+		//! Number of frees
+		uint64 frees;
+		//! Memory in bytes which was reserved from the system for this size class
+		uint64 reservedBytes;
+	};
+
+	//! Memory allocators for SQLite [SQLITE_CONFIG_MALLOC].\n
+	//! ALLOCATOR_SYSTEM\n
+	//! The default allocator of SQLite (malloc/free).\n
+	//! ALLOCATOR_POOL\n
+	//! Size-class pool allocator: requests up to 8 KB are rounded up to one of 36 size classes and served\n
+	//! from free lists which are filled from 64 KB chunks. Freed blocks are kept in their size class, so that\n
+	//! the steady churn of statement and row buffers does not reach the system allocator. Every size class\n
+	//! has its own lock. Larger requests (e.g. page cache pages bigger than 8 KB) are passed to malloc().\n
+	//! ALLOCATOR_THREAD_CACHING\n
+	//! Like ALLOCATOR_POOL, but every thread keeps a small cache of free blocks per size class, so that most\n
+	//! allocations and frees don't need a lock. The caches exchange blocks with the pool in batches.\n\n
+	//! The allocator must be installed before SQLite is initialized, i.e. before the first database is opened,\n
+	//! or after sqlite3_shutdown(). The pool memory is returned to the system when SQLite is shut down.\n
+	//! e.g. \n
+	//! SQLiteAllocator::Install(SQLiteAllocator::ALLOCATOR_THREAD_CACHING);\n
+	//! SQLiteDatabase db("test.db", SQLITE_OPEN_READWRITE, 0);
+	class _SQLiteWrapperExport SQLiteAllocator
+	{
+	public:
+		//! Provided allocators
+		enum AllocatorType {ALLOCATOR_SYSTEM, ALLOCATOR_POOL, ALLOCATOR_THREAD_CACHING};
+
+		//! Installs an allocator for SQLite.\n
+		//! Throws an exception if SQLite is already initialized.
+		//! @param type		Allocator
+		static void Install(AllocatorType type);
+		//! Returns the installed allocator.
+		static AllocatorType GetInstalledType();
+
+		//! Returns the counters of all size classes; the last entry holds the large allocations.\n
+		//! The thread caches report their counters to the pool when they exchange blocks with it,\n
+		//! therefore the counters of ALLOCATOR_THREAD_CACHING can lag behind slightly.
+		static std::vector<SQLiteAllocatorStatistics> GetStatistics();
+
+	protected:
+		//! Allocation function of ALLOCATOR_POOL [sqlite3_mem_methods::xMalloc]
+		static void *PoolMalloc(int bytes);
+		//! Free function of ALLOCATOR_POOL [sqlite3_mem_methods::xFree]
+		static void PoolFree(void *memory);
+		//! Reallocation function of ALLOCATOR_POOL [sqlite3_mem_methods::xRealloc]
+		static void *PoolRealloc(void *memory, int bytes);
+		//! Allocation function of ALLOCATOR_THREAD_CACHING [sqlite3_mem_methods::xMalloc]
+		static void *CachingMalloc(int bytes);
+		//! Free function of ALLOCATOR_THREAD_CACHING [sqlite3_mem_methods::xFree]
+		static void CachingFree(void *memory);
+		//! Reallocation function of ALLOCATOR_THREAD_CACHING [sqlite3_mem_methods::xRealloc]
+		static void *CachingRealloc(void *memory, int bytes);
+		//! Returns the usable size of an allocation [sqlite3_mem_methods::xSize]
+		static int Size(void *memory);
+		//! Returns the size which is really allocated for a request [sqlite3_mem_methods::xRoundup]
+		static int Roundup(int bytes);
+		//! Initializes the allocator [sqlite3_mem_methods::xInit]
+		static int Init(void *appData);
+		//! Returns the pool memory to the system [sqlite3_mem_methods::xShutdown]
+		static void Shutdown(void *appData);
+
+	private:
+		//! Static class
+		SQLiteAllocator();
+	};
+};
+
+#endif // KompexSQLiteAllocator_H
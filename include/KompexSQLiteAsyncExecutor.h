@@ -0,0 +1,229 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteAsyncExecutor_H
+#define KompexSQLiteAsyncExecutor_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteValue.h"
+
+namespace Kompex
+{
+	class SQLiteDatabase;
+
+	//! Result of a query which was submitted to a SQLiteAsyncExecutor.\n
+	//! Holds the future of the result and allows to cancel the query.
+	template<class T>
+	class SQLiteAsyncResult
+	{
+	public:
+		//! Constructor
+		SQLiteAsyncResult(std::future<T> &&future, const std::shared_ptr<std::atomic<bool> > &cancelFlag):
+			mFuture(std::move(future)),
+			mCancelFlag(cancelFlag)
+		{
+		}
+
+		//! Waits for the result and returns it. Throws a SQLiteException if the query failed or was cancelled.
+		T Get() {return mFuture.get();}
+		//! Returns the future of the result.
+		std::future<T> &GetFuture() {return mFuture;}
+		//! Cancels the query. A queued query is not started anymore, a running query is interrupted\n
+		//! at its next progress check. The future reports a SQLiteException in both cases,\n
+		//! unless the query has already finished.
+		void Cancel() {mCancelFlag->store(true, std::memory_order_relaxed);}
+
+	private:
+		//! Future of the result
+		std::future<T> mFuture;
+		//! Cancellation flag which is shared with the executor
+		std::shared_ptr<std::atomic<bool> > mCancelFlag;
+	};
+
+	//! Stores the return value of a function in a promise (return type void is handled separately).
+	template<class R>
+	struct SQLiteAsyncInvoker
+	{
+		template<class F>
+		static void Invoke(std::promise<R> &promise, F &function, SQLiteDatabase &db) {promise.set_value(function(db));}
+	};
+
+	template<>
+	struct SQLiteAsyncInvoker<void>
+	{
+		template<class F>
+		static void Invoke(std::promise<void> &promise, F &function, SQLiteDatabase &db) {function(db); promise.set_value();}
+	};
+
+	//! Executes queries asynchronously on a dedicated worker thread per connection.\n
+	//! Every query returns a SQLiteAsyncResult with a future, so that the calling thread (e.g. the I/O thread\n
+	//! of an event loop) never blocks on SQLite. Queries can have a deadline and can be cancelled one by one:\n
+	//! the executor installs a progress handler [sqlite3_progress_handler], which interrupts only the running\n
+	//! query when its deadline has passed or it was cancelled. InterruptDatabaseOperation() instead would\n
+	//! interrupt everything on the connection.\n
+	//! The connection must not be used by other threads while the executor exists.\n
+	//! e.g. \n
+	//! SQLiteAsyncExecutor executor(&db);\n
+	//! SQLiteAsyncResult<std::vector<SQLiteAsyncExecutor::Row> > result = executor.Query("SELECT * FROM user WHERE id = ?", params, 100);\n
+	//! ...\n
+	//! std::vector<SQLiteAsyncExecutor::Row> rows = result.Get();
+	class _SQLiteWrapperExport SQLiteAsyncExecutor
+	{
+	public:
+		//! Result row of Query()
+		typedef std::vector<SQLiteValue> Row;
+
+		//! Constructor.\n
+		//! Installs the progress handler and starts the worker thread.
+		//! @param db					Connection which is used by the worker thread
+		//! @param progressInterval		Number of virtual machine instructions between two checks of the deadline and\n
+		//!								the cancellation flag; smaller values react faster, but cost more time
+		SQLiteAsyncExecutor(SQLiteDatabase *db, int progressInterval = 1000);
+		//! Destructor.\n
+		//! Interrupts the running query, fails all queued queries and stops the worker thread.
+		virtual ~SQLiteAsyncExecutor();
+
+		//! Executes a function with the connection on the worker thread.\n
+		//! The function gets a SQLiteDatabase reference and can use SQLiteStatement etc. as usual.
+		//! @param function		Function or lambda, e.g. [](SQLiteDatabase &db) -> int {...}
+		//! @param timeout		Deadline in milliseconds after the submission; 0 = no deadline
+		template<class F>
+		SQLiteAsyncResult<decltype(std::declval<F&>()(std::declval<SQLiteDatabase&>()))> Submit(F function, unsigned int timeout = 0)
+		{
+			typedef decltype(std::declval<F&>()(std::declval<SQLiteDatabase&>())) R;
+
+			std::shared_ptr<std::promise<R> > promise = std::make_shared<std::promise<R> >();
+			Task task;
+			task.cancelFlag = std::make_shared<std::atomic<bool> >(false);
+			task.run = [this, promise, function]() mutable
+			{
+				try
+				{
+					SQLiteAsyncInvoker<R>::Invoke(*promise, function, *mDatabase);
+				}
+				catch(...)
+				{
+					promise->set_exception(GetTaskException());
+				}
+			};
+			task.fail = [promise](const std::exception_ptr &exception) {promise->set_exception(exception);};
+
+			SQLiteAsyncResult<R> result(promise->get_future(), task.cancelFlag);
+			Enqueue(task, timeout);
+			return result;
+		}
+
+		//! Executes a query on the worker thread and returns all result rows.
+		//! @param sql				SQL statement (UTF-8)
+		//! @param parameters		Values for the SQL parameters; the first value is bound to the first parameter
+		//! @param timeout			Deadline in milliseconds after the submission; 0 = no deadline
+		SQLiteAsyncResult<std::vector<Row> > Query(const std::string &sql, const std::vector<SQLiteValue> &parameters = std::vector<SQLiteValue>(), unsigned int timeout = 0);
+		//! Executes a statement which returns no rows (e.g. INSERT, UPDATE) on the worker thread.
+		//! @param sql				SQL statement (UTF-8)
+		//! @param parameters		Values for the SQL parameters; the first value is bound to the first parameter
+		//! @param timeout			Deadline in milliseconds after the submission; 0 = no deadline
+		//! @return					Number of changed rows
+		SQLiteAsyncResult<int> Execute(const std::string &sql, const std::vector<SQLiteValue> &parameters = std::vector<SQLiteValue>(), unsigned int timeout = 0);
+
+		//! Cancels all queued queries and the running query.
+		void CancelAll();
+		//! Returns the number of queued queries.
+		size_t GetQueueSize() const;
+
+	protected:
+		//! Queued query
+		struct Task
+		{
+			//! Runs the query and fulfills the promise
+			std::function<void()> run;
+			//! Fulfills the promise with an exception
+			std::function<void(const std::exception_ptr&)> fail;
+			//! Cancellation flag
+			std::shared_ptr<std::atomic<bool> > cancelFlag;
+			//! Deadline
+			std::chrono::steady_clock::time_point deadline;
+			//! Has the task a deadline?
+			bool hasDeadline;
+		};
+
+		//! Reasons why the progress handler interrupted a query
+		enum InterruptReason {INTERRUPT_NONE, INTERRUPT_CANCELLED, INTERRUPT_DEADLINE, INTERRUPT_STOPPED};
+
+		//! Callback function for the progress handler [sqlite3_progress_handler]
+		static int ProgressHandler(void *ptr);
+		//! Main loop of the worker thread.
+		void Run();
+		//! Queues a task.
+		void Enqueue(Task &task, unsigned int timeout);
+		//! Returns the exception for the currently handled exception of a task;\n
+		//! errors caused by an interruption of the progress handler are replaced with a meaningful message.
+		std::exception_ptr GetTaskException() const;
+		//! Returns the exception for an interruption reason.
+		static std::exception_ptr GetInterruptException(InterruptReason reason);
+		//! Returns the interruption reason for a task or INTERRUPT_NONE.
+		InterruptReason CheckTask(const Task &task) const;
+		//! Stops the worker thread.
+		void Stop();
+
+	private:
+		//! Copy constructor
+		SQLiteAsyncExecutor(const SQLiteAsyncExecutor &executor);
+		//! Assignment operator
+		SQLiteAsyncExecutor &operator=(const SQLiteAsyncExecutor &executor);
+
+		//! Connection of the worker thread
+		SQLiteDatabase *mDatabase;
+
+		//! Protects the queue
+		mutable std::mutex mMutex;
+		//! Wakes up the worker thread
+		std::condition_variable mCondition;
+		//! Queued tasks
+		std::deque<Task> mQueue;
+		//! Shall the worker thread stop?
+		std::atomic<bool> mIsStopRequested;
+
+		//! Task which is executed by the worker thread (only used by the worker thread)
+		const Task *mCurrentTask;
+		//! Why was the current task interrupted? (only used by the worker thread)
+		InterruptReason mInterruptReason;
+		//! Cancellation flag of the running task, used by CancelAll()
+		std::shared_ptr<std::atomic<bool> > mCurrentCancelFlag;
+
+		//! Worker thread
+		std::thread mThread;
+	};
+};
+
+#endif // KompexSQLiteAsyncExecutor_H
@@ -0,0 +1,228 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteBulkInserter_H
+#define KompexSQLiteBulkInserter_H
+
+#include <chrono>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteValue.h"
+
+namespace Kompex
+{
+	class SQLiteDatabase;
+
+	//! Fast insertion of many rows into one table.\n
+	//! The rows are collected and written with a multi-row INSERT statement (INSERT INTO t (a, b) VALUES (?, ?), (?, ?), ...)\n
+	//! which is prepared only once. The inserter opens a transaction by itself and commits it automatically\n
+	//! after a given number of rows or bytes. If the database connection is already inside of a transaction,\n
+	//! the inserter uses the existing transaction and never commits.\n
+	//! The values are copied into the inserter (SQLiteValue) when a row is inserted and are bound from there\n
+	//! with SQLITE_STATIC, i.e. SQLite doesn't copy them a second time. Text and BLOB data is copied once.\n
+	//! If an INSERT fails (e.g. a constraint violation), the exception is passed on and the collected rows are discarded.\n
+	//! The transaction of the inserter is rolled back, i.e. all rows since the last commit are lost. Inside of a transaction\n
+	//! of the caller only the failed statement is undone; the rows of earlier statements stay and the caller decides.\n
+	//! e.g. \n
+	//! std::vector<std::string> columns; columns.push_back("id"); columns.push_back("name");\n
+	//! SQLiteBulkInserter inserter(&db, "user", columns);\n
+	//! inserter.InsertRow(1, "Lucas");\n
+	//! inserter.Insert(std::make_tuple(2, std::string("Emma")));\n
+	//! inserter.Finish();
+	class _SQLiteWrapperExport SQLiteBulkInserter
+	{
+	public:
+		/**
+		Constructor.
+
+		@param db					Database in which the rows shall be inserted
+		@param tableName			Name of the table
+		@param columnNames			Names of the columns which will be filled
+		@param rowsPerCommit		The transaction will be committed after this number of rows.
+		@param bytesPerCommit		The transaction will be committed after this number of bytes of data (approximately).
+		@param useMultiRowInsert	If true, as many rows as possible (limited by SQLITE_MAX_VARIABLE_NUMBER)\n
+									are inserted with one INSERT statement. If false, every row is inserted separately.
+		*/
+		SQLiteBulkInserter(SQLiteDatabase *db, const std::string &tableName, const std::vector<std::string> &columnNames,
+			unsigned int rowsPerCommit = 10000, size_t bytesPerCommit = 16 * 1024 * 1024, bool useMultiRowInsert = true);
+		//! Destructor.\n
+		//! Calls Finish(). Errors will be written to std::cerr and the open transaction will be rolled back.\n
+		//! Call Finish() by yourself if you want to handle the errors.
+		virtual ~SQLiteBulkInserter();
+
+		//! Inserts a row. The number of values must be equal to the number of columns.
+		//! @param row				Values of the row
+		void Insert(const std::vector<SQLiteValue> &row);
+		//! Inserts a row. The number of tuple elements must be equal to the number of columns.
+		//! @param row				Values of the row
+		template<class... T>
+		void Insert(const std::tuple<T...> &row)
+		{
+			CheckRowSize(sizeof...(T));
+			TupleAppender<sizeof...(T), std::tuple<T...> >::Append(*this, row);
+			RowAdded();
+		}
+		//! Inserts a row. The number of values must be equal to the number of columns.
+		//! @param values			Values of the row
+		template<class... T>
+		void InsertRow(const T&... values)
+		{
+			CheckRowSize(sizeof...(T));
+			AppendValues(values...);
+			RowAdded();
+		}
+		//! Inserts all rows of a container. Every row must be a std::tuple or a std::vector<SQLiteValue>.
+		//! @param rows				Container with rows
+		template<class Container>
+		void InsertAll(const Container &rows)
+		{
+			for(typename Container::const_iterator iter = rows.begin(); iter != rows.end(); ++iter)
+				Insert(*iter);
+		}
+
+		//! Writes all collected rows into the database without committing them.
+		void Flush();
+		//! Writes all collected rows into the database and commits the transaction of the inserter.
+		void Commit();
+		//! Writes all collected rows, commits the transaction and stops the time measurement.
+		void Finish();
+		//! Discards all collected rows and rolls back the transaction of the inserter.
+		void Rollback();
+
+		//! Returns the number of rows which were inserted into the database (without rolled back rows).
+		uint64 GetInsertedRows() const {return mInsertedRows;}
+		//! Returns the number of transactions which were committed by the inserter.
+		uint64 GetCommitCount() const {return mCommitCount;}
+		//! Returns the number of rows which are written with one INSERT statement.
+		unsigned int GetRowsPerStatement() const {return mRowsPerStatement;}
+		//! Returns the time in seconds between the first inserted row and Finish() (or now, if Finish() was not called yet).
+		double GetElapsedSeconds() const;
+		//! Returns the number of inserted rows per second.
+		double GetRowsPerSecond() const;
+
+	protected:
+		//! Builds the INSERT statement for the given number of rows.
+		std::string BuildInsertStatement(unsigned int rows) const;
+		//! Executes the given statement with the collected values starting at the given offset.
+		void ExecuteStatement(sqlite3_stmt *statement, size_t valueOffset, size_t valueCount);
+		//! Opens the transaction of the inserter if necessary.
+		void BeginTransactionIfNecessary();
+		//! Discards the collected rows after a failed INSERT and rolls back the transaction of the inserter.
+		void DiscardAfterFailure();
+		//! Called after the values of a row were collected.
+		void RowAdded();
+		//! Checks that a row has one value per column.
+		void CheckRowSize(size_t size) const;
+		//! Finalizes the prepared statements.
+		void FreeStatements();
+
+		//! Appends one value to the collected values.
+		inline void AppendValue(const SQLiteValue &value)
+		{
+			mPendingBytes += value.GetSize();
+			mPendingValues.push_back(value);
+		}
+		//! Appends one temporary value to the collected values without copying its data again.
+		inline void AppendValue(SQLiteValue &&value)
+		{
+			mPendingBytes += value.GetSize();
+			mPendingValues.push_back(std::move(value));
+		}
+		//! End of the recursion.
+		inline void AppendValues() {}
+		//! Appends all values to the collected values.
+		template<class V, class... T>
+		inline void AppendValues(const V &value, const T&... values)
+		{
+			AppendValue(SQLiteValue(value));
+			AppendValues(values...);
+		}
+
+		//! Appends the first N elements of a tuple to the collected values.
+		template<int N, class Tuple>
+		struct TupleAppender
+		{
+			static inline void Append(SQLiteBulkInserter &inserter, const Tuple &row)
+			{
+				TupleAppender<N - 1, Tuple>::Append(inserter, row);
+				inserter.AppendValue(SQLiteValue(std::get<N - 1>(row)));
+			}
+		};
+		//! End of the recursion.
+		template<class Tuple>
+		struct TupleAppender<0, Tuple>
+		{
+			static inline void Append(SQLiteBulkInserter &, const Tuple &) {}
+		};
+
+	private:
+		//! Copy constructor
+		SQLiteBulkInserter(const SQLiteBulkInserter &inserter);
+		//! Assignment operator
+		SQLiteBulkInserter &operator=(const SQLiteBulkInserter &inserter);
+
+		//! Database pointer
+		SQLiteDatabase *mDatabase;
+		//! Name of the table
+		std::string mTableName;
+		//! Names of the columns
+		std::vector<std::string> mColumnNames;
+		//! Commit after this number of rows
+		unsigned int mRowsPerCommit;
+		//! Commit after this number of bytes
+		size_t mBytesPerCommit;
+		//! Number of rows per multi-row INSERT statement
+		unsigned int mRowsPerStatement;
+		//! Multi-row INSERT statement
+		sqlite3_stmt *mMultiRowStatement;
+		//! Single-row INSERT statement
+		sqlite3_stmt *mSingleRowStatement;
+
+		//! Collected values which were not written yet
+		std::vector<SQLiteValue> mPendingValues;
+		//! Bytes of the collected values
+		size_t mPendingBytes;
+		//! Rows written since the last commit
+		unsigned int mUncommittedRows;
+		//! Bytes written since the last commit
+		size_t mUncommittedBytes;
+		//! Has the inserter opened a transaction?
+		bool mIsTransactionActive;
+
+		//! Number of inserted rows
+		uint64 mInsertedRows;
+		//! Number of commits
+		uint64 mCommitCount;
+		//! Was the time measurement started?
+		bool mIsTimerStarted;
+		//! Was Finish() called?
+		bool mIsFinished;
+		//! Time of the first inserted row
+		std::chrono::steady_clock::time_point mStartTime;
+		//! Time of Finish()
+		std::chrono::steady_clock::time_point mFinishTime;
+	};
+};
+
+#endif // KompexSQLiteBulkInserter_H
@@ -0,0 +1,97 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteColumnLookup_H
+#define KompexSQLiteColumnLookup_H
+
+#include <string>
+#include <vector>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+
+namespace Kompex
+{
+	//! Maps the column names of a prepared statement to their column numbers.\n
+	//! The names are stored in a flat hash table with open addressing (linear probing),\n
+	//! which is built once per prepared statement.
+	class _SQLiteWrapperExport SQLiteColumnLookup
+	{
+	public:
+		//! Constructor.
+		SQLiteColumnLookup();
+
+		//! Reads all column names of the given statement into the hash table.\n
+		//! If a column name exists more than once, the last column wins.
+		//! @param statement		Prepared statement
+		void Build(sqlite3_stmt *statement);
+		//! Removes all entries. The allocated memory will be kept for the next Build().
+		void Clear();
+		//! Exchanges the content with another lookup table without copying.
+		void Swap(SQLiteColumnLookup &lookup);
+
+		//! Returns true if Build() was called since the last Clear().
+		bool IsBuilt() const {return mIsBuilt;}
+		//! Returns the number of columns for which the table was built.
+		int GetColumnCount() const {return mColumnCount;}
+		//! Returns true if the table was built for the current column names of the given statement.\n
+		//! A statement which is recompiled after a schema change may keep its column count, but rename or reorder its columns.
+		//! @param statement		Prepared statement
+		bool Matches(sqlite3_stmt *statement) const;
+
+		//! Returns the column number for the given column name or -1 if the name is unknown.
+		//! @param name			Column name (UTF-8)
+		//! @param length		Length of the column name in bytes
+		int Find(const char *name, size_t length) const;
+		//! Returns the column number for the given column name or -1 if the name is unknown.
+		//! @param name			Column name (UTF-8)
+		inline int Find(const std::string &name) const {return Find(name.data(), name.length());}
+
+	protected:
+		//! FNV-1a hash of a column name
+		static unsigned int Hash(const char *name, size_t length);
+
+	private:
+		//! Hash table slot
+		struct Slot
+		{
+			//! Hash of the column name
+			unsigned int hash;
+			//! Offset of the column name in mNames
+			unsigned int nameOffset;
+			//! Length of the column name in bytes
+			unsigned int nameLength;
+			//! Column number; -1 for an empty slot
+			int column;
+		};
+
+		//! Hash table; the size is always a power of two
+		std::vector<Slot> mSlots;
+		//! All column names one after another (in column order)
+		std::string mNames;
+		//! Offset of every column name in mNames; the last element is the end of the last name
+		std::vector<unsigned int> mColumnNameOffsets;
+		//! Number of columns
+		int mColumnCount;
+		//! Was Build() called?
+		bool mIsBuilt;
+	};
+};
+
+#endif // KompexSQLiteColumnLookup_H
@@ -0,0 +1,220 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteConnectionPool_H
+#define KompexSQLiteConnectionPool_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "KompexSQLitePrerequisites.h"
+
+namespace Kompex
+{
+	class SQLiteDatabase;
+
+	//! Usage statistics of a SQLiteConnectionPool.
+	struct SQLiteConnectionPoolStatistics
+	{
+		//! Number of read-only connections
+		unsigned int readerCount;
+		//! Number of read-only connections which are currently leased
+		unsigned int readersInUse;
+		//! Is the writer connection currently leased?
+		bool isWriterInUse;
+
+		//! Number of reader leases
+		uint64 readerAcquisitions;
+		//! Number of writer leases
+		uint64 writerAcquisitions;
+		//! Number of reader leases which had to wait for a free connection
+		uint64 readerWaits;
+		//! Number of writer leases which had to wait for the writer connection
+		uint64 writerWaits;
+
+		//! Total time in seconds which was spent waiting for read-only connections
+		double readerWaitSeconds;
+		//! Total time in seconds which was spent waiting for the writer connection
+		double writerWaitSeconds;
+		//! Longest time in seconds which a single lease had to wait
+		double maxWaitSeconds;
+
+		//! Share of the time in which the read-only connections were leased (0.0 - 1.0)
+		double readerUtilization;
+		//! Share of the time in which the writer connection was leased (0.0 - 1.0)
+		double writerUtilization;
+	};
+
+	//! Pool of database connections to one database file for multi-threaded applications.\n
+	//! The pool opens one writer connection and several read-only connections and switches the database\n
+	//! into the WAL journal mode, so that readers and the writer do not block each other.\n
+	//! A connection is handed out as lease and given back automatically when the lease is destroyed.\n
+	//! Every connection keeps its own statement cache, therefore prepared statements stay with\n
+	//! the connection and are reused by every thread which leases it afterwards.\n
+	//! When a connection is given back, its active statements are reset and an open transaction is rolled back,\n
+	//! i.e. a transaction must be committed before the lease ends.\n
+	//! e.g. \n
+	//! SQLiteConnectionPool pool("test.db", 8);\n
+	//! {\n
+	//!     SQLiteConnectionPool::Lease lease = pool.AcquireReader();\n
+	//!     SQLiteStatement stmt(lease.Get());\n
+	//!     stmt.SqlCached("SELECT name FROM user WHERE id = 1");\n
+	//!     ...\n
+	//! }
+	class _SQLiteWrapperExport SQLiteConnectionPool
+	{
+	public:
+		//! Exclusive use of one connection of the pool. Leases can be moved but not copied.
+		class _SQLiteWrapperExport Lease
+		{
+		public:
+			//! Constructor for an empty lease
+			Lease();
+			//! Move constructor
+			Lease(Lease &&lease);
+			//! Move assignment operator; gives back the currently leased connection
+			Lease &operator=(Lease &&lease);
+			//! Destructor; gives back the leased connection
+			~Lease();
+
+			//! Returns the leased database connection or a null pointer if the lease is empty.
+			SQLiteDatabase *Get() const {return mDatabase;}
+			//! Returns the leased database connection.
+			SQLiteDatabase *operator->() const {return mDatabase;}
+			//! Returns true if the lease holds a connection.
+			bool IsValid() const {return mDatabase != 0;}
+			//! Returns true if the lease holds the writer connection.
+			bool IsWriter() const {return mIsWriter;}
+			//! Gives back the leased connection before the lease is destroyed.
+			void Release();
+
+		private:
+			friend class SQLiteConnectionPool;
+
+			//! Constructor
+			Lease(SQLiteConnectionPool *pool, SQLiteDatabase *database, unsigned int index, bool isWriter);
+			//! Copy constructor
+			Lease(const Lease &lease);
+			//! Assignment operator
+			Lease &operator=(const Lease &lease);
+
+			//! Pool of the connection
+			SQLiteConnectionPool *mPool;
+			//! Leased connection
+			SQLiteDatabase *mDatabase;
+			//! Index of the read-only connection
+			unsigned int mIndex;
+			//! Is it the writer connection?
+			bool mIsWriter;
+			//! Start of the lease
+			std::chrono::steady_clock::time_point mAcquireTime;
+		};
+
+		/**
+		Constructor.\n
+		Opens all connections and activates the WAL journal mode.
+
+		@param filename					Database filename (UTF-8); the file is created if it does not exist
+		@param readerCount				Number of read-only connections\n
+										0 = one connection per hardware thread
+		@param busyTimeout				Milliseconds which every connection waits for a lock before SQLITE_BUSY is returned
+		@param statementCacheCapacity	Capacity of the statement cache of every connection
+		*/
+		SQLiteConnectionPool(const std::string &filename, unsigned int readerCount = 0, int busyTimeout = 5000, unsigned int statementCacheCapacity = 32);
+		//! Destructor.\n
+		//! All leases must have been given back before the pool is destroyed.
+		virtual ~SQLiteConnectionPool();
+
+		//! Leases a read-only connection. Blocks until a connection is free.
+		Lease AcquireReader();
+		//! Leases a read-only connection.
+		//! @param lease					Receives the connection
+		//! @param timeout					Maximum time in milliseconds to wait for a free connection
+		//! @return							'true' if a connection was leased and 'false' if the timeout has expired
+		bool TryAcquireReader(Lease &lease, unsigned int timeout);
+		//! Leases the writer connection. Blocks until the connection is free.
+		Lease AcquireWriter();
+		//! Leases the writer connection.
+		//! @param lease					Receives the connection
+		//! @param timeout					Maximum time in milliseconds to wait for the connection
+		//! @return							'true' if the connection was leased and 'false' if the timeout has expired
+		bool TryAcquireWriter(Lease &lease, unsigned int timeout);
+
+		//! Returns the number of read-only connections.
+		unsigned int GetReaderCount() const {return static_cast<unsigned int>(mReaders.size());}
+		//! Returns the database filename.
+		const std::string &GetFilename() const {return mFilename;}
+
+		//! Returns the usage statistics.
+		SQLiteConnectionPoolStatistics GetStatistics() const;
+		//! Resets the counters and the time measurement of the usage statistics.
+		void ResetStatistics();
+
+	protected:
+		//! Leases a read-only connection.
+		bool AcquireReader(Lease &lease, bool isTimeoutActive, unsigned int timeout);
+		//! Leases the writer connection.
+		bool AcquireWriter(Lease &lease, bool isTimeoutActive, unsigned int timeout);
+		//! Gives back a connection. Called by the lease.
+		void Release(Lease &lease);
+		//! Resets all active statements and rolls back an open transaction of a connection which is given back.
+		void ResetConnection(SQLiteDatabase *database);
+		//! Records the waiting time of an acquisition. The mutex must be locked.
+		void RecordWait(double seconds, bool isWriter);
+		//! Closes and deletes all connections.
+		void CloseConnections();
+
+	private:
+		//! Copy constructor
+		SQLiteConnectionPool(const SQLiteConnectionPool &pool);
+		//! Assignment operator
+		SQLiteConnectionPool &operator=(const SQLiteConnectionPool &pool);
+
+		//! Database filename
+		std::string mFilename;
+		//! Writer connection
+		SQLiteDatabase *mWriter;
+		//! Read-only connections
+		std::vector<SQLiteDatabase*> mReaders;
+		//! Indices of the free read-only connections (the last given back connection is leased first)
+		std::vector<unsigned int> mFreeReaders;
+		//! Is the writer connection leased?
+		bool mIsWriterInUse;
+
+		//! Protects the connection lists and the statistics
+		mutable std::mutex mMutex;
+		//! Signaled when a read-only connection was given back
+		std::condition_variable mReaderAvailable;
+		//! Signaled when the writer connection was given back
+		std::condition_variable mWriterAvailable;
+
+		//! Statistics counters
+		SQLiteConnectionPoolStatistics mStatistics;
+		//! Accumulated lease time of all read-only connections in seconds
+		double mReaderBusySeconds;
+		//! Accumulated lease time of the writer connection in seconds
+		double mWriterBusySeconds;
+		//! Start of the time measurement
+		std::chrono::steady_clock::time_point mStatisticsStartTime;
+	};
+};
+
+#endif // KompexSQLiteConnectionPool_H
@@ -0,0 +1,95 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteCountingVfs_H
+#define KompexSQLiteCountingVfs_H
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+
+namespace Kompex
+{
+	//! I/O counters of the SQLiteCountingVfs.
+	struct SQLiteIoStatistics
+	{
+		//! Number of read() calls on database files [sqlite3_io_methods::xRead]
+		uint64 reads;
+		//! Bytes read with read() from database files
+		uint64 readBytes;
+		//! Number of read() calls on WAL files
+		uint64 walReads;
+		//! Bytes read with read() from WAL files
+		uint64 walReadBytes;
+		//! Number of pages which were served from the memory mapping [sqlite3_io_methods::xFetch]
+		uint64 mmapFetches;
+		//! Bytes which were served from the memory mapping
+		uint64 mmapFetchBytes;
+		//! Number of pages which could not be served from the memory mapping, e.g. because they are beyond\n
+		//! the mmap window; SQLite reads them with read() (counted in reads as well)
+		uint64 mmapFallbacks;
+		//! Number of write() calls on database and WAL files
+		uint64 writes;
+		//! Bytes written to database and WAL files
+		uint64 writeBytes;
+
+		//! Returns the part of the database page reads which were served from the memory mapping (0.0 - 1.0).
+		double GetMmapRatio() const
+		{
+			uint64 pageReads = mmapFetches + reads;
+			return pageReads > 0 ? static_cast<double>(mmapFetches) / pageReads : 0.0;
+		}
+	};
+
+	//! VFS shim which counts the page reads of database files served by memory-mapped I/O and by read().\n
+	//! The shim passes all calls to a base VFS (by default the default VFS of the platform) and counts\n
+	//! the reads and writes of database and WAL files of all connections which use the shim.\n
+	//! Use it with SQLiteDatabase::SetMmapSize() to verify that a read-mostly database is served from the\n
+	//! memory mapping (memory-mapped I/O requires SQLite 3.7.17 or newer at runtime).\n
+	//! e.g. \n
+	//! SQLiteCountingVfs::Register();\n
+	//! SQLiteDatabase db("lookup.db", SQLITE_OPEN_READONLY, SQLiteCountingVfs::GetName());\n
+	//! db.SetMmapSize(256 * 1024 * 1024);\n
+	//! ...\n
+	//! double ratio = SQLiteCountingVfs::GetStatistics().GetMmapRatio();
+	class _SQLiteWrapperExport SQLiteCountingVfs
+	{
+	public:
+		//! Registers the shim as VFS with the name GetName() [sqlite3_vfs_register].\n
+		//! Further calls are ignored.
+		//! @param baseVfsName		Name of the VFS which does the I/O; NULL = default VFS
+		//! @param makeDefault		Shall the shim become the default VFS?
+		static void Register(const char *baseVfsName = 0, bool makeDefault = false);
+		//! Unregisters the shim [sqlite3_vfs_unregister].\n
+		//! Please note, that no database must be opened with the shim anymore.
+		static void Unregister();
+		//! Returns the name of the shim, which can be passed as zVfs to SQLiteDatabase.
+		static const char *GetName() {return "kompex-counting";}
+
+		//! Returns the counters.
+		static SQLiteIoStatistics GetStatistics();
+		//! Resets the counters.
+		static void ResetStatistics();
+
+	private:
+		//! Static class
+		SQLiteCountingVfs();
+	};
+};
+
+#endif // KompexSQLiteCountingVfs_H
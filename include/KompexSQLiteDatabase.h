@@ -19,18 +19,138 @@
 #ifndef KompexSQLiteDatabase_H
 #define KompexSQLiteDatabase_H
 
+#include <atomic>
+#include <chrono>
+#include <random>
 #include <string>
 
 #include "sqlite3.h"
 
 #include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteDatabaseStatistics.h"
+#include "KompexSQLiteFunction.h"
+#include "KompexSQLiteStatementCache.h"
+#include "KompexSQLiteStatementStatistics.h"
 
 namespace Kompex
 {
+	class SQLiteProfiler;
+
 	//! Administration of the database and all concerning settings.
 	class _SQLiteWrapperExport SQLiteDatabase
 	{
 	public:
+		//! Journal modes for SetJournalMode() [PRAGMA journal_mode]
+		enum JournalMode {JOURNAL_DELETE, JOURNAL_TRUNCATE, JOURNAL_PERSIST, JOURNAL_MEMORY, JOURNAL_WAL, JOURNAL_OFF};
+		//! Synchronization levels for SetSynchronous() [PRAGMA synchronous]
+		enum SynchronousMode {SYNCHRONOUS_OFF, SYNCHRONOUS_NORMAL, SYNCHRONOUS_FULL};
+		//! Checkpoint modes for WalCheckpoint() [sqlite3_wal_checkpoint_v2]\n
+		//! CHECKPOINT_PASSIVE\n
+		//! Checkpoint as many frames as possible without waiting for any readers or writers.\n
+		//! CHECKPOINT_FULL\n
+		//! Waits until there is no writer and all readers read from the most recent snapshot.\n
+		//! CHECKPOINT_RESTART\n
+		//! Like CHECKPOINT_FULL, additionally waits until the next writer can restart the WAL file from the beginning.\n
+		//! CHECKPOINT_TRUNCATE\n
+		//! Like CHECKPOINT_RESTART, additionally truncates the WAL file to zero bytes (requires SQLite 3.8.8;\n
+		//! CHECKPOINT_RESTART is used with older versions).
+		enum CheckpointMode {CHECKPOINT_PASSIVE, CHECKPOINT_FULL, CHECKPOINT_RESTART, CHECKPOINT_TRUNCATE};
+
+		//! Journal settings which can be applied when a database is opened.\n
+		//! The default values activate the WAL mode with synchronous=NORMAL, which is durable\n
+		//! in WAL mode except for the last transactions before a power failure.
+		struct JournalSettings
+		{
+			JournalSettings():
+				journalMode(JOURNAL_WAL),
+				synchronous(SYNCHRONOUS_NORMAL),
+				walAutoCheckpoint(1000),
+				journalSizeLimit(-1)
+			{}
+
+			//! Journal mode
+			JournalMode journalMode;
+			//! Synchronization level
+			SynchronousMode synchronous;
+			//! WAL size in pages which triggers an automatic checkpoint on commit; 0 disables the automatic checkpoints
+			int walAutoCheckpoint;
+			//! Maximum size in bytes of a journal or WAL file which is kept after a transaction or checkpoint; -1 = no limit
+			int64 journalSizeLimit;
+		};
+
+		//! Storage of temporary tables and indices for SetTempStore() [PRAGMA temp_store]
+		enum TempStore {TEMP_STORE_DEFAULT, TEMP_STORE_FILE, TEMP_STORE_MEMORY};
+		//! Predefined memory settings for ApplyTuningProfile() and ConfigurePageCache().\n
+		//! PROFILE_DEFAULT\n
+		//! The default values of SQLite (lookaside 1200 bytes x 100 slots, 2 MB page cache).\n
+		//! PROFILE_READ_HEAVY\n
+		//! Many small lookaside slots for the short-lived allocations of prepared statements, 64 MB page cache\n
+		//! and temporary tables in memory, for many queries on a working set which fits into memory.\n
+		//! PROFILE_BULK_LOAD\n
+		//! Larger lookaside slots for the row buffers of INSERT statements and a 256 MB page cache, so that index\n
+		//! pages stay in memory while large transactions are written. Temporary data (e.g. sorts of CREATE INDEX)\n
+		//! is written to files.\n
+		//! PROFILE_LOW_MEMORY\n
+		//! Small lookaside memory, 512 KB page cache and temporary tables in files.
+		enum TuningProfile {PROFILE_DEFAULT, PROFILE_READ_HEAVY, PROFILE_BULK_LOAD, PROFILE_LOW_MEMORY};
+
+		//! Memory settings of a connection which can be applied with ApplyTuningSettings().\n
+		//! Compare the lookaside and cache counters of GetStatistics() to find the best settings for a workload.
+		struct TuningSettings
+		{
+			//! Constructor.
+			//! @param profile		Profile which provides the values
+			TuningSettings(TuningProfile profile = PROFILE_DEFAULT);
+
+			//! Size of a lookaside slot in bytes; 0 disables the lookaside memory
+			int lookasideSlotSize;
+			//! Number of lookaside slots
+			int lookasideSlotCount;
+			//! Page cache size; positive values are pages, negative values are kilobytes
+			int64 cacheSize;
+			//! Storage of temporary tables and indices
+			TempStore tempStore;
+		};
+
+		//! Retry policy for locked databases (SQLITE_BUSY) which is used by SetBusyRetryPolicy().\n
+		//! A busy connection sleeps initialBackoff milliseconds before it retries; the time is doubled for every\n
+		//! further retry up to maxBackoff. A random part of the sleep time (jitter) prevents that competing\n
+		//! processes retry at the same time.
+		struct BusyRetryPolicy
+		{
+			BusyRetryPolicy():
+				timeout(5000),
+				initialBackoff(1),
+				maxBackoff(100),
+				maxAttempts(0),
+				jitter(0.5)
+			{}
+
+			//! Maximum time in milliseconds which is waited for a lock; 0 = no limit
+			unsigned int timeout;
+			//! Sleep time in milliseconds before the first retry
+			unsigned int initialBackoff;
+			//! Maximum sleep time in milliseconds between two retries
+			unsigned int maxBackoff;
+			//! Maximum number of retries; 0 = no limit
+			unsigned int maxAttempts;
+			//! Part of the sleep time which is randomized (0.0 - 1.0)
+			double jitter;
+		};
+
+		//! Counters of the busy retry policy.
+		struct BusyStatistics
+		{
+			//! Number of operations which found the database locked
+			uint64 busyWaits;
+			//! Number of retries
+			uint64 retries;
+			//! Number of operations which gave up and returned SQLITE_BUSY
+			uint64 failures;
+			//! Total time in seconds spent waiting for locks
+			double blockedSeconds;
+		};
+
 		//! Default constructor.\n
 		//! Closes automatically the connection to a SQLite database file.
 		SQLiteDatabase();
@@ -132,6 +252,14 @@ namespace Kompex
 		//! @param filename		Database filename (UTF-16)
 		void Open(const wchar_t *filename);
 
+		//! Opens a connection to a SQLite database file and applies the given journal settings.\n
+		//! Shut down existing database handle, if one exist.
+		//! @param filename		Database filename (UTF-8)
+		//! @param flags		Flags (see Open())
+		//! @param zVfs			Name of VFS module to use; NULL for default
+		//! @param settings		Journal settings
+		void Open(const std::string &filename, int flags, const char *zVfs, const JournalSettings &settings);
+
 		//! Closes a connection to a SQLite database file.
 		void Close();
 
@@ -168,6 +296,23 @@ namespace Kompex
 		//! Output: std::cout
 		inline void ActivateProfiling() const {sqlite3_profile(mDatabaseHandle, &Kompex::SQLiteDatabase::ProfileOutput, 0);}
 
+		//! Callback function which receives the SQL statements for ActivateTracing().\n
+		//! userData: pointer which was passed to ActivateTracing()\n
+		//! sql: UTF-8 rendering of the SQL statement text
+		typedef void (*TraceHandler)(void *userData, const char *sql);
+		//! Passes every SQL statement to the given callback function when it begins executing.
+		//! @param handler		Callback function
+		//! @param userData		Pointer which is passed to the callback function
+		inline void ActivateTracing(TraceHandler handler, void *userData) const {sqlite3_trace(mDatabaseHandle, handler, userData);}
+		//! Stops the tracing.
+		inline void DeactivateTracing() const {sqlite3_trace(mDatabaseHandle, 0, 0);}
+		//! Passes the execution time of every SQL statement to the given profiler.\n
+		//! One profiler can be used by several database connections.
+		//! @param profiler		Profiler which collects the execution times
+		void ActivateProfiling(SQLiteProfiler *profiler) const;
+		//! Stops the profiling.
+		inline void DeactivateProfiling() const {sqlite3_profile(mDatabaseHandle, 0, 0);}
+
 		//! The SetSoftHeapLimit() interface places a "soft" limit on the amount of heap memory that may be allocated by SQLite.\n
 		//! If an internal allocation is requested that would exceed the soft heap limit, sqlite3_release_memory()\n
 		//! is invoked one or more times to free up some space before the allocation is performed.\n
@@ -193,9 +338,38 @@ namespace Kompex
 		//!							The value returned by GetMemoryHighwaterMark(true) is the high-water mark prior to the reset. 
 		long long GetMemoryHighwaterMark(bool resetFlag = false) const {return sqlite3_memory_highwater(resetFlag);}
 
+		//! Returns a snapshot of the resource usage of this connection [sqlite3_db_status]\n
+		//! and of the SQLite library [sqlite3_status].\n
+		//! Use SQLiteDatabaseStatistics::Delta() to get the activity between two snapshots.
+		//! @param resetHighwater	Resets the highwater marks after the snapshot was taken.\n
+		//!							The cache and lookaside counters are never reset, so that deltas stay valid.
+		SQLiteDatabaseStatistics GetStatistics(bool resetHighwater = false) const;
+
 		//! Provided encodings for MoveDatabaseToMemory().
 		enum UtfEncoding {UTF8, UTF16};
 
+		//! Callback function which reports the progress of an incremental copy.\n
+		//! remainingPages: pages which still must be copied\n
+		//! pageCount: total number of pages of the source database\n
+		//! userData: pointer which was passed to the copying method
+		typedef void (*BackupProgressHandler)(int remainingPages, int pageCount, void *userData);
+
+		//! Result of an incremental copy.
+		struct BackupStatistics
+		{
+			//! Total number of pages of the source database
+			int pageCount;
+			//! Number of sqlite3_backup_step() calls
+			int steps;
+			//! Number of steps which had to be repeated because the source or destination was locked
+			int busySteps;
+			//! Number of times the copy started again because the source database was changed;\n
+			//! after 3 restarts the remaining pages are copied in one step
+			int restarts;
+			//! Duration of the copy in seconds
+			double seconds;
+		};
+
 		//! Move the whole database into memory.\n
 		//! Please pay attention, that after a call of MoveDatabaseToMemory() all sql statements are executed into memory.\n
 		//! i.e. that all changes will be lost after closing the database!
@@ -203,6 +377,25 @@ namespace Kompex
 		//! @param encoding		Encoding which will be used for moving the data.
 		void MoveDatabaseToMemory(UtfEncoding encoding = UTF8);
 
+		/**
+		Move the whole database into memory by copying the database pages [sqlite3_backup_step].\n
+		In contrast to MoveDatabaseToMemory(UtfEncoding) no SQL statements are replayed, i.e. indices are not rebuilt\n
+		and the content of sqlite_sequence is preserved. The origin database is read in chunks of pagesPerStep pages\n
+		and its read lock is released between the chunks, so that other connections can proceed.\n
+		If another connection changes the origin database during the copy, the copy starts again automatically.\n
+		Please pay attention, that after a call of MoveDatabaseToMemoryIncremental() all sql statements are executed into memory.\n
+		i.e. that all changes will be lost after closing the database!
+
+		@param pagesPerStep		Number of pages which are copied in one step; -1 copies all pages in one step
+		@param sleepTime		Pause in milliseconds between two steps; 0 only yields the processor
+		@param progressHandler	Callback function which is called after every step (optional)
+		@param userData			Pointer which is passed to the callback function
+		@param busyTimeout		Maximum time in milliseconds which the copy waits for a locked database without progress;\n
+								an exception is thrown afterwards. 0 = fail at the first lock
+		@return					Statistics of the copy
+		*/
+		BackupStatistics MoveDatabaseToMemoryIncremental(int pagesPerStep = 256, unsigned int sleepTime = 0, BackupProgressHandler progressHandler = 0, void *userData = 0, unsigned int busyTimeout = 5000);
+
 		//! Takes a snapshot of a database which is located in memory and saves it to a database file.
 		//! @param filename		Filename for the new database file to which the snapshot will be saved.\n
 		//!						When you leave the filename blank, you will overwrite your origin file database.
@@ -211,6 +404,29 @@ namespace Kompex
 		//! @param filename		Filename for the new database file to which the snapshot will be saved.
 		void SaveDatabaseFromMemoryToFile(const wchar_t *filename);
 
+		/**
+		Takes a snapshot of a database which is located in memory and saves it to a database file.\n
+		The pages are copied in chunks of pagesPerStep pages, the memory database is only locked during a chunk.\n
+		Changes which are done by this connection between the chunks are taken into the snapshot automatically.\n
+		The snapshot is written into a temporary file (filename + ".tmp") which replaces the target file\n
+		only after the snapshot was completed, i.e. the target file is never left in a half written state.\n
+		If the origin database file is replaced, it is detached during the swap and attached again afterwards.\n
+		A WAL file of the target is checkpointed and its journal files are removed before the swap,\n
+		i.e. the target file must not be opened by any other connection.\n
+		Hint: this method can only be used for UTF-8 filenames
+
+		@param filename			Filename for the new database file to which the snapshot will be saved.\n
+								When you leave the filename blank, you will overwrite your origin file database.
+		@param pagesPerStep		Number of pages which are copied in one step; -1 copies all pages in one step
+		@param sleepTime		Pause in milliseconds between two steps; 0 only yields the processor
+		@param progressHandler	Callback function which is called after every step (optional)
+		@param userData			Pointer which is passed to the callback function
+		@param busyTimeout		Maximum time in milliseconds which the copy waits for a locked database without progress;\n
+								an exception is thrown afterwards. 0 = fail at the first lock
+		@return					Statistics of the snapshot
+		*/
+		BackupStatistics SaveDatabaseFromMemoryToFileIncremental(const std::string &filename = "", int pagesPerStep = 256, unsigned int sleepTime = 10, BackupProgressHandler progressHandler = 0, void *userData = 0, unsigned int busyTimeout = 5000);
+
 		//! This function returns the rowid of the most recent successful INSERT into the database.\n
 		//! If no successful INSERTs have ever occurred on that database connection, zero is returned.\n\n
 		//! What is the rowid?\n
@@ -227,6 +443,85 @@ namespace Kompex
 		//! This function attempts to free as much heap memory as possible from the database connection.
 		inline void ReleaseMemory() {sqlite3_db_release_memory(mDatabaseHandle);}
 
+		//! Applies journal mode, synchronization level, automatic checkpoints and journal size limit.
+		//! @param settings		Journal settings
+		void ApplyJournalSettings(const JournalSettings &settings);
+		//! Sets the journal mode of the main database [PRAGMA journal_mode].\n
+		//! Throws an exception if the journal mode could not be changed (e.g. WAL for a memory database).
+		//! @param mode			Journal mode
+		void SetJournalMode(JournalMode mode);
+		//! Returns the journal mode of the main database.
+		JournalMode GetJournalMode();
+		//! Sets the synchronization level of the main database [PRAGMA synchronous].
+		//! @param mode			Synchronization level
+		void SetSynchronous(SynchronousMode mode);
+		//! Sets the WAL size in pages which triggers an automatic checkpoint when a transaction is committed.\n
+		//! The checkpoint is run by the committing thread. 0 disables the automatic checkpoints. Default: 1000
+		//! @param pages		WAL size in pages
+		void SetWalAutoCheckpoint(int pages);
+		//! Sets the maximum size of a journal or WAL file which is kept after a transaction or checkpoint [PRAGMA journal_size_limit].
+		//! @param bytes		Size limit in bytes; -1 = no limit
+		void SetJournalSizeLimit(int64 bytes);
+
+		//! Applies lookaside memory, page cache size and temp store.\n
+		//! Please note, that the lookaside memory can only be changed while no prepared statement of this connection exists,\n
+		//! therefore the statement cache is cleared. An exception is thrown if other statements are still prepared.
+		//! @param settings		Tuning settings
+		void ApplyTuningSettings(const TuningSettings &settings);
+		//! Applies the settings of a tuning profile, see ApplyTuningSettings().
+		//! @param profile		Tuning profile
+		inline void ApplyTuningProfile(TuningProfile profile) {ApplyTuningSettings(TuningSettings(profile));}
+		//! Sets the lookaside memory of this connection [SQLITE_DBCONFIG_LOOKASIDE].\n
+		//! Small allocations (e.g. of the parser and of prepared statements) are served from these slots instead of the heap.\n
+		//! Throws an exception if lookaside memory is in use, i.e. while prepared statements exist.
+		//! @param slotSize		Size of a slot in bytes (rounded down to a multiple of 8); 0 disables the lookaside memory
+		//! @param slotCount	Number of slots
+		void SetLookaside(int slotSize, int slotCount);
+		//! Sets the size of the page cache of the main database [PRAGMA cache_size].
+		//! @param size			Positive values are pages, negative values are kilobytes
+		void SetCacheSize(int64 size);
+		//! Returns the size of the page cache of the main database [PRAGMA cache_size].
+		//! @return				Positive values are pages, negative values are kilobytes
+		int64 GetCacheSize();
+		//! Sets the storage of temporary tables and indices [PRAGMA temp_store].
+		//! @param tempStore	Storage of temporary data
+		void SetTempStore(TempStore tempStore);
+		//! Sets the maximum number of bytes of the main database which are accessed with memory-mapped I/O [PRAGMA mmap_size].\n
+		//! Pages within the mmap window are read without a copy from the operating system cache, which helps read-mostly\n
+		//! databases. 0 disables memory-mapped I/O. The value is limited by SQLITE_MAX_MMAP_SIZE of the SQLite build.\n
+		//! Throws an exception if the runtime SQLite version is older than 3.7.17.\n
+		//! Use the SQLiteCountingVfs to measure how many pages are served from the mapping.
+		//! @param bytes		Size of the mmap window in bytes
+		void SetMmapSize(int64 bytes);
+		//! Returns the size of the mmap window of the main database in bytes [PRAGMA mmap_size].\n
+		//! 0 if memory-mapped I/O is disabled or not supported by the runtime SQLite version.
+		int64 GetMmapSize();
+
+		//! Preallocates one memory region for the page caches of all connections [SQLITE_CONFIG_PAGECACHE].\n
+		//! Pages are taken from the region as long as it has free slots, afterwards they are allocated from the heap\n
+		//! (see SQLiteDatabaseStatistics::pagecacheUsed and pagecacheOverflow).\n
+		//! This is a global setting: it must be called before SQLite is initialized, i.e. before the first database is\n
+		//! opened, or after sqlite3_shutdown(). Otherwise an exception is thrown.
+		//! @param pageSize		Largest page size of the databases in bytes; the page header is added automatically
+		//! @param pageCount	Number of pages in the region; 0 releases the region
+		static void ConfigurePageCache(int pageSize, int pageCount);
+		//! Preallocates the page cache region of a tuning profile (4 KB pages):\n
+		//! PROFILE_READ_HEAVY 64 MB, PROFILE_BULK_LOAD 256 MB, PROFILE_LOW_MEMORY 512 KB and no region for PROFILE_DEFAULT.
+		//! @param profile		Tuning profile
+		static void ConfigurePageCache(TuningProfile profile);
+
+		/**
+		Runs a checkpoint on a database in WAL mode [sqlite3_wal_checkpoint_v2].
+
+		@param mode					Checkpoint mode
+		@param walFrames			Receives the number of frames in the WAL file (optional)
+		@param checkpointedFrames	Receives the number of frames which were checkpointed (optional)
+		@param databaseName			Name of the attached database; NULL checkpoints all attached databases
+		@return						'true' on success and 'false' if the checkpoint could not be completed\n
+									because of a concurrent reader or writer (SQLITE_BUSY)
+		*/
+		bool WalCheckpoint(CheckpointMode mode = CHECKPOINT_PASSIVE, int *walFrames = 0, int *checkpointedFrames = 0, const char *databaseName = 0);
+
 		/**
 		This method can be used to register a new virtual table module name. Module names must be\n
 		registered before creating a new virtual table using the module and before using a preexisting\n
@@ -243,6 +538,186 @@ namespace Kompex
 		*/
 		void CreateModule(const std::string &moduleName, const sqlite3_module *module, void *clientData, void(*xDestroy)(void*));
 
+		/**
+		Registers a C++ function, function object or lambda as scalar SQL function [sqlite3_create_function_v2].\n
+		The number and types of the SQL arguments and the result type are deduced from the callable; the arguments\n
+		are converted with SQLiteFunctionType (all integral and floating point types, std::string, const char*,\n
+		SQLiteTextView, SQLiteBlobView, SQLiteValue, sqlite3_value*). Use SQLiteTextView and SQLiteBlobView to avoid copies.\n
+		Exceptions of the callable are reported as SQL errors.\n
+		Throws an exception if the number of arguments exceeds the limit of SQLite [SQLITE_LIMIT_FUNCTION_ARG].\n
+		e.g. \n
+		db.CreateFunction("in_range", [](double value, double low, double high) {return value >= low && value <= high;});\n
+		SELECT * FROM measurement WHERE in_range(value, 10.0, 20.0);
+
+		@param name				Name of the SQL function (UTF-8)
+		@param function			Callable; it is copied and destroyed when the function is removed or the connection is closed
+		@param isDeterministic	Does the function always return the same result for the same arguments?\n
+								SQLite can then factor it out of loops and use it in indices [SQLITE_DETERMINISTIC]\n
+								(requires SQLite 3.8.3, ignored with older versions). Only set it for pure functions;\n
+								a function which depends on other state (time, random numbers, locale) returns stale results.
+		*/
+		template<class F>
+		void CreateFunction(const std::string &name, F function, bool isDeterministic = false)
+		{
+			typedef SQLiteScalarFunction<F> Function;
+			RegisterFunction(name, Function::arity, isDeterministic, new F(function), &Function::Call, 0, 0, &Function::Destroy);
+		}
+		/**
+		Registers an aggregate SQL function which is computed by a C++ state class [sqlite3_create_function_v2].\n
+		For every group a copy of the prototype is placement-constructed in the aggregate context of SQLite,\n
+		Step() is called for every row of the group and Final() returns the result; afterwards the state is destroyed.\n
+		The SQL arguments are deduced from Step(), the result type from Final() (see CreateFunction()).\n
+		e.g. \n
+		struct Average \n
+		{ \n
+			Average(): sum(0.0), count(0) {} \n
+			void Step(double value) {sum += value; ++count;} \n
+			double Final() {return count > 0 ? sum / count : 0.0;} \n
+			double sum; int64 count; \n
+		}; \n
+		db.CreateAggregateFunction("average", Average());\n
+		SELECT customer, average(amount) FROM orders GROUP BY customer;
+
+		@param name				Name of the SQL function (UTF-8)
+		@param prototype		Initial state of every group, e.g. with parameters like the k of a top-k aggregate
+		@param isDeterministic	Does the function always return the same result for the same rows? [SQLITE_DETERMINISTIC]
+		*/
+		template<class S>
+		void CreateAggregateFunction(const std::string &name, const S &prototype, bool isDeterministic = false)
+		{
+			typedef SQLiteAggregateFunction<S> Function;
+			RegisterFunction(name, Function::arity, isDeterministic, new S(prototype), 0, &Function::Step, &Function::Final, &Function::Destroy);
+		}
+
+	#if SQLITE_VERSION_NUMBER >= 3025000
+		//! Registers an aggregate SQL function which can also be used as window function [sqlite3_create_window_function].\n
+		//! Requires SQLite 3.25.0. The state class needs Step(), Final(), Inverse() (removes a row which leaves the\n
+		//! window, same arguments as Step()) and Value() const (current result of the window), see CreateAggregateFunction().
+		//! @param name				Name of the SQL function (UTF-8)
+		//! @param prototype		Initial state of every group or window
+		//! @param isDeterministic	Does the function always return the same result for the same rows? [SQLITE_DETERMINISTIC]
+		template<class S>
+		void CreateWindowFunction(const std::string &name, const S &prototype, bool isDeterministic = false)
+		{
+			typedef SQLiteAggregateFunction<S> Function;
+			RegisterWindowFunction(name, Function::arity, isDeterministic, new S(prototype), &Function::Step, &Function::Final,
+				&Function::Value, &Function::Inverse, &Function::Destroy);
+		}
+	#endif
+
+		/**
+		Registers a C++ comparator as collation for UTF-8 texts [sqlite3_create_collation_v2].\n
+		The comparator gets two texts as SQLiteTextView (without a copy) or std::string and returns a negative,\n
+		zero or positive number, or a bool "less than" result. It must define a consistent order.\n
+		e.g. \n
+		db.CreateCollation("natural_order", &SQLiteSortKey::CompareNaturalOrder);\n
+		SELECT name FROM file ORDER BY name COLLATE natural_order;\n
+		Please note, that every comparison calls the comparator; see AddSortKeyColumn() for large sorts.
+
+		@param name				Name of the collation (UTF-8)
+		@param comparator		Callable; it is copied and destroyed when the collation is removed or the connection is closed
+		*/
+		template<class C>
+		void CreateCollation(const std::string &name, C comparator)
+		{
+			typedef SQLiteCollation<C> Collation;
+			RegisterCollation(name, new C(comparator), &Collation::Compare, &Collation::Destroy);
+		}
+		//! Registers a comparator function as collation, see CreateCollation() above.\n
+		//! This overload selects the matching function of an overload set, e.g. &SQLiteSortKey::CompareLocale.
+		//! @param name				Name of the collation (UTF-8)
+		//! @param comparator		Function which compares two texts
+		void CreateCollation(const std::string &name, int (*comparator)(const SQLiteTextView &, const SQLiteTextView &))
+		{
+			CreateCollation<int (*)(const SQLiteTextView &, const SQLiteTextView &)>(name, comparator);
+		}
+		//! Removes a collation which was registered with CreateCollation().
+		//! @param name				Name of the collation (UTF-8)
+		void RemoveCollation(const std::string &name);
+
+		/**
+		Registers a SQL function which returns the binary sort key of a text as BLOB, see AddSortKeyColumn().\n
+		BLOBs are compared with memcmp(), so the key function must produce keys whose byte order is the desired\n
+		order of the texts, e.g. SQLiteSortKey::NaturalOrder() or SQLiteSortKey::Locale(). NULL is mapped to NULL.
+
+		@param name				Name of the SQL function (UTF-8)
+		@param keyFunction		Callable which gets a SQLiteTextView and returns the key as std::string
+		*/
+		template<class K>
+		void CreateSortKeyFunction(const std::string &name, K keyFunction)
+		{
+			CreateFunction(name, [keyFunction](SQLiteTextView text) mutable -> SQLiteValue
+			{
+				if(text.IsNull())
+					return SQLiteValue();
+
+				std::string key = keyFunction(text);
+				return SQLiteValue(SQLiteBlobView(key.data(), static_cast<int>(key.length())));
+			});
+		}
+		//! Registers a sort key function, see CreateSortKeyFunction() above.\n
+		//! This overload selects the matching function of an overload set, e.g. &SQLiteSortKey::Locale.
+		//! @param name				Name of the SQL function (UTF-8)
+		//! @param keyFunction		Function which returns the sort key of a text
+		void CreateSortKeyFunction(const std::string &name, std::string (*keyFunction)(const SQLiteTextView &))
+		{
+			CreateSortKeyFunction<std::string (*)(const SQLiteTextView &)>(name, keyFunction);
+		}
+		/**
+		Adds a column with precomputed sort keys of a text column to a table.\n
+		The sort key column is filled with the sort key function, kept up to date by triggers on INSERT and UPDATE\n
+		and indexed, so that ORDER BY on the sort key column compares with memcmp() or reads the index in order\n
+		instead of calling a collation for every comparison.\n
+		The sort key function (see CreateSortKeyFunction()) must be registered on every connection which writes\n
+		to the table. The table must have a rowid (no WITHOUT ROWID table).\n
+		All changes are made in one savepoint; an exception is thrown if something fails.\n
+		e.g. \n
+		db.CreateSortKeyFunction("natural_key", &SQLiteSortKey::NaturalOrder);\n
+		db.AddSortKeyColumn("file", "name", "name_key", "natural_key");\n
+		SELECT name FROM file ORDER BY name_key;
+
+		@param table			Name of the table
+		@param column			Name of the text column
+		@param sortKeyColumn	Name of the new sort key column
+		@param sortKeyFunction	Name of the SQL function which computes the sort key
+		@param createIndex		Shall an index be created on the sort key column?
+		*/
+		void AddSortKeyColumn(const std::string &table, const std::string &column, const std::string &sortKeyColumn, const std::string &sortKeyFunction, bool createIndex = true);
+
+		//! Removes a SQL function which was registered with CreateFunction().
+		//! @param name				Name of the SQL function (UTF-8)
+		//! @param numberOfArguments	Number of arguments of the function
+		void RemoveFunction(const std::string &name, int numberOfArguments);
+
+		//! Returns the cache which holds the prepared statements of this connection.\n
+		//! The cache is used by SQLiteStatement::SqlCached() and the GetSqlResult%() methods.
+		SQLiteStatementCache &GetStatementCache() {return mStatementCache;}
+		//! Sets the maximum number of prepared statements which are cached for this connection.\n
+		//! 0 disables the statement cache. Default: 32
+		//! @param capacity		Maximum number of cached statements
+		inline void SetStatementCacheCapacity(unsigned int capacity) {mStatementCache.SetCapacity(capacity);}
+
+		//! Sets a timeout in milliseconds which is waited for a locked database before SQLITE_BUSY is returned [sqlite3_busy_timeout].\n
+		//! Replaces the busy retry policy; 0 turns off all busy handling.
+		//! @param timeout		Timeout in milliseconds
+		void SetBusyTimeout(int timeout);
+		//! Activates a busy retry policy with exponential backoff and jitter [sqlite3_busy_handler].\n
+		//! SQLite calls the handler whenever a table is locked, so the policy applies to all statements of this\n
+		//! connection (e.g. SQLiteStatement::Sql(), FetchRow(), BeginTransaction() and CommitTransaction()).\n
+		//! The policy is kept if the connection is re-opened.\n
+		//! Please note, that SQLite returns SQLITE_BUSY without retrying if waiting would cause a deadlock,\n
+		//! e.g. if a read transaction must be upgraded to a write transaction while another connection writes.
+		//! @param policy		Retry policy
+		void SetBusyRetryPolicy(const BusyRetryPolicy &policy);
+		//! Returns the counters of the busy retry policy.
+		BusyStatistics GetBusyStatistics() const;
+		//! Resets the counters of the busy retry policy.
+		void ResetBusyStatistics();
+
+		//! Returns the runtime counters of all statements of this connection per SQL text.\n
+		//! The counters are disabled by default, enable them with GetStatementStatistics().SetEnabled(true).
+		SQLiteStatementStatistics &GetStatementStatistics() {return mStatementStatistics;}
+
 	protected:
 		//! Callback function for ActivateTracing() [sqlite3_trace]
 		static void TraceOutput(void *ptr, const char *sql);
@@ -254,6 +729,30 @@ namespace Kompex
 		static int ProcessDMLRow(void *db, int nColumns, char **values, char **columns);
 		//! Takes and saves a snapshot of the memory database in a file.
 		void TakeSnapshot(sqlite3 *destinationDatabase);
+		//! Executes a PRAGMA statement and returns the first column of the first result row.
+		std::string ExecutePragma(const std::string &pragma);
+		//! Registers a SQL function and checks the number of arguments [sqlite3_create_function_v2].\n
+		//! The destructor is called for the user data if the registration fails.
+		void RegisterFunction(const std::string &name, int numberOfArguments, bool isDeterministic, void *userData,
+			void (*xFunc)(sqlite3_context*, int, sqlite3_value**), void (*xStep)(sqlite3_context*, int, sqlite3_value**),
+			void (*xFinal)(sqlite3_context*), void (*xDestroy)(void*));
+	#if SQLITE_VERSION_NUMBER >= 3025000
+		//! Registers a window function and checks the number of arguments [sqlite3_create_window_function].\n
+		//! The destructor is called for the user data if the registration fails.
+		void RegisterWindowFunction(const std::string &name, int numberOfArguments, bool isDeterministic, void *userData,
+			void (*xStep)(sqlite3_context*, int, sqlite3_value**), void (*xFinal)(sqlite3_context*), void (*xValue)(sqlite3_context*),
+			void (*xInverse)(sqlite3_context*, int, sqlite3_value**), void (*xDestroy)(void*));
+	#endif
+		//! Registers a collation [sqlite3_create_collation_v2].\n
+		//! The destructor is called for the user data if the registration fails.
+		void RegisterCollation(const std::string &name, void *userData, int (*xCompare)(void*, int, const void*, int, const void*), void (*xDestroy)(void*));
+		//! Checks name and number of arguments of a SQL function and returns the flags for the registration.\n
+		//! The destructor is called for the user data if the check fails.
+		int CheckFunctionRegistration(const std::string &name, int numberOfArguments, bool isDeterministic, void *userData, void (*xDestroy)(void*));
+		//! Callback function for SetBusyRetryPolicy() [sqlite3_busy_handler]
+		static int BusyRetryHandler(void *ptr, int numberOfCalls);
+		//! Copies all pages of a backup in chunks of pagesPerStep pages and finishes the backup.
+		static BackupStatistics RunIncrementalBackup(sqlite3_backup *backup, sqlite3 *destinationDatabase, int pagesPerStep, unsigned int sleepTime, BackupProgressHandler progressHandler, void *userData, unsigned int busyTimeout);
 
 	private:
 		//! SQLite db handle
@@ -264,7 +763,35 @@ namespace Kompex
 		std::wstring mDatabaseFilenameUtf16;
 		//! Is the database currently stored in memory?
 		bool mIsMemoryDatabaseActive;
-
+		//! Cache for prepared statements
+		SQLiteStatementCache mStatementCache;
+		//! Runtime counters of the statements
+		SQLiteStatementStatistics mStatementStatistics;
+		//! Busy retry policy
+		BusyRetryPolicy mBusyRetryPolicy;
+		//! Is the busy retry policy active?
+		bool mIsBusyRetryPolicyActive;
+		//! Busy timeout which is used instead of the busy retry policy
+		int mBusyTimeout;
+		//! Start of the current wait for a lock
+		std::chrono::steady_clock::time_point mBusyWaitStartTime;
+		//! Random numbers for the jitter
+		std::minstd_rand mBusyRandomGenerator;
+		//! Counters of the busy retry policy (see BusyStatistics)
+		std::atomic<uint64> mBusyWaits;
+		std::atomic<uint64> mBusyRetries;
+		std::atomic<uint64> mBusyFailures;
+		std::atomic<uint64> mBusyBlockedTime;
+
+		//! Initializes the members; shared by all constructors.
+		void Init();
+		//! Installs the busy handling on the current database handle.
+		void ApplyBusyHandling();
+		//! Replaces the target file with the source file (atomically where the file system supports it).\n
+		//! Beforehand the target is checkpointed and its journal files are removed, afterwards the directory is synced.
+		static void SwapDatabaseFile(const std::string &sourceFilename, const std::string &targetFilename);
+		//! Attaches the origin database file as 'origin' to the memory database.
+		void AttachOriginDatabase(sqlite3 *memoryDatabase);
 		//! Clean up routine if something failed in MoveDatabaseToMemory() 
 		void CleanUpFailedMemoryDatabase(sqlite3 *memoryDatabase, sqlite3 *rollbackDatabase, bool isDetachNecessary, bool isRollbackNecessary, sqlite3_stmt *stmt, const std::string &errMsg);
 
@@ -0,0 +1,119 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteDatabaseStatistics_H
+#define KompexSQLiteDatabaseStatistics_H
+
+#include <string>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+
+namespace Kompex
+{
+	//! Current value and highest value of a status parameter.
+	struct SQLiteStatusValue
+	{
+		SQLiteStatusValue(): current(0), highwater(0) {}
+
+		//! Current value
+		int64 current;
+		//! Highest value since the highwater mark was reset
+		int64 highwater;
+	};
+
+	//! Snapshot of the resource usage of a database connection [sqlite3_db_status]\n
+	//! and of the SQLite library [sqlite3_status].\n
+	//! Counters (hits, misses, writes) grow monotonically, so that the difference of two snapshots\n
+	//! (see Delta()) shows the activity between them. Gauges (used memory etc.) show the state at the time of the snapshot.
+	struct _SQLiteWrapperExport SQLiteDatabaseStatistics
+	{
+		SQLiteDatabaseStatistics();
+
+		//! Wall clock time of the snapshot (seconds since 1970-01-01)
+		double timestamp;
+		//! Seconds between the two snapshots of a delta; 0 for a single snapshot
+		double interval;
+
+		// connection counters
+
+		//! Page cache hits [SQLITE_DBSTATUS_CACHE_HIT]
+		int64 cacheHits;
+		//! Page cache misses [SQLITE_DBSTATUS_CACHE_MISS]
+		int64 cacheMisses;
+		//! Dirty pages written to the database file [SQLITE_DBSTATUS_CACHE_WRITE]
+		int64 cacheWrites;
+		//! Memory requests which were satisfied from lookaside memory [SQLITE_DBSTATUS_LOOKASIDE_HIT]
+		int64 lookasideHits;
+		//! Memory requests which were too large for lookaside memory [SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE]
+		int64 lookasideMissSize;
+		//! Memory requests which failed because all lookaside memory was in use [SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL]
+		int64 lookasideMissFull;
+
+		// connection gauges
+
+		//! Lookaside memory slots in use [SQLITE_DBSTATUS_LOOKASIDE_USED]
+		SQLiteStatusValue lookasideUsed;
+		//! Heap memory in bytes used by the page cache [SQLITE_DBSTATUS_CACHE_USED]
+		int64 cacheUsed;
+		//! Heap memory in bytes used to store the schema [SQLITE_DBSTATUS_SCHEMA_USED]
+		int64 schemaUsed;
+		//! Heap and lookaside memory in bytes used by all prepared statements [SQLITE_DBSTATUS_STMT_USED]
+		int64 statementUsed;
+
+		// library gauges (shared by all connections)
+
+		//! Memory in bytes which is checked out by the SQLite memory allocator [SQLITE_STATUS_MEMORY_USED]
+		SQLiteStatusValue memoryUsed;
+		//! Largest memory allocation in bytes [SQLITE_STATUS_MALLOC_SIZE]
+		SQLiteStatusValue mallocSize;
+		//! Number of separate memory allocations [SQLITE_STATUS_MALLOC_COUNT]
+		SQLiteStatusValue mallocCount;
+		//! Pages which are used out of the page cache memory of SQLITE_CONFIG_PAGECACHE [SQLITE_STATUS_PAGECACHE_USED]
+		SQLiteStatusValue pagecacheUsed;
+		//! Bytes of page cache allocations which did not fit into SQLITE_CONFIG_PAGECACHE [SQLITE_STATUS_PAGECACHE_OVERFLOW]
+		SQLiteStatusValue pagecacheOverflow;
+		//! Largest page cache allocation in bytes [SQLITE_STATUS_PAGECACHE_SIZE]
+		SQLiteStatusValue pagecacheSize;
+		//! Scratch memory allocations which are checked out [SQLITE_STATUS_SCRATCH_USED]
+		SQLiteStatusValue scratchUsed;
+		//! Bytes of scratch allocations which did not fit into SQLITE_CONFIG_SCRATCH [SQLITE_STATUS_SCRATCH_OVERFLOW]
+		SQLiteStatusValue scratchOverflow;
+		//! Largest scratch allocation in bytes [SQLITE_STATUS_SCRATCH_SIZE]
+		SQLiteStatusValue scratchSize;
+		//! Deepest parser stack [SQLITE_STATUS_PARSER_STACK]
+		SQLiteStatusValue parserStack;
+
+		//! Returns the page cache hit ratio (0.0 - 1.0).
+		double GetCacheHitRatio() const;
+		//! Returns the part of the memory requests which were satisfied from lookaside memory (0.0 - 1.0).
+		double GetLookasideHitRatio() const;
+
+		//! Returns the activity between an earlier snapshot and this snapshot.\n
+		//! The counters contain the differences, the gauges the values of this snapshot.
+		//! @param earlier		Snapshot which was taken before this snapshot
+		SQLiteDatabaseStatistics Delta(const SQLiteDatabaseStatistics &earlier) const;
+
+		//! Returns the snapshot as JSON object, e.g. for a metrics pipeline.\n
+		//! Counters and single gauges are numbers, gauges with highwater mark are objects {"current": x, "highwater": y}.
+		std::string ToJson() const;
+	};
+};
+
+#endif // KompexSQLiteDatabaseStatistics_H
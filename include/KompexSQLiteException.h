@@ -57,6 +57,8 @@ namespace Kompex
 			strStream << "file: " << mFilename << "\nline: " << mLine << "\nerror: " << std::string(mErrorDescription) << "\n";
 			return strStream.str();
 		}
+		//! Get the error description
+		const std::string &GetErrorDescription() const {return mErrorDescription;}
 
 	private:
 		//! Error description
@@ -0,0 +1,561 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteFunction_H
+#define KompexSQLiteFunction_H
+
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteException.h"
+#include "KompexSQLiteValue.h"
+#include "KompexSQLiteView.h"
+
+namespace Kompex
+{
+	//! Conversion between SQLite values and C++ types for user-defined functions.\n
+	//! FromValue() reads a function argument with the matching sqlite3_value_%() function (SQLite applies its\n
+	//! usual type conversions, e.g. NULL becomes 0), ToResult() sets the function result with sqlite3_result_%().\n
+	//! Specialize the template to support further types (the second parameter is only used for the integral\n
+	//! and floating point types below).
+	template<class T, class Enable = void>
+	struct SQLiteFunctionType;
+
+	template<>
+	struct SQLiteFunctionType<int>
+	{
+		static int FromValue(sqlite3_value *value) {return sqlite3_value_int(value);}
+		static void ToResult(sqlite3_context *context, int result) {sqlite3_result_int(context, result);}
+	};
+
+	template<>
+	struct SQLiteFunctionType<int64>
+	{
+		static int64 FromValue(sqlite3_value *value) {return sqlite3_value_int64(value);}
+		static void ToResult(sqlite3_context *context, int64 result) {sqlite3_result_int64(context, result);}
+	};
+
+	template<>
+	struct SQLiteFunctionType<bool>
+	{
+		static bool FromValue(sqlite3_value *value) {return sqlite3_value_int64(value) != 0;}
+		static void ToResult(sqlite3_context *context, bool result) {sqlite3_result_int(context, result ? 1 : 0);}
+	};
+
+	template<>
+	struct SQLiteFunctionType<double>
+	{
+		static double FromValue(sqlite3_value *value) {return sqlite3_value_double(value);}
+		static void ToResult(sqlite3_context *context, double result) {sqlite3_result_double(context, result);}
+	};
+
+	//! All other integral types (e.g. long, unsigned int, size_t) are converted from and to a 64-bit integer;\n
+	//! unsigned values above the range of int64 are wrapped.
+	template<class T>
+	struct SQLiteFunctionType<T, typename std::enable_if<std::is_integral<T>::value>::type>
+	{
+		static T FromValue(sqlite3_value *value) {return static_cast<T>(sqlite3_value_int64(value));}
+		static void ToResult(sqlite3_context *context, T result) {sqlite3_result_int64(context, static_cast<int64>(result));}
+	};
+
+	//! All other floating point types (float, long double) are converted from and to a double.
+	template<class T>
+	struct SQLiteFunctionType<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+	{
+		static T FromValue(sqlite3_value *value) {return static_cast<T>(sqlite3_value_double(value));}
+		static void ToResult(sqlite3_context *context, T result) {sqlite3_result_double(context, static_cast<double>(result));}
+	};
+
+	//! Copies the text; prefer SQLiteTextView for arguments.
+	template<>
+	struct SQLiteFunctionType<std::string>
+	{
+		static std::string FromValue(sqlite3_value *value)
+		{
+			const char *text = reinterpret_cast<const char*>(sqlite3_value_text(value));
+			return text ? std::string(text, sqlite3_value_bytes(value)) : std::string();
+		}
+		static void ToResult(sqlite3_context *context, const std::string &result)
+		{
+			sqlite3_result_text(context, result.c_str(), static_cast<int>(result.length()), SQLITE_TRANSIENT);
+		}
+	};
+
+	//! Returns a null pointer for NULL values.
+	template<>
+	struct SQLiteFunctionType<const char*>
+	{
+		static const char *FromValue(sqlite3_value *value) {return reinterpret_cast<const char*>(sqlite3_value_text(value));}
+		static void ToResult(sqlite3_context *context, const char *result)
+		{
+			if(result)
+				sqlite3_result_text(context, result, -1, SQLITE_TRANSIENT);
+			else
+				sqlite3_result_null(context);
+		}
+	};
+
+	//! Text argument without a copy; the view is valid until the function returns.
+	template<>
+	struct SQLiteFunctionType<SQLiteTextView>
+	{
+		static SQLiteTextView FromValue(sqlite3_value *value)
+		{
+			const char *text = reinterpret_cast<const char*>(sqlite3_value_text(value));
+			return SQLiteTextView(text, text ? sqlite3_value_bytes(value) : 0);
+		}
+		static void ToResult(sqlite3_context *context, const SQLiteTextView &result)
+		{
+			if(result.IsNull())
+				sqlite3_result_null(context);
+			else
+				sqlite3_result_text(context, result.data, result.length, SQLITE_TRANSIENT);
+		}
+	};
+
+	//! BLOB argument without a copy; the view is valid until the function returns.
+	template<>
+	struct SQLiteFunctionType<SQLiteBlobView>
+	{
+		static SQLiteBlobView FromValue(sqlite3_value *value)
+		{
+			const void *blob = sqlite3_value_blob(value);
+			return SQLiteBlobView(blob, blob ? sqlite3_value_bytes(value) : 0);
+		}
+		static void ToResult(sqlite3_context *context, const SQLiteBlobView &result)
+		{
+			sqlite3_result_blob(context, result.data, result.bytes, SQLITE_TRANSIENT);
+		}
+	};
+
+	//! Argument or result with any type including NULL.
+	template<>
+	struct SQLiteFunctionType<SQLiteValue>
+	{
+		static SQLiteValue FromValue(sqlite3_value *value)
+		{
+			switch(sqlite3_value_type(value))
+			{
+				case SQLITE_INTEGER:
+					return SQLiteValue(static_cast<int64>(sqlite3_value_int64(value)));
+				case SQLITE_FLOAT:
+					return SQLiteValue(sqlite3_value_double(value));
+				case SQLITE_TEXT:
+					return SQLiteValue(SQLiteFunctionType<SQLiteTextView>::FromValue(value));
+				case SQLITE_BLOB:
+					return SQLiteValue(SQLiteFunctionType<SQLiteBlobView>::FromValue(value));
+				default:
+					return SQLiteValue();
+			}
+		}
+		static void ToResult(sqlite3_context *context, const SQLiteValue &result)
+		{
+			switch(result.GetType())
+			{
+				case SQLITE_INTEGER:
+					sqlite3_result_int64(context, result.GetInt64());
+					break;
+				case SQLITE_FLOAT:
+					sqlite3_result_double(context, result.GetDouble());
+					break;
+				case SQLITE_TEXT:
+					sqlite3_result_text(context, result.GetData().c_str(), static_cast<int>(result.GetData().length()), SQLITE_TRANSIENT);
+					break;
+				case SQLITE_BLOB:
+					sqlite3_result_blob(context, result.GetData().data(), static_cast<int>(result.GetData().length()), SQLITE_TRANSIENT);
+					break;
+				default:
+					sqlite3_result_null(context);
+			}
+		}
+	};
+
+	//! Raw argument, e.g. to check sqlite3_value_type() for NULL.
+	template<>
+	struct SQLiteFunctionType<sqlite3_value*>
+	{
+		static sqlite3_value *FromValue(sqlite3_value *value) {return value;}
+		static void ToResult(sqlite3_context *context, sqlite3_value *result) {sqlite3_result_value(context, result);}
+	};
+
+	//! Compile-time list of argument indices.
+	template<size_t... I>
+	struct SQLiteIndexSequence
+	{
+	};
+
+	//! Creates SQLiteIndexSequence<0, 1, ..., N - 1>.
+	template<size_t N, size_t... I>
+	struct SQLiteMakeIndexSequence: SQLiteMakeIndexSequence<N - 1, N - 1, I...>
+	{
+	};
+
+	template<size_t... I>
+	struct SQLiteMakeIndexSequence<0, I...>
+	{
+		typedef SQLiteIndexSequence<I...> Type;
+	};
+
+	//! Deduces the result and argument types of a function pointer, function object or lambda.
+	template<class F>
+	struct SQLiteCallableTraits: SQLiteCallableTraits<decltype(&F::operator())>
+	{
+	};
+
+	template<class R, class... A>
+	struct SQLiteCallableTraits<R(*)(A...)>
+	{
+		//! Result type
+		typedef R ResultType;
+		//! Argument types without references and const
+		typedef std::tuple<typename std::decay<A>::type...> ArgumentTypes;
+		//! Number of arguments
+		static const int arity = sizeof...(A);
+	};
+
+	template<class C, class R, class... A>
+	struct SQLiteCallableTraits<R(C::*)(A...)>: SQLiteCallableTraits<R(*)(A...)>
+	{
+	};
+
+	template<class C, class R, class... A>
+	struct SQLiteCallableTraits<R(C::*)(A...) const>: SQLiteCallableTraits<R(*)(A...)>
+	{
+	};
+
+	//! Calls a function and sets its result (return type void is handled separately).
+	template<class R>
+	struct SQLiteFunctionCaller
+	{
+		template<class F, class... A>
+		static void Call(sqlite3_context *context, F &function, A&&... arguments)
+		{
+			SQLiteFunctionType<typename std::decay<R>::type>::ToResult(context, function(std::forward<A>(arguments)...));
+		}
+	};
+
+	template<>
+	struct SQLiteFunctionCaller<void>
+	{
+		template<class F, class... A>
+		static void Call(sqlite3_context *context, F &function, A&&... arguments)
+		{
+			function(std::forward<A>(arguments)...);
+			sqlite3_result_null(context);
+		}
+	};
+
+	//! Reports the currently handled exception of a user-defined function as SQL error.
+	inline void SetFunctionError(sqlite3_context *context)
+	{
+		try
+		{
+			throw;
+		}
+		catch(SQLiteException &exception)
+		{
+			sqlite3_result_error(context, exception.GetErrorDescription().c_str(), -1);
+		}
+		catch(std::bad_alloc&)
+		{
+			sqlite3_result_error_nomem(context);
+		}
+		catch(std::exception &exception)
+		{
+			sqlite3_result_error(context, exception.what(), -1);
+		}
+		catch(...)
+		{
+			sqlite3_result_error(context, "unknown exception in user-defined function", -1);
+		}
+	}
+
+	//! Trampolines of a scalar user-defined function, see SQLiteDatabase::CreateFunction().\n
+	//! The function object is stored as user data of the SQL function.
+	template<class F>
+	class SQLiteScalarFunction
+	{
+	public:
+		typedef SQLiteCallableTraits<F> Traits;
+		typedef typename Traits::ArgumentTypes ArgumentTypes;
+
+		//! Number of arguments
+		static const int arity = Traits::arity;
+
+		//! Callback function for the SQL function [sqlite3_create_function_v2: xFunc]
+		static void Call(sqlite3_context *context, int, sqlite3_value **argv)
+		{
+			try
+			{
+				Invoke(context, *static_cast<F*>(sqlite3_user_data(context)), argv, typename SQLiteMakeIndexSequence<Traits::arity>::Type());
+			}
+			catch(...)
+			{
+				SetFunctionError(context);
+			}
+		}
+
+		//! Deletes the function object [sqlite3_create_function_v2: xDestroy]
+		static void Destroy(void *function)
+		{
+			delete static_cast<F*>(function);
+		}
+
+	private:
+		template<size_t... I>
+		static void Invoke(sqlite3_context *context, F &function, sqlite3_value **argv, SQLiteIndexSequence<I...>)
+		{
+			SQLiteFunctionCaller<typename Traits::ResultType>::Call(context, function,
+				SQLiteFunctionType<typename std::tuple_element<I, ArgumentTypes>::type>::FromValue(argv[I])...);
+		}
+	};
+
+	//! Trampolines of an aggregate user-defined function with a state class S, see SQLiteDatabase::CreateAggregateFunction().\n
+	//! One S object per group is placement-constructed in the aggregate context of SQLite [sqlite3_aggregate_context]\n
+	//! as copy of the prototype which is stored as user data, so no separate heap allocation is necessary.\n
+	//! S must provide Step(...) with the SQL arguments and Final() with the result; window functions additionally need\n
+	//! Inverse(...) with the same arguments as Step(...) and Value() const.
+	template<class S>
+	class SQLiteAggregateFunction
+	{
+	public:
+		typedef SQLiteCallableTraits<decltype(&S::Step)> StepTraits;
+		typedef typename StepTraits::ArgumentTypes ArgumentTypes;
+
+		//! Number of arguments
+		static const int arity = StepTraits::arity;
+
+		//! Adds a row to the state of the group [sqlite3_create_function_v2: xStep]
+		static void Step(sqlite3_context *context, int, sqlite3_value **argv)
+		{
+			try
+			{
+				S *state = GetState(context);
+				if(state)
+					InvokeStep(*state, argv, typename SQLiteMakeIndexSequence<StepTraits::arity>::Type());
+				else
+					sqlite3_result_error_nomem(context);
+			}
+			catch(...)
+			{
+				SetFunctionError(context);
+			}
+		}
+
+		//! Sets the result of the group and destroys the state [sqlite3_create_function_v2: xFinal]\n
+		//! SQLite calls it also if the query was aborted, so the state is always destroyed.
+		static void Final(sqlite3_context *context)
+		{
+			Storage *storage = static_cast<Storage*>(sqlite3_aggregate_context(context, 0));
+			try
+			{
+				if(storage && storage->isConstructed)
+				{
+					S &state = storage->GetState();
+					SetResult(context, state);
+				}
+				else
+				{
+					// empty group
+					S state(GetPrototype(context));
+					SetResult(context, state);
+				}
+			}
+			catch(...)
+			{
+				SetFunctionError(context);
+			}
+
+			if(storage && storage->isConstructed)
+			{
+				storage->GetState().~S();
+				storage->isConstructed = false;
+			}
+		}
+
+		//! Deletes the prototype [sqlite3_create_function_v2: xDestroy]
+		static void Destroy(void *prototype)
+		{
+			delete static_cast<S*>(prototype);
+		}
+
+	#if SQLITE_VERSION_NUMBER >= 3025000
+		//! Sets the current result of the window [sqlite3_create_window_function: xValue]
+		static void Value(sqlite3_context *context)
+		{
+			try
+			{
+				S *state = GetState(context);
+				if(state)
+					SetValue(context, *state);
+				else
+					sqlite3_result_error_nomem(context);
+			}
+			catch(...)
+			{
+				SetFunctionError(context);
+			}
+		}
+
+		//! Removes a row from the state of the window [sqlite3_create_window_function: xInverse]
+		static void Inverse(sqlite3_context *context, int, sqlite3_value **argv)
+		{
+			try
+			{
+				S *state = GetState(context);
+				if(state)
+					InvokeInverse(*state, argv, typename SQLiteMakeIndexSequence<StepTraits::arity>::Type());
+				else
+					sqlite3_result_error_nomem(context);
+			}
+			catch(...)
+			{
+				SetFunctionError(context);
+			}
+		}
+	#endif
+
+	private:
+		// the memory of sqlite3_aggregate_context() is 8 byte aligned
+		static_assert(std::alignment_of<S>::value <= 8, "the state class must not require an alignment of more than 8 bytes");
+
+		//! Memory in the aggregate context; SQLite initializes it with zeros
+		struct Storage
+		{
+			typename std::aligned_storage<sizeof(S), std::alignment_of<S>::value>::type state;
+			bool isConstructed;
+
+			S &GetState() {return *reinterpret_cast<S*>(&state);}
+		};
+
+		static const S &GetPrototype(sqlite3_context *context)
+		{
+			return *static_cast<const S*>(sqlite3_user_data(context));
+		}
+
+		//! Returns the state of the group and constructs it with the first row.
+		static S *GetState(sqlite3_context *context)
+		{
+			Storage *storage = static_cast<Storage*>(sqlite3_aggregate_context(context, sizeof(Storage)));
+			if(!storage)
+				return 0;
+
+			if(!storage->isConstructed)
+			{
+				new(&storage->state) S(GetPrototype(context));
+				storage->isConstructed = true;
+			}
+			return &storage->GetState();
+		}
+
+		static void SetResult(sqlite3_context *context, S &state)
+		{
+			auto finalCall = [&state]() -> decltype(state.Final()) {return state.Final();};
+			SQLiteFunctionCaller<decltype(state.Final())>::Call(context, finalCall);
+		}
+
+		template<size_t... I>
+		static void InvokeStep(S &state, sqlite3_value **argv, SQLiteIndexSequence<I...>)
+		{
+			state.Step(SQLiteFunctionType<typename std::tuple_element<I, ArgumentTypes>::type>::FromValue(argv[I])...);
+		}
+
+	#if SQLITE_VERSION_NUMBER >= 3025000
+		static void SetValue(sqlite3_context *context, const S &state)
+		{
+			auto valueCall = [&state]() -> decltype(state.Value()) {return state.Value();};
+			SQLiteFunctionCaller<decltype(state.Value())>::Call(context, valueCall);
+		}
+
+		template<size_t... I>
+		static void InvokeInverse(S &state, sqlite3_value **argv, SQLiteIndexSequence<I...>)
+		{
+			state.Inverse(SQLiteFunctionType<typename std::tuple_element<I, ArgumentTypes>::type>::FromValue(argv[I])...);
+		}
+	#endif
+	};
+
+	//! Converts the result of a comparator to -1, 0 or 1 (a bool result is handled as "less than").
+	template<class R>
+	struct SQLiteCollationResult
+	{
+		template<class C, class A>
+		static int Compare(C &comparator, const A &text1, const A &text2)
+		{
+			R result = comparator(text1, text2);
+			return result < 0 ? -1 : (result > 0 ? 1 : 0);
+		}
+	};
+
+	template<>
+	struct SQLiteCollationResult<bool>
+	{
+		template<class C, class A>
+		static int Compare(C &comparator, const A &text1, const A &text2)
+		{
+			if(comparator(text1, text2))
+				return -1;
+			return comparator(text2, text1) ? 1 : 0;
+		}
+	};
+
+	//! Trampolines of a collation, see SQLiteDatabase::CreateCollation().\n
+	//! The comparator gets two texts as SQLiteTextView (without a copy) or std::string and returns\n
+	//! a negative, zero or positive number or a bool "less than" result.
+	template<class C>
+	class SQLiteCollation
+	{
+	public:
+		typedef SQLiteCallableTraits<C> Traits;
+		typedef typename std::tuple_element<0, typename Traits::ArgumentTypes>::type ArgumentType;
+
+		static_assert(Traits::arity == 2, "a comparator needs two arguments");
+
+		//! Compares two UTF-8 texts [sqlite3_create_collation_v2: xCompare]\n
+		//! A collation can't report errors, therefore an exception of the comparator is handled as equality.
+		static int Compare(void *comparator, int length1, const void *text1, int length2, const void *text2)
+		{
+			try
+			{
+				ArgumentType argument1(static_cast<const char*>(text1), length1);
+				ArgumentType argument2(static_cast<const char*>(text2), length2);
+				return SQLiteCollationResult<typename std::decay<typename Traits::ResultType>::type>::Compare(*static_cast<C*>(comparator), argument1, argument2);
+			}
+			catch(...)
+			{
+				return 0;
+			}
+		}
+
+		//! Deletes the comparator [sqlite3_create_collation_v2: xDestroy]
+		static void Destroy(void *comparator)
+		{
+			delete static_cast<C*>(comparator);
+		}
+	};
+};
+
+#endif // KompexSQLiteFunction_H
@@ -0,0 +1,183 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteGroupCommitWriter_H
+#define KompexSQLiteGroupCommitWriter_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteLatencyHistogram.h"
+#include "KompexSQLiteValue.h"
+
+namespace Kompex
+{
+	class SQLiteDatabase;
+
+	//! Statistics of a SQLiteGroupCommitWriter.
+	struct SQLiteGroupCommitStatistics
+	{
+		//! Number of committed batches
+		uint64 batches;
+		//! Number of batches which could not be committed
+		uint64 failedBatches;
+		//! Number of executed requests
+		uint64 requests;
+		//! Number of requests which failed (including the requests of failed batches)
+		uint64 failedRequests;
+		//! Number of requests per batch
+		SQLiteLatencyHistogram batchSizes;
+		//! Duration of the COMMIT statement (i.e. mostly of the journal sync) of the committed batches in microseconds
+		SQLiteLatencyHistogram commitLatencies;
+		//! Time from the submission of a request until its batch was committed in microseconds
+		SQLiteLatencyHistogram requestLatencies;
+	};
+
+	//! Collects write statements of many threads and commits them together (group commit).\n
+	//! Every submitted statement is queued; a single writer thread takes all queued statements\n
+	//! (up to maxBatchSize) and executes them in one transaction, so that many small writes share one\n
+	//! journal sync instead of paying one sync each in autocommit mode. Every statement runs in its own\n
+	//! savepoint, so that a failing statement (e.g. a constraint violation) fails only its own request.\n
+	//! Submit() returns a future which becomes ready when the batch was committed; a failure is reported\n
+	//! as SQLiteException by future::get().\n
+	//! Please note, that a commit is only durable against power failures with synchronous=FULL\n
+	//! (with synchronous=NORMAL in WAL mode, the last transactions may be lost).\n
+	//! The connection must not be used by other threads while the writer exists.\n
+	//! e.g. \n
+	//! SQLiteGroupCommitWriter writer(&db);\n
+	//! std::future<void> result = writer.SubmitStatement("INSERT INTO log (time, text) VALUES (?, ?)", time, text);\n
+	//! result.get();
+	class _SQLiteWrapperExport SQLiteGroupCommitWriter
+	{
+	public:
+		/**
+		Constructor.\n
+		Starts the writer thread.
+
+		@param db				Connection which is used by the writer thread
+		@param maxBatchSize		Maximum number of statements per transaction
+		@param maxBatchDelay	Time in microseconds which the writer waits for further statements after the first\n
+								statement of a batch was queued; 0 commits whatever is queued when the writer is free.\n
+								A short delay increases the batch size when there are only a few concurrent writers.
+		*/
+		SQLiteGroupCommitWriter(SQLiteDatabase *db, unsigned int maxBatchSize = 512, unsigned int maxBatchDelay = 0);
+		//! Destructor.\n
+		//! Commits the queued statements and stops the writer thread.
+		virtual ~SQLiteGroupCommitWriter();
+
+		//! Queues a SQL statement without parameters.
+		//! @param sql				SQL statement (UTF-8)
+		//! @return					Future which becomes ready when the statement was committed
+		std::future<void> Submit(const std::string &sql);
+		//! Queues a SQL statement with parameters.
+		//! @param sql				SQL statement (UTF-8)
+		//! @param parameters		Values for the SQL parameters; the first value is bound to the first parameter
+		//! @return					Future which becomes ready when the statement was committed
+		std::future<void> Submit(const std::string &sql, const std::vector<SQLiteValue> &parameters);
+		//! Queues a SQL statement with parameters.
+		//! @param sql				SQL statement (UTF-8)
+		//! @param parameters		Values for the SQL parameters; the first value is bound to the first parameter
+		//! @return					Future which becomes ready when the statement was committed
+		template<class... T>
+		std::future<void> SubmitStatement(const std::string &sql, const T&... parameters)
+		{
+			std::vector<SQLiteValue> values;
+			values.reserve(sizeof...(parameters));
+			AppendParameters(values, parameters...);
+			return Submit(sql, values);
+		}
+
+		//! Returns the number of queued statements.
+		size_t GetQueueSize() const;
+		//! Returns the statistics.
+		SQLiteGroupCommitStatistics GetStatistics() const;
+		//! Resets the statistics.
+		void ResetStatistics();
+
+	protected:
+		//! Queued statement
+		struct Request
+		{
+			//! SQL text (UTF-8)
+			std::string sql;
+			//! Parameters
+			std::vector<SQLiteValue> parameters;
+			//! Result for the submitting thread
+			std::promise<void> promise;
+			//! Submission time
+			std::chrono::steady_clock::time_point submitTime;
+		};
+
+		//! Main loop of the writer thread.
+		void Run();
+		//! Executes and commits one batch and completes the futures.
+		void ExecuteBatch(std::vector<Request> &batch);
+		//! Executes a statement with a prepared statement from the statement cache of the database.
+		void ExecuteStatement(const char *sql, const std::vector<SQLiteValue> &parameters);
+		//! Stops the writer thread.
+		void Stop();
+
+		//! End of the recursion.
+		static inline void AppendParameters(std::vector<SQLiteValue> &) {}
+		//! Appends all parameters to the given container.
+		template<class V, class... T>
+		static inline void AppendParameters(std::vector<SQLiteValue> &values, const V &value, const T&... parameters)
+		{
+			values.push_back(SQLiteValue(value));
+			AppendParameters(values, parameters...);
+		}
+
+	private:
+		//! Copy constructor
+		SQLiteGroupCommitWriter(const SQLiteGroupCommitWriter &writer);
+		//! Assignment operator
+		SQLiteGroupCommitWriter &operator=(const SQLiteGroupCommitWriter &writer);
+
+		//! Connection of the writer thread
+		SQLiteDatabase *mDatabase;
+		//! Maximum number of statements per transaction
+		size_t mMaxBatchSize;
+		//! Time which the writer waits for further statements
+		std::chrono::microseconds mMaxBatchDelay;
+
+		//! Protects the queue and the statistics
+		mutable std::mutex mMutex;
+		//! Wakes up the writer thread
+		std::condition_variable mCondition;
+		//! Queued statements
+		std::deque<Request> mQueue;
+		//! Shall the writer thread stop?
+		bool mIsStopRequested;
+		//! Statistics
+		SQLiteGroupCommitStatistics mStatistics;
+
+		//! Writer thread
+		std::thread mThread;
+	};
+};
+
+#endif // KompexSQLiteGroupCommitWriter_H
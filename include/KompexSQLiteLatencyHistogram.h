@@ -0,0 +1,82 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteLatencyHistogram_H
+#define KompexSQLiteLatencyHistogram_H
+
+#include <vector>
+
+#include "KompexSQLitePrerequisites.h"
+
+namespace Kompex
+{
+	//! Histogram with a constant relative precision for latencies or other positive values.\n
+	//! Every power of two is divided into 32 linear sub-buckets (log-linear layout like a HDR histogram),\n
+	//! therefore every recorded value is represented with an error of less than 3.2%, independent of its magnitude.\n
+	//! Recording a value is a constant time operation without any allocation.
+	class _SQLiteWrapperExport SQLiteLatencyHistogram
+	{
+	public:
+		//! Constructor
+		SQLiteLatencyHistogram();
+
+		//! Records a value.
+		//! @param value		Value (e.g. latency in nanoseconds)
+		//! @param count		Number of occurrences of the value
+		void Record(uint64 value, uint64 count = 1);
+		//! Adds all values of another histogram.
+		void Merge(const SQLiteLatencyHistogram &histogram);
+		//! Removes all values.
+		void Reset();
+
+		//! Returns the number of recorded values.
+		uint64 GetCount() const {return mCount;}
+		//! Returns the sum of all recorded values.
+		uint64 GetTotal() const {return mTotal;}
+		//! Returns the smallest recorded value or 0.
+		uint64 GetMin() const {return mCount ? mMin : 0;}
+		//! Returns the largest recorded value.
+		uint64 GetMax() const {return mMax;}
+		//! Returns the arithmetic mean of the recorded values.
+		double GetMean() const {return mCount ? static_cast<double>(mTotal) / mCount : 0.0;}
+		//! Returns the value below which the given percentage of the recorded values fall.\n
+		//! The result is the upper bound of the bucket which contains the percentile.
+		//! @param percentile	Percentile (0.0 - 100.0)
+		uint64 GetPercentile(double percentile) const;
+
+	protected:
+		//! Returns the bucket index of a value.
+		static unsigned int GetBucketIndex(uint64 value);
+		//! Returns the largest value which is stored in the given bucket.
+		static uint64 GetBucketUpperBound(unsigned int index);
+
+	private:
+		//! Counters of the buckets
+		std::vector<uint64> mBuckets;
+		//! Number of recorded values
+		uint64 mCount;
+		//! Sum of the recorded values
+		uint64 mTotal;
+		//! Smallest recorded value
+		uint64 mMin;
+		//! Largest recorded value
+		uint64 mMax;
+	};
+};
+
+#endif // KompexSQLiteLatencyHistogram_H
@@ -0,0 +1,132 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLitePageCache_H
+#define KompexSQLitePageCache_H
+
+#include <cstddef>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+
+namespace Kompex
+{
+	//! Counters of the SQLitePageCache.
+	struct SQLitePageCacheStatistics
+	{
+		//! Number of page requests
+		uint64 fetches;
+		//! Number of page requests which found the page in the cache
+		uint64 hits;
+		//! Number of pages which were created
+		uint64 createdPages;
+		//! Number of unpinned pages which were taken away from a connection to hold another page
+		uint64 recycledPages;
+		//! Number of page requests which were refused, because the capacity was reached and no shard had an unpinned page\n
+		//! (SQLite writes dirty pages and asks again in this case)
+		uint64 refusedFetches;
+		//! Number of shard lock acquisitions
+		uint64 lockAcquisitions;
+		//! Number of shard lock acquisitions which had to wait for another thread
+		uint64 lockContentions;
+		//! Number of pages in the cache
+		uint64 pages;
+		//! Number of pages which are allocated from the heap (memory databases and pages beyond the capacity)
+		uint64 heapPages;
+		//! Size of the preallocated memory region in bytes
+		uint64 capacity;
+		//! Bytes of the memory region which are used by pages
+		uint64 usedBytes;
+		//! Is the memory region backed by huge pages?
+		bool isHugePagesActive;
+
+		//! Returns the hit ratio (0.0 - 1.0).
+		double GetHitRatio() const {return fetches > 0 ? static_cast<double>(hits) / fetches : 0.0;}
+		//! Returns the part of the lock acquisitions which had to wait (0.0 - 1.0).
+		double GetContentionRatio() const {return lockAcquisitions > 0 ? static_cast<double>(lockContentions) / lockAcquisitions : 0.0;}
+	};
+
+	//! Page cache for all connections of the process [SQLITE_CONFIG_PCACHE2].\n
+	//! By default every connection has its own page cache with its own limit (PRAGMA cache_size), so a pool of\n
+	//! 32 connections reserves up to 32 times the cache size and an idle connection keeps its pages while a busy\n
+	//! connection evicts its hot pages. SQLitePageCache holds the pages of all connections in one memory region\n
+	//! with one capacity: a connection which needs a page takes the least recently used unpinned page of any\n
+	//! connection. The cache_size of the connections is not used anymore.\n
+	//! The pages and the LRU lists are split into shards by page number, each with its own lock, so that\n
+	//! connections which read different pages don't wait for each other. The memory region can be backed by\n
+	//! huge pages (Linux: MAP_HUGETLB, otherwise transparent huge pages are requested) to reduce TLB misses.\n
+	//! Please note, that SQLite doesn't tell the page cache which file a page belongs to and every connection\n
+	//! modifies the content of its pages, therefore the page content itself can't be shared. Use the shared\n
+	//! cache mode [sqlite3_enable_shared_cache] if connections shall share the content of their pages.\n
+	//! The page cache must be installed before SQLite is initialized, i.e. before the first database is opened,\n
+	//! or after sqlite3_shutdown(). The memory region is allocated when SQLite is initialized.\n
+	//! e.g. \n
+	//! SQLitePageCache::Install(256 * 1024 * 1024, 16, true);\n
+	//! SQLiteDatabase db("test.db", SQLITE_OPEN_READWRITE, 0);
+	class _SQLiteWrapperExport SQLitePageCache
+	{
+	public:
+		//! Installs the page cache.\n
+		//! Throws an exception if SQLite is already initialized.
+		//! @param capacity			Size of the memory region for all pages in bytes
+		//! @param shardCount		Number of shards; more shards reduce the lock contention
+		//! @param useHugePages		Shall the memory region be backed by huge pages?
+		static void Install(size_t capacity, unsigned int shardCount = 16, bool useHugePages = false);
+		//! Restores the default page cache of SQLite.\n
+		//! Throws an exception if SQLite is already initialized.
+		static void Uninstall();
+		//! Is the page cache installed?
+		static bool IsInstalled();
+
+		//! Returns the counters.
+		static SQLitePageCacheStatistics GetStatistics();
+		//! Resets the counters (the gauges like pages and usedBytes are kept).
+		static void ResetStatistics();
+
+	protected:
+		//! Allocates the memory region [sqlite3_pcache_methods2::xInit]
+		static int Init(void *arg);
+		//! Releases the memory region [sqlite3_pcache_methods2::xShutdown]
+		static void Shutdown(void *arg);
+		//! Creates the cache of a connection [sqlite3_pcache_methods2::xCreate]
+		static sqlite3_pcache *Create(int pageSize, int extraSize, int isPurgeable);
+		//! Sets the suggested cache size; unused [sqlite3_pcache_methods2::xCachesize]
+		static void Cachesize(sqlite3_pcache *cache, int maxPages);
+		//! Returns the number of pages of a cache [sqlite3_pcache_methods2::xPagecount]
+		static int Pagecount(sqlite3_pcache *cache);
+		//! Returns a page [sqlite3_pcache_methods2::xFetch]
+		static sqlite3_pcache_page *Fetch(sqlite3_pcache *cache, unsigned int key, int createFlag);
+		//! Unpins a page [sqlite3_pcache_methods2::xUnpin]
+		static void Unpin(sqlite3_pcache *cache, sqlite3_pcache_page *page, int discard);
+		//! Changes the page number of a page [sqlite3_pcache_methods2::xRekey]
+		static void Rekey(sqlite3_pcache *cache, sqlite3_pcache_page *page, unsigned int oldKey, unsigned int newKey);
+		//! Discards all pages with a page number >= limit [sqlite3_pcache_methods2::xTruncate]
+		static void Truncate(sqlite3_pcache *cache, unsigned int limit);
+		//! Destroys the cache of a connection [sqlite3_pcache_methods2::xDestroy]
+		static void Destroy(sqlite3_pcache *cache);
+		//! Releases the unpinned pages of a cache [sqlite3_pcache_methods2::xShrink]
+		static void Shrink(sqlite3_pcache *cache);
+
+	private:
+		//! Static class
+		SQLitePageCache();
+	};
+};
+
+#endif // KompexSQLitePageCache_H
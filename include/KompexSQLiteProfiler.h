@@ -0,0 +1,152 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteProfiler_H
+#define KompexSQLiteProfiler_H
+
+#include <atomic>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteLatencyHistogram.h"
+
+namespace Kompex
+{
+	//! Aggregated profile of one normalized SQL statement.
+	struct SQLiteProfileEntry
+	{
+		//! Normalized SQL statement (literals are replaced by '?')
+		std::string sql;
+		//! Number of executions
+		uint64 count;
+		//! Total execution time in nanoseconds
+		uint64 totalTime;
+		//! Mean execution time in nanoseconds
+		double meanTime;
+		//! Median execution time in nanoseconds
+		uint64 p50Time;
+		//! 95th percentile of the execution time in nanoseconds
+		uint64 p95Time;
+		//! 99th percentile of the execution time in nanoseconds
+		uint64 p99Time;
+		//! Longest execution time in nanoseconds
+		uint64 maxTime;
+	};
+
+	//! Collects the execution times of all SQL statements of one or more database connections.\n
+	//! The profiler is fed by the profile callback of SQLite [sqlite3_profile], which is called by the thread\n
+	//! that executed the statement. The callback only computes a hash of the normalized SQL text and writes it\n
+	//! together with the execution time into a lock-free ring buffer of the calling thread; it never locks\n
+	//! and never allocates memory (except for the first execution of a statement in a thread).\n
+	//! The ring buffers are drained by Collect(), which aggregates the execution times per normalized SQL text\n
+	//! in latency histograms. Collect() is called automatically by all reporting methods; call it periodically\n
+	//! if the ring buffers may overflow between two reports (the number of lost events is reported).\n
+	//! Note: SQLite measures the execution time with the resolution of the operating system clock.\n
+	//! e.g. \n
+	//! SQLiteProfiler profiler;\n
+	//! db.ActivateProfiling(&profiler);\n
+	//! ...\n
+	//! profiler.Dump(std::cout, 10, SQLiteProfiler::ORDER_BY_TOTAL_TIME);
+	class _SQLiteWrapperExport SQLiteProfiler
+	{
+	public:
+		//! Sort orders for GetTopStatements() and Dump()
+		enum SortOrder {ORDER_BY_TOTAL_TIME, ORDER_BY_MEAN_TIME, ORDER_BY_P99_TIME, ORDER_BY_MAX_TIME, ORDER_BY_COUNT};
+
+		//! Constructor.
+		//! @param ringBufferSize		Number of events which can be buffered per thread (rounded up to a power of two)
+		SQLiteProfiler(unsigned int ringBufferSize = 4096);
+		//! Destructor.\n
+		//! The profiler must be deactivated on all database connections before it is destroyed.
+		virtual ~SQLiteProfiler();
+
+		//! Callback function for sqlite3_profile(); the profiler must be passed as first argument.
+		static void ProfileCallback(void *profiler, const char *sql, sqlite3_uint64 time);
+
+		//! Moves all buffered events into the histograms.
+		void Collect();
+		//! Removes all collected events.
+		void Reset();
+
+		//! Returns the profiles of the top N statements.
+		//! @param count				Maximum number of statements; 0 returns all statements
+		//! @param order				Sort order
+		std::vector<SQLiteProfileEntry> GetTopStatements(unsigned int count = 10, SortOrder order = ORDER_BY_TOTAL_TIME);
+		//! Writes the profiles of the top N statements as table into a stream.
+		//! @param stream				Output stream
+		//! @param count				Maximum number of statements; 0 writes all statements
+		//! @param order				Sort order
+		void Dump(std::ostream &stream, unsigned int count = 10, SortOrder order = ORDER_BY_TOTAL_TIME);
+
+		//! Returns the number of events which were lost because a ring buffer was full.
+		uint64 GetLostEvents() const;
+
+		/**
+		Normalizes a SQL statement and returns the hash of the normalized text.\n
+		String and numeric literals are replaced by '?', whitespace is collapsed and keywords\n
+		and identifiers are converted into lower case, so that all executions of a statement\n
+		with different values are aggregated together.
+
+		@param sql				SQL statement
+		@param normalizedSql	Receives the normalized text (optional)
+		@return					64-bit FNV-1a hash of the normalized text
+		*/
+		static uint64 NormalizeSql(const char *sql, std::string *normalizedSql = 0);
+
+	protected:
+		//! Single-producer/single-consumer ring buffer of one thread
+		struct RingBuffer;
+		//! Aggregated statement
+		struct Statement;
+
+		//! Returns the ring buffer of the calling thread and creates it if necessary.
+		RingBuffer *GetThreadRingBuffer();
+		//! Registers the normalized text of a hash. Called once per statement and thread.
+		void RegisterStatement(uint64 hash, const char *sql);
+		//! Moves all buffered events into the histograms. The mutex must be locked.
+		void CollectEvents();
+
+	private:
+		//! Copy constructor
+		SQLiteProfiler(const SQLiteProfiler &profiler);
+		//! Assignment operator
+		SQLiteProfiler &operator=(const SQLiteProfiler &profiler);
+
+		//! Unique id of the profiler (used to find the ring buffers of a thread)
+		uint64 mId;
+		//! Size of every ring buffer
+		unsigned int mRingBufferSize;
+		//! Protects the ring buffer list and the aggregated statements
+		mutable std::mutex mMutex;
+		//! Ring buffers of all threads
+		std::vector<std::unique_ptr<RingBuffer> > mRingBuffers;
+		//! Aggregated statements; key: hash of the normalized SQL text
+		std::map<uint64, std::unique_ptr<Statement> > mStatements;
+		//! Normalized SQL texts of the hashes
+		std::map<uint64, std::string> mStatementTexts;
+	};
+};
+
+#endif // KompexSQLiteProfiler_H
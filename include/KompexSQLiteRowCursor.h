@@ -0,0 +1,255 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteRowCursor_H
+#define KompexSQLiteRowCursor_H
+
+#include <cstddef>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteException.h"
+#include "KompexSQLiteView.h"
+
+namespace Kompex
+{
+	//! Reads a single column value as native type. Specialized for every supported column type.\n
+	//! IsCompatible() returns false for the storage classes which can't be read without losing the value,\n
+	//! i.e. TEXT, BLOB and NULL for the numeric types. Text and BLOB types accept every storage class,\n
+	//! because SQLite converts numbers to their text representation.
+	template<class T>
+	struct SQLiteColumnReader;
+
+	//! Reads an int column value.
+	template<>
+	struct SQLiteColumnReader<int>
+	{
+		static inline bool IsCompatible(int type) {return type == SQLITE_INTEGER || type == SQLITE_FLOAT;}
+		static inline int Read(sqlite3_stmt *statement, int column) {return sqlite3_column_int(statement, column);}
+	};
+
+	//! Reads an int64 column value.
+	template<>
+	struct SQLiteColumnReader<int64>
+	{
+		static inline bool IsCompatible(int type) {return type == SQLITE_INTEGER || type == SQLITE_FLOAT;}
+		static inline int64 Read(sqlite3_stmt *statement, int column) {return sqlite3_column_int64(statement, column);}
+	};
+
+	//! Reads a double column value.
+	template<>
+	struct SQLiteColumnReader<double>
+	{
+		static inline bool IsCompatible(int type) {return type == SQLITE_INTEGER || type == SQLITE_FLOAT;}
+		static inline double Read(sqlite3_stmt *statement, int column) {return sqlite3_column_double(statement, column);}
+	};
+
+	//! Reads a bool column value.
+	template<>
+	struct SQLiteColumnReader<bool>
+	{
+		static inline bool IsCompatible(int type) {return type == SQLITE_INTEGER || type == SQLITE_FLOAT;}
+		static inline bool Read(sqlite3_stmt *statement, int column) {return !!sqlite3_column_int(statement, column);}
+	};
+
+	//! Reads a text column value as view; the view is valid until the next row is fetched.
+	template<>
+	struct SQLiteColumnReader<SQLiteTextView>
+	{
+		static inline bool IsCompatible(int) {return true;}
+		static inline SQLiteTextView Read(sqlite3_stmt *statement, int column)
+		{
+			const char *text = reinterpret_cast<const char*>(sqlite3_column_text(statement, column));
+			return SQLiteTextView(text, sqlite3_column_bytes(statement, column));
+		}
+	};
+
+	//! Reads a text column value as copy. NULL values will be represented as an empty string.
+	template<>
+	struct SQLiteColumnReader<std::string>
+	{
+		static inline bool IsCompatible(int) {return true;}
+		static inline std::string Read(sqlite3_stmt *statement, int column)
+		{
+			return SQLiteColumnReader<SQLiteTextView>::Read(statement, column).ToString();
+		}
+	};
+
+	//! Reads a BLOB column value as view; the view is valid until the next row is fetched.
+	template<>
+	struct SQLiteColumnReader<SQLiteBlobView>
+	{
+		static inline bool IsCompatible(int) {return true;}
+		static inline SQLiteBlobView Read(sqlite3_stmt *statement, int column)
+		{
+			const void *blob = sqlite3_column_blob(statement, column);
+			return SQLiteBlobView(blob, sqlite3_column_bytes(statement, column));
+		}
+	};
+
+	//! Fills the first N elements of a row tuple. The recursion is resolved at compile time.
+	template<int N, class Row>
+	struct SQLiteRowReader
+	{
+		static inline void Read(sqlite3_stmt *statement, Row &row)
+		{
+			SQLiteRowReader<N - 1, Row>::Read(statement, row);
+			std::get<N - 1>(row) = SQLiteColumnReader<typename std::tuple_element<N - 1, Row>::type>::Read(statement, N - 1);
+		}
+
+		//! Returns the number of the first column whose value can not be read as the requested type or -1.
+		static inline int FindIncompatibleColumn(sqlite3_stmt *statement)
+		{
+			int column = SQLiteRowReader<N - 1, Row>::FindIncompatibleColumn(statement);
+			if(column != -1)
+				return column;
+
+			if(!SQLiteColumnReader<typename std::tuple_element<N - 1, Row>::type>::IsCompatible(sqlite3_column_type(statement, N - 1)))
+				return N - 1;
+
+			return -1;
+		}
+	};
+
+	//! End of the recursion.
+	template<class Row>
+	struct SQLiteRowReader<0, Row>
+	{
+		static inline void Read(sqlite3_stmt *, Row &) {}
+		static inline int FindIncompatibleColumn(sqlite3_stmt *) {return -1;}
+	};
+
+	//! Typed cursor over the result rows of a SQLiteStatement.\n
+	//! The column count is validated once when the cursor is created. The storage class of every value is checked\n
+	//! with sqlite3_column_type() before the row is read directly into a std::tuple, so that e.g. a TEXT or NULL\n
+	//! value in an int column throws an exception instead of being converted to 0. A NULL text is read as\n
+	//! null SQLiteTextView or as empty std::string.\n
+	//! e.g. \n
+	//! stmt.Sql("SELECT id, name, score FROM user");\n
+	//! SQLiteRowCursor<int64, SQLiteTextView, double> cursor(stmt);\n
+	//! for(SQLiteRowCursor<int64, SQLiteTextView, double>::Iterator iter = cursor.begin(); iter != cursor.end(); ++iter)\n
+	//!     std::cout << std::get<0>(*iter) << std::endl;\n
+	//! stmt.FreeQuery();\n
+	//! The cursor can be used in a range-based for loop as well. It can be iterated only once;\n
+	//! call Reset() on the statement to read the rows again.
+	template<class... T>
+	class SQLiteRowCursor
+	{
+	public:
+		//! Type of a result row
+		typedef std::tuple<T...> Row;
+
+		//! Input iterator over the result rows.
+		class Iterator
+		{
+		public:
+			typedef std::input_iterator_tag iterator_category;
+			typedef Row value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const Row *pointer;
+			typedef const Row &reference;
+
+			//! Constructor for the end iterator
+			Iterator(): mCursor(0) {}
+			//! Constructor
+			explicit Iterator(SQLiteRowCursor *cursor): mCursor(cursor) {}
+
+			//! Returns the current row.
+			const Row &operator*() const {return mCursor->mRow;}
+			//! Returns the current row.
+			const Row *operator->() const {return &mCursor->mRow;}
+			//! Fetches the next row.
+			Iterator &operator++()
+			{
+				if(!mCursor->Fetch())
+					mCursor = 0;
+				return *this;
+			}
+
+			bool operator==(const Iterator &iter) const {return mCursor == iter.mCursor;}
+			bool operator!=(const Iterator &iter) const {return mCursor != iter.mCursor;}
+
+		private:
+			//! Cursor which is iterated; null pointer at the end
+			SQLiteRowCursor *mCursor;
+		};
+
+		//! Constructor.\n
+		//! You must first call Sql() on the statement!
+		//! @param statement		Statement whose result rows shall be read
+		explicit SQLiteRowCursor(SQLiteStatement &statement):
+			mStatement(statement)
+		{
+			statement.CheckStatement();
+
+			if(sqlite3_column_count(statement.GetStatementHandle()) != static_cast<int>(sizeof...(T)))
+			{
+				std::stringstream strStream;
+				strStream << "SQLiteRowCursor() the result has " << sqlite3_column_count(statement.GetStatementHandle())
+					<< " columns but " << sizeof...(T) << " columns were requested";
+				KOMPEX_EXCEPT(strStream.str());
+			}
+		}
+
+		//! Fetches the first row and returns an iterator to it.
+		Iterator begin()
+		{
+			if(!Fetch())
+				return Iterator();
+			return Iterator(this);
+		}
+		//! Returns the end iterator.
+		Iterator end() {return Iterator();}
+
+		//! Fetches the next row.
+		//! @return		'true' if a row was read and 'false' if there is no further result row
+		bool Fetch()
+		{
+			if(!mStatement.FetchRow())
+				return false;
+
+			sqlite3_stmt *statement = mStatement.GetStatementHandle();
+			int column = SQLiteRowReader<sizeof...(T), Row>::FindIncompatibleColumn(statement);
+			if(column != -1)
+			{
+				std::stringstream strStream;
+				strStream << "SQLiteRowCursor() column " << column << " contains no numeric value";
+				KOMPEX_EXCEPT(strStream.str());
+			}
+
+			SQLiteRowReader<sizeof...(T), Row>::Read(statement, mRow);
+			return true;
+		}
+		//! Returns the current row.
+		const Row &GetRow() const {return mRow;}
+
+	private:
+		//! Statement whose result rows are read
+		SQLiteStatement &mStatement;
+		//! Current row
+		Row mRow;
+	};
+};
+
+#endif // KompexSQLiteRowCursor_H
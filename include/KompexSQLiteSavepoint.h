@@ -0,0 +1,97 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteSavepoint_H
+#define KompexSQLiteSavepoint_H
+
+#include <string>
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteStatement.h"
+
+namespace Kompex
+{
+	class SQLiteDatabase;
+
+	//! Nested transaction which is rolled back automatically if it wasn't released [SAVEPOINT].\n
+	//! Savepoints can be nested inside of a transaction (e.g. BeginTransaction(TRANSACTION_IMMEDIATE)),\n
+	//! so that many small units of work can be committed together while every unit can be undone on its own.\n
+	//! Outside of a transaction the outermost savepoint starts a deferred transaction, which is committed by Release().\n
+	//! The SAVEPOINT, RELEASE and ROLLBACK TO statements are taken from the statement cache of the database.\n
+	//! e.g. \n
+	//! stmt.BeginTransaction(SQLiteStatement::TRANSACTION_IMMEDIATE);\n
+	//! for(...)\n
+	//! {\n
+	//!     SQLiteSavepoint savepoint(&db);\n
+	//!     ...\n
+	//!     if(isValid)\n
+	//!         savepoint.Release();\n
+	//! }   // not released units are rolled back here\n
+	//! stmt.CommitTransaction();
+	class _SQLiteWrapperExport SQLiteSavepoint
+	{
+	public:
+		//! Constructor; starts the savepoint.\n
+		//! Nested savepoints may use the same name, because RELEASE and ROLLBACK TO refer to the most recent\n
+		//! savepoint of the given name. Keeping the default name allows the reuse of the cached statements.
+		//! @param db		Database in which the savepoint should be started
+		//! @param name		Name of the savepoint
+		SQLiteSavepoint(SQLiteDatabase *db, const std::string &name = "kompex_savepoint");
+		//! Destructor; rolls the savepoint back if neither Release() nor Rollback() was called.
+		~SQLiteSavepoint();
+
+		//! Releases the savepoint, i.e. keeps its changes as part of the enclosing transaction\n
+		//! (or commits them if there is no enclosing transaction) [RELEASE].
+		void Release();
+		//! Reverts all changes since the savepoint was started and ends the savepoint [ROLLBACK TO, RELEASE].
+		void Rollback();
+		//! Reverts all changes since the savepoint was started; the savepoint stays active [ROLLBACK TO].
+		void RollbackTo();
+
+		//! Returns true if the savepoint was neither released nor rolled back.
+		inline bool IsActive() const {return mIsActive;}
+		//! Returns the name of the savepoint.
+		inline const std::string &GetName() const {return mName;}
+
+	private:
+		//! Copy constructor
+		SQLiteSavepoint(const SQLiteSavepoint &savepoint);
+		//! Assignment operator
+		SQLiteSavepoint &operator=(const SQLiteSavepoint &savepoint);
+
+		//! Executes one of the savepoint statements.
+		void Execute(const std::string &sql);
+		//! Throws an exception if the savepoint isn't active anymore.
+		void CheckActive() const;
+
+		//! Statement which executes the savepoint statements
+		SQLiteStatement mStatement;
+		//! Name of the savepoint
+		std::string mName;
+		//! SAVEPOINT statement
+		std::string mSavepointSql;
+		//! RELEASE statement
+		std::string mReleaseSql;
+		//! ROLLBACK TO statement
+		std::string mRollbackSql;
+		//! Was the savepoint neither released nor rolled back?
+		bool mIsActive;
+	};
+};
+
+#endif // KompexSQLiteSavepoint_H
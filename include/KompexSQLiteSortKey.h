@@ -0,0 +1,67 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteSortKey_H
+#define KompexSQLiteSortKey_H
+
+#include <locale>
+#include <string>
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteView.h"
+
+namespace Kompex
+{
+	//! Sort key functions and comparators for SQLiteDatabase::CreateSortKeyFunction() and CreateCollation().\n
+	//! A sort key is a byte string whose memcmp() order is the order of the texts, so that a column with\n
+	//! precomputed sort keys can be sorted and indexed without calling a collation for every comparison.\n
+	//! e.g. \n
+	//! db.CreateSortKeyFunction("natural_key", &SQLiteSortKey::NaturalOrder);\n
+	//! db.AddSortKeyColumn("file", "name", "name_key", "natural_key");\n
+	//! The one-argument Locale() and the two-argument CompareLocale() use the global locale [std::locale::global],\n
+	//! which is read on every call; a change of the global locale requires new sort keys.
+	class _SQLiteWrapperExport SQLiteSortKey
+	{
+	public:
+		//! Returns the sort key for the natural order, i.e. runs of digits are compared by their numeric value\n
+		//! ("file2" < "file10"); leading zeros are ignored. All other bytes are compared as they are.
+		static std::string NaturalOrder(const SQLiteTextView &text);
+		//! Compares two texts in the natural order without creating sort keys.\n
+		//! The result matches the comparison of the sort keys of NaturalOrder().
+		static int CompareNaturalOrder(const SQLiteTextView &text1, const SQLiteTextView &text2);
+
+		//! Returns the sort key for the collation of the global locale [std::collate::transform].\n
+		//! Please note, that the texts are handled as bytes, i.e. the locale must match the UTF-8 encoding.
+		static std::string Locale(const SQLiteTextView &text);
+		//! Returns the sort key for the collation of a locale [std::collate::transform].\n
+		//! Bind the locale with a lambda to register it, e.g. \n
+		//! db.CreateSortKeyFunction("de_key", [de](const SQLiteTextView &text) {return SQLiteSortKey::Locale(text, de);});
+		static std::string Locale(const SQLiteTextView &text, const std::locale &locale);
+		//! Compares two texts with the collation of the global locale [std::collate::compare].\n
+		//! The result matches the comparison of the sort keys of Locale().
+		static int CompareLocale(const SQLiteTextView &text1, const SQLiteTextView &text2);
+		//! Compares two texts with the collation of a locale [std::collate::compare].
+		static int CompareLocale(const SQLiteTextView &text1, const SQLiteTextView &text2, const std::locale &locale);
+
+	private:
+		//! Static class
+		SQLiteSortKey();
+	};
+};
+
+#endif // KompexSQLiteSortKey_H
@@ -21,19 +21,34 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "sqlite3.h"
 
 #include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteColumnLookup.h"
+#include "KompexSQLiteStatus.h"
+#include "KompexSQLiteView.h"
 
 namespace Kompex
 {	
 	class SQLiteDatabase;
+	template<class... T> class SQLiteRowCursor;
 
 	//! Execution of SQL statements and result processing.
 	class _SQLiteWrapperExport SQLiteStatement
 	{
 	public:
+		//! Transaction modes for BeginTransaction()\n
+		//! TRANSACTION_DEFERRED\n
+		//! No lock is acquired until the database is first accessed. A read transaction which writes later\n
+		//! must upgrade its lock, which fails with SQLITE_BUSY if another connection writes at the same time.\n
+		//! TRANSACTION_IMMEDIATE\n
+		//! The write lock is acquired immediately, so that the transaction can't fail later because of a concurrent writer.\n
+		//! TRANSACTION_EXCLUSIVE\n
+		//! Like TRANSACTION_IMMEDIATE, additionally prevents other connections from reading (except in WAL mode).
+		enum TransactionMode {TRANSACTION_DEFERRED, TRANSACTION_IMMEDIATE, TRANSACTION_EXCLUSIVE};
+
 		//! Constructor.\n
 		//! @param db		Database in which the SQL should be performed
 		SQLiteStatement(SQLiteDatabase *db);
@@ -82,6 +97,15 @@ namespace Kompex
 		//! Do not forget to call FreeQuery() when you have finished.
 		inline void Sql(const wchar_t *sql) {Prepare(sql);}
 
+		//! Works like Sql(), but takes an already prepared statement from the statement cache of the database if available.\n
+		//! Use it for SQL statements which are executed again and again (e.g. lookup queries with Bind..() methods).\n
+		//! Do not forget to call FreeQuery() when you have finished, which hands the statement back to the cache.
+		inline void SqlCached(const std::string &sql) {PrepareCached(sql.c_str());}
+		//! Works like Sql(), but takes an already prepared statement from the statement cache of the database if available.\n
+		//! Use it for SQL statements which are executed again and again (e.g. lookup queries with Bind..() methods).\n
+		//! Do not forget to call FreeQuery() when you have finished, which hands the statement back to the cache.
+		inline void SqlCached(const char *sql) {PrepareCached(sql);}
+
 		//! If you have called Sql(), you can step throw all results.
 		//! @return		'true' if there are further result rows and 'false' if there is no further result row
 		bool FetchRow() const;
@@ -165,6 +189,34 @@ namespace Kompex
 		//! @param column		Name of the column from which we want read the data.
 		std::string GetColumnString(const std::string &column) const;
 
+		//! Returns a view of the text from a single column of the current result row of a query without copying it.\n
+		//! The view is only valid until the next FetchRow(), Reset() or FreeQuery() call.\n
+		//! NULL values will be returned as view with a null pointer.\n
+		//! You must first call Sql()!
+		//! @param column		Number of the column from which we want read the data.
+		SQLiteTextView GetColumnTextView(int column) const;
+		//! Returns a view of the text from a single column of the current result row of a query without copying it.\n
+		//! The view is only valid until the next FetchRow(), Reset() or FreeQuery() call.\n
+		//! NULL values will be returned as view with a null pointer.\n
+		//! You must first call Sql()!
+		//! @param column		Name of the column from which we want read the data.
+		SQLiteTextView GetColumnTextView(const std::string &column) const;
+
+		//! Appends the text from a single column of the current result row of a query to the given buffer.\n
+		//! If you clear() the buffer for every row, its capacity will be reused and no memory must be allocated.\n
+		//! NULL values append nothing.\n
+		//! You must first call Sql()!
+		//! @param column		Number of the column from which we want read the data.
+		//! @param buffer		Buffer to which the text will be appended
+		void AppendColumnString(int column, std::string &buffer) const;
+		//! Appends the text from a single column of the current result row of a query to the given buffer.\n
+		//! If you clear() the buffer for every row, its capacity will be reused and no memory must be allocated.\n
+		//! NULL values append nothing.\n
+		//! You must first call Sql()!
+		//! @param column		Name of the column from which we want read the data.
+		//! @param buffer		Buffer to which the text will be appended
+		void AppendColumnString(const std::string &column, std::string &buffer) const;
+
 		//! Returns a UTF-16 string from a single column of the current result row of a query.\n
 		//! NULL values will be returned as null pointer.\n
 		//! You must first call Sql()!
@@ -227,6 +279,30 @@ namespace Kompex
 		//! @param column		Name of the column from which we want read the data.
 		const void *GetColumnBlob(const std::string &column) const;		
 		
+		//! Returns a view of the BLOB from a single column of the current result row of a query without copying it.\n
+		//! The view is only valid until the next FetchRow(), Reset() or FreeQuery() call.\n
+		//! You must first call Sql()!
+		//! @param column		Number of the column from which we want read the data.
+		SQLiteBlobView GetColumnBlobView(int column) const;
+		//! Returns a view of the BLOB from a single column of the current result row of a query without copying it.\n
+		//! The view is only valid until the next FetchRow(), Reset() or FreeQuery() call.\n
+		//! You must first call Sql()!
+		//! @param column		Name of the column from which we want read the data.
+		SQLiteBlobView GetColumnBlobView(const std::string &column) const;
+
+		//! Appends the BLOB from a single column of the current result row of a query to the given buffer.\n
+		//! If you clear() the buffer for every row, its capacity will be reused and no memory must be allocated.\n
+		//! You must first call Sql()!
+		//! @param column		Number of the column from which we want read the data.
+		//! @param buffer		Buffer to which the BLOB data will be appended
+		void AppendColumnBlob(int column, std::vector<unsigned char> &buffer) const;
+		//! Appends the BLOB from a single column of the current result row of a query to the given buffer.\n
+		//! If you clear() the buffer for every row, its capacity will be reused and no memory must be allocated.\n
+		//! You must first call Sql()!
+		//! @param column		Name of the column from which we want read the data.
+		//! @param buffer		Buffer to which the BLOB data will be appended
+		void AppendColumnBlob(const std::string &column, std::vector<unsigned char> &buffer) const;
+
 		//! Returns the number of bytes in a column that has type BLOB or the number of bytes in a TEXT string with UTF-8 encoding.\n
 		//! You must first call Sql()!
 		//! @param column		Number of the column from which we want read the bytes.
@@ -312,6 +388,13 @@ namespace Kompex
 		//! @param column		Name of the column from which we want read the declared datatype of the table column.
 		wchar_t *GetColumnDeclaredDatatype16(const std::string &column) const;
 
+		//! Returns the column number for the given column name.\n
+		//! Resolve the names once after Sql() and use the returned numbers with the GetColumn..(int) methods,\n
+		//! so that no column name must be looked up for every result row.\n
+		//! You must first call Sql()!
+		//! @param columnName	Name of the column
+		int GetColumnNumber(const std::string &columnName) const;
+
 		//! Return the number of columns in the result set.\n
 		//! You must first call Sql()!
 		int GetColumnCount() const;
@@ -402,8 +485,60 @@ namespace Kompex
 		//! using the Bind*() functions retain their values. Use ClearBindings() to reset the bindings.
 		void Reset() const;
 
-		//! Begins a transaction.
-		void BeginTransaction();
+		//! Non-throwing version of FetchRow() for hot paths where errors are expected (e.g. SQLITE_BUSY).\n
+		//! No exception and no error message is created; the status can be checked with IsRow(), IsDone() and IsOk().
+		//! @return		SQLITE_ROW if there is a further result row, SQLITE_DONE if there is no further result row or the error
+		SQLiteStatus TryFetchRow() const {return GetStatus(StepStatement());}
+		//! Non-throwing version of Execute() for hot paths where errors are expected\n
+		//! (e.g. constraint violations when inserting rows which may already exist).
+		//! @return		SQLITE_DONE or SQLITE_ROW if the statement was executed, otherwise the error
+		SQLiteStatus TryExecute() const {return GetStatus(StepStatement());}
+		//! Non-throwing version of Reset().\n
+		//! Please note, that sqlite3_reset() returns the error of the last execution again,\n
+		//! e.g. the constraint violation of a failed TryExecute(). The statement is reset nevertheless.
+		SQLiteStatus TryReset() const;
+
+		//! Non-throwing version of BindInt().
+		SQLiteStatus TryBindInt(int column, int value) const {return GetStatus(sqlite3_bind_int(mStatement, column, value));}
+		//! Non-throwing version of BindBool().
+		SQLiteStatus TryBindBool(int column, bool value) const {return GetStatus(sqlite3_bind_int(mStatement, column, static_cast<int>(value)));}
+		//! Non-throwing version of BindString().
+		SQLiteStatus TryBindString(int column, const std::string &string) const {return GetStatus(sqlite3_bind_text(mStatement, column, string.c_str(), string.length(), SQLITE_TRANSIENT));}
+		//! Non-throwing version of BindString16().
+		SQLiteStatus TryBindString16(int column, const wchar_t *string) const {return GetStatus(sqlite3_bind_text16(mStatement, column, string, -1, SQLITE_TRANSIENT));}
+		//! Non-throwing version of BindDouble().
+		SQLiteStatus TryBindDouble(int column, double value) const {return GetStatus(sqlite3_bind_double(mStatement, column, value));}
+		//! Non-throwing version of BindInt64().
+		SQLiteStatus TryBindInt64(int column, int64 value) const {return GetStatus(sqlite3_bind_int64(mStatement, column, value));}
+		//! Non-throwing version of BindNull().
+		SQLiteStatus TryBindNull(int column) const {return GetStatus(sqlite3_bind_null(mStatement, column));}
+		//! Non-throwing version of BindBlob().
+		SQLiteStatus TryBindBlob(int column, const void* data, int numberOfBytes = -1) const {return GetStatus(sqlite3_bind_blob(mStatement, column, data, numberOfBytes, SQLITE_TRANSIENT));}
+		//! Non-throwing version of BindZeroBlob().
+		SQLiteStatus TryBindZeroBlob(int column, int length) const {return GetStatus(sqlite3_bind_zeroblob(mStatement, column, length));}
+
+		//! Returns the value of a runtime counter of the prepared statement [sqlite3_stmt_status].\n
+		//! The counters accumulate over all executions of the prepared statement, i.e. a statement from the statement\n
+		//! cache includes the executions of earlier SQLiteStatement objects. The statement statistics of the database\n
+		//! (see SQLiteDatabase::GetStatementStatistics()) don't reset the counters, and a reset by this method doesn't\n
+		//! remove the counted values from the statement statistics.
+		//! @param counter		SQLITE_STMTSTATUS_FULLSCAN_STEP, SQLITE_STMTSTATUS_SORT or SQLITE_STMTSTATUS_AUTOINDEX
+		//! @param reset		Resets the counter to zero
+		int GetStatementStatus(int counter, bool reset = false) const;
+		//! Returns the number of times that SQLite has stepped forward in a table as part of a full table scan.\n
+		//! Large numbers may indicate a missing index.
+		inline int GetFullscanSteps() const {return GetStatementStatus(SQLITE_STMTSTATUS_FULLSCAN_STEP);}
+		//! Returns the number of sort operations that have occurred.\n
+		//! A non-zero value may indicate an opportunity to improve performance through careful use of indices.
+		inline int GetSortOperations() const {return GetStatementStatus(SQLITE_STMTSTATUS_SORT);}
+		//! Returns the number of rows inserted into transient indices that were created automatically.\n
+		//! A non-zero value indicates that a permanent index would help.
+		inline int GetAutoIndexInserts() const {return GetStatementStatus(SQLITE_STMTSTATUS_AUTOINDEX);}
+
+		//! Begins a transaction.\n
+		//! Use TRANSACTION_IMMEDIATE for transactions which write, to avoid SQLITE_BUSY errors in the middle of the transaction.
+		//! @param mode		Transaction mode
+		void BeginTransaction(TransactionMode mode = TRANSACTION_DEFERRED);
 		//! Commits a transaction.\n
 		//! Exception output: std::cerr
 		void CommitTransaction();
@@ -411,7 +546,7 @@ namespace Kompex
 		inline void RollbackTransaction()
 		{
 			FreeQuery();
-			SqlStatement("ROLLBACK;");
+			SqlStatementCached("ROLLBACK;");
 		}
 
 		//! Can be used only for transaction SQL statements.\n
@@ -420,21 +555,21 @@ namespace Kompex
 		//! If your sql statement variable is invalid before you called CommitTransaction()
 		//! you need to use SecureTransaction(), which creates a internal copy of your sql statement.
 		//! @param sql		SQL statement
-		inline void Transaction(const char *sql) {mTransactionSQL[mTransactionID++] = std::make_pair(sql, false);}
+		inline void Transaction(const char *sql) {mTransactionStatements.push_back(TransactionStatement(sql));}
 		//! Can be used only for transaction SQL statements.\n
 		//! Can be used for transactions, if you want use the default error handling.
 		//! Please note that there is only used a reference of your sql statement.\n
 		//! If your sql statement variable is invalid before you called CommitTransaction()
 		//! you need to use SecureTransaction(), which creates a internal copy of your sql statement.
 		//! @param sql		SQL statement
-		inline void Transaction(const std::string &sql)	{mTransactionSQL[mTransactionID++] = std::make_pair(sql.c_str(), false);}
+		inline void Transaction(const std::string &sql)	{mTransactionStatements.push_back(TransactionStatement(sql.c_str()));}
 		//! Can be used only for transaction SQL statements.\n
 		//! Can be used for transactions, if you want use the default error handling.
 		//! Please note that there is only used a reference of your sql statement.\n
 		//! If your sql statement variable is invalid before you called CommitTransaction()
 		//! you need to use SecureTransaction(), which creates a internal copy of your sql statement.
 		//! @param sql		SQL statement
-		inline void Transaction(const wchar_t *sql) {mTransactionSQL16[mTransactionID++] = std::make_pair(sql, false);}
+		inline void Transaction(const wchar_t *sql) {mTransactionStatements.push_back(TransactionStatement(sql));}
 
 		//! Can be used only for transaction SQL statements.\n
 		//! Can be used for transactions, if you want use the default error handling.\n
@@ -639,8 +774,23 @@ namespace Kompex
 		//! Compile sql query into a byte-code program.
 		//! @param sqlStatement			SQL statement (UTF-16) 
 		void Prepare(const wchar_t *sqlStatement);
+		//! Takes a prepared statement from the statement cache of the database.
+		//! @param sqlStatement			SQL statement (UTF-8) 
+		void PrepareCached(const char *sqlStatement);
+		//! Takes a prepared statement from the statement cache of the database.
+		//! @param sqlStatement			SQL statement (UTF-8) 
+		inline void PrepareCached(const std::string &sqlStatement) {PrepareCached(sqlStatement.c_str());}
+		//! The statement cache is keyed by UTF-8 text, therefore UTF-16 statements are always compiled.
+		//! @param sqlStatement			SQL statement (UTF-16) 
+		inline void PrepareCached(const wchar_t *sqlStatement) {Prepare(sqlStatement);}
 		//! Must be called one or more times to evaluate the statement.
 		bool Step() const;
+		//! Calls sqlite3_step() and measures it, if the statement statistics of the database are enabled.
+		int StepStatement() const;
+		//! Creates the status for a result code; the extended result code is taken from the database connection.
+		SQLiteStatus GetStatus(int resultCode) const;
+		//! Adds the counters of the current execution to the statement statistics of the database.
+		void RecordStatementStatistics() const;
 		//! Checks if the statement pointer is valid
 		void CheckStatement() const;
 		//! Checks if the database pointer is valid
@@ -656,22 +806,36 @@ namespace Kompex
 		//! Returns the first value of the first row. Internally used in GetSqlResultBlob().
 		const void *SqlResultBlob(const void *defaultReturnValue);
 
+		//! Returns a view of a text column without any checks.
+		inline SQLiteTextView ColumnTextView(int column) const
+		{
+			// sqlite3_column_bytes() must be called after sqlite3_column_text() to get the size of the converted text
+			const char *text = reinterpret_cast<const char*>(sqlite3_column_text(mStatement, column));
+			return SQLiteTextView(text, sqlite3_column_bytes(mStatement, column));
+		}
+		//! Returns a view of a BLOB column without any checks.
+		inline SQLiteBlobView ColumnBlobView(int column) const
+		{
+			const void *blob = sqlite3_column_blob(mStatement, column);
+			return SQLiteBlobView(blob, sqlite3_column_bytes(mStatement, column));
+		}
+
 		//! Checks whether the given column number is located within the available column range.
 		//! @param columnNumber			column number which shall be checked
 		//! @param functionName                 name of the function which shall be shown in the exception message
-		void CheckColumnNumber(int columnNumber, const std::string &functionName = "") const;
+		void CheckColumnNumber(int columnNumber, const char *functionName = "") const;
 		
-		//! Free the allocated memory and clean the containers
+		//! Clean the transaction container
 		void CleanUpTransaction();
 
-         	//! Free the allocated memory of sql statements
-		//! @param isMemAllocated		Was memory allocated?
-		//! @param str					SQL statement string
+		//! Executes a SQL statement with a prepared statement from the statement cache of the database.
+		//! @param sql					SQL statement
 		template<class T>
-		inline void DeleteTransactionSqlStr(bool isMemAllocated, T *str)
+		inline void SqlStatementCached(const T *sql)
 		{
-			if(isMemAllocated)
-				delete[] str;
+			PrepareCached(sql);
+			Step();
+			FreeQuery();
 		}
 
 		//! Returns the first value of the first row from the given sql statement result.
@@ -682,6 +846,8 @@ namespace Kompex
 		T GetColumnValue(S sql, T(Kompex::SQLiteStatement::*getColumnFunc)(int columnNumber)const, T defaultReturnValue);
 
 	private:
+		template<class... T> friend class SQLiteRowCursor;
+
 		//! Assigns to every column number the corresponding column name.
 		void AssignColumnNumberToColumnName() const;
 		//! Returns the column number for a given column name.
@@ -691,24 +857,61 @@ namespace Kompex
 		struct sqlite3_stmt *mStatement;
 		//! Database pointer
 		SQLiteDatabase *mDatabase;
+		//! Was the statement taken from the statement cache of the database?
+		bool mIsStatementCached;
 
-		//! typedef for UTF-8 transaction statements
-		typedef std::map<unsigned short /* transaction id */, std::pair<const char* /* sql */, bool /* memory allocated */> > TTransactionSQL;
-		//! typedef for UTF-16 transaction statements
-		typedef std::map<unsigned short /* transaction id */, std::pair<const wchar_t* /* sql */, bool /*  is memory allocated */> > TTransactionSQL16;
-	
-		//! Stores UTF-8 transaction statements
-		TTransactionSQL mTransactionSQL;
-		//! Stores UTF-16 transaction statements
-		TTransactionSQL16 mTransactionSQL16;
-
-		//! ID for transactions
-		unsigned short mTransactionID;
+		//! Transaction statement; either a reference to the caller's string or an internal copy
+		struct TransactionStatement
+		{
+			//! Encoding and storage of the statement
+			enum Kind
+			{
+				REFERENCED_UTF8,
+				REFERENCED_UTF16,
+				COPIED_UTF8,
+				COPIED_UTF16
+			};
+
+			//! Constructor for a referenced UTF-8 statement
+			explicit TransactionStatement(const char *sqlStatement): kind(REFERENCED_UTF8), sql(sqlStatement), sql16(0) {}
+			//! Constructor for a referenced UTF-16 statement
+			explicit TransactionStatement(const wchar_t *sqlStatement): kind(REFERENCED_UTF16), sql(0), sql16(sqlStatement) {}
+			//! Constructor for a copied UTF-8 statement (SecureTransaction)
+			explicit TransactionStatement(const std::string &sqlStatement): kind(COPIED_UTF8), sql(0), sql16(0), sqlCopy(sqlStatement) {}
+			//! Constructor for a copied UTF-16 statement (SecureTransaction)
+			explicit TransactionStatement(const std::wstring &sqlStatement): kind(COPIED_UTF16), sql(0), sql16(0), sql16Copy(sqlStatement) {}
+
+			//! Encoding and storage of the statement
+			Kind kind;
+			//! Referenced UTF-8 statement
+			const char *sql;
+			//! Referenced UTF-16 statement
+			const wchar_t *sql16;
+			//! Copy of a UTF-8 statement (SecureTransaction)
+			std::string sqlCopy;
+			//! Copy of a UTF-16 statement (SecureTransaction)
+			std::wstring sql16Copy;
+		};
+
+		//! Stores the UTF-8 and UTF-16 transaction statements in their execution order
+		std::vector<TransactionStatement> mTransactionStatements;
 		
-		//! Container which stores the assignments for every column number and the corresponding column name (cache the results).
-		mutable std::map<std::string /* column name */, int /* column number */> mColumnNumberToColumnNameAssignment;
-		//! Saves whether the assignments for every column number and the corresponding column name was already done.
-		mutable bool mIsColumnNumberAssignedToColumnName;
+		//! Stores the assignments for every column name and the corresponding column number (built once per prepared statement).
+		mutable SQLiteColumnLookup mColumnLookup;
+		//! Were the column names of the lookup table compared with the statement since its last recompilation could have happened?
+		mutable bool mIsColumnLookupChecked;
+
+		//! Number of sqlite3_step() calls of the current execution (statement statistics)
+		mutable uint64 mSteps;
+		//! Number of result rows of the current execution (statement statistics)
+		mutable uint64 mRowsStepped;
+		//! Time in nanoseconds spent in sqlite3_step() during the current execution (statement statistics)
+		mutable uint64 mStepTime;
+		//! Number of SQLite counters which are taken into the statement statistics
+		static const int STATUS_COUNTER_COUNT = 3;
+		//! Values of the SQLite counters (full scan steps, sorts, automatic index rows) at the first step of\n
+		//! the current execution (statement statistics)
+		mutable int64 mStatusBaseline[STATUS_COUNTER_COUNT];
 
 	};
 };
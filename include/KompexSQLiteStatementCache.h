@@ -0,0 +1,132 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteStatementCache_H
+#define KompexSQLiteStatementCache_H
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteColumnLookup.h"
+
+namespace Kompex
+{
+	//! Bounded LRU cache for prepared statements of one database connection.\n
+	//! Statements are keyed by their SQL text (UTF-8). A statement which is handed out by Acquire()\n
+	//! is removed from the cache until it is given back with Release(), so that the same statement\n
+	//! can never be used by two SQLiteStatement objects at the same time.
+	class _SQLiteWrapperExport SQLiteStatementCache
+	{
+	public:
+		//! Constructor.
+		//! @param capacity		Maximum number of statements which are kept prepared.\n
+		//!						0 disables the cache.
+		SQLiteStatementCache(unsigned int capacity = 32);
+		//! Destructor.\n
+		//! Finalizes all cached statements.
+		virtual ~SQLiteStatementCache();
+
+		//! Returns a prepared statement for the given SQL text.\n
+		//! If the cache holds an already prepared statement for the SQL text it will be returned (cache hit),\n
+		//! otherwise the SQL text will be compiled with sqlite3_prepare_v2() (cache miss).
+		//! @param databaseHandle	Database connection which shall be used
+		//! @param sql				SQL statement (UTF-8)
+		//! @param columnLookup		Receives the column name lookup table which was built for the statement\n
+		//!							or an empty table if the statement was compiled.
+		sqlite3_stmt *Acquire(sqlite3 *databaseHandle, const char *sql, SQLiteColumnLookup &columnLookup);
+		//! Hands a statement, which was returned by Acquire(), back to the cache.\n
+		//! The statement will be reset and its bindings will be cleared and it is cached under the SQL text\n
+		//! which was passed to Acquire(). If the cache is full, the least recently used statement will be finalized.
+		//! @param statement		Statement which was returned by Acquire()
+		//! @param columnLookup		Column name lookup table of the statement, which will be kept together with\n
+		//!							the statement. The given object will be cleared.
+		void Release(sqlite3_stmt *statement, SQLiteColumnLookup &columnLookup);
+		//! Finalizes all cached statements.\n
+		//! Must be called before the associated database connection will be closed.
+		void Clear();
+
+		//! Sets the maximum number of cached statements.\n
+		//! Surplus statements will be finalized immediately. 0 disables the cache.
+		void SetCapacity(unsigned int capacity);
+		//! Returns the maximum number of cached statements.
+		unsigned int GetCapacity() const {return mCapacity;}
+		//! Returns the number of currently cached statements.
+		unsigned int GetSize() const {return static_cast<unsigned int>(mEntries.size());}
+
+		//! Returns the number of Acquire() calls which could be served from the cache.
+		uint64 GetHits() const {return mHits;}
+		//! Returns the number of Acquire() calls which needed to prepare a new statement.
+		uint64 GetMisses() const {return mMisses;}
+		//! Returns the number of statements which were finalized because the cache was full.
+		uint64 GetEvictions() const {return mEvictions;}
+		//! Resets the hit, miss and eviction counters.
+		void ResetStatistics() {mHits = mMisses = mEvictions = 0;}
+
+	protected:
+		//! Finalizes the least recently used statements until the cache fits into the given size.
+		void Shrink(unsigned int size);
+
+	private:
+		//! Cached statement
+		struct Entry
+		{
+			//! SQL text (UTF-8)
+			std::string sql;
+			//! Prepared statement
+			sqlite3_stmt *statement;
+			//! Column name lookup table of the statement
+			SQLiteColumnLookup columnLookup;
+		};
+
+		//! Cached statements; most recently used at the front
+		typedef std::list<Entry> TEntryList;
+		//! Lookup table SQL text -> position in the list
+		typedef std::map<std::string, TEntryList::iterator> TEntryLookup;
+		//! Lookup table handed out statement -> SQL text which was passed to Acquire()
+		typedef std::map<sqlite3_stmt*, std::string> TAcquiredLookup;
+
+		//! Copy constructor
+		SQLiteStatementCache(const SQLiteStatementCache &cache);
+		//! Assignment operator
+		SQLiteStatementCache &operator=(const SQLiteStatementCache &cache);
+
+		//! Cached statements
+		TEntryList mEntries;
+		//! Lookup table for the cached statements
+		TEntryLookup mLookup;
+		//! SQL texts of the statements which are handed out; sqlite3_sql() may differ from them\n
+		//! (e.g. trailing whitespace, comments or further statements are cut off)
+		TAcquiredLookup mAcquired;
+		//! Database connection to which the cached statements belong
+		sqlite3 *mDatabaseHandle;
+		//! Maximum number of cached statements
+		unsigned int mCapacity;
+		//! Number of cache hits
+		uint64 mHits;
+		//! Number of cache misses
+		uint64 mMisses;
+		//! Number of evicted statements
+		uint64 mEvictions;
+	};
+};
+
+#endif // KompexSQLiteStatementCache_H
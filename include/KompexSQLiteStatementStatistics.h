@@ -0,0 +1,101 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteStatementStatistics_H
+#define KompexSQLiteStatementStatistics_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "KompexSQLitePrerequisites.h"
+
+namespace Kompex
+{
+	//! Accumulated runtime counters of one SQL statement text.
+	struct SQLiteStatementCounters
+	{
+		//! SQL statement text
+		std::string sql;
+		//! Number of executions (an execution ends with SQLiteStatement::Reset() or FreeQuery())
+		uint64 executions;
+		//! Number of sqlite3_step() calls
+		uint64 steps;
+		//! Number of result rows
+		uint64 rows;
+		//! Number of times SQLite stepped forward in a table as part of a full table scan [SQLITE_STMTSTATUS_FULLSCAN_STEP]\n
+		//! Large numbers may indicate a missing index.
+		uint64 fullscanSteps;
+		//! Number of sort operations [SQLITE_STMTSTATUS_SORT]\n
+		//! A non-zero value may indicate an opportunity to improve performance through careful use of indices.
+		uint64 sorts;
+		//! Number of rows inserted into transient indices that were created automatically [SQLITE_STMTSTATUS_AUTOINDEX]\n
+		//! A non-zero value indicates that a permanent index would help.
+		uint64 autoindexSteps;
+		//! Total time in seconds which was spent in sqlite3_step()
+		double seconds;
+	};
+
+	//! Accumulates the runtime counters of all statements of a database connection per SQL text.\n
+	//! The counters are collected by SQLiteStatement: rows and step time are measured around every\n
+	//! sqlite3_step() call, the SQLite counters [sqlite3_stmt_status] are read at the first step and again when the\n
+	//! statement is reset or freed, without resetting them. The statistics are disabled by default.\n
+	//! e.g. \n
+	//! db.GetStatementStatistics().SetEnabled(true);\n
+	//! ...\n
+	//! std::vector<SQLiteStatementCounters> counters = db.GetStatementStatistics().GetSnapshot();
+	class _SQLiteWrapperExport SQLiteStatementStatistics
+	{
+	public:
+		//! Constructor
+		SQLiteStatementStatistics();
+
+		//! Enables or disables the collection of the counters.
+		void SetEnabled(bool isEnabled) {mIsEnabled.store(isEnabled, std::memory_order_relaxed);}
+		//! Returns true if the counters are collected.
+		bool IsEnabled() const {return mIsEnabled.load(std::memory_order_relaxed);}
+
+		//! Adds the counters of one execution of a statement.
+		void Record(const char *sql, uint64 steps, uint64 rows, int fullscanSteps, int sorts, int autoindexSteps, uint64 nanoseconds);
+
+		//! Returns the accumulated counters of all statements, sorted by the total step time (descending).
+		//! @param reset		Resets all counters after the snapshot was taken
+		std::vector<SQLiteStatementCounters> GetSnapshot(bool reset = false);
+		//! Resets all counters.
+		void Reset();
+		//! Returns the number of distinct SQL texts.
+		size_t GetSize() const;
+
+	private:
+		//! Copy constructor
+		SQLiteStatementStatistics(const SQLiteStatementStatistics &statistics);
+		//! Assignment operator
+		SQLiteStatementStatistics &operator=(const SQLiteStatementStatistics &statistics);
+
+		//! Are the counters collected?
+		std::atomic<bool> mIsEnabled;
+		//! Protects the counters, so that a snapshot can be taken by another thread
+		mutable std::mutex mMutex;
+		//! Counters per SQL text
+		std::map<std::string, SQLiteStatementCounters> mCounters;
+	};
+};
+
+#endif // KompexSQLiteStatementStatistics_H
@@ -0,0 +1,85 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteStatus_H
+#define KompexSQLiteStatus_H
+
+#include <string>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+
+namespace Kompex
+{
+	//! Result of a non-throwing operation (e.g. SQLiteStatement::TryFetchRow()).\n
+	//! Holds the extended SQLite result code and the database handle only. The error message\n
+	//! isn't copied; it is built on demand by GetErrorDescription(), so that expected errors\n
+	//! (e.g. SQLITE_BUSY or a constraint violation) are as cheap as possible.
+	class _SQLiteWrapperExport SQLiteStatus
+	{
+	public:
+		//! Constructor for SQLITE_OK
+		SQLiteStatus(): mResultCode(SQLITE_OK), mDatabaseHandle(0) {}
+		//! Constructor
+		//! @param resultCode		Primary or extended SQLite result code
+		//! @param databaseHandle	Database connection which returned the result code
+		SQLiteStatus(int resultCode, sqlite3 *databaseHandle): mResultCode(resultCode), mDatabaseHandle(databaseHandle) {}
+
+		//! Returns the extended result code (e.g. SQLITE_CONSTRAINT_UNIQUE).\n
+		//! Equals the primary result code if SQLite provides no extended result code.
+		inline int GetExtendedResultCode() const {return mResultCode;}
+		//! Returns the primary result code (e.g. SQLITE_CONSTRAINT).
+		inline int GetResultCode() const {return mResultCode & 0xff;}
+
+		//! Returns true if the operation was successful (SQLITE_OK, SQLITE_ROW or SQLITE_DONE).
+		inline bool IsOk() const {return GetResultCode() == SQLITE_OK || GetResultCode() == SQLITE_ROW || GetResultCode() == SQLITE_DONE;}
+		//! Returns true if a result row is available (SQLITE_ROW).
+		inline bool IsRow() const {return GetResultCode() == SQLITE_ROW;}
+		//! Returns true if the statement has finished executing (SQLITE_DONE).
+		inline bool IsDone() const {return GetResultCode() == SQLITE_DONE;}
+		//! Returns true if the database or a table is locked (SQLITE_BUSY or SQLITE_LOCKED).\n
+		//! The operation can be retried later.
+		inline bool IsBusy() const {return GetResultCode() == SQLITE_BUSY || GetResultCode() == SQLITE_LOCKED;}
+		//! Returns true if a constraint was violated (SQLITE_CONSTRAINT).
+		inline bool IsConstraintViolation() const {return GetResultCode() == SQLITE_CONSTRAINT;}
+
+		//! Same as IsOk().
+		explicit operator bool() const {return IsOk();}
+
+		//! Returns the error description.\n
+		//! The detailed message of the connection [sqlite3_errmsg] is only available until the next call\n
+		//! on the connection fails or succeeds with another result code; afterwards the generic English\n
+		//! description of the result code is returned [sqlite3_errstr].
+		std::string GetErrorDescription() const
+		{
+			if(mDatabaseHandle && sqlite3_extended_errcode(mDatabaseHandle) == mResultCode)
+				return sqlite3_errmsg(mDatabaseHandle);
+
+			return sqlite3_errstr(mResultCode);
+		}
+
+	private:
+		//! Extended SQLite result code
+		int mResultCode;
+		//! Database connection which returned the result code
+		sqlite3 *mDatabaseHandle;
+	};
+};
+
+#endif // KompexSQLiteStatus_H
@@ -0,0 +1,148 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteTransactionBatch_H
+#define KompexSQLiteTransactionBatch_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteColumnLookup.h"
+#include "KompexSQLiteValue.h"
+
+namespace Kompex
+{
+	class SQLiteDatabase;
+
+	//! Collects SQL statements with their parameters and executes them in one transaction.\n
+	//! Identical SQL texts are compiled only once; the parameters of every queued statement are stored\n
+	//! one after another in a contiguous container. The prepared statements are taken from the statement cache\n
+	//! of the database and handed back after every execution, so that a batch can be filled and executed again\n
+	//! and again without recompiling and no statement outlives its connection (e.g. MoveDatabaseToMemory()).\n
+	//! e.g. \n
+	//! SQLiteTransactionBatch batch(&db);\n
+	//! batch.AddStatement("UPDATE user SET score = ? WHERE id = ?", 10, 1);\n
+	//! batch.AddStatement("UPDATE user SET score = ? WHERE id = ?", 20, 2);\n
+	//! batch.Execute();
+	class _SQLiteWrapperExport SQLiteTransactionBatch
+	{
+	public:
+		//! Constructor.
+		//! @param db		Database in which the statements shall be executed
+		SQLiteTransactionBatch(SQLiteDatabase *db);
+		//! Destructor.\n
+		//! Not executed statements are discarded.
+		virtual ~SQLiteTransactionBatch();
+
+		//! Queues a SQL statement without parameters.
+		//! @param sql				SQL statement (UTF-8)
+		void Add(const std::string &sql);
+		//! Queues a SQL statement with parameters.
+		//! @param sql				SQL statement (UTF-8)
+		//! @param parameters		Values for the SQL parameters; the first value is bound to the first parameter
+		void Add(const std::string &sql, const std::vector<SQLiteValue> &parameters);
+		//! Queues a SQL statement with parameters.
+		//! @param sql				SQL statement (UTF-8)
+		//! @param parameters		Values for the SQL parameters; the first value is bound to the first parameter
+		template<class... T>
+		void AddStatement(const std::string &sql, const T&... parameters)
+		{
+			unsigned int statementIndex = GetStatementIndex(sql);
+			size_t parameterOffset = mParameters.size();
+			AppendParameters(parameters...);
+			AddEntry(statementIndex, parameterOffset);
+		}
+
+		//! Executes all queued statements in their order in one transaction and clears the queue.\n
+		//! If the database connection is already inside of a transaction, the statements are executed\n
+		//! within a savepoint of that transaction and no commit is done.\n
+		//! If a statement fails, the transaction (or the savepoint) will be rolled back, the queue will be cleared\n
+		//! and an exception is thrown.
+		void Execute();
+		//! Discards all queued statements. The prepared statements are kept.
+		void Clear();
+
+		//! Returns the number of queued statements.
+		size_t GetSize() const {return mEntries.size();}
+		//! Returns the number of distinct SQL texts which were used so far.
+		size_t GetDistinctStatementCount() const {return mStatements.size();}
+
+	protected:
+		//! Returns the index of the given SQL text in mStatements and adds it if necessary.
+		unsigned int GetStatementIndex(const std::string &sql);
+		//! Adds a queue entry for all parameters behind the given offset.
+		void AddEntry(unsigned int statementIndex, size_t parameterOffset);
+		//! Hands all prepared statements back to the statement cache of the database.
+		void ReleaseStatements();
+
+		//! End of the recursion.
+		inline void AppendParameters() {}
+		//! Appends all parameters to the parameter container.
+		template<class V, class... T>
+		inline void AppendParameters(const V &value, const T&... values)
+		{
+			mParameters.push_back(SQLiteValue(value));
+			AppendParameters(values...);
+		}
+
+	private:
+		//! Copy constructor
+		SQLiteTransactionBatch(const SQLiteTransactionBatch &batch);
+		//! Assignment operator
+		SQLiteTransactionBatch &operator=(const SQLiteTransactionBatch &batch);
+
+		//! Distinct SQL statement
+		struct Statement
+		{
+			//! SQL text (UTF-8)
+			std::string sql;
+			//! Prepared statement; taken from the statement cache during Execute()
+			sqlite3_stmt *statement;
+			//! Column name lookup table of the statement, which is kept by the statement cache
+			SQLiteColumnLookup columnLookup;
+		};
+
+		//! Queued statement
+		struct Entry
+		{
+			//! Index in mStatements
+			unsigned int statementIndex;
+			//! Number of parameters
+			unsigned int parameterCount;
+			//! Position of the first parameter in mParameters
+			size_t parameterOffset;
+		};
+
+		//! Database pointer
+		SQLiteDatabase *mDatabase;
+		//! Distinct statements
+		std::vector<Statement> mStatements;
+		//! Lookup table SQL text -> index in mStatements
+		std::map<std::string, unsigned int> mStatementLookup;
+		//! Queued statements in their execution order
+		std::vector<Entry> mEntries;
+		//! Parameters of all queued statements
+		std::vector<SQLiteValue> mParameters;
+	};
+};
+
+#endif // KompexSQLiteTransactionBatch_H
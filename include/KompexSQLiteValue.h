@@ -0,0 +1,107 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteValue_H
+#define KompexSQLiteValue_H
+
+#include <string>
+#include <type_traits>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteView.h"
+
+namespace Kompex
+{
+	//! Owning copy of a single SQL value (NULL, INTEGER, FLOAT, TEXT or BLOB),\n
+	//! which can be stored until it is bound to a prepared statement.
+	class _SQLiteWrapperExport SQLiteValue
+	{
+	public:
+		//! Constructor for a NULL value
+		SQLiteValue(): mType(SQLITE_NULL), mInteger(0), mDouble(0.0) {}
+		//! Constructor for an integral value (int, long, unsigned int, size_t, int64, ...).\n
+		//! The value is stored as int64; unsigned values above the int64 range wrap around.
+		template<class T>
+		SQLiteValue(T value, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type* = 0):
+			mType(SQLITE_INTEGER), mInteger(static_cast<int64>(value)), mDouble(0.0) {}
+		//! Constructor for a bool value
+		SQLiteValue(bool value): mType(SQLITE_INTEGER), mInteger(value ? 1 : 0), mDouble(0.0) {}
+		//! Constructor for a floating point value (float, double, long double); the value is stored as double
+		template<class T>
+		SQLiteValue(T value, typename std::enable_if<std::is_floating_point<T>::value>::type* = 0):
+			mType(SQLITE_FLOAT), mInteger(0), mDouble(static_cast<double>(value)) {}
+		//! Constructor for a UTF-8 string; a null pointer will be stored as NULL value
+		SQLiteValue(const char *value): mType(value ? SQLITE_TEXT : SQLITE_NULL), mInteger(0), mDouble(0.0), mData(value ? value : "") {}
+		//! Constructor for a UTF-8 string
+		SQLiteValue(const std::string &value): mType(SQLITE_TEXT), mInteger(0), mDouble(0.0), mData(value) {}
+		//! Constructor for a UTF-8 string; a NULL view will be stored as NULL value
+		SQLiteValue(const SQLiteTextView &value): mType(value.IsNull() ? SQLITE_NULL : SQLITE_TEXT), mInteger(0), mDouble(0.0), mData(value.ToString()) {}
+		//! Constructor for a BLOB
+		SQLiteValue(const SQLiteBlobView &value): mType(SQLITE_BLOB), mInteger(0), mDouble(0.0), mData(static_cast<const char*>(value.data), value.data ? value.bytes : 0) {}
+
+		//! Returns the datatype code of the value (SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL).
+		int GetType() const {return mType;}
+		//! Returns true if the value is NULL.
+		bool IsNull() const {return mType == SQLITE_NULL;}
+		//! Returns the integer value.
+		int64 GetInt64() const {return mInteger;}
+		//! Returns the floating point value.
+		double GetDouble() const {return mDouble;}
+		//! Returns the text or BLOB data.
+		const std::string &GetData() const {return mData;}
+		//! Returns the number of bytes which the value occupies in the database (approximately).
+		size_t GetSize() const {return (mType == SQLITE_TEXT || mType == SQLITE_BLOB) ? mData.length() : 8;}
+
+		//! Binds the value to a parameter of a prepared statement.\n
+		//! Text and BLOB data is not copied by SQLite, therefore the value must neither be changed nor destroyed\n
+		//! until the statement was reset or the parameter was bound again.
+		//! @param statement		Prepared statement
+		//! @param index			Index of the SQL parameter (the leftmost parameter has an index of 1)
+		//! @return					SQLite result code of the sqlite3_bind_*() function
+		int Bind(sqlite3_stmt *statement, int index) const
+		{
+			switch(mType)
+			{
+				case SQLITE_INTEGER:
+					return sqlite3_bind_int64(statement, index, mInteger);
+				case SQLITE_FLOAT:
+					return sqlite3_bind_double(statement, index, mDouble);
+				case SQLITE_TEXT:
+					return sqlite3_bind_text(statement, index, mData.data(), static_cast<int>(mData.length()), SQLITE_STATIC);
+				case SQLITE_BLOB:
+					return sqlite3_bind_blob(statement, index, mData.data(), static_cast<int>(mData.length()), SQLITE_STATIC);
+				default:
+					return sqlite3_bind_null(statement, index);
+			}
+		}
+
+	private:
+		//! Datatype code
+		int mType;
+		//! Integer value
+		int64 mInteger;
+		//! Floating point value
+		double mDouble;
+		//! Text or BLOB data
+		std::string mData;
+	};
+};
+
+#endif // KompexSQLiteValue_H
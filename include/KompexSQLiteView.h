@@ -0,0 +1,71 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteView_H
+#define KompexSQLiteView_H
+
+#include <string>
+
+#include "KompexSQLitePrerequisites.h"
+
+namespace Kompex
+{
+	//! Non-owning view of a UTF-8 text value which is stored inside of SQLite.\n
+	//! The view is only valid until the next FetchRow(), Reset() or FreeQuery() call\n
+	//! of the statement from which it was taken.
+	struct _SQLiteWrapperExport SQLiteTextView
+	{
+		//! Constructor for a NULL value
+		SQLiteTextView(): data(0), length(0) {}
+		//! Constructor
+		SQLiteTextView(const char *text, int textLength): data(text), length(textLength) {}
+
+		//! Returns true if the value is NULL.
+		bool IsNull() const {return data == 0;}
+		//! Returns true if the text is empty or NULL.
+		bool IsEmpty() const {return length == 0;}
+		//! Returns a copy of the text. NULL values will be represented as an empty string.
+		std::string ToString() const {return data ? std::string(data, length) : std::string();}
+
+		//! Text (zero-terminated); null pointer for NULL values
+		const char *data;
+		//! Length of the text in bytes, without the zero terminator
+		int length;
+	};
+
+	//! Non-owning view of a BLOB value which is stored inside of SQLite.\n
+	//! The view is only valid until the next FetchRow(), Reset() or FreeQuery() call\n
+	//! of the statement from which it was taken.
+	struct _SQLiteWrapperExport SQLiteBlobView
+	{
+		//! Constructor for a NULL value
+		SQLiteBlobView(): data(0), bytes(0) {}
+		//! Constructor
+		SQLiteBlobView(const void *blob, int numberOfBytes): data(blob), bytes(numberOfBytes) {}
+
+		//! Returns true if the value is NULL or a zero-length BLOB.
+		bool IsEmpty() const {return bytes == 0;}
+
+		//! BLOB data; null pointer for NULL values and zero-length BLOBs
+		const void *data;
+		//! Size of the BLOB in bytes
+		int bytes;
+	};
+};
+
+#endif // KompexSQLiteView_H
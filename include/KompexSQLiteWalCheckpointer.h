@@ -0,0 +1,145 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteWalCheckpointer_H
+#define KompexSQLiteWalCheckpointer_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "sqlite3.h"
+
+#include "KompexSQLitePrerequisites.h"
+#include "KompexSQLiteDatabase.h"
+
+namespace Kompex
+{
+	//! Statistics of a SQLiteWalCheckpointer.
+	struct SQLiteWalCheckpointerStatistics
+	{
+		//! Number of frames in the WAL file after the last commit
+		int walFrames;
+		//! Size of the WAL file in bytes (calculated from the number of frames)
+		int64 walBytes;
+		//! Number of commits which were reported by the WAL hook
+		uint64 commits;
+		//! Number of PASSIVE checkpoints which were started because the WAL file reached the threshold
+		uint64 passiveCheckpoints;
+		//! Number of RESTART/TRUNCATE checkpoints which were started during idle times
+		uint64 idleCheckpoints;
+		//! Number of checkpoints which could not be completed because of concurrent readers or writers
+		uint64 busyCheckpoints;
+		//! Total number of frames which were written back into the database file
+		uint64 checkpointedFrames;
+		//! Duration of the last checkpoint in seconds
+		double lastCheckpointSeconds;
+		//! Duration of the longest checkpoint in seconds
+		double maxCheckpointSeconds;
+		//! Total duration of all checkpoints in seconds
+		double totalCheckpointSeconds;
+	};
+
+	//! Runs the checkpoints of a database in WAL mode on a background thread.\n
+	//! By default SQLite runs a checkpoint within the commit of the transaction which lets the WAL file\n
+	//! grow beyond 1000 pages, i.e. the committing thread has to wait for it. The checkpointer replaces this\n
+	//! automatic checkpoint with a WAL hook [sqlite3_wal_hook] on the writer connection, which only records the\n
+	//! WAL size and wakes up the background thread. The thread uses its own connection and runs\n
+	//! - a PASSIVE checkpoint as soon as the WAL file has reached the threshold and\n
+	//! - a RESTART or TRUNCATE checkpoint when no transaction was committed during the idle time,\n
+	//!   so that the WAL file does not grow any further.\n
+	//! The checkpointer must be destroyed before the writer connection is closed.\n
+	//! e.g. \n
+	//! SQLiteDatabase db;\n
+	//! db.Open("test.db", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0, SQLiteDatabase::JournalSettings());\n
+	//! SQLiteWalCheckpointer checkpointer(&db);
+	class _SQLiteWrapperExport SQLiteWalCheckpointer
+	{
+	public:
+		/**
+		Constructor.\n
+		Installs the WAL hook on the writer connection and starts the background thread.
+
+		@param db					Writer connection (must be in WAL mode)
+		@param thresholdFrames		WAL size in frames (pages) which triggers a PASSIVE checkpoint
+		@param idleTime				Time in milliseconds without commits after which a RESTART/TRUNCATE checkpoint is run
+		@param idleMode				Checkpoint mode during idle times (CHECKPOINT_RESTART or CHECKPOINT_TRUNCATE)
+		@param busyTimeout			Milliseconds which the checkpoint connection waits for readers and writers
+		*/
+		SQLiteWalCheckpointer(SQLiteDatabase *db, int thresholdFrames = 1000, unsigned int idleTime = 1000,
+			SQLiteDatabase::CheckpointMode idleMode = SQLiteDatabase::CHECKPOINT_TRUNCATE, int busyTimeout = 100);
+		//! Destructor.\n
+		//! Stops the background thread and restores the automatic checkpoints of the writer connection.
+		virtual ~SQLiteWalCheckpointer();
+
+		//! Wakes up the background thread to run a PASSIVE checkpoint immediately.
+		void RequestCheckpoint();
+		//! Returns the statistics.
+		SQLiteWalCheckpointerStatistics GetStatistics() const;
+
+	protected:
+		//! Callback function for the WAL hook [sqlite3_wal_hook]; called by the writer after every commit.
+		static int WalHook(void *ptr, sqlite3 *db, const char *databaseName, int walFrames);
+		//! Main loop of the background thread.
+		void Run();
+		//! Stops the background thread.
+		void Stop();
+
+	private:
+		//! Copy constructor
+		SQLiteWalCheckpointer(const SQLiteWalCheckpointer &checkpointer);
+		//! Assignment operator
+		SQLiteWalCheckpointer &operator=(const SQLiteWalCheckpointer &checkpointer);
+
+		//! Writer connection
+		SQLiteDatabase *mWriter;
+		//! Connection of the background thread
+		SQLiteDatabase mCheckpointDatabase;
+		//! WAL size in frames which triggers a PASSIVE checkpoint
+		int mThresholdFrames;
+		//! Idle time after which the idle checkpoint is run
+		std::chrono::milliseconds mIdleTime;
+		//! Checkpoint mode during idle times
+		SQLiteDatabase::CheckpointMode mIdleMode;
+		//! Page size of the database
+		int mPageSize;
+		//! Automatic checkpoint setting of the writer before the checkpointer was started [PRAGMA wal_autocheckpoint]
+		int mPreviousAutoCheckpoint;
+
+		//! Protects the state and the statistics
+		mutable std::mutex mMutex;
+		//! Wakes up the background thread
+		std::condition_variable mCondition;
+		//! Was a PASSIVE checkpoint requested?
+		bool mIsCheckpointRequested;
+		//! Shall the background thread stop?
+		bool mIsStopRequested;
+		//! Are there frames in the WAL file which were not yet written back by an idle checkpoint?
+		bool mIsIdleCheckpointPending;
+		//! Time of the last commit
+		std::chrono::steady_clock::time_point mLastCommitTime;
+		//! Statistics
+		SQLiteWalCheckpointerStatistics mStatistics;
+
+		//! Background thread
+		std::thread mThread;
+	};
+};
+
+#endif // KompexSQLiteWalCheckpointer_H
@@ -0,0 +1,500 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "KompexSQLiteAllocator.h"
+#include "KompexSQLiteException.h"
+
+namespace Kompex
+{
+
+namespace
+{
+	// every block starts with a header which holds the usable size; SQLite requires an 8 byte alignment
+	const size_t HEADER_SIZE = 8;
+	const size_t MAX_BLOCK_SIZE = 8192;
+	const size_t CHUNK_SIZE = 64 * 1024;
+	// limit of a thread cache per size class in bytes; half of it is exchanged with the pool at once
+	const size_t THREAD_CACHE_BYTES = 32 * 1024;
+
+	// 8 byte steps up to 64 bytes, afterwards four classes per power of two
+	const size_t SIZE_CLASSES[] = {
+		8, 16, 24, 32, 40, 48, 56, 64,
+		80, 96, 112, 128, 160, 192, 224, 256,
+		320, 384, 448, 512, 640, 768, 896, 1024,
+		1280, 1536, 1792, 2048, 2560, 3072, 3584, 4096,
+		5120, 6144, 7168, 8192
+	};
+	const unsigned int SIZE_CLASS_COUNT = sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]);
+
+	struct FreeBlock
+	{
+		FreeBlock *next;
+	};
+
+	struct SizeClass
+	{
+		SizeClass(): freeList(0), allocations(0), frees(0), reservedBytes(0), cachedAllocations(0), cachedFrees(0) {}
+
+		std::mutex mutex;
+		FreeBlock *freeList;
+		// protected by the mutex
+		uint64 allocations;
+		uint64 frees;
+		uint64 reservedBytes;
+		// reported by the thread caches
+		std::atomic<uint64> cachedAllocations;
+		std::atomic<uint64> cachedFrees;
+	};
+
+	SizeClass sizeClasses[SIZE_CLASS_COUNT];
+	// size class for every multiple of 8 bytes up to MAX_BLOCK_SIZE
+	unsigned char sizeClassLookup[MAX_BLOCK_SIZE / 8 + 1];
+
+	std::mutex chunkMutex;
+	std::vector<void*> chunks;
+
+	std::atomic<uint64> largeAllocations(0);
+	std::atomic<uint64> largeFrees(0);
+	std::atomic<uint64> largeBytes(0);
+
+	// incremented when the pool memory is released, so that the thread caches drop their blocks
+	std::atomic<unsigned int> poolGeneration(1);
+
+	SQLiteAllocator::AllocatorType installedType = SQLiteAllocator::ALLOCATOR_SYSTEM;
+	sqlite3_mem_methods systemMethods;
+	bool isSystemMethodsSaved = false;
+
+	inline unsigned int GetSizeClass(size_t bytes)
+	{
+		return sizeClassLookup[(bytes + 7) >> 3];
+	}
+
+	inline size_t GetUsableSize(void *memory)
+	{
+		return static_cast<size_t>(*reinterpret_cast<uint64*>(static_cast<char*>(memory) - HEADER_SIZE));
+	}
+
+	inline void *ToMemory(void *block, size_t usableSize)
+	{
+		*static_cast<uint64*>(block) = usableSize;
+		return static_cast<char*>(block) + HEADER_SIZE;
+	}
+
+	inline void *ToBlock(void *memory)
+	{
+		return static_cast<char*>(memory) - HEADER_SIZE;
+	}
+
+	//! Carves a new chunk into blocks of the size class; the size class must be locked.
+	bool AddChunk(SizeClass &sizeClass, unsigned int classIndex)
+	{
+		size_t blockSize = SIZE_CLASSES[classIndex] + HEADER_SIZE;
+		size_t blockCount = std::max<size_t>(CHUNK_SIZE / blockSize, 4);
+		char *chunk = static_cast<char*>(std::malloc(blockCount * blockSize));
+		if(!chunk)
+			return false;
+
+		{
+			std::lock_guard<std::mutex> lock(chunkMutex);
+			chunks.push_back(chunk);
+		}
+
+		for(size_t i = 0; i < blockCount; ++i)
+		{
+			FreeBlock *block = reinterpret_cast<FreeBlock*>(chunk + i * blockSize);
+			block->next = sizeClass.freeList;
+			sizeClass.freeList = block;
+		}
+
+		sizeClass.reservedBytes += blockCount * blockSize;
+		return true;
+	}
+
+	//! Takes up to count blocks from the pool and returns the number of taken blocks.
+	size_t TakeBlocks(unsigned int classIndex, size_t count, FreeBlock *&head)
+	{
+		SizeClass &sizeClass = sizeClasses[classIndex];
+		std::lock_guard<std::mutex> lock(sizeClass.mutex);
+
+		size_t taken = 0;
+		while(taken < count)
+		{
+			if(!sizeClass.freeList && !AddChunk(sizeClass, classIndex))
+				break;
+
+			FreeBlock *block = sizeClass.freeList;
+			sizeClass.freeList = block->next;
+			block->next = head;
+			head = block;
+			++taken;
+		}
+		return taken;
+	}
+
+	//! Returns a list of blocks to the pool.
+	void ReturnBlocks(unsigned int classIndex, FreeBlock *head, FreeBlock *tail)
+	{
+		SizeClass &sizeClass = sizeClasses[classIndex];
+		std::lock_guard<std::mutex> lock(sizeClass.mutex);
+		tail->next = sizeClass.freeList;
+		sizeClass.freeList = head;
+	}
+
+	void *LargeMalloc(size_t bytes)
+	{
+		size_t usableSize = (bytes + 7) & ~static_cast<size_t>(7);
+		void *block = std::malloc(usableSize + HEADER_SIZE);
+		if(!block)
+			return 0;
+
+		largeAllocations.fetch_add(1, std::memory_order_relaxed);
+		largeBytes.fetch_add(usableSize, std::memory_order_relaxed);
+		return ToMemory(block, usableSize);
+	}
+
+	void LargeFree(void *memory)
+	{
+		largeFrees.fetch_add(1, std::memory_order_relaxed);
+		largeBytes.fetch_sub(GetUsableSize(memory), std::memory_order_relaxed);
+		std::free(ToBlock(memory));
+	}
+
+	//! Free blocks of one thread
+	struct ThreadCache
+	{
+		ThreadCache(): generation(poolGeneration.load())
+		{
+			for(unsigned int i = 0; i < SIZE_CLASS_COUNT; ++i)
+			{
+				heads[i] = 0;
+				counts[i] = 0;
+				allocations[i] = 0;
+				frees[i] = 0;
+			}
+		}
+
+		~ThreadCache()
+		{
+			// the counters stay valid when the pool memory was released, the blocks don't
+			bool isPoolValid = generation == poolGeneration.load();
+			for(unsigned int i = 0; i < SIZE_CLASS_COUNT; ++i)
+			{
+				Flush(i);
+				if(isPoolValid && heads[i])
+				{
+					FreeBlock *tail = heads[i];
+					while(tail->next)
+						tail = tail->next;
+					ReturnBlocks(i, heads[i], tail);
+				}
+			}
+		}
+
+		//! Forgets all blocks if the pool memory was released in the meantime.
+		inline void CheckGeneration()
+		{
+			unsigned int currentGeneration = poolGeneration.load(std::memory_order_relaxed);
+			if(generation != currentGeneration)
+			{
+				for(unsigned int i = 0; i < SIZE_CLASS_COUNT; ++i)
+					Flush(i);
+				*this = ThreadCache();
+				generation = currentGeneration;
+			}
+		}
+
+		//! Reports the counters to the pool.
+		void Flush(unsigned int classIndex)
+		{
+			sizeClasses[classIndex].cachedAllocations.fetch_add(allocations[classIndex], std::memory_order_relaxed);
+			sizeClasses[classIndex].cachedFrees.fetch_add(frees[classIndex], std::memory_order_relaxed);
+			allocations[classIndex] = 0;
+			frees[classIndex] = 0;
+		}
+
+		static inline size_t GetLimit(unsigned int classIndex)
+		{
+			return std::max<size_t>(THREAD_CACHE_BYTES / SIZE_CLASSES[classIndex], 8);
+		}
+
+		FreeBlock *heads[SIZE_CLASS_COUNT];
+		size_t counts[SIZE_CLASS_COUNT];
+		uint64 allocations[SIZE_CLASS_COUNT];
+		uint64 frees[SIZE_CLASS_COUNT];
+		unsigned int generation;
+	};
+
+	ThreadCache &GetThreadCache()
+	{
+		static thread_local ThreadCache cache;
+		return cache;
+	}
+
+	void InitSizeClassLookup()
+	{
+		unsigned int classIndex = 0;
+		for(size_t i = 0; i <= MAX_BLOCK_SIZE / 8; ++i)
+		{
+			while(SIZE_CLASSES[classIndex] < i * 8)
+				++classIndex;
+			sizeClassLookup[i] = static_cast<unsigned char>(classIndex);
+		}
+	}
+}
+
+void SQLiteAllocator::Install(AllocatorType type)
+{
+	if(!isSystemMethodsSaved)
+	{
+		if(sqlite3_config(SQLITE_CONFIG_GETMALLOC, &systemMethods) != SQLITE_OK)
+			KOMPEX_EXCEPT("Install() the allocator can only be installed before SQLite is initialized or after sqlite3_shutdown()");
+		isSystemMethodsSaved = true;
+		InitSizeClassLookup();
+	}
+
+	sqlite3_mem_methods methods;
+	switch(type)
+	{
+		case ALLOCATOR_POOL:
+			methods.xMalloc = &SQLiteAllocator::PoolMalloc;
+			methods.xFree = &SQLiteAllocator::PoolFree;
+			methods.xRealloc = &SQLiteAllocator::PoolRealloc;
+			break;
+		case ALLOCATOR_THREAD_CACHING:
+			methods.xMalloc = &SQLiteAllocator::CachingMalloc;
+			methods.xFree = &SQLiteAllocator::CachingFree;
+			methods.xRealloc = &SQLiteAllocator::CachingRealloc;
+			break;
+		default:
+			methods = systemMethods;
+	}
+
+	if(type != ALLOCATOR_SYSTEM)
+	{
+		methods.xSize = &SQLiteAllocator::Size;
+		methods.xRoundup = &SQLiteAllocator::Roundup;
+		methods.xInit = &SQLiteAllocator::Init;
+		methods.xShutdown = &SQLiteAllocator::Shutdown;
+		methods.pAppData = 0;
+	}
+
+	if(sqlite3_config(SQLITE_CONFIG_MALLOC, &methods) != SQLITE_OK)
+		KOMPEX_EXCEPT("Install() the allocator can only be installed before SQLite is initialized or after sqlite3_shutdown()");
+
+	installedType = type;
+}
+
+SQLiteAllocator::AllocatorType SQLiteAllocator::GetInstalledType()
+{
+	return installedType;
+}
+
+std::vector<SQLiteAllocatorStatistics> SQLiteAllocator::GetStatistics()
+{
+	std::vector<SQLiteAllocatorStatistics> statistics(SIZE_CLASS_COUNT + 1);
+	for(unsigned int i = 0; i < SIZE_CLASS_COUNT; ++i)
+	{
+		SizeClass &sizeClass = sizeClasses[i];
+		std::lock_guard<std::mutex> lock(sizeClass.mutex);
+		statistics[i].blockSize = SIZE_CLASSES[i];
+		statistics[i].allocations = sizeClass.allocations + sizeClass.cachedAllocations.load(std::memory_order_relaxed);
+		statistics[i].frees = sizeClass.frees + sizeClass.cachedFrees.load(std::memory_order_relaxed);
+		statistics[i].reservedBytes = sizeClass.reservedBytes;
+	}
+
+	SQLiteAllocatorStatistics &large = statistics[SIZE_CLASS_COUNT];
+	large.blockSize = 0;
+	large.allocations = largeAllocations.load(std::memory_order_relaxed);
+	large.frees = largeFrees.load(std::memory_order_relaxed);
+	large.reservedBytes = largeBytes.load(std::memory_order_relaxed);
+
+	return statistics;
+}
+
+void *SQLiteAllocator::PoolMalloc(int bytes)
+{
+	size_t size = bytes > 0 ? static_cast<size_t>(bytes) : 1;
+	if(size > MAX_BLOCK_SIZE)
+		return LargeMalloc(size);
+
+	unsigned int classIndex = GetSizeClass(size);
+	SizeClass &sizeClass = sizeClasses[classIndex];
+	std::lock_guard<std::mutex> lock(sizeClass.mutex);
+
+	if(!sizeClass.freeList && !AddChunk(sizeClass, classIndex))
+		return 0;
+
+	FreeBlock *block = sizeClass.freeList;
+	sizeClass.freeList = block->next;
+	++sizeClass.allocations;
+	return ToMemory(block, SIZE_CLASSES[classIndex]);
+}
+
+void SQLiteAllocator::PoolFree(void *memory)
+{
+	if(!memory)
+		return;
+
+	size_t size = GetUsableSize(memory);
+	if(size > MAX_BLOCK_SIZE)
+		return LargeFree(memory);
+
+	SizeClass &sizeClass = sizeClasses[GetSizeClass(size)];
+	FreeBlock *block = static_cast<FreeBlock*>(ToBlock(memory));
+
+	std::lock_guard<std::mutex> lock(sizeClass.mutex);
+	block->next = sizeClass.freeList;
+	sizeClass.freeList = block;
+	++sizeClass.frees;
+}
+
+void *SQLiteAllocator::PoolRealloc(void *memory, int bytes)
+{
+	size_t size = GetUsableSize(memory);
+	// the block is kept if it is large enough and not oversized
+	if(static_cast<size_t>(bytes) <= size && static_cast<size_t>(bytes) > size / 2)
+		return memory;
+
+	void *newMemory = PoolMalloc(bytes);
+	if(newMemory)
+	{
+		std::memcpy(newMemory, memory, std::min(size, static_cast<size_t>(bytes)));
+		PoolFree(memory);
+	}
+	return newMemory;
+}
+
+void *SQLiteAllocator::CachingMalloc(int bytes)
+{
+	size_t size = bytes > 0 ? static_cast<size_t>(bytes) : 1;
+	if(size > MAX_BLOCK_SIZE)
+		return LargeMalloc(size);
+
+	unsigned int classIndex = GetSizeClass(size);
+	ThreadCache &cache = GetThreadCache();
+	cache.CheckGeneration();
+
+	if(!cache.heads[classIndex])
+	{
+		cache.counts[classIndex] = TakeBlocks(classIndex, ThreadCache::GetLimit(classIndex) / 2, cache.heads[classIndex]);
+		cache.Flush(classIndex);
+		if(!cache.heads[classIndex])
+			return 0;
+	}
+
+	FreeBlock *block = cache.heads[classIndex];
+	cache.heads[classIndex] = block->next;
+	--cache.counts[classIndex];
+	++cache.allocations[classIndex];
+	return ToMemory(block, SIZE_CLASSES[classIndex]);
+}
+
+void SQLiteAllocator::CachingFree(void *memory)
+{
+	if(!memory)
+		return;
+
+	size_t size = GetUsableSize(memory);
+	if(size > MAX_BLOCK_SIZE)
+		return LargeFree(memory);
+
+	unsigned int classIndex = GetSizeClass(size);
+	ThreadCache &cache = GetThreadCache();
+	cache.CheckGeneration();
+
+	FreeBlock *block = static_cast<FreeBlock*>(ToBlock(memory));
+	block->next = cache.heads[classIndex];
+	cache.heads[classIndex] = block;
+	++cache.counts[classIndex];
+	++cache.frees[classIndex];
+
+	// hand the half of the cache back to the pool, so that the blocks can be used by other threads
+	size_t limit = ThreadCache::GetLimit(classIndex);
+	if(cache.counts[classIndex] > limit)
+	{
+		FreeBlock *head = cache.heads[classIndex];
+		FreeBlock *tail = head;
+		for(size_t i = 1; i < limit / 2; ++i)
+			tail = tail->next;
+
+		cache.heads[classIndex] = tail->next;
+		cache.counts[classIndex] -= limit / 2;
+		ReturnBlocks(classIndex, head, tail);
+		cache.Flush(classIndex);
+	}
+}
+
+void *SQLiteAllocator::CachingRealloc(void *memory, int bytes)
+{
+	size_t size = GetUsableSize(memory);
+	if(static_cast<size_t>(bytes) <= size && static_cast<size_t>(bytes) > size / 2)
+		return memory;
+
+	void *newMemory = CachingMalloc(bytes);
+	if(newMemory)
+	{
+		std::memcpy(newMemory, memory, std::min(size, static_cast<size_t>(bytes)));
+		CachingFree(memory);
+	}
+	return newMemory;
+}
+
+int SQLiteAllocator::Size(void *memory)
+{
+	return memory ? static_cast<int>(GetUsableSize(memory)) : 0;
+}
+
+int SQLiteAllocator::Roundup(int bytes)
+{
+	size_t size = bytes > 0 ? static_cast<size_t>(bytes) : 1;
+	if(size > MAX_BLOCK_SIZE)
+		return static_cast<int>((size + 7) & ~static_cast<size_t>(7));
+
+	return static_cast<int>(SIZE_CLASSES[GetSizeClass(size)]);
+}
+
+int SQLiteAllocator::Init(void *)
+{
+	return SQLITE_OK;
+}
+
+void SQLiteAllocator::Shutdown(void *)
+{
+	// SQLite has freed all memory; the blocks in the thread caches become invalid
+	poolGeneration.fetch_add(1);
+
+	for(unsigned int i = 0; i < SIZE_CLASS_COUNT; ++i)
+	{
+		std::lock_guard<std::mutex> lock(sizeClasses[i].mutex);
+		sizeClasses[i].freeList = 0;
+		sizeClasses[i].reservedBytes = 0;
+	}
+
+	std::lock_guard<std::mutex> lock(chunkMutex);
+	for(std::vector<void*>::iterator iter = chunks.begin(); iter != chunks.end(); ++iter)
+		std::free(*iter);
+	chunks.clear();
+}
+
+}	// namespace Kompex
@@ -0,0 +1,260 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "KompexSQLiteAsyncExecutor.h"
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteException.h"
+
+namespace Kompex
+{
+
+namespace
+{
+	//! Executes a statement with a prepared statement from the statement cache and
+	//! calls rowHandler(statement) for every result row.
+	template<class H>
+	void ExecuteCachedStatement(SQLiteDatabase &db, const std::string &sql, const std::vector<SQLiteValue> &parameters, H rowHandler)
+	{
+		sqlite3 *handle = db.GetDatabaseHandle();
+		SQLiteColumnLookup columnLookup;
+		sqlite3_stmt *statement = db.GetStatementCache().Acquire(handle, sql.c_str(), columnLookup);
+
+		int rc = SQLITE_OK;
+		for(size_t i = 0; i < parameters.size() && rc == SQLITE_OK; ++i)
+			rc = parameters[i].Bind(statement, static_cast<int>(i + 1));
+
+		if(rc == SQLITE_OK)
+		{
+			while((rc = sqlite3_step(statement)) == SQLITE_ROW)
+				rowHandler(statement);
+		}
+
+		std::string errMsg;
+		if(rc != SQLITE_DONE)
+			errMsg = sqlite3_errmsg(handle);
+
+		db.GetStatementCache().Release(statement, columnLookup);
+
+		if(!errMsg.empty())
+			KOMPEX_EXCEPT(errMsg);
+	}
+
+	SQLiteValue GetColumnValue(sqlite3_stmt *statement, int column)
+	{
+		switch(sqlite3_column_type(statement, column))
+		{
+			case SQLITE_INTEGER:
+				return SQLiteValue(static_cast<int64>(sqlite3_column_int64(statement, column)));
+			case SQLITE_FLOAT:
+				return SQLiteValue(sqlite3_column_double(statement, column));
+			case SQLITE_TEXT:
+			{
+				const char *text = reinterpret_cast<const char*>(sqlite3_column_text(statement, column));
+				return SQLiteValue(SQLiteTextView(text, sqlite3_column_bytes(statement, column)));
+			}
+			case SQLITE_BLOB:
+			{
+				const void *blob = sqlite3_column_blob(statement, column);
+				return SQLiteValue(SQLiteBlobView(blob, sqlite3_column_bytes(statement, column)));
+			}
+			default:
+				return SQLiteValue();
+		}
+	}
+}
+
+SQLiteAsyncExecutor::SQLiteAsyncExecutor(SQLiteDatabase *db, int progressInterval):
+	mDatabase(db),
+	mIsStopRequested(false),
+	mCurrentTask(0),
+	mInterruptReason(INTERRUPT_NONE)
+{
+	if(!mDatabase || !mDatabase->GetDatabaseHandle())
+		KOMPEX_EXCEPT("SQLiteAsyncExecutor() database is not opened");
+
+	sqlite3_progress_handler(mDatabase->GetDatabaseHandle(), progressInterval > 0 ? progressInterval : 1000, &Kompex::SQLiteAsyncExecutor::ProgressHandler, this);
+
+	mThread = std::thread(&SQLiteAsyncExecutor::Run, this);
+}
+
+SQLiteAsyncExecutor::~SQLiteAsyncExecutor()
+{
+	Stop();
+
+	if(mDatabase->GetDatabaseHandle())
+		sqlite3_progress_handler(mDatabase->GetDatabaseHandle(), 0, 0, 0);
+}
+
+void SQLiteAsyncExecutor::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsStopRequested.store(true);
+	}
+	mCondition.notify_one();
+
+	if(mThread.joinable())
+		mThread.join();
+}
+
+SQLiteAsyncResult<std::vector<SQLiteAsyncExecutor::Row> > SQLiteAsyncExecutor::Query(const std::string &sql, const std::vector<SQLiteValue> &parameters, unsigned int timeout)
+{
+	return Submit([sql, parameters](SQLiteDatabase &db) -> std::vector<Row>
+	{
+		std::vector<Row> rows;
+		ExecuteCachedStatement(db, sql, parameters, [&rows](sqlite3_stmt *statement)
+		{
+			int columnCount = sqlite3_column_count(statement);
+			rows.push_back(Row());
+			rows.back().reserve(columnCount);
+			for(int i = 0; i < columnCount; ++i)
+				rows.back().push_back(GetColumnValue(statement, i));
+		});
+		return rows;
+	}, timeout);
+}
+
+SQLiteAsyncResult<int> SQLiteAsyncExecutor::Execute(const std::string &sql, const std::vector<SQLiteValue> &parameters, unsigned int timeout)
+{
+	return Submit([sql, parameters](SQLiteDatabase &db) -> int
+	{
+		ExecuteCachedStatement(db, sql, parameters, [](sqlite3_stmt*) {});
+		return db.GetDatabaseChanges();
+	}, timeout);
+}
+
+void SQLiteAsyncExecutor::Enqueue(Task &task, unsigned int timeout)
+{
+	task.hasDeadline = timeout > 0;
+	if(task.hasDeadline)
+		task.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if(mIsStopRequested.load())
+			KOMPEX_EXCEPT("SQLiteAsyncExecutor the executor is stopped");
+
+		mQueue.push_back(task);
+	}
+	mCondition.notify_one();
+}
+
+void SQLiteAsyncExecutor::CancelAll()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for(std::deque<Task>::iterator iter = mQueue.begin(); iter != mQueue.end(); ++iter)
+		iter->cancelFlag->store(true, std::memory_order_relaxed);
+
+	if(mCurrentCancelFlag)
+		mCurrentCancelFlag->store(true, std::memory_order_relaxed);
+}
+
+size_t SQLiteAsyncExecutor::GetQueueSize() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mQueue.size();
+}
+
+void SQLiteAsyncExecutor::Run()
+{
+	while(true)
+	{
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			while(mQueue.empty() && !mIsStopRequested.load())
+				mCondition.wait(lock);
+
+			if(mIsStopRequested.load())
+				break;
+
+			task = mQueue.front();
+			mQueue.pop_front();
+			mCurrentCancelFlag = task.cancelFlag;
+		}
+
+		// the task may have been cancelled or may have expired while it was queued
+		InterruptReason reason = CheckTask(task);
+		if(reason != INTERRUPT_NONE)
+		{
+			task.fail(GetInterruptException(reason));
+		}
+		else
+		{
+			mCurrentTask = &task;
+			mInterruptReason = INTERRUPT_NONE;
+			task.run();
+			mCurrentTask = 0;
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mCurrentCancelFlag.reset();
+	}
+
+	// fail all queries which were not started
+	std::lock_guard<std::mutex> lock(mMutex);
+	for(std::deque<Task>::iterator iter = mQueue.begin(); iter != mQueue.end(); ++iter)
+		iter->fail(GetInterruptException(INTERRUPT_STOPPED));
+	mQueue.clear();
+}
+
+SQLiteAsyncExecutor::InterruptReason SQLiteAsyncExecutor::CheckTask(const Task &task) const
+{
+	if(mIsStopRequested.load(std::memory_order_relaxed))
+		return INTERRUPT_STOPPED;
+	if(task.cancelFlag->load(std::memory_order_relaxed))
+		return INTERRUPT_CANCELLED;
+	if(task.hasDeadline && std::chrono::steady_clock::now() >= task.deadline)
+		return INTERRUPT_DEADLINE;
+
+	return INTERRUPT_NONE;
+}
+
+int SQLiteAsyncExecutor::ProgressHandler(void *ptr)
+{
+	SQLiteAsyncExecutor *executor = static_cast<SQLiteAsyncExecutor*>(ptr);
+	if(!executor->mCurrentTask)
+		return 0;
+
+	// a non-zero return value interrupts the query with SQLITE_INTERRUPT
+	executor->mInterruptReason = executor->CheckTask(*executor->mCurrentTask);
+	return executor->mInterruptReason != INTERRUPT_NONE ? 1 : 0;
+}
+
+std::exception_ptr SQLiteAsyncExecutor::GetTaskException() const
+{
+	if(mInterruptReason != INTERRUPT_NONE)
+		return GetInterruptException(mInterruptReason);
+
+	return std::current_exception();
+}
+
+std::exception_ptr SQLiteAsyncExecutor::GetInterruptException(InterruptReason reason)
+{
+	switch(reason)
+	{
+		case INTERRUPT_CANCELLED:
+			return std::make_exception_ptr(SQLiteException(__FILE__, __LINE__, "SQLiteAsyncExecutor the query was cancelled"));
+		case INTERRUPT_DEADLINE:
+			return std::make_exception_ptr(SQLiteException(__FILE__, __LINE__, "SQLiteAsyncExecutor the deadline of the query was exceeded"));
+		default:
+			return std::make_exception_ptr(SQLiteException(__FILE__, __LINE__, "SQLiteAsyncExecutor the executor was stopped"));
+	}
+}
+
+}	// namespace Kompex
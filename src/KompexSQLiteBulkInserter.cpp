@@ -0,0 +1,340 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+
+#include "KompexSQLiteBulkInserter.h"
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteException.h"
+#include "KompexSQLiteInternal.h"
+
+namespace Kompex
+{
+
+SQLiteBulkInserter::SQLiteBulkInserter(SQLiteDatabase *db, const std::string &tableName, const std::vector<std::string> &columnNames,
+	unsigned int rowsPerCommit, size_t bytesPerCommit, bool useMultiRowInsert):
+	mDatabase(db),
+	mTableName(tableName),
+	mColumnNames(columnNames),
+	mRowsPerCommit(rowsPerCommit),
+	mBytesPerCommit(bytesPerCommit),
+	mRowsPerStatement(1),
+	mMultiRowStatement(0),
+	mSingleRowStatement(0),
+	mPendingBytes(0),
+	mUncommittedRows(0),
+	mUncommittedBytes(0),
+	mIsTransactionActive(false),
+	mInsertedRows(0),
+	mCommitCount(0),
+	mIsTimerStarted(false),
+	mIsFinished(false)
+{
+	if(!mDatabase || !mDatabase->GetDatabaseHandle())
+		KOMPEX_EXCEPT("SQLiteBulkInserter() database pointer invalid");
+	if(mColumnNames.empty())
+		KOMPEX_EXCEPT("SQLiteBulkInserter() no columns given");
+
+	if(useMultiRowInsert)
+	{
+		// the number of host parameters is limited by SQLITE_MAX_VARIABLE_NUMBER and
+		// a multi-row VALUES clause is limited like a compound SELECT by SQLITE_MAX_COMPOUND_SELECT
+		sqlite3 *handle = mDatabase->GetDatabaseHandle();
+		int variableLimit = sqlite3_limit(handle, SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+		int compoundLimit = sqlite3_limit(handle, SQLITE_LIMIT_COMPOUND_SELECT, -1);
+
+		mRowsPerStatement = variableLimit / static_cast<int>(mColumnNames.size());
+		if(compoundLimit > 0 && mRowsPerStatement > static_cast<unsigned int>(compoundLimit))
+			mRowsPerStatement = compoundLimit;
+		if(mRowsPerStatement < 1)
+			mRowsPerStatement = 1;
+	}
+
+	mPendingValues.reserve(mRowsPerStatement * mColumnNames.size());
+}
+
+SQLiteBulkInserter::~SQLiteBulkInserter()
+{
+	try
+	{
+		Finish();
+	}
+	catch(SQLiteException &exception)
+	{
+		std::cerr << "Exception Occured!" << std::endl;
+		exception.Show();
+		try
+		{
+			Rollback();
+		}
+		catch(SQLiteException &)
+		{
+		}
+	}
+
+	FreeStatements();
+}
+
+void SQLiteBulkInserter::Insert(const std::vector<SQLiteValue> &row)
+{
+	CheckRowSize(row.size());
+	for(std::vector<SQLiteValue>::const_iterator iter = row.begin(); iter != row.end(); ++iter)
+		AppendValue(*iter);
+	RowAdded();
+}
+
+void SQLiteBulkInserter::CheckRowSize(size_t size) const
+{
+	if(size != mColumnNames.size())
+		KOMPEX_EXCEPT("SQLiteBulkInserter::Insert() the number of values doesn't match the number of columns");
+}
+
+void SQLiteBulkInserter::RowAdded()
+{
+	if(!mIsTimerStarted)
+	{
+		mStartTime = std::chrono::steady_clock::now();
+		mIsTimerStarted = true;
+	}
+	mIsFinished = false;
+
+	size_t columns = mColumnNames.size();
+	if(mPendingValues.size() < mRowsPerStatement * columns)
+		return;
+
+	// enough rows for one complete INSERT statement
+	try
+	{
+		if(!mMultiRowStatement)
+		{
+			std::string sql = BuildInsertStatement(mRowsPerStatement);
+			if(sqlite3_prepare_v2(mDatabase->GetDatabaseHandle(), sql.c_str(), -1, &mMultiRowStatement, 0) != SQLITE_OK)
+				KOMPEX_EXCEPT(sqlite3_errmsg(mDatabase->GetDatabaseHandle()));
+		}
+
+		ExecuteStatement(mMultiRowStatement, 0, mPendingValues.size());
+	}
+	catch(SQLiteException&)
+	{
+		DiscardAfterFailure();
+		throw;
+	}
+
+	mUncommittedRows += mRowsPerStatement;
+	mUncommittedBytes += mPendingBytes;
+	mInsertedRows += mRowsPerStatement;
+	mPendingValues.clear();
+	mPendingBytes = 0;
+
+	if(mUncommittedRows >= mRowsPerCommit || mUncommittedBytes >= mBytesPerCommit)
+		Commit();
+}
+
+void SQLiteBulkInserter::Flush()
+{
+	size_t columns = mColumnNames.size();
+	if(mPendingValues.empty())
+		return;
+
+	// the remaining rows don't fill a multi-row statement - insert them one by one
+	unsigned int rows = static_cast<unsigned int>(mPendingValues.size() / columns);
+	unsigned int writtenRows = 0;
+	try
+	{
+		if(!mSingleRowStatement)
+		{
+			std::string sql = BuildInsertStatement(1);
+			if(sqlite3_prepare_v2(mDatabase->GetDatabaseHandle(), sql.c_str(), -1, &mSingleRowStatement, 0) != SQLITE_OK)
+				KOMPEX_EXCEPT(sqlite3_errmsg(mDatabase->GetDatabaseHandle()));
+		}
+
+		for(; writtenRows < rows; ++writtenRows)
+			ExecuteStatement(mSingleRowStatement, writtenRows * columns, columns);
+	}
+	catch(SQLiteException&)
+	{
+		// the rows before the failed one are already in the database and must not be written again
+		mUncommittedRows += writtenRows;
+		mInsertedRows += writtenRows;
+		DiscardAfterFailure();
+		throw;
+	}
+
+	mUncommittedRows += rows;
+	mUncommittedBytes += mPendingBytes;
+	mInsertedRows += rows;
+	mPendingValues.clear();
+	mPendingBytes = 0;
+}
+
+void SQLiteBulkInserter::Commit()
+{
+	Flush();
+
+	if(mIsTransactionActive)
+	{
+		if(sqlite3_exec(mDatabase->GetDatabaseHandle(), "COMMIT", 0, 0, 0) != SQLITE_OK)
+			KOMPEX_EXCEPT(sqlite3_errmsg(mDatabase->GetDatabaseHandle()));
+
+		mIsTransactionActive = false;
+		++mCommitCount;
+	}
+
+	mUncommittedRows = 0;
+	mUncommittedBytes = 0;
+}
+
+void SQLiteBulkInserter::Finish()
+{
+	if(mIsFinished)
+		return;
+
+	Commit();
+	FreeStatements();
+
+	mFinishTime = std::chrono::steady_clock::now();
+	mIsFinished = true;
+}
+
+void SQLiteBulkInserter::Rollback()
+{
+	mPendingValues.clear();
+	mPendingBytes = 0;
+
+	// the statements must not be active while the transaction will be rolled back
+	FreeStatements();
+
+	if(mIsTransactionActive)
+	{
+		// the rows since the last commit are removed again
+		mInsertedRows -= mUncommittedRows;
+		mUncommittedRows = 0;
+		mUncommittedBytes = 0;
+		mIsTransactionActive = false;
+		if(sqlite3_exec(mDatabase->GetDatabaseHandle(), "ROLLBACK", 0, 0, 0) != SQLITE_OK)
+			KOMPEX_EXCEPT(sqlite3_errmsg(mDatabase->GetDatabaseHandle()));
+	}
+
+	mUncommittedRows = 0;
+	mUncommittedBytes = 0;
+}
+
+void SQLiteBulkInserter::DiscardAfterFailure()
+{
+	if(!mIsTransactionActive)
+	{
+		// the failed statement was rolled back by SQLite; the transaction of the caller stays untouched
+		mPendingValues.clear();
+		mPendingBytes = 0;
+		return;
+	}
+
+	try
+	{
+		Rollback();
+	}
+	catch(SQLiteException&)
+	{
+		// SQLite has already rolled back the whole transaction (e.g. SQLITE_FULL)
+	}
+}
+
+void SQLiteBulkInserter::BeginTransactionIfNecessary()
+{
+	// use an already existing transaction of the connection
+	if(mIsTransactionActive || !sqlite3_get_autocommit(mDatabase->GetDatabaseHandle()))
+		return;
+
+	if(sqlite3_exec(mDatabase->GetDatabaseHandle(), "BEGIN", 0, 0, 0) != SQLITE_OK)
+		KOMPEX_EXCEPT(sqlite3_errmsg(mDatabase->GetDatabaseHandle()));
+
+	mIsTransactionActive = true;
+}
+
+void SQLiteBulkInserter::ExecuteStatement(sqlite3_stmt *statement, size_t valueOffset, size_t valueCount)
+{
+	BeginTransactionIfNecessary();
+
+	// the values are bound without copying them (SQLITE_STATIC) - they stay alive until the statement was reset
+	for(size_t i = 0; i < valueCount; ++i)
+	{
+		if(mPendingValues[valueOffset + i].Bind(statement, static_cast<int>(i + 1)) != SQLITE_OK)
+			KOMPEX_EXCEPT(sqlite3_errmsg(mDatabase->GetDatabaseHandle()));
+	}
+
+	if(sqlite3_step(statement) != SQLITE_DONE)
+	{
+		std::string errMsg = sqlite3_errmsg(mDatabase->GetDatabaseHandle());
+		sqlite3_reset(statement);
+		KOMPEX_EXCEPT(errMsg);
+	}
+
+	sqlite3_reset(statement);
+}
+
+std::string SQLiteBulkInserter::BuildInsertStatement(unsigned int rows) const
+{
+	std::string row = "(";
+	for(size_t i = 0; i < mColumnNames.size(); ++i)
+		row += (i == 0) ? "?" : ", ?";
+	row += ")";
+
+	std::string sql = "INSERT INTO " + Internal::QuoteIdentifier(mTableName) + " (";
+	for(size_t i = 0; i < mColumnNames.size(); ++i)
+	{
+		if(i != 0)
+			sql += ", ";
+		sql += Internal::QuoteIdentifier(mColumnNames[i]);
+	}
+	sql += ") VALUES ";
+
+	sql.reserve(sql.length() + rows * (row.length() + 2));
+	for(unsigned int i = 0; i < rows; ++i)
+	{
+		if(i != 0)
+			sql += ", ";
+		sql += row;
+	}
+
+	return sql;
+}
+
+void SQLiteBulkInserter::FreeStatements()
+{
+	sqlite3_finalize(mMultiRowStatement);
+	mMultiRowStatement = 0;
+	sqlite3_finalize(mSingleRowStatement);
+	mSingleRowStatement = 0;
+}
+
+double SQLiteBulkInserter::GetElapsedSeconds() const
+{
+	if(!mIsTimerStarted)
+		return 0.0;
+
+	std::chrono::steady_clock::time_point endTime = mIsFinished ? mFinishTime : std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(endTime - mStartTime).count();
+}
+
+double SQLiteBulkInserter::GetRowsPerSecond() const
+{
+	double seconds = GetElapsedSeconds();
+	return seconds > 0.0 ? static_cast<double>(mInsertedRows) / seconds : 0.0;
+}
+
+}	// namespace Kompex
@@ -0,0 +1,148 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <string.h>
+
+#include "KompexSQLiteColumnLookup.h"
+
+namespace Kompex
+{
+
+SQLiteColumnLookup::SQLiteColumnLookup():
+	mColumnCount(0),
+	mIsBuilt(false)
+{
+}
+
+void SQLiteColumnLookup::Build(sqlite3_stmt *statement)
+{
+	Clear();
+
+	mColumnCount = sqlite3_column_count(statement);
+
+	// keep the load factor at or below 50% so that the probe sequences stay short
+	size_t size = 8;
+	while(size < static_cast<size_t>(mColumnCount) * 2)
+		size <<= 1;
+
+	Slot emptySlot = {0, 0, 0, -1};
+	mSlots.assign(size, emptySlot);
+
+	mColumnNameOffsets.reserve(mColumnCount + 1);
+	for(int i = 0; i < mColumnCount; ++i)
+	{
+		mColumnNameOffsets.push_back(static_cast<unsigned int>(mNames.length()));
+
+		const char *name = sqlite3_column_name(statement, i);
+		if(!name)
+			continue;
+
+		size_t length = strlen(name);
+		unsigned int hash = Hash(name, length);
+		size_t index = hash & (size - 1);
+
+		while(mSlots[index].column != -1)
+		{
+			Slot &slot = mSlots[index];
+			if(slot.hash == hash && slot.nameLength == length && memcmp(mNames.data() + slot.nameOffset, name, length) == 0)
+				break;
+
+			index = (index + 1) & (size - 1);
+		}
+
+		Slot &slot = mSlots[index];
+		if(slot.column == -1)
+		{
+			slot.hash = hash;
+			slot.nameOffset = static_cast<unsigned int>(mNames.length());
+			slot.nameLength = static_cast<unsigned int>(length);
+		}
+		slot.column = i;
+		mNames.append(name, length);
+	}
+	mColumnNameOffsets.push_back(static_cast<unsigned int>(mNames.length()));
+
+	mIsBuilt = true;
+}
+
+void SQLiteColumnLookup::Clear()
+{
+	mSlots.clear();
+	mNames.clear();
+	mColumnNameOffsets.clear();
+	mColumnCount = 0;
+	mIsBuilt = false;
+}
+
+void SQLiteColumnLookup::Swap(SQLiteColumnLookup &lookup)
+{
+	mSlots.swap(lookup.mSlots);
+	mNames.swap(lookup.mNames);
+	mColumnNameOffsets.swap(lookup.mColumnNameOffsets);
+	std::swap(mColumnCount, lookup.mColumnCount);
+	std::swap(mIsBuilt, lookup.mIsBuilt);
+}
+
+bool SQLiteColumnLookup::Matches(sqlite3_stmt *statement) const
+{
+	if(!mIsBuilt || mColumnCount != sqlite3_column_count(statement))
+		return false;
+
+	for(int i = 0; i < mColumnCount; ++i)
+	{
+		const char *name = sqlite3_column_name(statement, i);
+		size_t length = name ? strlen(name) : 0;
+		if(length != mColumnNameOffsets[i + 1] - mColumnNameOffsets[i] || memcmp(mNames.data() + mColumnNameOffsets[i], name, length) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+int SQLiteColumnLookup::Find(const char *name, size_t length) const
+{
+	if(mSlots.empty())
+		return -1;
+
+	size_t mask = mSlots.size() - 1;
+	unsigned int hash = Hash(name, length);
+
+	for(size_t index = hash & mask; mSlots[index].column != -1; index = (index + 1) & mask)
+	{
+		const Slot &slot = mSlots[index];
+		if(slot.hash == hash && slot.nameLength == length && memcmp(mNames.data() + slot.nameOffset, name, length) == 0)
+			return slot.column;
+	}
+
+	return -1;
+}
+
+unsigned int SQLiteColumnLookup::Hash(const char *name, size_t length)
+{
+	unsigned int hash = 2166136261u;
+	for(size_t i = 0; i < length; ++i)
+	{
+		hash ^= static_cast<unsigned char>(name[i]);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+}	// namespace Kompex
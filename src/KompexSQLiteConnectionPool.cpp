@@ -0,0 +1,339 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <thread>
+
+#include "KompexSQLiteConnectionPool.h"
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteException.h"
+
+namespace Kompex
+{
+
+//------------------------------------------------------------------------------------
+// Lease
+
+SQLiteConnectionPool::Lease::Lease():
+	mPool(0),
+	mDatabase(0),
+	mIndex(0),
+	mIsWriter(false)
+{
+}
+
+SQLiteConnectionPool::Lease::Lease(SQLiteConnectionPool *pool, SQLiteDatabase *database, unsigned int index, bool isWriter):
+	mPool(pool),
+	mDatabase(database),
+	mIndex(index),
+	mIsWriter(isWriter),
+	mAcquireTime(std::chrono::steady_clock::now())
+{
+}
+
+SQLiteConnectionPool::Lease::Lease(Lease &&lease):
+	mPool(lease.mPool),
+	mDatabase(lease.mDatabase),
+	mIndex(lease.mIndex),
+	mIsWriter(lease.mIsWriter),
+	mAcquireTime(lease.mAcquireTime)
+{
+	lease.mPool = 0;
+	lease.mDatabase = 0;
+}
+
+SQLiteConnectionPool::Lease &SQLiteConnectionPool::Lease::operator=(Lease &&lease)
+{
+	if(this != &lease)
+	{
+		Release();
+
+		mPool = lease.mPool;
+		mDatabase = lease.mDatabase;
+		mIndex = lease.mIndex;
+		mIsWriter = lease.mIsWriter;
+		mAcquireTime = lease.mAcquireTime;
+
+		lease.mPool = 0;
+		lease.mDatabase = 0;
+	}
+	return *this;
+}
+
+SQLiteConnectionPool::Lease::~Lease()
+{
+	Release();
+}
+
+void SQLiteConnectionPool::Lease::Release()
+{
+	if(mPool && mDatabase)
+		mPool->Release(*this);
+
+	mPool = 0;
+	mDatabase = 0;
+}
+
+//------------------------------------------------------------------------------------
+// SQLiteConnectionPool
+
+SQLiteConnectionPool::SQLiteConnectionPool(const std::string &filename, unsigned int readerCount, int busyTimeout, unsigned int statementCacheCapacity):
+	mFilename(filename),
+	mWriter(0),
+	mIsWriterInUse(false)
+{
+	if(readerCount == 0)
+		readerCount = std::max(1u, std::thread::hardware_concurrency());
+
+	try
+	{
+		// every connection is used by only one thread at the same time
+		mWriter = new SQLiteDatabase(filename, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, 0);
+		mWriter->SetStatementCacheCapacity(statementCacheCapacity);
+		mWriter->SetBusyTimeout(busyTimeout);
+
+		// readers and the writer block each other in all other journal modes
+		SQLiteStatement stmt(mWriter);
+		std::string journalMode = stmt.GetSqlResultString("PRAGMA journal_mode = WAL;");
+		std::transform(journalMode.begin(), journalMode.end(), journalMode.begin(), ::tolower);
+		if(journalMode != "wal")
+			KOMPEX_EXCEPT("SQLiteConnectionPool() the WAL journal mode could not be activated for '" + filename + "'");
+
+		mReaders.reserve(readerCount);
+		mFreeReaders.reserve(readerCount);
+		for(unsigned int i = 0; i < readerCount; ++i)
+		{
+			SQLiteDatabase *reader = new SQLiteDatabase(filename, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, 0);
+			mReaders.push_back(reader);
+			reader->SetStatementCacheCapacity(statementCacheCapacity);
+			reader->SetBusyTimeout(busyTimeout);
+			mFreeReaders.push_back(i);
+		}
+	}
+	catch(...)
+	{
+		CloseConnections();
+		throw;
+	}
+
+	ResetStatistics();
+}
+
+SQLiteConnectionPool::~SQLiteConnectionPool()
+{
+	CloseConnections();
+}
+
+void SQLiteConnectionPool::CloseConnections()
+{
+	for(std::vector<SQLiteDatabase*>::iterator iter = mReaders.begin(); iter != mReaders.end(); ++iter)
+		delete *iter;
+	mReaders.clear();
+	mFreeReaders.clear();
+
+	delete mWriter;
+	mWriter = 0;
+}
+
+SQLiteConnectionPool::Lease SQLiteConnectionPool::AcquireReader()
+{
+	Lease lease;
+	AcquireReader(lease, false, 0);
+	return lease;
+}
+
+bool SQLiteConnectionPool::TryAcquireReader(Lease &lease, unsigned int timeout)
+{
+	return AcquireReader(lease, true, timeout);
+}
+
+SQLiteConnectionPool::Lease SQLiteConnectionPool::AcquireWriter()
+{
+	Lease lease;
+	AcquireWriter(lease, false, 0);
+	return lease;
+}
+
+bool SQLiteConnectionPool::TryAcquireWriter(Lease &lease, unsigned int timeout)
+{
+	return AcquireWriter(lease, true, timeout);
+}
+
+bool SQLiteConnectionPool::AcquireReader(Lease &lease, bool isTimeoutActive, unsigned int timeout)
+{
+	lease.Release();
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	bool hasWaited = mFreeReaders.empty();
+	if(isTimeoutActive)
+	{
+		if(!mReaderAvailable.wait_until(lock, startTime + std::chrono::milliseconds(timeout), [this] {return !mFreeReaders.empty();}))
+			return false;
+	}
+	else
+	{
+		mReaderAvailable.wait(lock, [this] {return !mFreeReaders.empty();});
+	}
+
+	unsigned int index = mFreeReaders.back();
+	mFreeReaders.pop_back();
+
+	++mStatistics.readerAcquisitions;
+	if(hasWaited)
+	{
+		++mStatistics.readerWaits;
+		RecordWait(std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count(), false);
+	}
+
+	lease = Lease(this, mReaders[index], index, false);
+	return true;
+}
+
+bool SQLiteConnectionPool::AcquireWriter(Lease &lease, bool isTimeoutActive, unsigned int timeout)
+{
+	lease.Release();
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	bool hasWaited = mIsWriterInUse;
+	if(isTimeoutActive)
+	{
+		if(!mWriterAvailable.wait_until(lock, startTime + std::chrono::milliseconds(timeout), [this] {return !mIsWriterInUse;}))
+			return false;
+	}
+	else
+	{
+		mWriterAvailable.wait(lock, [this] {return !mIsWriterInUse;});
+	}
+
+	mIsWriterInUse = true;
+
+	++mStatistics.writerAcquisitions;
+	if(hasWaited)
+	{
+		++mStatistics.writerWaits;
+		RecordWait(std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count(), true);
+	}
+
+	lease = Lease(this, mWriter, 0, true);
+	return true;
+}
+
+void SQLiteConnectionPool::Release(Lease &lease)
+{
+	ResetConnection(lease.mDatabase);
+
+	double leaseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lease.mAcquireTime).count();
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if(lease.mIsWriter)
+		{
+			mWriterBusySeconds += leaseSeconds;
+			mIsWriterInUse = false;
+		}
+		else
+		{
+			mReaderBusySeconds += leaseSeconds;
+			mFreeReaders.push_back(lease.mIndex);
+		}
+	}
+
+	if(lease.mIsWriter)
+		mWriterAvailable.notify_one();
+	else
+		mReaderAvailable.notify_one();
+}
+
+void SQLiteConnectionPool::ResetConnection(SQLiteDatabase *database)
+{
+	sqlite3 *handle = database->GetDatabaseHandle();
+
+	// a statement which wasn't reset keeps its read transaction open, i.e. the next lease would read an old
+	// snapshot and no checkpoint could write back the WAL file beyond it
+	for(sqlite3_stmt *statement = sqlite3_next_stmt(handle, 0); statement != 0; statement = sqlite3_next_stmt(handle, statement))
+	{
+		if(sqlite3_stmt_busy(statement))
+			sqlite3_reset(statement);
+	}
+
+	// a transaction which was left open (e.g. because of an exception) must not be inherited by the next lease
+	if(!sqlite3_get_autocommit(handle))
+		sqlite3_exec(handle, "ROLLBACK", 0, 0, 0);
+}
+
+void SQLiteConnectionPool::RecordWait(double seconds, bool isWriter)
+{
+	if(isWriter)
+		mStatistics.writerWaitSeconds += seconds;
+	else
+		mStatistics.readerWaitSeconds += seconds;
+
+	if(seconds > mStatistics.maxWaitSeconds)
+		mStatistics.maxWaitSeconds = seconds;
+}
+
+SQLiteConnectionPoolStatistics SQLiteConnectionPool::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	SQLiteConnectionPoolStatistics statistics = mStatistics;
+	statistics.readerCount = static_cast<unsigned int>(mReaders.size());
+	statistics.readersInUse = static_cast<unsigned int>(mReaders.size() - mFreeReaders.size());
+	statistics.isWriterInUse = mIsWriterInUse;
+
+	// only leases which were given back are taken into account
+	double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - mStatisticsStartTime).count();
+	if(elapsedSeconds > 0.0)
+	{
+		if(!mReaders.empty())
+			statistics.readerUtilization = std::min(1.0, mReaderBusySeconds / (elapsedSeconds * mReaders.size()));
+		statistics.writerUtilization = std::min(1.0, mWriterBusySeconds / elapsedSeconds);
+	}
+
+	return statistics;
+}
+
+void SQLiteConnectionPool::ResetStatistics()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mStatistics.readerCount = 0;
+	mStatistics.readersInUse = 0;
+	mStatistics.isWriterInUse = false;
+	mStatistics.readerAcquisitions = 0;
+	mStatistics.writerAcquisitions = 0;
+	mStatistics.readerWaits = 0;
+	mStatistics.writerWaits = 0;
+	mStatistics.readerWaitSeconds = 0.0;
+	mStatistics.writerWaitSeconds = 0.0;
+	mStatistics.maxWaitSeconds = 0.0;
+	mStatistics.readerUtilization = 0.0;
+	mStatistics.writerUtilization = 0.0;
+
+	mReaderBusySeconds = 0.0;
+	mWriterBusySeconds = 0.0;
+	mStatisticsStartTime = std::chrono::steady_clock::now();
+}
+
+}	// namespace Kompex
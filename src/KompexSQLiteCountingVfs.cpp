@@ -0,0 +1,440 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <cstring>
+#include <string>
+
+#include "KompexSQLiteCountingVfs.h"
+#include "KompexSQLiteException.h"
+
+namespace Kompex
+{
+
+namespace
+{
+	//! sqlite3_io_methods in version 3 (SQLite 3.7.17), independent of the version of sqlite3.h
+	struct IoMethods
+	{
+		int iVersion;
+		int (*xClose)(sqlite3_file*);
+		int (*xRead)(sqlite3_file*, void*, int, sqlite3_int64);
+		int (*xWrite)(sqlite3_file*, const void*, int, sqlite3_int64);
+		int (*xTruncate)(sqlite3_file*, sqlite3_int64);
+		int (*xSync)(sqlite3_file*, int);
+		int (*xFileSize)(sqlite3_file*, sqlite3_int64*);
+		int (*xLock)(sqlite3_file*, int);
+		int (*xUnlock)(sqlite3_file*, int);
+		int (*xCheckReservedLock)(sqlite3_file*, int*);
+		int (*xFileControl)(sqlite3_file*, int, void*);
+		int (*xSectorSize)(sqlite3_file*);
+		int (*xDeviceCharacteristics)(sqlite3_file*);
+		int (*xShmMap)(sqlite3_file*, int, int, int, void volatile**);
+		int (*xShmLock)(sqlite3_file*, int, int, int);
+		void (*xShmBarrier)(sqlite3_file*);
+		int (*xShmUnmap)(sqlite3_file*, int);
+		int (*xFetch)(sqlite3_file*, sqlite3_int64, int, void**);
+		int (*xUnfetch)(sqlite3_file*, sqlite3_int64, void*);
+	};
+
+	//! File of the shim; the file of the base VFS follows
+	struct CountingFile
+	{
+		sqlite3_file base;
+		sqlite3_file *realFile;
+		bool isDatabase;
+		bool isWal;
+	};
+
+	sqlite3_vfs countingVfs;
+	bool isRegistered = false;
+
+	std::atomic<uint64> reads(0);
+	std::atomic<uint64> readBytes(0);
+	std::atomic<uint64> walReads(0);
+	std::atomic<uint64> walReadBytes(0);
+	std::atomic<uint64> mmapFetches(0);
+	std::atomic<uint64> mmapFetchBytes(0);
+	std::atomic<uint64> mmapFallbacks(0);
+	std::atomic<uint64> writes(0);
+	std::atomic<uint64> writeBytes(0);
+
+	inline sqlite3_vfs *GetBaseVfs(sqlite3_vfs *vfs)
+	{
+		return static_cast<sqlite3_vfs*>(vfs->pAppData);
+	}
+
+	inline sqlite3_file *GetRealFile(sqlite3_file *file)
+	{
+		return reinterpret_cast<CountingFile*>(file)->realFile;
+	}
+
+	inline const IoMethods *GetRealMethods(sqlite3_file *file)
+	{
+		return reinterpret_cast<const IoMethods*>(GetRealFile(file)->pMethods);
+	}
+
+	inline void Count(std::atomic<uint64> &counter, uint64 value)
+	{
+		counter.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	// I/O methods
+
+	int Close(sqlite3_file *file)
+	{
+		return GetRealMethods(file)->xClose(GetRealFile(file));
+	}
+
+	int Read(sqlite3_file *file, void *buffer, int amount, sqlite3_int64 offset)
+	{
+		CountingFile *countingFile = reinterpret_cast<CountingFile*>(file);
+		if(countingFile->isDatabase)
+		{
+			Count(reads, 1);
+			Count(readBytes, amount);
+		}
+		else if(countingFile->isWal)
+		{
+			Count(walReads, 1);
+			Count(walReadBytes, amount);
+		}
+		return GetRealMethods(file)->xRead(GetRealFile(file), buffer, amount, offset);
+	}
+
+	int Write(sqlite3_file *file, const void *buffer, int amount, sqlite3_int64 offset)
+	{
+		CountingFile *countingFile = reinterpret_cast<CountingFile*>(file);
+		if(countingFile->isDatabase || countingFile->isWal)
+		{
+			Count(writes, 1);
+			Count(writeBytes, amount);
+		}
+		return GetRealMethods(file)->xWrite(GetRealFile(file), buffer, amount, offset);
+	}
+
+	int Truncate(sqlite3_file *file, sqlite3_int64 size)
+	{
+		return GetRealMethods(file)->xTruncate(GetRealFile(file), size);
+	}
+
+	int Sync(sqlite3_file *file, int flags)
+	{
+		return GetRealMethods(file)->xSync(GetRealFile(file), flags);
+	}
+
+	int FileSize(sqlite3_file *file, sqlite3_int64 *size)
+	{
+		return GetRealMethods(file)->xFileSize(GetRealFile(file), size);
+	}
+
+	int Lock(sqlite3_file *file, int lock)
+	{
+		return GetRealMethods(file)->xLock(GetRealFile(file), lock);
+	}
+
+	int Unlock(sqlite3_file *file, int lock)
+	{
+		return GetRealMethods(file)->xUnlock(GetRealFile(file), lock);
+	}
+
+	int CheckReservedLock(sqlite3_file *file, int *result)
+	{
+		return GetRealMethods(file)->xCheckReservedLock(GetRealFile(file), result);
+	}
+
+	int FileControl(sqlite3_file *file, int operation, void *argument)
+	{
+		return GetRealMethods(file)->xFileControl(GetRealFile(file), operation, argument);
+	}
+
+	int SectorSize(sqlite3_file *file)
+	{
+		return GetRealMethods(file)->xSectorSize(GetRealFile(file));
+	}
+
+	int DeviceCharacteristics(sqlite3_file *file)
+	{
+		return GetRealMethods(file)->xDeviceCharacteristics(GetRealFile(file));
+	}
+
+	int ShmMap(sqlite3_file *file, int region, int regionSize, int isWrite, void volatile **memory)
+	{
+		return GetRealMethods(file)->xShmMap(GetRealFile(file), region, regionSize, isWrite, memory);
+	}
+
+	int ShmLock(sqlite3_file *file, int offset, int n, int flags)
+	{
+		return GetRealMethods(file)->xShmLock(GetRealFile(file), offset, n, flags);
+	}
+
+	void ShmBarrier(sqlite3_file *file)
+	{
+		GetRealMethods(file)->xShmBarrier(GetRealFile(file));
+	}
+
+	int ShmUnmap(sqlite3_file *file, int deleteFlag)
+	{
+		return GetRealMethods(file)->xShmUnmap(GetRealFile(file), deleteFlag);
+	}
+
+	int Fetch(sqlite3_file *file, sqlite3_int64 offset, int amount, void **memory)
+	{
+		int rc = GetRealMethods(file)->xFetch(GetRealFile(file), offset, amount, memory);
+		if(reinterpret_cast<CountingFile*>(file)->isDatabase)
+		{
+			if(rc == SQLITE_OK && *memory)
+			{
+				Count(mmapFetches, 1);
+				Count(mmapFetchBytes, amount);
+			}
+			else
+			{
+				Count(mmapFallbacks, 1);
+			}
+		}
+		return rc;
+	}
+
+	int Unfetch(sqlite3_file *file, sqlite3_int64 offset, void *memory)
+	{
+		return GetRealMethods(file)->xUnfetch(GetRealFile(file), offset, memory);
+	}
+
+	//! I/O methods for base files of version 1, 2 and 3
+	IoMethods ioMethods[3];
+
+	void InitIoMethods()
+	{
+		for(int i = 0; i < 3; ++i)
+		{
+			IoMethods &methods = ioMethods[i];
+			std::memset(&methods, 0, sizeof(methods));
+			methods.iVersion = i + 1;
+			methods.xClose = &Close;
+			methods.xRead = &Read;
+			methods.xWrite = &Write;
+			methods.xTruncate = &Truncate;
+			methods.xSync = &Sync;
+			methods.xFileSize = &FileSize;
+			methods.xLock = &Lock;
+			methods.xUnlock = &Unlock;
+			methods.xCheckReservedLock = &CheckReservedLock;
+			methods.xFileControl = &FileControl;
+			methods.xSectorSize = &SectorSize;
+			methods.xDeviceCharacteristics = &DeviceCharacteristics;
+			if(i >= 1)
+			{
+				methods.xShmMap = &ShmMap;
+				methods.xShmLock = &ShmLock;
+				methods.xShmBarrier = &ShmBarrier;
+				methods.xShmUnmap = &ShmUnmap;
+			}
+			if(i >= 2)
+			{
+				methods.xFetch = &Fetch;
+				methods.xUnfetch = &Unfetch;
+			}
+		}
+	}
+
+	// VFS methods
+
+	int Open(sqlite3_vfs *vfs, const char *name, sqlite3_file *file, int flags, int *outFlags)
+	{
+		CountingFile *countingFile = reinterpret_cast<CountingFile*>(file);
+		countingFile->realFile = reinterpret_cast<sqlite3_file*>(countingFile + 1);
+		countingFile->isDatabase = (flags & SQLITE_OPEN_MAIN_DB) != 0;
+		countingFile->isWal = (flags & SQLITE_OPEN_WAL) != 0;
+
+		sqlite3_vfs *baseVfs = GetBaseVfs(vfs);
+		int rc = baseVfs->xOpen(baseVfs, name, countingFile->realFile, flags, outFlags);
+
+		// the shim provides the same version of the I/O methods as the base file
+		const sqlite3_io_methods *realMethods = countingFile->realFile->pMethods;
+		if(realMethods)
+		{
+			int version = realMethods->iVersion < 1 ? 1 : (realMethods->iVersion > 3 ? 3 : realMethods->iVersion);
+			file->pMethods = reinterpret_cast<const sqlite3_io_methods*>(&ioMethods[version - 1]);
+		}
+		else
+		{
+			file->pMethods = 0;
+		}
+		return rc;
+	}
+
+	int Delete(sqlite3_vfs *vfs, const char *name, int syncDir)
+	{
+		return GetBaseVfs(vfs)->xDelete(GetBaseVfs(vfs), name, syncDir);
+	}
+
+	int Access(sqlite3_vfs *vfs, const char *name, int flags, int *result)
+	{
+		return GetBaseVfs(vfs)->xAccess(GetBaseVfs(vfs), name, flags, result);
+	}
+
+	int FullPathname(sqlite3_vfs *vfs, const char *name, int size, char *result)
+	{
+		return GetBaseVfs(vfs)->xFullPathname(GetBaseVfs(vfs), name, size, result);
+	}
+
+	void *DlOpen(sqlite3_vfs *vfs, const char *filename)
+	{
+		return GetBaseVfs(vfs)->xDlOpen(GetBaseVfs(vfs), filename);
+	}
+
+	void DlError(sqlite3_vfs *vfs, int size, char *errMsg)
+	{
+		GetBaseVfs(vfs)->xDlError(GetBaseVfs(vfs), size, errMsg);
+	}
+
+	void (*DlSym(sqlite3_vfs *vfs, void *handle, const char *symbol))(void)
+	{
+		return GetBaseVfs(vfs)->xDlSym(GetBaseVfs(vfs), handle, symbol);
+	}
+
+	void DlClose(sqlite3_vfs *vfs, void *handle)
+	{
+		GetBaseVfs(vfs)->xDlClose(GetBaseVfs(vfs), handle);
+	}
+
+	int Randomness(sqlite3_vfs *vfs, int size, char *result)
+	{
+		return GetBaseVfs(vfs)->xRandomness(GetBaseVfs(vfs), size, result);
+	}
+
+	int Sleep(sqlite3_vfs *vfs, int microseconds)
+	{
+		return GetBaseVfs(vfs)->xSleep(GetBaseVfs(vfs), microseconds);
+	}
+
+	int CurrentTime(sqlite3_vfs *vfs, double *time)
+	{
+		return GetBaseVfs(vfs)->xCurrentTime(GetBaseVfs(vfs), time);
+	}
+
+	int GetLastError(sqlite3_vfs *vfs, int size, char *errMsg)
+	{
+		return GetBaseVfs(vfs)->xGetLastError(GetBaseVfs(vfs), size, errMsg);
+	}
+
+	int CurrentTimeInt64(sqlite3_vfs *vfs, sqlite3_int64 *time)
+	{
+		return GetBaseVfs(vfs)->xCurrentTimeInt64(GetBaseVfs(vfs), time);
+	}
+
+	int SetSystemCall(sqlite3_vfs *vfs, const char *name, sqlite3_syscall_ptr function)
+	{
+		return GetBaseVfs(vfs)->xSetSystemCall(GetBaseVfs(vfs), name, function);
+	}
+
+	sqlite3_syscall_ptr GetSystemCall(sqlite3_vfs *vfs, const char *name)
+	{
+		return GetBaseVfs(vfs)->xGetSystemCall(GetBaseVfs(vfs), name);
+	}
+
+	const char *NextSystemCall(sqlite3_vfs *vfs, const char *name)
+	{
+		return GetBaseVfs(vfs)->xNextSystemCall(GetBaseVfs(vfs), name);
+	}
+}
+
+void SQLiteCountingVfs::Register(const char *baseVfsName, bool makeDefault)
+{
+	if(isRegistered)
+		return;
+
+	sqlite3_vfs *baseVfs = sqlite3_vfs_find(baseVfsName);
+	if(!baseVfs)
+		KOMPEX_EXCEPT(std::string("Register() VFS '") + (baseVfsName ? baseVfsName : "default") + "' not found");
+
+	InitIoMethods();
+
+	std::memset(&countingVfs, 0, sizeof(countingVfs));
+	countingVfs.iVersion = baseVfs->iVersion < 3 ? baseVfs->iVersion : 3;
+	countingVfs.szOsFile = static_cast<int>(sizeof(CountingFile)) + baseVfs->szOsFile;
+	countingVfs.mxPathname = baseVfs->mxPathname;
+	countingVfs.zName = GetName();
+	countingVfs.pAppData = baseVfs;
+	countingVfs.xOpen = &Open;
+	countingVfs.xDelete = &Delete;
+	countingVfs.xAccess = &Access;
+	countingVfs.xFullPathname = &FullPathname;
+	countingVfs.xDlOpen = &DlOpen;
+	countingVfs.xDlError = &DlError;
+	countingVfs.xDlSym = &DlSym;
+	countingVfs.xDlClose = &DlClose;
+	countingVfs.xRandomness = &Randomness;
+	countingVfs.xSleep = &Sleep;
+	countingVfs.xCurrentTime = &CurrentTime;
+	countingVfs.xGetLastError = &GetLastError;
+	if(countingVfs.iVersion >= 2)
+		countingVfs.xCurrentTimeInt64 = &CurrentTimeInt64;
+	if(countingVfs.iVersion >= 3)
+	{
+		countingVfs.xSetSystemCall = &SetSystemCall;
+		countingVfs.xGetSystemCall = &GetSystemCall;
+		countingVfs.xNextSystemCall = &NextSystemCall;
+	}
+
+	int rc = sqlite3_vfs_register(&countingVfs, makeDefault ? 1 : 0);
+	if(rc != SQLITE_OK)
+		KOMPEX_EXCEPT(sqlite3_errstr(rc));
+
+	isRegistered = true;
+}
+
+void SQLiteCountingVfs::Unregister()
+{
+	if(!isRegistered)
+		return;
+
+	sqlite3_vfs_unregister(&countingVfs);
+	isRegistered = false;
+}
+
+SQLiteIoStatistics SQLiteCountingVfs::GetStatistics()
+{
+	SQLiteIoStatistics statistics;
+	statistics.reads = reads.load(std::memory_order_relaxed);
+	statistics.readBytes = readBytes.load(std::memory_order_relaxed);
+	statistics.walReads = walReads.load(std::memory_order_relaxed);
+	statistics.walReadBytes = walReadBytes.load(std::memory_order_relaxed);
+	statistics.mmapFetches = mmapFetches.load(std::memory_order_relaxed);
+	statistics.mmapFetchBytes = mmapFetchBytes.load(std::memory_order_relaxed);
+	statistics.mmapFallbacks = mmapFallbacks.load(std::memory_order_relaxed);
+	statistics.writes = writes.load(std::memory_order_relaxed);
+	statistics.writeBytes = writeBytes.load(std::memory_order_relaxed);
+	return statistics;
+}
+
+void SQLiteCountingVfs::ResetStatistics()
+{
+	reads.store(0);
+	readBytes.store(0);
+	walReads.store(0);
+	walReadBytes.store(0);
+	mmapFetches.store(0);
+	mmapFetchBytes.store(0);
+	mmapFallbacks.store(0);
+	writes.store(0);
+	writeBytes.store(0);
+}
+
+}	// namespace Kompex
@@ -16,41 +16,53 @@
     along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <exception>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
 #include "KompexSQLiteDatabase.h"
 #include "KompexSQLiteException.h"
+#include "KompexSQLiteProfiler.h"
+#include "KompexSQLiteInternal.h"
 
 namespace Kompex
 {
 
-SQLiteDatabase::SQLiteDatabase():
-	mDatabaseHandle(0),
-	mIsMemoryDatabaseActive(false),
-	mDatabaseFilenameUtf8(""),
-	mDatabaseFilenameUtf16(L"")
+SQLiteDatabase::SQLiteDatabase()
 {
+	Init();
 }
 
-SQLiteDatabase::SQLiteDatabase(const char *filename, int flags, const char *zVfs):
-	mDatabaseHandle(0),
-	mIsMemoryDatabaseActive(false)
+SQLiteDatabase::SQLiteDatabase(const char *filename, int flags, const char *zVfs)
 {
+	Init();
 	Open(filename, flags, zVfs);
 }
 
-SQLiteDatabase::SQLiteDatabase(const wchar_t *filename):
-	mDatabaseHandle(0),
-	mIsMemoryDatabaseActive(false)
+SQLiteDatabase::SQLiteDatabase(const wchar_t *filename)
 {
+	Init();
 	Open(filename);
 }
 
-SQLiteDatabase::SQLiteDatabase(const std::string &filename, int flags, const char *zVfs):
-	mDatabaseHandle(0),
-	mIsMemoryDatabaseActive(false)
+SQLiteDatabase::SQLiteDatabase(const std::string &filename, int flags, const char *zVfs)
 {
+	Init();
 	Open(filename, flags, zVfs);
 }
 
@@ -59,6 +71,16 @@ SQLiteDatabase::~SQLiteDatabase()
 	Close();
 }
 
+void SQLiteDatabase::Init()
+{
+	mDatabaseHandle = 0;
+	mIsMemoryDatabaseActive = false;
+	mIsBusyRetryPolicyActive = false;
+	mBusyTimeout = 0;
+	mBusyRandomGenerator.seed(std::random_device()());
+	ResetBusyStatistics();
+}
+
 void SQLiteDatabase::Open(const char *filename, int flags, const char *zVfs)
 {
 	// close old db, if one exist
@@ -70,6 +92,7 @@ void SQLiteDatabase::Open(const char *filename, int flags, const char *zVfs)
 
 	mDatabaseFilenameUtf8 = std::string(filename);
 	mDatabaseFilenameUtf16 = L"";
+	ApplyBusyHandling();
 }
 
 void SQLiteDatabase::Open(const std::string &filename, int flags, const char *zVfs)
@@ -83,6 +106,13 @@ void SQLiteDatabase::Open(const std::string &filename, int flags, const char *zV
 
 	mDatabaseFilenameUtf8 = std::string(filename);
 	mDatabaseFilenameUtf16 = L"";
+	ApplyBusyHandling();
+}
+
+void SQLiteDatabase::Open(const std::string &filename, int flags, const char *zVfs, const JournalSettings &settings)
+{
+	Open(filename, flags, zVfs);
+	ApplyJournalSettings(settings);
 }
 
 void SQLiteDatabase::Open(const wchar_t *filename)
@@ -97,10 +127,14 @@ void SQLiteDatabase::Open(const wchar_t *filename)
 
 	mDatabaseFilenameUtf8 = "";
 	mDatabaseFilenameUtf16 = filename;
+	ApplyBusyHandling();
 }
 
 void SQLiteDatabase::Close()
 {	
+	// cached statements would prevent the database from closing
+	mStatementCache.Clear();
+
 	// detach database if the database was moved into memory
 	if(mIsMemoryDatabaseActive)
 	{
@@ -124,13 +158,170 @@ void SQLiteDatabase::Close()
 
 void SQLiteDatabase::TraceOutput(void *ptr, const char *sql)
 {
-	std::cout << "trace: " << sql << std::endl;
+	// no std::endl - flushing after every statement is too expensive
+	std::cout << "trace: " << sql << "\n";
 }
 
 void SQLiteDatabase::ProfileOutput(void* ptr, const char* sql, sqlite3_uint64 time)
 {
-	std::cout << "profile: " << sql << std::endl;
-	std::cout << "profile time: " << time << std::endl;
+	std::cout << "profile: " << sql << "\n";
+	std::cout << "profile time: " << time << "\n";
+}
+
+void SQLiteDatabase::ActivateProfiling(SQLiteProfiler *profiler) const
+{
+	sqlite3_profile(mDatabaseHandle, &Kompex::SQLiteProfiler::ProfileCallback, profiler);
+}
+
+void SQLiteDatabase::SetBusyTimeout(int timeout)
+{
+	mIsBusyRetryPolicyActive = false;
+	mBusyTimeout = timeout;
+	ApplyBusyHandling();
+}
+
+void SQLiteDatabase::SetBusyRetryPolicy(const BusyRetryPolicy &policy)
+{
+	if(policy.jitter < 0.0 || policy.jitter > 1.0)
+		KOMPEX_EXCEPT("SetBusyRetryPolicy() jitter must be within 0.0 and 1.0");
+
+	mBusyRetryPolicy = policy;
+	mIsBusyRetryPolicyActive = true;
+	ApplyBusyHandling();
+}
+
+void SQLiteDatabase::ApplyBusyHandling()
+{
+	if(!mDatabaseHandle)
+		return;
+
+	if(mIsBusyRetryPolicyActive)
+		sqlite3_busy_handler(mDatabaseHandle, &Kompex::SQLiteDatabase::BusyRetryHandler, this);
+	else if(mBusyTimeout > 0)
+		sqlite3_busy_timeout(mDatabaseHandle, mBusyTimeout);
+	else
+		sqlite3_busy_handler(mDatabaseHandle, 0, 0);
+}
+
+int SQLiteDatabase::BusyRetryHandler(void *ptr, int numberOfCalls)
+{
+	SQLiteDatabase *db = static_cast<SQLiteDatabase*>(ptr);
+	const BusyRetryPolicy &policy = db->mBusyRetryPolicy;
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	// SQLite counts the calls per lock request, so the first call starts a new wait
+	if(numberOfCalls == 0)
+	{
+		db->mBusyWaitStartTime = now;
+		db->mBusyWaits.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	std::chrono::microseconds waited = std::chrono::duration_cast<std::chrono::microseconds>(now - db->mBusyWaitStartTime);
+	std::chrono::microseconds timeout(static_cast<int64>(policy.timeout) * 1000);
+	if((policy.maxAttempts > 0 && static_cast<unsigned int>(numberOfCalls) >= policy.maxAttempts) ||
+	   (policy.timeout > 0 && waited >= timeout))
+	{
+		db->mBusyFailures.fetch_add(1, std::memory_order_relaxed);
+		return 0;
+	}
+
+	// exponential backoff; the shift is limited to avoid an overflow
+	int64 backoff = static_cast<int64>(policy.initialBackoff) * 1000 << std::min(numberOfCalls, 20);
+	backoff = std::min(backoff, static_cast<int64>(policy.maxBackoff) * 1000);
+	if(policy.jitter > 0.0)
+	{
+		std::uniform_real_distribution<double> distribution(0.0, policy.jitter);
+		backoff -= static_cast<int64>(backoff * distribution(db->mBusyRandomGenerator));
+	}
+	if(policy.timeout > 0)
+		backoff = std::min(backoff, static_cast<int64>((timeout - waited).count()));
+
+	std::this_thread::sleep_for(std::chrono::microseconds(backoff));
+
+	db->mBusyRetries.fetch_add(1, std::memory_order_relaxed);
+	db->mBusyBlockedTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - now).count(), std::memory_order_relaxed);
+	return 1;
+}
+
+SQLiteDatabase::BusyStatistics SQLiteDatabase::GetBusyStatistics() const
+{
+	BusyStatistics statistics;
+	statistics.busyWaits = mBusyWaits.load(std::memory_order_relaxed);
+	statistics.retries = mBusyRetries.load(std::memory_order_relaxed);
+	statistics.failures = mBusyFailures.load(std::memory_order_relaxed);
+	statistics.blockedSeconds = mBusyBlockedTime.load(std::memory_order_relaxed) / 1e9;
+	return statistics;
+}
+
+void SQLiteDatabase::ResetBusyStatistics()
+{
+	mBusyWaits.store(0, std::memory_order_relaxed);
+	mBusyRetries.store(0, std::memory_order_relaxed);
+	mBusyFailures.store(0, std::memory_order_relaxed);
+	mBusyBlockedTime.store(0, std::memory_order_relaxed);
+}
+
+namespace
+{
+	SQLiteStatusValue GetDatabaseStatus(sqlite3 *db, int operation, bool resetHighwater)
+	{
+		int current = 0, highwater = 0;
+		SQLiteStatusValue value;
+		if(sqlite3_db_status(db, operation, &current, &highwater, resetHighwater) == SQLITE_OK)
+		{
+			value.current = current;
+			value.highwater = highwater;
+		}
+		return value;
+	}
+
+	SQLiteStatusValue GetLibraryStatus(int operation, bool resetHighwater)
+	{
+		int current = 0, highwater = 0;
+		SQLiteStatusValue value;
+		if(sqlite3_status(operation, &current, &highwater, resetHighwater) == SQLITE_OK)
+		{
+			value.current = current;
+			value.highwater = highwater;
+		}
+		return value;
+	}
+}
+
+SQLiteDatabaseStatistics SQLiteDatabase::GetStatistics(bool resetHighwater) const
+{
+	if(!mDatabaseHandle)
+		KOMPEX_EXCEPT("No opened database! Please open a database first.");
+
+	SQLiteDatabaseStatistics statistics;
+	statistics.timestamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	// the cache counters are never reset, so that they can be used for deltas
+	statistics.cacheHits = GetDatabaseStatus(mDatabaseHandle, SQLITE_DBSTATUS_CACHE_HIT, false).current;
+	statistics.cacheMisses = GetDatabaseStatus(mDatabaseHandle, SQLITE_DBSTATUS_CACHE_MISS, false).current;
+	statistics.cacheWrites = GetDatabaseStatus(mDatabaseHandle, SQLITE_DBSTATUS_CACHE_WRITE, false).current;
+	// the lookaside counters are only available as highwater value; resetting it would reset the counters as well
+	statistics.lookasideHits = GetDatabaseStatus(mDatabaseHandle, SQLITE_DBSTATUS_LOOKASIDE_HIT, false).highwater;
+	statistics.lookasideMissSize = GetDatabaseStatus(mDatabaseHandle, SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, false).highwater;
+	statistics.lookasideMissFull = GetDatabaseStatus(mDatabaseHandle, SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, false).highwater;
+
+	statistics.lookasideUsed = GetDatabaseStatus(mDatabaseHandle, SQLITE_DBSTATUS_LOOKASIDE_USED, resetHighwater);
+	statistics.cacheUsed = GetDatabaseStatus(mDatabaseHandle, SQLITE_DBSTATUS_CACHE_USED, false).current;
+	statistics.schemaUsed = GetDatabaseStatus(mDatabaseHandle, SQLITE_DBSTATUS_SCHEMA_USED, false).current;
+	statistics.statementUsed = GetDatabaseStatus(mDatabaseHandle, SQLITE_DBSTATUS_STMT_USED, false).current;
+
+	statistics.memoryUsed = GetLibraryStatus(SQLITE_STATUS_MEMORY_USED, resetHighwater);
+	statistics.mallocSize = GetLibraryStatus(SQLITE_STATUS_MALLOC_SIZE, resetHighwater);
+	statistics.mallocCount = GetLibraryStatus(SQLITE_STATUS_MALLOC_COUNT, resetHighwater);
+	statistics.pagecacheUsed = GetLibraryStatus(SQLITE_STATUS_PAGECACHE_USED, resetHighwater);
+	statistics.pagecacheOverflow = GetLibraryStatus(SQLITE_STATUS_PAGECACHE_OVERFLOW, resetHighwater);
+	statistics.pagecacheSize = GetLibraryStatus(SQLITE_STATUS_PAGECACHE_SIZE, resetHighwater);
+	statistics.scratchUsed = GetLibraryStatus(SQLITE_STATUS_SCRATCH_USED, resetHighwater);
+	statistics.scratchOverflow = GetLibraryStatus(SQLITE_STATUS_SCRATCH_OVERFLOW, resetHighwater);
+	statistics.scratchSize = GetLibraryStatus(SQLITE_STATUS_SCRATCH_SIZE, resetHighwater);
+	statistics.parserStack = GetLibraryStatus(SQLITE_STATUS_PARSER_STACK, resetHighwater);
+
+	return statistics;
 }
 
 void SQLiteDatabase::MoveDatabaseToMemory(UtfEncoding encoding)
@@ -210,27 +401,7 @@ void SQLiteDatabase::MoveDatabaseToMemory(UtfEncoding encoding)
 		sqlite3_exec(mDatabaseHandle, "COMMIT", 0, 0, 0);
 
 		// attach the origin database to the in-memory
-		if(mDatabaseFilenameUtf8 != "")
-		{
-			std::string sql = "ATTACH DATABASE '" + mDatabaseFilenameUtf8 + "' as origin";
-			if(sqlite3_exec(memoryDatabase, sql.c_str(), 0, 0, 0) != SQLITE_OK)
-			{
-				sqlite3_close(memoryDatabase);
-				KOMPEX_EXCEPT(sqlite3_errmsg(memoryDatabase));
-			}
-		}
-		else
-		{
-			struct sqlite3_stmt *statement;
-			std::wstring sql = L"ATTACH DATABASE '" + mDatabaseFilenameUtf16 + L"' as origin";
-			if(sqlite3_prepare16_v2(memoryDatabase, sql.c_str(), -1, &statement, 0) != SQLITE_OK)
-				CleanUpFailedMemoryDatabase(memoryDatabase, memoryDatabase, false, false, statement, sqlite3_errmsg(memoryDatabase));
-
-			if(sqlite3_step(statement) != SQLITE_DONE)
-				CleanUpFailedMemoryDatabase(memoryDatabase, memoryDatabase, false, false, statement, sqlite3_errmsg(memoryDatabase));
-
-			sqlite3_finalize(statement);
-		}
+		AttachOriginDatabase(memoryDatabase);
 
 		// copy the data from the origin database to the in-memory
 		sqlite3_exec(memoryDatabase, "BEGIN", 0, 0, 0);
@@ -296,9 +467,11 @@ void SQLiteDatabase::MoveDatabaseToMemory(UtfEncoding encoding)
 
 		if(sqlite3_exec(memoryDatabase, "COMMIT", 0, 0, 0) == SQLITE_OK)
 		{
+			mStatementCache.Clear();
 			sqlite3_close(mDatabaseHandle);
 			mDatabaseHandle = memoryDatabase;
 			mIsMemoryDatabaseActive = true;
+			ApplyBusyHandling();
 		}
 		else
 		{
@@ -307,6 +480,218 @@ void SQLiteDatabase::MoveDatabaseToMemory(UtfEncoding encoding)
 	}
 }
 
+SQLiteDatabase::BackupStatistics SQLiteDatabase::MoveDatabaseToMemoryIncremental(int pagesPerStep, unsigned int sleepTime, BackupProgressHandler progressHandler, void *userData, unsigned int busyTimeout)
+{
+	if(mIsMemoryDatabaseActive)
+		KOMPEX_EXCEPT("MoveDatabaseToMemoryIncremental() the database is already located in memory");
+
+	if(mDatabaseFilenameUtf8 == "" && mDatabaseFilenameUtf16 == L"")
+		KOMPEX_EXCEPT("No opened database! Please open a database first.");
+
+	sqlite3 *memoryDatabase;
+	if(mDatabaseFilenameUtf8 != "")
+		sqlite3_open(":memory:", &memoryDatabase);
+	else
+		sqlite3_open16(L":memory:", &memoryDatabase);
+
+	// older SQLite versions can not change the page size of a memory database during the backup
+	std::string pageSizeSql = "PRAGMA page_size = " + ExecutePragma("PRAGMA main.page_size;");
+	sqlite3_exec(memoryDatabase, pageSizeSql.c_str(), 0, 0, 0);
+
+	sqlite3_backup *backup = sqlite3_backup_init(memoryDatabase, "main", mDatabaseHandle, "main");
+	if(!backup)
+		CleanUpFailedMemoryDatabase(memoryDatabase, memoryDatabase, false, false, 0, sqlite3_errmsg(memoryDatabase));
+
+	BackupStatistics statistics;
+	try
+	{
+		statistics = RunIncrementalBackup(backup, memoryDatabase, pagesPerStep, sleepTime, progressHandler, userData, busyTimeout);
+	}
+	catch(SQLiteException &exception)
+	{
+		CleanUpFailedMemoryDatabase(memoryDatabase, memoryDatabase, false, false, 0, exception.GetErrorDescription());
+	}
+
+	// attach the origin database to the in-memory
+	AttachOriginDatabase(memoryDatabase);
+
+	mStatementCache.Clear();
+	sqlite3_close(mDatabaseHandle);
+	mDatabaseHandle = memoryDatabase;
+	mIsMemoryDatabaseActive = true;
+	ApplyBusyHandling();
+
+	return statistics;
+}
+
+SQLiteDatabase::BackupStatistics SQLiteDatabase::RunIncrementalBackup(sqlite3_backup *backup, sqlite3 *destinationDatabase, int pagesPerStep, unsigned int sleepTime, BackupProgressHandler progressHandler, void *userData, unsigned int busyTimeout)
+{
+	BackupStatistics statistics;
+	statistics.pageCount = 0;
+	statistics.steps = 0;
+	statistics.busySteps = 0;
+	statistics.restarts = 0;
+	statistics.seconds = 0.0;
+
+	// every commit into a memory database restarts the backup; if the source is changed permanently
+	// the backup would never be completed, therefore the remaining pages are copied in one step after some restarts
+	const int maxRestarts = 3;
+	int lastRemainingPages = -1;
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	// start of the current series of busy steps
+	std::chrono::steady_clock::time_point busyStartTime = startTime;
+	bool isBusy = false;
+
+	int rc;
+	do
+	{
+		rc = sqlite3_backup_step(backup, statistics.restarts < maxRestarts ? pagesPerStep : -1);
+		++statistics.steps;
+
+		if(rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+		{
+			++statistics.busySteps;
+
+			// a lock which is held permanently by another connection must not block the copy forever
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if(!isBusy)
+			{
+				busyStartTime = now;
+				isBusy = true;
+			}
+			if(now - busyStartTime >= std::chrono::milliseconds(busyTimeout))
+				break;
+		}
+		else
+		{
+			isBusy = false;
+		}
+
+		if(rc == SQLITE_OK)
+		{
+			int remainingPages = sqlite3_backup_remaining(backup);
+			if(lastRemainingPages != -1 && remainingPages >= lastRemainingPages)
+				++statistics.restarts;
+			lastRemainingPages = remainingPages;
+		}
+
+		if(progressHandler && (rc == SQLITE_OK || rc == SQLITE_DONE))
+			progressHandler(sqlite3_backup_remaining(backup), sqlite3_backup_pagecount(backup), userData);
+
+		// the locks are released between the steps, so that other connections can proceed
+		if(rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+		{
+			if(sleepTime > 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
+			else
+				std::this_thread::yield();
+		}
+	}
+	while(rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+	statistics.pageCount = sqlite3_backup_pagecount(backup);
+	sqlite3_backup_finish(backup);
+	statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	if(rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+		KOMPEX_EXCEPT("RunIncrementalBackup() the database is locked by another connection");
+	if(rc != SQLITE_DONE)
+		KOMPEX_EXCEPT(sqlite3_errmsg(destinationDatabase));
+
+	return statistics;
+}
+
+namespace
+{
+	// the filename is bound as parameter, so that quotes in the filename can't break the statement
+	int AttachOriginFile(sqlite3 *db, const std::string &filename)
+	{
+		sqlite3_stmt *statement;
+		int rc = sqlite3_prepare_v2(db, "ATTACH DATABASE ? AS origin", -1, &statement, 0);
+		if(rc == SQLITE_OK)
+		{
+			sqlite3_bind_text(statement, 1, filename.c_str(), -1, SQLITE_STATIC);
+			rc = sqlite3_step(statement);
+		}
+		// sqlite3_finalize() keeps the error message of sqlite3_step()
+		sqlite3_finalize(statement);
+		return (rc == SQLITE_DONE) ? SQLITE_OK : rc;
+	}
+
+	int AttachOriginFile(sqlite3 *db, const std::wstring &filename)
+	{
+		sqlite3_stmt *statement;
+		int rc = sqlite3_prepare16_v2(db, L"ATTACH DATABASE ? AS origin", -1, &statement, 0);
+		if(rc == SQLITE_OK)
+		{
+			sqlite3_bind_text16(statement, 1, filename.c_str(), -1, SQLITE_STATIC);
+			rc = sqlite3_step(statement);
+		}
+		sqlite3_finalize(statement);
+		return (rc == SQLITE_DONE) ? SQLITE_OK : rc;
+	}
+
+	int GetSQLiteCheckpointMode(SQLiteDatabase::CheckpointMode mode)
+	{
+		int checkpointMode = SQLITE_CHECKPOINT_PASSIVE;
+		switch(mode)
+		{
+			case SQLiteDatabase::CHECKPOINT_FULL:
+				checkpointMode = SQLITE_CHECKPOINT_FULL;
+				break;
+			case SQLiteDatabase::CHECKPOINT_RESTART:
+				checkpointMode = SQLITE_CHECKPOINT_RESTART;
+				break;
+			case SQLiteDatabase::CHECKPOINT_TRUNCATE:
+				// SQLITE_CHECKPOINT_TRUNCATE is known since SQLite 3.8.8
+				#ifdef SQLITE_CHECKPOINT_TRUNCATE
+				checkpointMode = SQLITE_CHECKPOINT_TRUNCATE;
+				#else
+				checkpointMode = sqlite3_libversion_number() >= 3008008 ? 3 : SQLITE_CHECKPOINT_RESTART;
+				#endif
+				break;
+			default:
+				break;
+		}
+		return checkpointMode;
+	}
+
+	// writes the frames of a left over WAL file back into the database file and closes the database file again;
+	// returns false if the database file is still in use by another connection
+	bool CheckpointDatabaseFile(const std::string &filename)
+	{
+		sqlite3 *db;
+		int rc = sqlite3_open_v2(filename.c_str(), &db, SQLITE_OPEN_READWRITE, 0);
+		// the WAL file is opened with the first read access to the database
+		if(rc == SQLITE_OK)
+			rc = sqlite3_exec(db, "PRAGMA schema_version;", 0, 0, 0);
+		if(rc == SQLITE_OK)
+			rc = sqlite3_wal_checkpoint_v2(db, 0, GetSQLiteCheckpointMode(SQLiteDatabase::CHECKPOINT_TRUNCATE), 0, 0);
+		sqlite3_close(db);
+
+		// any other error (e.g. there is no database file yet) is of no interest, because the file is replaced anyway
+		return rc != SQLITE_BUSY && rc != SQLITE_LOCKED;
+	}
+
+	void RemoveJournalFiles(const std::string &filename)
+	{
+		std::remove((filename + "-wal").c_str());
+		std::remove((filename + "-shm").c_str());
+		std::remove((filename + "-journal").c_str());
+	}
+}
+
+void SQLiteDatabase::AttachOriginDatabase(sqlite3 *memoryDatabase)
+{
+	int rc = (mDatabaseFilenameUtf8 != "") ?
+		AttachOriginFile(memoryDatabase, mDatabaseFilenameUtf8) :
+		AttachOriginFile(memoryDatabase, mDatabaseFilenameUtf16);
+
+	if(rc != SQLITE_OK)
+		CleanUpFailedMemoryDatabase(memoryDatabase, memoryDatabase, false, false, 0, sqlite3_errmsg(memoryDatabase));
+}
+
 void SQLiteDatabase::CleanUpFailedMemoryDatabase(sqlite3 *memoryDatabase, sqlite3 *rollbackDatabase, bool isDetachNecessary, bool isRollbackNecessary, sqlite3_stmt *stmt, const std::string &errMsg)
 {
 	if(stmt != 0)
@@ -395,6 +780,120 @@ void SQLiteDatabase::SaveDatabaseFromMemoryToFile(const wchar_t *filename)
 	}
 }
 
+SQLiteDatabase::BackupStatistics SQLiteDatabase::SaveDatabaseFromMemoryToFileIncremental(const std::string &filename, int pagesPerStep, unsigned int sleepTime, BackupProgressHandler progressHandler, void *userData, unsigned int busyTimeout)
+{
+	if(!mIsMemoryDatabaseActive)
+		KOMPEX_EXCEPT("SaveDatabaseFromMemoryToFileIncremental() the database is not located in memory");
+
+	std::string targetFilename = filename;
+	if(targetFilename == "")
+	{
+		if(mDatabaseFilenameUtf8 == "")
+			KOMPEX_EXCEPT("SaveDatabaseFromMemoryToFileIncremental() can only be used for UTF-8 filenames");
+		targetFilename = mDatabaseFilenameUtf8;
+	}
+	bool isOriginReplaced = (targetFilename == mDatabaseFilenameUtf8);
+
+	// the snapshot is written into a temporary file, so that the target file stays intact if anything fails
+	// a journal which was left over from a crashed snapshot would be rolled back into the new temporary file
+	std::string temporaryFilename = targetFilename + ".tmp";
+	std::remove(temporaryFilename.c_str());
+	RemoveJournalFiles(temporaryFilename);
+
+	sqlite3 *fileDatabase;
+	if(sqlite3_open_v2(temporaryFilename.c_str(), &fileDatabase, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0) != SQLITE_OK)
+	{
+		std::string errMsg = sqlite3_errmsg(fileDatabase);
+		sqlite3_close(fileDatabase);
+		KOMPEX_EXCEPT(errMsg);
+	}
+
+	BackupStatistics statistics;
+	std::string errMsg;
+	sqlite3_backup *backup = sqlite3_backup_init(fileDatabase, "main", mDatabaseHandle, "main");
+	if(!backup)
+	{
+		errMsg = sqlite3_errmsg(fileDatabase);
+	}
+	else
+	{
+		try
+		{
+			statistics = RunIncrementalBackup(backup, fileDatabase, pagesPerStep, sleepTime, progressHandler, userData, busyTimeout);
+		}
+		catch(SQLiteException &exception)
+		{
+			errMsg = exception.GetErrorDescription();
+		}
+	}
+
+	// closing the database syncs the file
+	if(sqlite3_close(fileDatabase) != SQLITE_OK && errMsg.empty())
+		errMsg = "SaveDatabaseFromMemoryToFileIncremental() the temporary database could not be closed";
+
+	// the origin database file must not be opened while it is replaced
+	if(errMsg.empty() && isOriginReplaced && sqlite3_exec(mDatabaseHandle, "DETACH DATABASE origin", 0, 0, 0) != SQLITE_OK)
+		errMsg = sqlite3_errmsg(mDatabaseHandle);
+
+	if(!errMsg.empty())
+	{
+		std::remove(temporaryFilename.c_str());
+		KOMPEX_EXCEPT(errMsg);
+	}
+
+	try
+	{
+		SwapDatabaseFile(temporaryFilename, targetFilename);
+	}
+	catch(SQLiteException &exception)
+	{
+		std::remove(temporaryFilename.c_str());
+		errMsg = exception.GetErrorDescription();
+	}
+
+	if(isOriginReplaced)
+	{
+		if(AttachOriginFile(mDatabaseHandle, mDatabaseFilenameUtf8) != SQLITE_OK && errMsg.empty())
+			errMsg = sqlite3_errmsg(mDatabaseHandle);
+	}
+
+	if(!errMsg.empty())
+		KOMPEX_EXCEPT(errMsg);
+
+	return statistics;
+}
+
+void SQLiteDatabase::SwapDatabaseFile(const std::string &sourceFilename, const std::string &targetFilename)
+{
+	// SQLite would replay the WAL file or roll back the journal of the old target into the new database file,
+	// i.e. the old target is checkpointed and closed and its journal files are removed before the swap
+	if(!CheckpointDatabaseFile(targetFilename))
+		KOMPEX_EXCEPT("SwapDatabaseFile() '" + targetFilename + "' is still in use by another connection");
+	RemoveJournalFiles(targetFilename);
+
+#if defined(_WIN32)
+	if(!MoveFileExA(sourceFilename.c_str(), targetFilename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+		KOMPEX_EXCEPT("SwapDatabaseFile() '" + targetFilename + "' could not be replaced");
+#else
+	// rename() replaces the target atomically
+	if(std::rename(sourceFilename.c_str(), targetFilename.c_str()) != 0)
+		KOMPEX_EXCEPT("SwapDatabaseFile() '" + targetFilename + "' could not be replaced");
+
+	// sync the directory, so that the new directory entry survives a crash
+	std::string::size_type separator = targetFilename.find_last_of('/');
+	std::string directory = (separator == std::string::npos) ? "." : targetFilename.substr(0, separator + 1);
+	int directoryDescriptor = open(directory.c_str(), O_RDONLY);
+	if(directoryDescriptor == -1)
+		KOMPEX_EXCEPT("SwapDatabaseFile() the directory of '" + targetFilename + "' could not be opened for syncing");
+
+	// some file systems don't support syncing a directory (EINVAL)
+	bool isSynced = (fsync(directoryDescriptor) == 0 || errno == EINVAL);
+	close(directoryDescriptor);
+	if(!isSynced)
+		KOMPEX_EXCEPT("SwapDatabaseFile() the directory of '" + targetFilename + "' could not be synced");
+#endif
+}
+
 void SQLiteDatabase::TakeSnapshot(sqlite3 *destinationDatabase)
 {
 	sqlite3_backup *backup;
@@ -428,4 +927,360 @@ void SQLiteDatabase::CreateModule(const std::string &moduleName, const sqlite3_m
 		KOMPEX_EXCEPT(sqlite3_errmsg(mDatabaseHandle));
 }
 
+void SQLiteDatabase::RegisterFunction(const std::string &name, int numberOfArguments, bool isDeterministic, void *userData,
+	void (*xFunc)(sqlite3_context*, int, sqlite3_value**), void (*xStep)(sqlite3_context*, int, sqlite3_value**),
+	void (*xFinal)(sqlite3_context*), void (*xDestroy)(void*))
+{
+	int flags = CheckFunctionRegistration(name, numberOfArguments, isDeterministic, userData, xDestroy);
+
+	// SQLite calls xDestroy if the registration fails
+	if(sqlite3_create_function_v2(mDatabaseHandle, name.c_str(), numberOfArguments, flags, userData, xFunc, xStep, xFinal, xDestroy) != SQLITE_OK)
+		KOMPEX_EXCEPT(sqlite3_errmsg(mDatabaseHandle));
+}
+
+#if SQLITE_VERSION_NUMBER >= 3025000
+void SQLiteDatabase::RegisterWindowFunction(const std::string &name, int numberOfArguments, bool isDeterministic, void *userData,
+	void (*xStep)(sqlite3_context*, int, sqlite3_value**), void (*xFinal)(sqlite3_context*), void (*xValue)(sqlite3_context*),
+	void (*xInverse)(sqlite3_context*, int, sqlite3_value**), void (*xDestroy)(void*))
+{
+	int flags = CheckFunctionRegistration(name, numberOfArguments, isDeterministic, userData, xDestroy);
+
+	// SQLite calls xDestroy if the registration fails
+	if(sqlite3_create_window_function(mDatabaseHandle, name.c_str(), numberOfArguments, flags, userData, xStep, xFinal, xValue, xInverse, xDestroy) != SQLITE_OK)
+		KOMPEX_EXCEPT(sqlite3_errmsg(mDatabaseHandle));
+}
+#endif
+
+int SQLiteDatabase::CheckFunctionRegistration(const std::string &name, int numberOfArguments, bool isDeterministic, void *userData, void (*xDestroy)(void*))
+{
+	std::string errMsg;
+	if(!mDatabaseHandle)
+		errMsg = "RegisterFunction() database is not opened";
+	else if(name.empty() || name.length() > 255)
+		errMsg = "RegisterFunction() the function name must have 1 to 255 bytes";
+	else if(numberOfArguments > sqlite3_limit(mDatabaseHandle, SQLITE_LIMIT_FUNCTION_ARG, -1))
+	{
+		std::stringstream strStream;
+		strStream << "RegisterFunction() '" << name << "' has " << numberOfArguments << " arguments, SQLite allows only "
+			<< sqlite3_limit(mDatabaseHandle, SQLITE_LIMIT_FUNCTION_ARG, -1);
+		errMsg = strStream.str();
+	}
+
+	if(!errMsg.empty())
+	{
+		if(xDestroy)
+			xDestroy(userData);
+		KOMPEX_EXCEPT(errMsg);
+	}
+
+	int flags = SQLITE_UTF8;
+	if(isDeterministic)
+	{
+		// SQLITE_DETERMINISTIC is known since SQLite 3.8.3
+		#ifdef SQLITE_DETERMINISTIC
+		flags |= SQLITE_DETERMINISTIC;
+		#else
+		if(sqlite3_libversion_number() >= 3008003)
+			flags |= 0x800;
+		#endif
+	}
+	return flags;
+}
+
+void SQLiteDatabase::RemoveFunction(const std::string &name, int numberOfArguments)
+{
+	if(sqlite3_create_function_v2(mDatabaseHandle, name.c_str(), numberOfArguments, SQLITE_UTF8, 0, 0, 0, 0, 0) != SQLITE_OK)
+		KOMPEX_EXCEPT(sqlite3_errmsg(mDatabaseHandle));
+}
+
+void SQLiteDatabase::RegisterCollation(const std::string &name, void *userData, int (*xCompare)(void*, int, const void*, int, const void*), void (*xDestroy)(void*))
+{
+	// unlike sqlite3_create_function_v2(), SQLite doesn't call xDestroy if the registration fails
+	if(!mDatabaseHandle || sqlite3_create_collation_v2(mDatabaseHandle, name.c_str(), SQLITE_UTF8, userData, xCompare, xDestroy) != SQLITE_OK)
+	{
+		std::string errMsg = mDatabaseHandle ? sqlite3_errmsg(mDatabaseHandle) : "RegisterCollation() database is not opened";
+		if(xDestroy)
+			xDestroy(userData);
+		KOMPEX_EXCEPT(errMsg);
+	}
+}
+
+void SQLiteDatabase::RemoveCollation(const std::string &name)
+{
+	if(sqlite3_create_collation_v2(mDatabaseHandle, name.c_str(), SQLITE_UTF8, 0, 0, 0) != SQLITE_OK)
+		KOMPEX_EXCEPT(sqlite3_errmsg(mDatabaseHandle));
+}
+
+void SQLiteDatabase::AddSortKeyColumn(const std::string &table, const std::string &column, const std::string &sortKeyColumn, const std::string &sortKeyFunction, bool createIndex)
+{
+	using Internal::QuoteIdentifier;
+
+	std::string quotedTable = QuoteIdentifier(table);
+	std::string quotedKeyColumn = QuoteIdentifier(sortKeyColumn);
+	std::string keyOfNewRow = QuoteIdentifier(sortKeyFunction) + "(NEW." + QuoteIdentifier(column) + ")";
+	std::string updateNewRow = "UPDATE " + quotedTable + " SET " + quotedKeyColumn + " = " + keyOfNewRow + " WHERE rowid = NEW.rowid; END;";
+
+	std::string sql = "SAVEPOINT kompex_sort_key;"
+		"ALTER TABLE " + quotedTable + " ADD COLUMN " + quotedKeyColumn + " BLOB;"
+		"UPDATE " + quotedTable + " SET " + quotedKeyColumn + " = " + QuoteIdentifier(sortKeyFunction) + "(" + QuoteIdentifier(column) + ");"
+		"CREATE TRIGGER " + QuoteIdentifier(table + "_" + sortKeyColumn + "_insert") + " AFTER INSERT ON " + quotedTable + " BEGIN " + updateNewRow +
+		"CREATE TRIGGER " + QuoteIdentifier(table + "_" + sortKeyColumn + "_update") + " AFTER UPDATE OF " + QuoteIdentifier(column) + " ON " + quotedTable + " BEGIN " + updateNewRow;
+	if(createIndex)
+		sql += "CREATE INDEX " + QuoteIdentifier(table + "_" + sortKeyColumn + "_index") + " ON " + quotedTable + "(" + quotedKeyColumn + ");";
+	sql += "RELEASE kompex_sort_key;";
+
+	char *errMsg = 0;
+	if(sqlite3_exec(mDatabaseHandle, sql.c_str(), 0, 0, &errMsg) != SQLITE_OK)
+	{
+		std::string errorDescription = errMsg ? errMsg : sqlite3_errmsg(mDatabaseHandle);
+		sqlite3_free(errMsg);
+		sqlite3_exec(mDatabaseHandle, "ROLLBACK TO kompex_sort_key; RELEASE kompex_sort_key;", 0, 0, 0);
+		KOMPEX_EXCEPT(errorDescription);
+	}
+}
+
+std::string SQLiteDatabase::ExecutePragma(const std::string &pragma)
+{
+	sqlite3_stmt *stmt;
+	if(sqlite3_prepare_v2(mDatabaseHandle, pragma.c_str(), -1, &stmt, 0) != SQLITE_OK)
+		KOMPEX_EXCEPT(sqlite3_errmsg(mDatabaseHandle));
+
+	std::string result;
+	int rc = sqlite3_step(stmt);
+	if(rc == SQLITE_ROW)
+	{
+		const char *value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+		if(value)
+			result = value;
+	}
+	else if(rc != SQLITE_DONE)
+	{
+		std::string errMsg = sqlite3_errmsg(mDatabaseHandle);
+		sqlite3_finalize(stmt);
+		KOMPEX_EXCEPT(errMsg);
+	}
+
+	sqlite3_finalize(stmt);
+	return result;
+}
+
+void SQLiteDatabase::ApplyJournalSettings(const JournalSettings &settings)
+{
+	SetJournalMode(settings.journalMode);
+	SetSynchronous(settings.synchronous);
+	SetWalAutoCheckpoint(settings.walAutoCheckpoint);
+	SetJournalSizeLimit(settings.journalSizeLimit);
+}
+
+void SQLiteDatabase::SetJournalMode(JournalMode mode)
+{
+	static const char *journalModes[] = {"delete", "truncate", "persist", "memory", "wal", "off"};
+
+	std::string result = ExecutePragma(std::string("PRAGMA journal_mode = ") + journalModes[mode] + ";");
+	std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+	if(result != journalModes[mode])
+		KOMPEX_EXCEPT(std::string("SetJournalMode() journal mode '") + journalModes[mode] + "' could not be activated, the current journal mode is '" + result + "'");
+}
+
+SQLiteDatabase::JournalMode SQLiteDatabase::GetJournalMode()
+{
+	std::string result = ExecutePragma("PRAGMA journal_mode;");
+	std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+
+	if(result == "truncate")
+		return JOURNAL_TRUNCATE;
+	if(result == "persist")
+		return JOURNAL_PERSIST;
+	if(result == "memory")
+		return JOURNAL_MEMORY;
+	if(result == "wal")
+		return JOURNAL_WAL;
+	if(result == "off")
+		return JOURNAL_OFF;
+	return JOURNAL_DELETE;
+}
+
+void SQLiteDatabase::SetSynchronous(SynchronousMode mode)
+{
+	static const char *synchronousModes[] = {"OFF", "NORMAL", "FULL"};
+	ExecutePragma(std::string("PRAGMA synchronous = ") + synchronousModes[mode] + ";");
+}
+
+void SQLiteDatabase::SetWalAutoCheckpoint(int pages)
+{
+	if(sqlite3_wal_autocheckpoint(mDatabaseHandle, pages) != SQLITE_OK)
+		KOMPEX_EXCEPT(sqlite3_errmsg(mDatabaseHandle));
+}
+
+void SQLiteDatabase::SetJournalSizeLimit(int64 bytes)
+{
+	std::stringstream strStream;
+	strStream << "PRAGMA journal_size_limit = " << bytes << ";";
+	ExecutePragma(strStream.str());
+}
+
+bool SQLiteDatabase::WalCheckpoint(CheckpointMode mode, int *walFrames, int *checkpointedFrames, const char *databaseName)
+{
+	int checkpointMode = GetSQLiteCheckpointMode(mode);
+
+	int frames = 0;
+	int checkpointed = 0;
+	int rc = sqlite3_wal_checkpoint_v2(mDatabaseHandle, databaseName, checkpointMode, &frames, &checkpointed);
+	if(rc != SQLITE_OK && rc != SQLITE_BUSY)
+		KOMPEX_EXCEPT(sqlite3_errmsg(mDatabaseHandle));
+
+	if(walFrames)
+		*walFrames = frames;
+	if(checkpointedFrames)
+		*checkpointedFrames = checkpointed;
+
+	return rc == SQLITE_OK;
+}
+
+SQLiteDatabase::TuningSettings::TuningSettings(TuningProfile profile)
+{
+	switch(profile)
+	{
+		case PROFILE_READ_HEAVY:
+			lookasideSlotSize = 256;
+			lookasideSlotCount = 500;
+			cacheSize = -65536;
+			tempStore = TEMP_STORE_MEMORY;
+			break;
+		case PROFILE_BULK_LOAD:
+			lookasideSlotSize = 2048;
+			lookasideSlotCount = 128;
+			cacheSize = -262144;
+			tempStore = TEMP_STORE_FILE;
+			break;
+		case PROFILE_LOW_MEMORY:
+			lookasideSlotSize = 128;
+			lookasideSlotCount = 32;
+			cacheSize = -512;
+			tempStore = TEMP_STORE_FILE;
+			break;
+		default:
+			lookasideSlotSize = 1200;
+			lookasideSlotCount = 100;
+			cacheSize = -2000;
+			tempStore = TEMP_STORE_DEFAULT;
+	}
+}
+
+void SQLiteDatabase::ApplyTuningSettings(const TuningSettings &settings)
+{
+	// the cached statements hold lookaside memory
+	mStatementCache.Clear();
+
+	SetLookaside(settings.lookasideSlotSize, settings.lookasideSlotCount);
+	SetCacheSize(settings.cacheSize);
+	SetTempStore(settings.tempStore);
+}
+
+void SQLiteDatabase::SetLookaside(int slotSize, int slotCount)
+{
+	// SQLite allocates the lookaside memory itself if no buffer is passed
+	int rc = sqlite3_db_config(mDatabaseHandle, SQLITE_DBCONFIG_LOOKASIDE, static_cast<void*>(0), slotSize, slotCount);
+	if(rc == SQLITE_BUSY)
+		KOMPEX_EXCEPT("SetLookaside() lookaside memory is in use, please finalize all statements of the connection");
+	if(rc != SQLITE_OK)
+		KOMPEX_EXCEPT(sqlite3_errstr(rc));
+}
+
+void SQLiteDatabase::SetCacheSize(int64 size)
+{
+	std::stringstream strStream;
+	strStream << "PRAGMA cache_size = " << size << ";";
+	ExecutePragma(strStream.str());
+}
+
+int64 SQLiteDatabase::GetCacheSize()
+{
+	int64 size = 0;
+	std::stringstream strStream(ExecutePragma("PRAGMA cache_size;"));
+	strStream >> size;
+	return size;
+}
+
+void SQLiteDatabase::SetTempStore(TempStore tempStore)
+{
+	static const char *tempStores[] = {"default", "file", "memory"};
+	ExecutePragma(std::string("PRAGMA temp_store = ") + tempStores[tempStore] + ";");
+}
+
+void SQLiteDatabase::SetMmapSize(int64 bytes)
+{
+	// older versions ignore the pragma silently
+	if(sqlite3_libversion_number() < 3007017)
+		KOMPEX_EXCEPT("SetMmapSize() memory-mapped I/O requires SQLite 3.7.17 or newer");
+
+	std::stringstream strStream;
+	strStream << "PRAGMA mmap_size = " << bytes << ";";
+	ExecutePragma(strStream.str());
+}
+
+int64 SQLiteDatabase::GetMmapSize()
+{
+	if(sqlite3_libversion_number() < 3007017)
+		return 0;
+
+	int64 size = 0;
+	std::stringstream strStream(ExecutePragma("PRAGMA mmap_size;"));
+	strStream >> size;
+	return size;
+}
+
+namespace
+{
+	//! Memory region of ConfigurePageCache(); it is used by SQLite until the next sqlite3_shutdown()
+	std::unique_ptr<char[]> pageCacheBuffer;
+}
+
+void SQLiteDatabase::ConfigurePageCache(int pageSize, int pageCount)
+{
+	if(pageCount <= 0)
+	{
+		if(sqlite3_config(SQLITE_CONFIG_PAGECACHE, static_cast<void*>(0), 0, 0) != SQLITE_OK)
+			KOMPEX_EXCEPT("ConfigurePageCache() the page cache can only be configured before SQLite is initialized or after sqlite3_shutdown()");
+		pageCacheBuffer.reset();
+		return;
+	}
+
+	// every slot holds a page and its header
+	int headerSize = 256;
+	// SQLITE_CONFIG_PCACHE_HDRSZ is known since SQLite 3.8.8
+	#ifdef SQLITE_CONFIG_PCACHE_HDRSZ
+	sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &headerSize);
+	#else
+	if(sqlite3_libversion_number() >= 3008008)
+		sqlite3_config(24, &headerSize);
+	#endif
+
+	int slotSize = (pageSize + headerSize + 7) & ~7;
+	std::unique_ptr<char[]> buffer(new char[static_cast<size_t>(slotSize) * pageCount]);
+	if(sqlite3_config(SQLITE_CONFIG_PAGECACHE, buffer.get(), slotSize, pageCount) != SQLITE_OK)
+		KOMPEX_EXCEPT("ConfigurePageCache() the page cache can only be configured before SQLite is initialized or after sqlite3_shutdown()");
+
+	// SQLite is not initialized, therefore the old region is not in use anymore
+	pageCacheBuffer = std::move(buffer);
+}
+
+void SQLiteDatabase::ConfigurePageCache(TuningProfile profile)
+{
+	switch(profile)
+	{
+		case PROFILE_READ_HEAVY:
+			ConfigurePageCache(4096, 16384);
+			break;
+		case PROFILE_BULK_LOAD:
+			ConfigurePageCache(4096, 65536);
+			break;
+		case PROFILE_LOW_MEMORY:
+			ConfigurePageCache(4096, 128);
+			break;
+		default:
+			ConfigurePageCache(0, 0);
+	}
+}
+
 }	// namespace Kompex
@@ -0,0 +1,116 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iomanip>
+#include <sstream>
+
+#include "KompexSQLiteDatabaseStatistics.h"
+
+namespace Kompex
+{
+
+SQLiteDatabaseStatistics::SQLiteDatabaseStatistics():
+	timestamp(0.0),
+	interval(0.0),
+	cacheHits(0),
+	cacheMisses(0),
+	cacheWrites(0),
+	lookasideHits(0),
+	lookasideMissSize(0),
+	lookasideMissFull(0),
+	cacheUsed(0),
+	schemaUsed(0),
+	statementUsed(0)
+{
+}
+
+double SQLiteDatabaseStatistics::GetCacheHitRatio() const
+{
+	int64 requests = cacheHits + cacheMisses;
+	return requests > 0 ? static_cast<double>(cacheHits) / requests : 0.0;
+}
+
+double SQLiteDatabaseStatistics::GetLookasideHitRatio() const
+{
+	int64 requests = lookasideHits + lookasideMissSize + lookasideMissFull;
+	return requests > 0 ? static_cast<double>(lookasideHits) / requests : 0.0;
+}
+
+SQLiteDatabaseStatistics SQLiteDatabaseStatistics::Delta(const SQLiteDatabaseStatistics &earlier) const
+{
+	SQLiteDatabaseStatistics delta = *this;
+	delta.interval = timestamp - earlier.timestamp;
+
+	delta.cacheHits = cacheHits - earlier.cacheHits;
+	delta.cacheMisses = cacheMisses - earlier.cacheMisses;
+	delta.cacheWrites = cacheWrites - earlier.cacheWrites;
+	delta.lookasideHits = lookasideHits - earlier.lookasideHits;
+	delta.lookasideMissSize = lookasideMissSize - earlier.lookasideMissSize;
+	delta.lookasideMissFull = lookasideMissFull - earlier.lookasideMissFull;
+
+	return delta;
+}
+
+namespace
+{
+	void WriteJsonValue(std::ostream &stream, const char *name, int64 value)
+	{
+		stream << ",\"" << name << "\":" << value;
+	}
+
+	void WriteJsonValue(std::ostream &stream, const char *name, const SQLiteStatusValue &value)
+	{
+		stream << ",\"" << name << "\":{\"current\":" << value.current << ",\"highwater\":" << value.highwater << "}";
+	}
+}
+
+std::string SQLiteDatabaseStatistics::ToJson() const
+{
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(6);
+
+	stream << "{\"timestamp\":" << timestamp << ",\"interval\":" << interval;
+
+	WriteJsonValue(stream, "cache_hits", cacheHits);
+	WriteJsonValue(stream, "cache_misses", cacheMisses);
+	WriteJsonValue(stream, "cache_writes", cacheWrites);
+	WriteJsonValue(stream, "lookaside_hits", lookasideHits);
+	WriteJsonValue(stream, "lookaside_miss_size", lookasideMissSize);
+	WriteJsonValue(stream, "lookaside_miss_full", lookasideMissFull);
+
+	WriteJsonValue(stream, "lookaside_used", lookasideUsed);
+	WriteJsonValue(stream, "cache_used", cacheUsed);
+	WriteJsonValue(stream, "schema_used", schemaUsed);
+	WriteJsonValue(stream, "statement_used", statementUsed);
+
+	WriteJsonValue(stream, "memory_used", memoryUsed);
+	WriteJsonValue(stream, "malloc_size", mallocSize);
+	WriteJsonValue(stream, "malloc_count", mallocCount);
+	WriteJsonValue(stream, "pagecache_used", pagecacheUsed);
+	WriteJsonValue(stream, "pagecache_overflow", pagecacheOverflow);
+	WriteJsonValue(stream, "pagecache_size", pagecacheSize);
+	WriteJsonValue(stream, "scratch_used", scratchUsed);
+	WriteJsonValue(stream, "scratch_overflow", scratchOverflow);
+	WriteJsonValue(stream, "scratch_size", scratchSize);
+	WriteJsonValue(stream, "parser_stack", parserStack);
+
+	stream << "}";
+	return stream.str();
+}
+
+}	// namespace Kompex
@@ -0,0 +1,274 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <exception>
+
+#include "KompexSQLiteGroupCommitWriter.h"
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteSavepoint.h"
+#include "KompexSQLiteException.h"
+
+namespace Kompex
+{
+
+SQLiteGroupCommitWriter::SQLiteGroupCommitWriter(SQLiteDatabase *db, unsigned int maxBatchSize, unsigned int maxBatchDelay):
+	mDatabase(db),
+	mMaxBatchSize(std::max(maxBatchSize, 1u)),
+	mMaxBatchDelay(maxBatchDelay),
+	mIsStopRequested(false)
+{
+	if(!mDatabase || !mDatabase->GetDatabaseHandle())
+		KOMPEX_EXCEPT("SQLiteGroupCommitWriter() database is not opened");
+
+	mStatistics.batches = 0;
+	mStatistics.failedBatches = 0;
+	mStatistics.requests = 0;
+	mStatistics.failedRequests = 0;
+
+	mThread = std::thread(&SQLiteGroupCommitWriter::Run, this);
+}
+
+SQLiteGroupCommitWriter::~SQLiteGroupCommitWriter()
+{
+	Stop();
+}
+
+void SQLiteGroupCommitWriter::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsStopRequested = true;
+	}
+	mCondition.notify_one();
+
+	if(mThread.joinable())
+		mThread.join();
+}
+
+std::future<void> SQLiteGroupCommitWriter::Submit(const std::string &sql)
+{
+	return Submit(sql, std::vector<SQLiteValue>());
+}
+
+std::future<void> SQLiteGroupCommitWriter::Submit(const std::string &sql, const std::vector<SQLiteValue> &parameters)
+{
+	Request request;
+	request.sql = sql;
+	request.parameters = parameters;
+	request.submitTime = std::chrono::steady_clock::now();
+	std::future<void> future = request.promise.get_future();
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if(mIsStopRequested)
+			KOMPEX_EXCEPT("Submit() the group commit writer is stopped");
+
+		mQueue.push_back(std::move(request));
+	}
+	mCondition.notify_one();
+
+	return future;
+}
+
+size_t SQLiteGroupCommitWriter::GetQueueSize() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mQueue.size();
+}
+
+SQLiteGroupCommitStatistics SQLiteGroupCommitWriter::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStatistics;
+}
+
+void SQLiteGroupCommitWriter::ResetStatistics()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStatistics.batches = 0;
+	mStatistics.failedBatches = 0;
+	mStatistics.requests = 0;
+	mStatistics.failedRequests = 0;
+	mStatistics.batchSizes.Reset();
+	mStatistics.commitLatencies.Reset();
+	mStatistics.requestLatencies.Reset();
+}
+
+void SQLiteGroupCommitWriter::Run()
+{
+	std::vector<Request> batch;
+	batch.reserve(mMaxBatchSize);
+
+	while(true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			while(mQueue.empty() && !mIsStopRequested)
+				mCondition.wait(lock);
+
+			// the queue is drained before the thread stops
+			if(mQueue.empty())
+				break;
+
+			// wait for further statements to fill the batch
+			if(mMaxBatchDelay.count() > 0 && !mIsStopRequested)
+			{
+				std::chrono::steady_clock::time_point deadline = mQueue.front().submitTime + mMaxBatchDelay;
+				while(mQueue.size() < mMaxBatchSize && !mIsStopRequested)
+				{
+					if(mCondition.wait_until(lock, deadline) == std::cv_status::timeout)
+						break;
+				}
+			}
+
+			size_t batchSize = std::min(mQueue.size(), mMaxBatchSize);
+			for(size_t i = 0; i < batchSize; ++i)
+			{
+				batch.push_back(std::move(mQueue.front()));
+				mQueue.pop_front();
+			}
+		}
+
+		ExecuteBatch(batch);
+		batch.clear();
+	}
+}
+
+void SQLiteGroupCommitWriter::ExecuteBatch(std::vector<Request> &batch)
+{
+	// error messages of the failed requests; an empty message means success
+	std::vector<std::string> errors(batch.size());
+	std::string batchError;
+	bool isCommitted = false;
+	std::chrono::steady_clock::duration commitLatency(0);
+
+	// every exception must be caught, otherwise the futures of the batch would never become ready
+	try
+	{
+		// the write lock is taken immediately, so that the batch can't fail later because of a lock upgrade
+		ExecuteStatement("BEGIN IMMEDIATE;", std::vector<SQLiteValue>());
+
+		for(size_t i = 0; i < batch.size() && batchError.empty(); ++i)
+		{
+			try
+			{
+				SQLiteSavepoint savepoint(mDatabase, "kompex_group_commit");
+				ExecuteStatement(batch[i].sql.c_str(), batch[i].parameters);
+				savepoint.Release();
+			}
+			catch(SQLiteException &exception)
+			{
+				errors[i] = exception.GetErrorDescription();
+
+				// some errors (e.g. SQLITE_FULL or SQLITE_IOERR) roll back the whole transaction
+				if(sqlite3_get_autocommit(mDatabase->GetDatabaseHandle()))
+					batchError = errors[i];
+			}
+		}
+
+		if(batchError.empty())
+		{
+			std::chrono::steady_clock::time_point commitStartTime = std::chrono::steady_clock::now();
+			ExecuteStatement("COMMIT;", std::vector<SQLiteValue>());
+			commitLatency = std::chrono::steady_clock::now() - commitStartTime;
+			isCommitted = true;
+		}
+	}
+	catch(SQLiteException &exception)
+	{
+		batchError = exception.GetErrorDescription();
+	}
+	catch(std::exception &exception)
+	{
+		batchError = exception.what();
+	}
+	catch(...)
+	{
+		batchError = "unknown exception during the group commit";
+	}
+
+	if(!batchError.empty() && !sqlite3_get_autocommit(mDatabase->GetDatabaseHandle()))
+		sqlite3_exec(mDatabase->GetDatabaseHandle(), "ROLLBACK", 0, 0, 0);
+
+	std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+
+	uint64 failedRequests = 0;
+	for(size_t i = 0; i < batch.size(); ++i)
+	{
+		if(!batchError.empty() || !errors[i].empty())
+			++failedRequests;
+	}
+
+	// the statistics are updated before the futures become ready, so that they include the batch of a completed request
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if(batchError.empty())
+			++mStatistics.batches;
+		else
+			++mStatistics.failedBatches;
+		mStatistics.requests += batch.size();
+		mStatistics.failedRequests += failedRequests;
+		mStatistics.batchSizes.Record(batch.size());
+		if(isCommitted)
+			mStatistics.commitLatencies.Record(std::chrono::duration_cast<std::chrono::microseconds>(commitLatency).count());
+		for(std::vector<Request>::const_iterator iter = batch.begin(); iter != batch.end(); ++iter)
+			mStatistics.requestLatencies.Record(std::chrono::duration_cast<std::chrono::microseconds>(endTime - iter->submitTime).count());
+	}
+
+	for(size_t i = 0; i < batch.size(); ++i)
+	{
+		const std::string &error = batchError.empty() ? errors[i] : batchError;
+		if(error.empty())
+			batch[i].promise.set_value();
+		else
+			batch[i].promise.set_exception(std::make_exception_ptr(SQLiteException(__FILE__, __LINE__, error)));
+	}
+}
+
+void SQLiteGroupCommitWriter::ExecuteStatement(const char *sql, const std::vector<SQLiteValue> &parameters)
+{
+	sqlite3 *handle = mDatabase->GetDatabaseHandle();
+	SQLiteColumnLookup columnLookup;
+	sqlite3_stmt *statement = mDatabase->GetStatementCache().Acquire(handle, sql, columnLookup);
+
+	int rc = SQLITE_OK;
+	for(size_t i = 0; i < parameters.size() && rc == SQLITE_OK; ++i)
+		rc = parameters[i].Bind(statement, static_cast<int>(i + 1));
+
+	if(rc == SQLITE_OK)
+	{
+		do
+		{
+			rc = sqlite3_step(statement);
+		}
+		while(rc == SQLITE_ROW);
+	}
+
+	std::string errMsg;
+	if(rc != SQLITE_DONE)
+		errMsg = sqlite3_errmsg(handle);
+
+	// the cache resets the statement and clears the bindings
+	mDatabase->GetStatementCache().Release(statement, columnLookup);
+
+	if(!errMsg.empty())
+		KOMPEX_EXCEPT(errMsg);
+}
+
+}	// namespace Kompex
@@ -0,0 +1,45 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteInternal_H
+#define KompexSQLiteInternal_H
+
+#include <string>
+
+// Helpers which are shared by the translation units of the wrapper; this header isn't installed.
+
+namespace Kompex
+{
+	namespace Internal
+	{
+		//! Quotes an identifier (e.g. table, column or savepoint name) with double quotes.
+		inline std::string QuoteIdentifier(const std::string &identifier)
+		{
+			std::string quoted = "\"";
+			for(std::string::const_iterator iter = identifier.begin(); iter != identifier.end(); ++iter)
+			{
+				if(*iter == '"')
+					quoted += '"';
+				quoted += *iter;
+			}
+			return quoted + "\"";
+		}
+	}
+};
+
+#endif // KompexSQLiteInternal_H
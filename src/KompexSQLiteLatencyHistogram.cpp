@@ -0,0 +1,135 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "KompexSQLiteLatencyHistogram.h"
+
+namespace Kompex
+{
+
+// number of linear sub-buckets per power of two (2^5 = 32)
+static const unsigned int SUB_BUCKET_BITS = 5;
+static const unsigned int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+// values below SUB_BUCKET_COUNT are stored exactly, every further power of two gets SUB_BUCKET_COUNT buckets
+static const unsigned int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+SQLiteLatencyHistogram::SQLiteLatencyHistogram():
+	mBuckets(BUCKET_COUNT, 0),
+	mCount(0),
+	mTotal(0),
+	mMin(0),
+	mMax(0)
+{
+}
+
+unsigned int SQLiteLatencyHistogram::GetBucketIndex(uint64 value)
+{
+	if(value < SUB_BUCKET_COUNT)
+		return static_cast<unsigned int>(value);
+
+	// position of the most significant bit
+	unsigned int msb = 0;
+	for(uint64 v = value >> 1; v; v >>= 1)
+		++msb;
+
+	unsigned int shift = msb - SUB_BUCKET_BITS;
+	unsigned int subBucket = static_cast<unsigned int>(value >> shift) - SUB_BUCKET_COUNT;
+	return (shift + 1) * SUB_BUCKET_COUNT + subBucket;
+}
+
+uint64 SQLiteLatencyHistogram::GetBucketUpperBound(unsigned int index)
+{
+	if(index < SUB_BUCKET_COUNT)
+		return index;
+
+	unsigned int shift = index / SUB_BUCKET_COUNT - 1;
+	uint64 subBucket = index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+	return ((subBucket + 1) << shift) - 1;
+}
+
+void SQLiteLatencyHistogram::Record(uint64 value, uint64 count)
+{
+	if(count == 0)
+		return;
+
+	mBuckets[GetBucketIndex(value)] += count;
+
+	if(mCount == 0 || value < mMin)
+		mMin = value;
+	if(value > mMax)
+		mMax = value;
+
+	mCount += count;
+	mTotal += value * count;
+}
+
+void SQLiteLatencyHistogram::Merge(const SQLiteLatencyHistogram &histogram)
+{
+	if(histogram.mCount == 0)
+		return;
+
+	for(unsigned int i = 0; i < BUCKET_COUNT; ++i)
+		mBuckets[i] += histogram.mBuckets[i];
+
+	if(mCount == 0 || histogram.mMin < mMin)
+		mMin = histogram.mMin;
+	if(histogram.mMax > mMax)
+		mMax = histogram.mMax;
+
+	mCount += histogram.mCount;
+	mTotal += histogram.mTotal;
+}
+
+void SQLiteLatencyHistogram::Reset()
+{
+	mBuckets.assign(BUCKET_COUNT, 0);
+	mCount = 0;
+	mTotal = 0;
+	mMin = 0;
+	mMax = 0;
+}
+
+uint64 SQLiteLatencyHistogram::GetPercentile(double percentile) const
+{
+	if(mCount == 0)
+		return 0;
+
+	if(percentile < 0.0)
+		percentile = 0.0;
+	if(percentile > 100.0)
+		percentile = 100.0;
+
+	// rank of the requested value (at least the first value)
+	uint64 rank = static_cast<uint64>(percentile / 100.0 * mCount + 0.5);
+	if(rank == 0)
+		rank = 1;
+
+	uint64 count = 0;
+	for(unsigned int i = 0; i < BUCKET_COUNT; ++i)
+	{
+		count += mBuckets[i];
+		if(count >= rank)
+		{
+			uint64 upperBound = GetBucketUpperBound(i);
+			return upperBound < mMax ? upperBound : mMax;
+		}
+	}
+
+	return mMax;
+}
+
+}	// namespace Kompex
@@ -0,0 +1,681 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#if defined(_WIN32)
+	#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+	#include <sys/mman.h>
+#endif
+
+#include "KompexSQLitePageCache.h"
+#include "KompexSQLiteException.h"
+
+namespace Kompex
+{
+
+namespace
+{
+	// number of LRU pages which are examined to find a page of the requested size
+	const int MAX_RECYCLE_ATTEMPTS = 8;
+	const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+	struct Cache;
+
+	//! Page header; the page content and the extra memory of SQLite follow the header
+	struct Page
+	{
+		sqlite3_pcache_page base;
+		Cache *cache;
+		unsigned int key;
+		size_t slotSize;
+		//! Pages of the same cache in the same shard
+		Page *cachePrev;
+		Page *cacheNext;
+		//! LRU list of the shard; only unpinned pages of purgeable caches
+		Page *lruPrev;
+		Page *lruNext;
+		bool isPinned;
+		bool isHeap;
+	};
+
+	const size_t PAGE_HEADER_SIZE = (sizeof(Page) + 7) & ~static_cast<size_t>(7);
+
+	//! Page cache of one connection
+	struct Cache
+	{
+		size_t pageSize;
+		size_t extraSize;
+		size_t slotSize;
+		bool isPurgeable;
+		std::atomic<unsigned int> pageCount;
+		//! First page of this cache per shard
+		std::vector<Page*> shardPages;
+	};
+
+	struct PageKey
+	{
+		const Cache *cache;
+		unsigned int key;
+
+		bool operator==(const PageKey &other) const {return cache == other.cache && key == other.key;}
+	};
+
+	struct PageKeyHash
+	{
+		size_t operator()(const PageKey &pageKey) const
+		{
+			return std::hash<const void*>()(pageKey.cache) ^ (static_cast<size_t>(pageKey.key) * 0x9E3779B1u);
+		}
+	};
+
+	struct Shard
+	{
+		Shard(): lruHead(0), lruTail(0), fetches(0), hits(0), createdPages(0), recycledPages(0), refusedFetches(0), lockAcquisitions(0), lockContentions(0), pages(0), heapPages(0) {}
+
+		std::mutex mutex;
+		std::unordered_map<PageKey, Page*, PageKeyHash> pageTable;
+		//! Most recently unpinned page
+		Page *lruHead;
+		//! Least recently unpinned page
+		Page *lruTail;
+		// counters, protected by the mutex
+		uint64 fetches;
+		uint64 hits;
+		uint64 createdPages;
+		uint64 recycledPages;
+		uint64 refusedFetches;
+		uint64 lockAcquisitions;
+		uint64 lockContentions;
+		uint64 pages;
+		uint64 heapPages;
+	};
+
+	// configuration of Install()
+	size_t configuredCapacity = 0;
+	unsigned int configuredShardCount = 16;
+	bool isHugePagesRequested = false;
+	bool isInstalled = false;
+	sqlite3_pcache_methods2 defaultMethods;
+	bool isDefaultMethodsSaved = false;
+
+	// state between xInit and xShutdown
+	std::vector<std::unique_ptr<Shard> > shards;
+	char *region = 0;
+	size_t regionSize = 0;
+	bool isHugePagesActive = false;
+
+	// slots of the memory region
+	std::mutex regionMutex;
+	size_t regionOffset = 0;
+	size_t usedBytes = 0;
+	std::map<size_t, void*> freeSlots;
+
+	//! Locks a shard and counts the contention.
+	inline std::unique_lock<std::mutex> LockShard(Shard &shard)
+	{
+		std::unique_lock<std::mutex> lock(shard.mutex, std::try_to_lock);
+		if(!lock.owns_lock())
+		{
+			lock.lock();
+			++shard.lockContentions;
+		}
+		++shard.lockAcquisitions;
+		return lock;
+	}
+
+	inline unsigned int GetShardIndex(unsigned int key)
+	{
+		return key % static_cast<unsigned int>(shards.size());
+	}
+
+	char *AllocateRegion(size_t &size, bool useHugePages, bool &isHugePages)
+	{
+		isHugePages = false;
+	#if defined(_WIN32)
+		return static_cast<char*>(VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+	#elif defined(__unix__) || defined(__APPLE__)
+		void *memory = MAP_FAILED;
+		#ifdef MAP_HUGETLB
+		if(useHugePages)
+		{
+			size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+			memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			isHugePages = memory != MAP_FAILED;
+		}
+		#endif
+		// no reserved huge pages available: use transparent huge pages if possible
+		if(memory == MAP_FAILED)
+		{
+			memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if(memory == MAP_FAILED)
+				return 0;
+			#ifdef MADV_HUGEPAGE
+			if(useHugePages)
+				madvise(memory, size, MADV_HUGEPAGE);
+			#endif
+		}
+		return static_cast<char*>(memory);
+	#else
+		return static_cast<char*>(std::malloc(size));
+	#endif
+	}
+
+	void FreeRegion(char *memory, size_t size)
+	{
+	#if defined(_WIN32)
+		VirtualFree(memory, 0, MEM_RELEASE);
+	#elif defined(__unix__) || defined(__APPLE__)
+		munmap(memory, size);
+	#else
+		std::free(memory);
+	#endif
+	}
+
+	//! Returns a free slot of the memory region or NULL if the region is exhausted.
+	void *AllocateSlot(size_t slotSize)
+	{
+		std::lock_guard<std::mutex> lock(regionMutex);
+		std::map<size_t, void*>::iterator iter = freeSlots.find(slotSize);
+		void *slot = 0;
+		if(iter != freeSlots.end() && iter->second)
+		{
+			slot = iter->second;
+			iter->second = *static_cast<void**>(slot);
+		}
+		else if(regionOffset + slotSize <= regionSize)
+		{
+			slot = region + regionOffset;
+			regionOffset += slotSize;
+		}
+
+		if(slot)
+			usedBytes += slotSize;
+		return slot;
+	}
+
+	void FreePage(Page *page)
+	{
+		if(page->isHeap)
+		{
+			std::free(page);
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(regionMutex);
+		void *&freeList = freeSlots[page->slotSize];
+		*reinterpret_cast<void**>(page) = freeList;
+		freeList = page;
+		usedBytes -= page->slotSize;
+	}
+
+	void RemoveFromLru(Shard &shard, Page *page)
+	{
+		if(page->lruPrev)
+			page->lruPrev->lruNext = page->lruNext;
+		else if(shard.lruHead == page)
+			shard.lruHead = page->lruNext;
+		else
+			return;
+
+		if(page->lruNext)
+			page->lruNext->lruPrev = page->lruPrev;
+		else
+			shard.lruTail = page->lruPrev;
+
+		page->lruPrev = page->lruNext = 0;
+	}
+
+	void AddToLru(Shard &shard, Page *page)
+	{
+		page->lruPrev = 0;
+		page->lruNext = shard.lruHead;
+		if(shard.lruHead)
+			shard.lruHead->lruPrev = page;
+		else
+			shard.lruTail = page;
+		shard.lruHead = page;
+	}
+
+	//! Inserts a page into the page table of the shard; the shard must be locked.
+	void InsertPage(Shard &shard, unsigned int shardIndex, Page *page)
+	{
+		Cache *cache = page->cache;
+		page->cachePrev = 0;
+		page->cacheNext = cache->shardPages[shardIndex];
+		if(page->cacheNext)
+			page->cacheNext->cachePrev = page;
+		cache->shardPages[shardIndex] = page;
+
+		PageKey pageKey = {cache, page->key};
+		shard.pageTable[pageKey] = page;
+		++cache->pageCount;
+		++shard.pages;
+		if(page->isHeap)
+			++shard.heapPages;
+	}
+
+	//! Removes a page from the shard without freeing it; the shard must be locked.
+	void RemovePage(Shard &shard, unsigned int shardIndex, Page *page)
+	{
+		Cache *cache = page->cache;
+		if(page->cachePrev)
+			page->cachePrev->cacheNext = page->cacheNext;
+		else
+			cache->shardPages[shardIndex] = page->cacheNext;
+		if(page->cacheNext)
+			page->cacheNext->cachePrev = page->cachePrev;
+
+		RemoveFromLru(shard, page);
+
+		PageKey pageKey = {cache, page->key};
+		shard.pageTable.erase(pageKey);
+		--cache->pageCount;
+		--shard.pages;
+		if(page->isHeap)
+			--shard.heapPages;
+	}
+
+	//! Takes the least recently used pages of a shard away from their caches until a page\n
+	//! with the requested slot size is found; the shard must be locked.
+	Page *RecyclePage(Shard &shard, unsigned int shardIndex, size_t slotSize)
+	{
+		for(int i = 0; i < MAX_RECYCLE_ATTEMPTS && shard.lruTail; ++i)
+		{
+			Page *victim = shard.lruTail;
+			RemovePage(shard, shardIndex, victim);
+			++shard.recycledPages;
+
+			if(victim->slotSize == slotSize)
+				return victim;
+
+			// a page of a connection with another page size; maybe its slot is large enough for a new slot
+			FreePage(victim);
+			void *slot = AllocateSlot(slotSize);
+			if(slot)
+			{
+				Page *page = static_cast<Page*>(slot);
+				page->isHeap = false;
+				return page;
+			}
+		}
+		return 0;
+	}
+}
+
+void SQLitePageCache::Install(size_t capacity, unsigned int shardCount, bool useHugePages)
+{
+	if(!isDefaultMethodsSaved)
+	{
+		if(sqlite3_config(SQLITE_CONFIG_GETPCACHE2, &defaultMethods) != SQLITE_OK)
+			KOMPEX_EXCEPT("Install() the page cache can only be installed before SQLite is initialized or after sqlite3_shutdown()");
+		isDefaultMethodsSaved = true;
+	}
+
+	sqlite3_pcache_methods2 methods;
+	std::memset(&methods, 0, sizeof(methods));
+	methods.iVersion = 1;
+	methods.xInit = &SQLitePageCache::Init;
+	methods.xShutdown = &SQLitePageCache::Shutdown;
+	methods.xCreate = &SQLitePageCache::Create;
+	methods.xCachesize = &SQLitePageCache::Cachesize;
+	methods.xPagecount = &SQLitePageCache::Pagecount;
+	methods.xFetch = &SQLitePageCache::Fetch;
+	methods.xUnpin = &SQLitePageCache::Unpin;
+	methods.xRekey = &SQLitePageCache::Rekey;
+	methods.xTruncate = &SQLitePageCache::Truncate;
+	methods.xDestroy = &SQLitePageCache::Destroy;
+	methods.xShrink = &SQLitePageCache::Shrink;
+
+	if(sqlite3_config(SQLITE_CONFIG_PCACHE2, &methods) != SQLITE_OK)
+		KOMPEX_EXCEPT("Install() the page cache can only be installed before SQLite is initialized or after sqlite3_shutdown()");
+
+	configuredCapacity = capacity;
+	configuredShardCount = shardCount > 0 ? shardCount : 1;
+	isHugePagesRequested = useHugePages;
+	isInstalled = true;
+}
+
+void SQLitePageCache::Uninstall()
+{
+	if(!isInstalled)
+		return;
+
+	if(sqlite3_config(SQLITE_CONFIG_PCACHE2, &defaultMethods) != SQLITE_OK)
+		KOMPEX_EXCEPT("Uninstall() the page cache can only be uninstalled before SQLite is initialized or after sqlite3_shutdown()");
+
+	isInstalled = false;
+}
+
+bool SQLitePageCache::IsInstalled()
+{
+	return isInstalled;
+}
+
+SQLitePageCacheStatistics SQLitePageCache::GetStatistics()
+{
+	SQLitePageCacheStatistics statistics;
+	std::memset(&statistics, 0, sizeof(statistics));
+
+	for(std::vector<std::unique_ptr<Shard> >::iterator iter = shards.begin(); iter != shards.end(); ++iter)
+	{
+		Shard &shard = **iter;
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		statistics.fetches += shard.fetches;
+		statistics.hits += shard.hits;
+		statistics.createdPages += shard.createdPages;
+		statistics.recycledPages += shard.recycledPages;
+		statistics.refusedFetches += shard.refusedFetches;
+		statistics.lockAcquisitions += shard.lockAcquisitions;
+		statistics.lockContentions += shard.lockContentions;
+		statistics.pages += shard.pages;
+		statistics.heapPages += shard.heapPages;
+	}
+
+	std::lock_guard<std::mutex> lock(regionMutex);
+	statistics.capacity = regionSize;
+	statistics.usedBytes = usedBytes;
+	statistics.isHugePagesActive = isHugePagesActive;
+	return statistics;
+}
+
+void SQLitePageCache::ResetStatistics()
+{
+	for(std::vector<std::unique_ptr<Shard> >::iterator iter = shards.begin(); iter != shards.end(); ++iter)
+	{
+		Shard &shard = **iter;
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		shard.fetches = shard.hits = shard.createdPages = shard.recycledPages = shard.refusedFetches = 0;
+		shard.lockAcquisitions = shard.lockContentions = 0;
+	}
+}
+
+int SQLitePageCache::Init(void *)
+{
+	// without a memory region all pages are allocated from the heap
+	regionSize = configuredCapacity;
+	if(regionSize > 0)
+	{
+		region = AllocateRegion(regionSize, isHugePagesRequested, isHugePagesActive);
+		if(!region)
+		{
+			regionSize = 0;
+			return SQLITE_NOMEM;
+		}
+	}
+
+	regionOffset = 0;
+	usedBytes = 0;
+	freeSlots.clear();
+
+	shards.clear();
+	for(unsigned int i = 0; i < configuredShardCount; ++i)
+		shards.push_back(std::unique_ptr<Shard>(new Shard()));
+
+	return SQLITE_OK;
+}
+
+void SQLitePageCache::Shutdown(void *)
+{
+	// all caches were destroyed by SQLite
+	shards.clear();
+	freeSlots.clear();
+
+	if(region)
+		FreeRegion(region, regionSize);
+	region = 0;
+	regionSize = 0;
+	regionOffset = 0;
+	usedBytes = 0;
+}
+
+sqlite3_pcache *SQLitePageCache::Create(int pageSize, int extraSize, int isPurgeable)
+{
+	Cache *cache = new(std::nothrow) Cache;
+	if(!cache)
+		return 0;
+
+	cache->pageSize = static_cast<size_t>(pageSize);
+	cache->extraSize = static_cast<size_t>(extraSize);
+	cache->slotSize = (PAGE_HEADER_SIZE + cache->pageSize + cache->extraSize + 7) & ~static_cast<size_t>(7);
+	cache->isPurgeable = isPurgeable != 0;
+	cache->pageCount = 0;
+	cache->shardPages.assign(shards.size(), 0);
+	return reinterpret_cast<sqlite3_pcache*>(cache);
+}
+
+void SQLitePageCache::Cachesize(sqlite3_pcache *, int)
+{
+	// the capacity is shared by all connections
+}
+
+int SQLitePageCache::Pagecount(sqlite3_pcache *cache)
+{
+	return static_cast<int>(reinterpret_cast<Cache*>(cache)->pageCount.load());
+}
+
+sqlite3_pcache_page *SQLitePageCache::Fetch(sqlite3_pcache *pcache, unsigned int key, int createFlag)
+{
+	Cache *cache = reinterpret_cast<Cache*>(pcache);
+	unsigned int shardIndex = GetShardIndex(key);
+	Shard &shard = *shards[shardIndex];
+
+	Page *page = 0;
+	{
+		std::unique_lock<std::mutex> lock = LockShard(shard);
+		++shard.fetches;
+
+		PageKey pageKey = {cache, key};
+		std::unordered_map<PageKey, Page*, PageKeyHash>::iterator iter = shard.pageTable.find(pageKey);
+		if(iter != shard.pageTable.end())
+		{
+			page = iter->second;
+			RemoveFromLru(shard, page);
+			page->isPinned = true;
+			++shard.hits;
+			return &page->base;
+		}
+
+		if(createFlag == 0)
+			return 0;
+
+		// pages of memory databases can't be recycled, they are not counted against the capacity
+		if(cache->isPurgeable)
+		{
+			void *slot = AllocateSlot(cache->slotSize);
+			if(slot)
+			{
+				page = static_cast<Page*>(slot);
+				page->isHeap = false;
+			}
+			else
+			{
+				page = RecyclePage(shard, shardIndex, cache->slotSize);
+			}
+		}
+	}
+
+	// the shard lock is released, so that the other shards can be searched without a lock order
+	if(!page && cache->isPurgeable)
+	{
+		for(unsigned int i = 1; i < shards.size() && !page; ++i)
+		{
+			unsigned int otherIndex = (shardIndex + i) % static_cast<unsigned int>(shards.size());
+			Shard &otherShard = *shards[otherIndex];
+			std::unique_lock<std::mutex> lock = LockShard(otherShard);
+			page = RecyclePage(otherShard, otherIndex, cache->slotSize);
+		}
+
+		// no shard has an unpinned page: SQLite writes dirty pages and asks again with createFlag 2
+		if(!page && createFlag == 1)
+		{
+			std::unique_lock<std::mutex> lock = LockShard(shard);
+			++shard.refusedFetches;
+			return 0;
+		}
+	}
+
+	if(!page)
+	{
+		page = static_cast<Page*>(std::malloc(cache->slotSize));
+		if(!page)
+			return 0;
+		page->isHeap = true;
+	}
+
+	char *memory = reinterpret_cast<char*>(page);
+	page->base.pBuf = memory + PAGE_HEADER_SIZE;
+	page->base.pExtra = memory + PAGE_HEADER_SIZE + cache->pageSize;
+	// SQLite expects zeroed extra memory for new pages
+	std::memset(page->base.pExtra, 0, cache->extraSize);
+	page->cache = cache;
+	page->key = key;
+	page->slotSize = cache->slotSize;
+	page->lruPrev = page->lruNext = 0;
+	page->isPinned = true;
+
+	// the connection is serialized by SQLite, so no other thread can insert the same page in the meantime
+	std::unique_lock<std::mutex> lock = LockShard(shard);
+	InsertPage(shard, shardIndex, page);
+	++shard.createdPages;
+	return &page->base;
+}
+
+void SQLitePageCache::Unpin(sqlite3_pcache *pcache, sqlite3_pcache_page *pcachePage, int discard)
+{
+	Cache *cache = reinterpret_cast<Cache*>(pcache);
+	Page *page = reinterpret_cast<Page*>(pcachePage);
+	unsigned int shardIndex = GetShardIndex(page->key);
+	Shard &shard = *shards[shardIndex];
+
+	std::unique_lock<std::mutex> lock = LockShard(shard);
+	page->isPinned = false;
+	if(discard)
+	{
+		RemovePage(shard, shardIndex, page);
+		lock.unlock();
+		FreePage(page);
+	}
+	else if(cache->isPurgeable)
+	{
+		AddToLru(shard, page);
+	}
+}
+
+void SQLitePageCache::Rekey(sqlite3_pcache *pcache, sqlite3_pcache_page *pcachePage, unsigned int oldKey, unsigned int newKey)
+{
+	Cache *cache = reinterpret_cast<Cache*>(pcache);
+	Page *page = reinterpret_cast<Page*>(pcachePage);
+
+	unsigned int oldIndex = GetShardIndex(oldKey);
+	{
+		std::unique_lock<std::mutex> lock = LockShard(*shards[oldIndex]);
+		RemovePage(*shards[oldIndex], oldIndex, page);
+	}
+
+	unsigned int newIndex = GetShardIndex(newKey);
+	Shard &shard = *shards[newIndex];
+	Page *replacedPage = 0;
+	{
+		std::unique_lock<std::mutex> lock = LockShard(shard);
+
+		// an existing page with the new key is discarded
+		PageKey pageKey = {cache, newKey};
+		std::unordered_map<PageKey, Page*, PageKeyHash>::iterator iter = shard.pageTable.find(pageKey);
+		if(iter != shard.pageTable.end())
+		{
+			replacedPage = iter->second;
+			RemovePage(shard, newIndex, replacedPage);
+		}
+
+		page->key = newKey;
+		InsertPage(shard, newIndex, page);
+		if(!page->isPinned && cache->isPurgeable)
+			AddToLru(shard, page);
+	}
+
+	if(replacedPage)
+		FreePage(replacedPage);
+}
+
+void SQLitePageCache::Truncate(sqlite3_pcache *pcache, unsigned int limit)
+{
+	Cache *cache = reinterpret_cast<Cache*>(pcache);
+	std::vector<Page*> removedPages;
+
+	for(unsigned int i = 0; i < shards.size(); ++i)
+	{
+		Shard &shard = *shards[i];
+		std::unique_lock<std::mutex> lock = LockShard(shard);
+		Page *page = cache->shardPages[i];
+		while(page)
+		{
+			Page *next = page->cacheNext;
+			if(page->key >= limit)
+			{
+				RemovePage(shard, i, page);
+				removedPages.push_back(page);
+			}
+			page = next;
+		}
+	}
+
+	for(std::vector<Page*>::iterator iter = removedPages.begin(); iter != removedPages.end(); ++iter)
+		FreePage(*iter);
+}
+
+void SQLitePageCache::Destroy(sqlite3_pcache *pcache)
+{
+	Truncate(pcache, 0);
+	delete reinterpret_cast<Cache*>(pcache);
+}
+
+void SQLitePageCache::Shrink(sqlite3_pcache *pcache)
+{
+	Cache *cache = reinterpret_cast<Cache*>(pcache);
+	std::vector<Page*> removedPages;
+
+	for(unsigned int i = 0; i < shards.size(); ++i)
+	{
+		Shard &shard = *shards[i];
+		std::unique_lock<std::mutex> lock = LockShard(shard);
+		Page *page = cache->shardPages[i];
+		while(page)
+		{
+			Page *next = page->cacheNext;
+			if(!page->isPinned)
+			{
+				RemovePage(shard, i, page);
+				removedPages.push_back(page);
+			}
+			page = next;
+		}
+	}
+
+	for(std::vector<Page*>::iterator iter = removedPages.begin(); iter != removedPages.end(); ++iter)
+		FreePage(*iter);
+}
+
+}	// namespace Kompex
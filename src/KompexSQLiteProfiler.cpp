@@ -0,0 +1,406 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <set>
+
+#include "KompexSQLiteProfiler.h"
+
+namespace Kompex
+{
+
+//------------------------------------------------------------------------------------
+// ring buffer and aggregated statement
+
+struct SQLiteProfiler::RingBuffer
+{
+	//! Execution of a statement
+	struct Event
+	{
+		uint64 hash;
+		uint64 time;
+	};
+
+	RingBuffer(unsigned int size):
+		events(size),
+		mask(size - 1),
+		head(0),
+		tail(0),
+		lostEvents(0)
+	{
+	}
+
+	//! Called only by the owning thread.
+	inline void Push(uint64 hash, uint64 time)
+	{
+		uint64 currentHead = head.load(std::memory_order_relaxed);
+		if(currentHead - tail.load(std::memory_order_acquire) > mask)
+		{
+			lostEvents.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		Event &event = events[currentHead & mask];
+		event.hash = hash;
+		event.time = time;
+		head.store(currentHead + 1, std::memory_order_release);
+	}
+
+	//! Events (the size is a power of two)
+	std::vector<Event> events;
+	//! size - 1
+	uint64 mask;
+	//! Next position which is written by the owning thread
+	std::atomic<uint64> head;
+	//! Next position which is read by Collect()
+	std::atomic<uint64> tail;
+	//! Number of events which were lost because the buffer was full
+	std::atomic<uint64> lostEvents;
+	//! Hashes whose normalized text was already registered by the owning thread
+	std::set<uint64> knownHashes;
+};
+
+struct SQLiteProfiler::Statement
+{
+	//! Normalized SQL text
+	std::string sql;
+	//! Execution times
+	SQLiteLatencyHistogram histogram;
+};
+
+//------------------------------------------------------------------------------------
+// SQLiteProfiler
+
+SQLiteProfiler::SQLiteProfiler(unsigned int ringBufferSize):
+	mRingBufferSize(2)
+{
+	static std::atomic<uint64> nextId(1);
+	mId = nextId.fetch_add(1);
+
+	while(mRingBufferSize < ringBufferSize)
+		mRingBufferSize <<= 1;
+}
+
+SQLiteProfiler::~SQLiteProfiler()
+{
+}
+
+SQLiteProfiler::RingBuffer *SQLiteProfiler::GetThreadRingBuffer()
+{
+	// ring buffers of the calling thread for every profiler which was used by this thread;
+	// the ids are never reused, therefore entries of destroyed profilers are never found again
+	static thread_local std::vector<std::pair<uint64, RingBuffer*> > threadRingBuffers;
+
+	for(std::vector<std::pair<uint64, RingBuffer*> >::const_iterator iter = threadRingBuffers.begin(); iter != threadRingBuffers.end(); ++iter)
+	{
+		if(iter->first == mId)
+			return iter->second;
+	}
+
+	// first event of this thread - the buffer is owned by the profiler and outlives the thread
+	RingBuffer *ringBuffer = new RingBuffer(mRingBufferSize);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mRingBuffers.push_back(std::unique_ptr<RingBuffer>(ringBuffer));
+	}
+	threadRingBuffers.push_back(std::make_pair(mId, ringBuffer));
+	return ringBuffer;
+}
+
+void SQLiteProfiler::ProfileCallback(void *ptr, const char *sql, sqlite3_uint64 time)
+{
+	SQLiteProfiler *profiler = static_cast<SQLiteProfiler*>(ptr);
+	RingBuffer *ringBuffer = profiler->GetThreadRingBuffer();
+
+	uint64 hash = NormalizeSql(sql);
+	if(ringBuffer->knownHashes.find(hash) == ringBuffer->knownHashes.end())
+	{
+		profiler->RegisterStatement(hash, sql);
+		ringBuffer->knownHashes.insert(hash);
+	}
+
+	ringBuffer->Push(hash, time);
+}
+
+void SQLiteProfiler::RegisterStatement(uint64 hash, const char *sql)
+{
+	std::string normalizedSql;
+	NormalizeSql(sql, &normalizedSql);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStatementTexts.insert(std::make_pair(hash, normalizedSql));
+}
+
+void SQLiteProfiler::Collect()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	CollectEvents();
+}
+
+void SQLiteProfiler::CollectEvents()
+{
+	for(std::vector<std::unique_ptr<RingBuffer> >::iterator iter = mRingBuffers.begin(); iter != mRingBuffers.end(); ++iter)
+	{
+		RingBuffer &ringBuffer = **iter;
+		uint64 tail = ringBuffer.tail.load(std::memory_order_relaxed);
+		uint64 head = ringBuffer.head.load(std::memory_order_acquire);
+
+		for(; tail != head; ++tail)
+		{
+			const RingBuffer::Event &event = ringBuffer.events[tail & ringBuffer.mask];
+
+			std::unique_ptr<Statement> &statement = mStatements[event.hash];
+			if(!statement)
+			{
+				statement.reset(new Statement);
+				statement->sql = mStatementTexts[event.hash];
+			}
+			statement->histogram.Record(event.time);
+		}
+
+		ringBuffer.tail.store(tail, std::memory_order_release);
+	}
+}
+
+void SQLiteProfiler::Reset()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	// drop the buffered events as well
+	CollectEvents();
+	mStatements.clear();
+	for(std::vector<std::unique_ptr<RingBuffer> >::iterator iter = mRingBuffers.begin(); iter != mRingBuffers.end(); ++iter)
+		(*iter)->lostEvents.store(0, std::memory_order_relaxed);
+}
+
+uint64 SQLiteProfiler::GetLostEvents() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	uint64 lostEvents = 0;
+	for(std::vector<std::unique_ptr<RingBuffer> >::const_iterator iter = mRingBuffers.begin(); iter != mRingBuffers.end(); ++iter)
+		lostEvents += (*iter)->lostEvents.load(std::memory_order_relaxed);
+	return lostEvents;
+}
+
+namespace
+{
+	//! Sort predicate for the profile entries
+	struct ProfileEntryComparator
+	{
+		ProfileEntryComparator(SQLiteProfiler::SortOrder order): mOrder(order) {}
+
+		bool operator()(const SQLiteProfileEntry &left, const SQLiteProfileEntry &right) const
+		{
+			switch(mOrder)
+			{
+				case SQLiteProfiler::ORDER_BY_MEAN_TIME:
+					return left.meanTime > right.meanTime;
+				case SQLiteProfiler::ORDER_BY_P99_TIME:
+					return left.p99Time > right.p99Time;
+				case SQLiteProfiler::ORDER_BY_MAX_TIME:
+					return left.maxTime > right.maxTime;
+				case SQLiteProfiler::ORDER_BY_COUNT:
+					return left.count > right.count;
+				default:
+					return left.totalTime > right.totalTime;
+			}
+		}
+
+		SQLiteProfiler::SortOrder mOrder;
+	};
+}
+
+std::vector<SQLiteProfileEntry> SQLiteProfiler::GetTopStatements(unsigned int count, SortOrder order)
+{
+	std::vector<SQLiteProfileEntry> entries;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		CollectEvents();
+
+		entries.reserve(mStatements.size());
+		for(std::map<uint64, std::unique_ptr<Statement> >::const_iterator iter = mStatements.begin(); iter != mStatements.end(); ++iter)
+		{
+			const SQLiteLatencyHistogram &histogram = iter->second->histogram;
+
+			SQLiteProfileEntry entry;
+			entry.sql = iter->second->sql;
+			entry.count = histogram.GetCount();
+			entry.totalTime = histogram.GetTotal();
+			entry.meanTime = histogram.GetMean();
+			entry.p50Time = histogram.GetPercentile(50.0);
+			entry.p95Time = histogram.GetPercentile(95.0);
+			entry.p99Time = histogram.GetPercentile(99.0);
+			entry.maxTime = histogram.GetMax();
+			entries.push_back(entry);
+		}
+	}
+
+	std::sort(entries.begin(), entries.end(), ProfileEntryComparator(order));
+	if(count > 0 && entries.size() > count)
+		entries.resize(count);
+
+	return entries;
+}
+
+void SQLiteProfiler::Dump(std::ostream &stream, unsigned int count, SortOrder order)
+{
+	std::vector<SQLiteProfileEntry> entries = GetTopStatements(count, order);
+
+	// times in microseconds
+	stream << std::setw(10) << "count" << std::setw(14) << "total [us]" << std::setw(12) << "mean [us]"
+		<< std::setw(12) << "p50 [us]" << std::setw(12) << "p95 [us]" << std::setw(12) << "p99 [us]"
+		<< std::setw(12) << "max [us]" << "  sql\n";
+
+	for(std::vector<SQLiteProfileEntry>::const_iterator iter = entries.begin(); iter != entries.end(); ++iter)
+	{
+		stream << std::setw(10) << iter->count
+			<< std::setw(14) << iter->totalTime / 1000
+			<< std::setw(12) << static_cast<uint64>(iter->meanTime / 1000.0)
+			<< std::setw(12) << iter->p50Time / 1000
+			<< std::setw(12) << iter->p95Time / 1000
+			<< std::setw(12) << iter->p99Time / 1000
+			<< std::setw(12) << iter->maxTime / 1000
+			<< "  " << iter->sql << "\n";
+	}
+
+	uint64 lostEvents = GetLostEvents();
+	if(lostEvents > 0)
+		stream << "lost events: " << lostEvents << "\n";
+	stream.flush();
+}
+
+//------------------------------------------------------------------------------------
+// normalization
+
+//! Appends a character to the normalized text and the hash.
+static inline void AppendNormalizedChar(char c, uint64 &hash, std::string *normalizedSql)
+{
+	hash ^= static_cast<unsigned char>(c);
+	hash *= 1099511628211ULL;
+	if(normalizedSql)
+		normalizedSql->push_back(c);
+}
+
+static inline bool IsIdentifierChar(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$' || (c & 0x80);
+}
+
+uint64 SQLiteProfiler::NormalizeSql(const char *sql, std::string *normalizedSql)
+{
+	uint64 hash = 14695981039346656037ULL;
+	if(normalizedSql)
+		normalizedSql->clear();
+	if(!sql)
+		return hash;
+
+	bool isSpacePending = false;
+	bool isEmpty = true;
+	char previous = 0;
+
+	const char *p = sql;
+	while(*p)
+	{
+		char c = *p;
+
+		// whitespace and comments are collapsed into one space
+		if(c == ' ' || c == '\t' || c == '\n' || c == '\r')
+		{
+			isSpacePending = true;
+			++p;
+			continue;
+		}
+		if(c == '-' && p[1] == '-')
+		{
+			while(*p && *p != '\n')
+				++p;
+			isSpacePending = true;
+			continue;
+		}
+		if(c == '/' && p[1] == '*')
+		{
+			p += 2;
+			while(*p && !(*p == '*' && p[1] == '/'))
+				++p;
+			if(*p)
+				p += 2;
+			isSpacePending = true;
+			continue;
+		}
+
+		if(isSpacePending && !isEmpty)
+			AppendNormalizedChar(' ', hash, normalizedSql);
+		isSpacePending = false;
+		isEmpty = false;
+
+		if(c == '\'')
+		{
+			// string literal ('' is an escaped quote)
+			++p;
+			while(*p)
+			{
+				if(*p == '\'' && p[1] == '\'')
+					p += 2;
+				else if(*p == '\'')
+					break;
+				else
+					++p;
+			}
+			if(*p)
+				++p;
+			AppendNormalizedChar('?', hash, normalizedSql);
+			previous = '?';
+		}
+		else if(c == '"' || c == '`' || c == '[')
+		{
+			// quoted identifier - copied unchanged
+			char closing = (c == '[') ? ']' : c;
+			AppendNormalizedChar(c, hash, normalizedSql);
+			++p;
+			while(*p && *p != closing)
+				AppendNormalizedChar(*p++, hash, normalizedSql);
+			if(*p)
+				AppendNormalizedChar(*p++, hash, normalizedSql);
+			previous = closing;
+		}
+		else if(((c >= '0' && c <= '9') || (c == '.' && p[1] >= '0' && p[1] <= '9')) && !IsIdentifierChar(previous))
+		{
+			// numeric literal (decimal, floating point or hexadecimal)
+			++p;
+			while(IsIdentifierChar(*p) || *p == '.' || ((*p == '+' || *p == '-') && (p[-1] == 'e' || p[-1] == 'E')))
+				++p;
+			AppendNormalizedChar('?', hash, normalizedSql);
+			previous = '?';
+		}
+		else
+		{
+			if(c >= 'A' && c <= 'Z')
+				c = c - 'A' + 'a';
+			AppendNormalizedChar(c, hash, normalizedSql);
+			previous = c;
+			++p;
+		}
+	}
+
+	return hash;
+}
+
+}	// namespace Kompex
@@ -0,0 +1,104 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "KompexSQLiteSavepoint.h"
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteException.h"
+#include "KompexSQLiteInternal.h"
+
+namespace Kompex
+{
+
+SQLiteSavepoint::SQLiteSavepoint(SQLiteDatabase *db, const std::string &name):
+	mStatement(db),
+	mName(name),
+	mIsActive(false)
+{
+	if(name.empty())
+		KOMPEX_EXCEPT("SQLiteSavepoint() the savepoint name must not be empty");
+
+	std::string quotedName = Internal::QuoteIdentifier(name);
+	mSavepointSql = "SAVEPOINT " + quotedName + ";";
+	mReleaseSql = "RELEASE " + quotedName + ";";
+	mRollbackSql = "ROLLBACK TO " + quotedName + ";";
+
+	Execute(mSavepointSql);
+	mIsActive = true;
+}
+
+SQLiteSavepoint::~SQLiteSavepoint()
+{
+	if(mIsActive)
+	{
+		// a destructor must not throw; the rollback fails if SQLite has already rolled back
+		// the whole transaction (e.g. SQLITE_FULL), which reverted the savepoint as well
+		try
+		{
+			Rollback();
+		}
+		catch(SQLiteException&)
+		{
+			mIsActive = false;
+		}
+	}
+}
+
+void SQLiteSavepoint::Release()
+{
+	CheckActive();
+	Execute(mReleaseSql);
+	mIsActive = false;
+}
+
+void SQLiteSavepoint::Rollback()
+{
+	CheckActive();
+	// ROLLBACK TO keeps the savepoint on the transaction stack, so that it must be released afterwards
+	Execute(mRollbackSql);
+	mIsActive = false;
+	Execute(mReleaseSql);
+}
+
+void SQLiteSavepoint::RollbackTo()
+{
+	CheckActive();
+	Execute(mRollbackSql);
+}
+
+void SQLiteSavepoint::Execute(const std::string &sql)
+{
+	try
+	{
+		mStatement.SqlCached(sql);
+		mStatement.ExecuteAndFree();
+	}
+	catch(SQLiteException&)
+	{
+		// hand the statement back to the cache
+		mStatement.FreeQuery();
+		throw;
+	}
+}
+
+void SQLiteSavepoint::CheckActive() const
+{
+	if(!mIsActive)
+		KOMPEX_EXCEPT("SQLiteSavepoint the savepoint was already released or rolled back");
+}
+
+}	// namespace Kompex
@@ -0,0 +1,141 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+
+#include "KompexSQLiteSortKey.h"
+
+namespace Kompex
+{
+
+namespace
+{
+	bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	//! Skips the leading zeros of the digit run at position and returns the end of the run.
+	int ScanNumber(const SQLiteTextView &text, int &position)
+	{
+		while(position < text.length && text.data[position] == '0')
+			++position;
+		int end = position;
+		while(end < text.length && IsDigit(text.data[end]))
+			++end;
+		return end;
+	}
+}
+
+std::string SQLiteSortKey::NaturalOrder(const SQLiteTextView &text)
+{
+	std::string key;
+	key.reserve(text.length + 8);
+
+	int position = 0;
+	while(position < text.length)
+	{
+		if(!IsDigit(text.data[position]))
+		{
+			key += text.data[position++];
+			continue;
+		}
+
+		// a number is stored as '0', the count of its significant digits and the digits,
+		// so that a shorter number sorts before a longer one; counts >= 255 use 0xFF and 4 bytes big endian
+		int end = ScanNumber(text, position);
+		unsigned int digits = static_cast<unsigned int>(end - position);
+		key += '0';
+		if(digits < 255)
+		{
+			key += static_cast<char>(digits);
+		}
+		else
+		{
+			key += static_cast<char>(0xFF);
+			for(int shift = 24; shift >= 0; shift -= 8)
+				key += static_cast<char>((digits >> shift) & 0xFF);
+		}
+		key.append(text.data + position, digits);
+		position = end;
+	}
+	return key;
+}
+
+int SQLiteSortKey::CompareNaturalOrder(const SQLiteTextView &text1, const SQLiteTextView &text2)
+{
+	int position1 = 0, position2 = 0;
+	while(position1 < text1.length && position2 < text2.length)
+	{
+		bool isDigit1 = IsDigit(text1.data[position1]);
+		bool isDigit2 = IsDigit(text2.data[position2]);
+		if(isDigit1 && isDigit2)
+		{
+			int end1 = ScanNumber(text1, position1);
+			int end2 = ScanNumber(text2, position2);
+			int digits1 = end1 - position1, digits2 = end2 - position2;
+			if(digits1 != digits2)
+				return digits1 < digits2 ? -1 : 1;
+
+			int result = std::memcmp(text1.data + position1, text2.data + position2, digits1);
+			if(result != 0)
+				return result < 0 ? -1 : 1;
+
+			position1 = end1;
+			position2 = end2;
+			continue;
+		}
+
+		// a number compares like its '0' marker in the sort key
+		unsigned char c1 = isDigit1 ? '0' : static_cast<unsigned char>(text1.data[position1]);
+		unsigned char c2 = isDigit2 ? '0' : static_cast<unsigned char>(text2.data[position2]);
+		if(c1 != c2)
+			return c1 < c2 ? -1 : 1;
+
+		++position1;
+		++position2;
+	}
+
+	if(position1 < text1.length)
+		return 1;
+	return position2 < text2.length ? -1 : 0;
+}
+
+std::string SQLiteSortKey::Locale(const SQLiteTextView &text)
+{
+	return Locale(text, std::locale());
+}
+
+std::string SQLiteSortKey::Locale(const SQLiteTextView &text, const std::locale &locale)
+{
+	const std::collate<char> &collate = std::use_facet<std::collate<char> >(locale);
+	return collate.transform(text.data, text.data + text.length);
+}
+
+int SQLiteSortKey::CompareLocale(const SQLiteTextView &text1, const SQLiteTextView &text2)
+{
+	return CompareLocale(text1, text2, std::locale());
+}
+
+int SQLiteSortKey::CompareLocale(const SQLiteTextView &text1, const SQLiteTextView &text2, const std::locale &locale)
+{
+	const std::collate<char> &collate = std::use_facet<std::collate<char> >(locale);
+	return collate.compare(text1.data, text1.data + text1.length, text2.data, text2.data + text2.length);
+}
+
+}	// namespace Kompex
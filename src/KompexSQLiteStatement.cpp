@@ -20,6 +20,7 @@
 #include <iomanip>
 #include <exception>
 #include <sstream>
+#include <chrono>
 #include <string.h>
 
 #include "KompexSQLiteStatement.h"
@@ -29,12 +30,23 @@
 namespace Kompex
 {
 
+namespace
+{
+	// SQLite counters which are added to the statement statistics; the order matches mStatusBaseline
+	const int STATUS_COUNTERS[] = {SQLITE_STMTSTATUS_FULLSCAN_STEP, SQLITE_STMTSTATUS_SORT, SQLITE_STMTSTATUS_AUTOINDEX};
+}
+
 SQLiteStatement::SQLiteStatement(SQLiteDatabase *db):
 	mDatabase(db),
 	mStatement(0),
-	mTransactionID(0),
-	mIsColumnNumberAssignedToColumnName(false)
+	mIsStatementCached(false),
+	mIsColumnLookupChecked(false),
+	mSteps(0),
+	mRowsStepped(0),
+	mStepTime(0)
 {
+	for(int i = 0; i < STATUS_COUNTER_COUNT; ++i)
+		mStatusBaseline[i] = 0;
 }
 
 SQLiteStatement::~SQLiteStatement()
@@ -45,7 +57,8 @@ SQLiteStatement::~SQLiteStatement()
 
 void SQLiteStatement::Prepare(const char *sqlStatement)
 {
-	mIsColumnNumberAssignedToColumnName = false;
+	mColumnLookup.Clear();
+	mIsStatementCached = false;
 	CheckDatabase();
 
 	// If the nByte argument is less than zero, 
@@ -60,7 +73,8 @@ void SQLiteStatement::Prepare(const char *sqlStatement)
 
 void SQLiteStatement::Prepare(const wchar_t *sqlStatement)
 {
-	mIsColumnNumberAssignedToColumnName = false;
+	mColumnLookup.Clear();
+	mIsStatementCached = false;
 	CheckDatabase();
 
 	// If the nByte argument is less than zero, 
@@ -73,9 +87,19 @@ void SQLiteStatement::Prepare(const wchar_t *sqlStatement)
 		KOMPEX_EXCEPT("Prepare() SQL statement failed");
 }
 
+void SQLiteStatement::PrepareCached(const char *sqlStatement)
+{
+	mIsStatementCached = false;
+	CheckDatabase();
+
+	// the column lookup table of a cached statement is reused as well
+	mStatement = mDatabase->GetStatementCache().Acquire(mDatabase->GetDatabaseHandle(), sqlStatement, mColumnLookup);
+	mIsStatementCached = true;
+}
+
 bool SQLiteStatement::Step() const
 {
-	switch(sqlite3_step(mStatement))
+	switch(StepStatement())
 	{
 		// sqlite3_step() has finished executing
 		case SQLITE_DONE:
@@ -104,7 +128,7 @@ void SQLiteStatement::SqlStatement(const wchar_t *sqlStatement)
 
 bool SQLiteStatement::FetchRow() const
 {
-	int rc = sqlite3_step(mStatement);
+	int rc = StepStatement();
 
 	switch(rc)
 	{
@@ -126,11 +150,92 @@ bool SQLiteStatement::FetchRow() const
 	return false;
 }
 
+int SQLiteStatement::StepStatement() const
+{
+	// the first step of an execution may recompile the statement after a schema change
+	if(!sqlite3_stmt_busy(mStatement))
+		mIsColumnLookupChecked = false;
+
+	if(!mDatabase->GetStatementStatistics().IsEnabled())
+		return sqlite3_step(mStatement);
+
+	// the SQLite counters are never reset by the statistics, they are measured against their values at the first step
+	if(mSteps == 0)
+	{
+		for(int i = 0; i < STATUS_COUNTER_COUNT; ++i)
+			mStatusBaseline[i] = sqlite3_stmt_status(mStatement, STATUS_COUNTERS[i], 0);
+	}
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	int rc = sqlite3_step(mStatement);
+	mStepTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+	++mSteps;
+	if(rc == SQLITE_ROW)
+		++mRowsStepped;
+
+	return rc;
+}
+
+SQLiteStatus SQLiteStatement::GetStatus(int resultCode) const
+{
+	sqlite3 *databaseHandle = mDatabase->GetDatabaseHandle();
+	if(resultCode == SQLITE_OK || resultCode == SQLITE_ROW || resultCode == SQLITE_DONE)
+		return SQLiteStatus(resultCode, databaseHandle);
+
+	// the extended result code belongs to the failed call only if the primary result codes match
+	// (e.g. SQLITE_MISUSE for an empty statement pointer isn't stored in the connection)
+	int extendedResultCode = sqlite3_extended_errcode(databaseHandle);
+	return SQLiteStatus((extendedResultCode & 0xff) == resultCode ? extendedResultCode : resultCode, databaseHandle);
+}
+
+void SQLiteStatement::RecordStatementStatistics() const
+{
+	if(mStatement && mSteps > 0 && mDatabase->GetStatementStatistics().IsEnabled())
+	{
+		int counters[STATUS_COUNTER_COUNT];
+		for(int i = 0; i < STATUS_COUNTER_COUNT; ++i)
+			counters[i] = static_cast<int>(sqlite3_stmt_status(mStatement, STATUS_COUNTERS[i], 0) - mStatusBaseline[i]);
+
+		mDatabase->GetStatementStatistics().Record(sqlite3_sql(mStatement), mSteps, mRowsStepped,
+			counters[0], counters[1], counters[2], mStepTime);
+	}
+
+	mSteps = 0;
+	mRowsStepped = 0;
+	mStepTime = 0;
+}
+
+int SQLiteStatement::GetStatementStatus(int counter, bool reset) const
+{
+	CheckStatement();
+	int value = sqlite3_stmt_status(mStatement, counter, reset ? 1 : 0);
+
+	// a reset during a measured execution moves the baseline, so that the statistics keep the counted value
+	if(reset && mSteps > 0)
+	{
+		for(int i = 0; i < STATUS_COUNTER_COUNT; ++i)
+		{
+			if(STATUS_COUNTERS[i] == counter)
+				mStatusBaseline[i] -= value;
+		}
+	}
+	return value;
+}
+
 void SQLiteStatement::FreeQuery()
 {
-	// destroy prepared statement
-	sqlite3_finalize(mStatement);
+	RecordStatementStatistics();
+
+	// destroy prepared statement or hand it back to the statement cache
+	if(mIsStatementCached)
+		mDatabase->GetStatementCache().Release(mStatement, mColumnLookup);
+	else
+		sqlite3_finalize(mStatement);
+
 	mStatement = 0;
+	mIsStatementCached = false;
+	mIsColumnLookupChecked = false;
 }
 
 void SQLiteStatement::CheckStatement() const
@@ -149,7 +254,7 @@ float SQLiteStatement::SqlAggregateFuncResult(const std::string &countSql)
 {
 	float result;
 
-	Sql(countSql);
+	PrepareCached(countSql);
 	while(FetchRow())
 		result = static_cast<float>(GetColumnDouble(0));
 	
@@ -161,7 +266,7 @@ float SQLiteStatement::SqlAggregateFuncResult(wchar_t *countSql)
 {
 	float result;
 
-	Sql(countSql);
+	PrepareCached(countSql);
 	while(FetchRow())
 		result = static_cast<float>(GetColumnDouble(0));
 	
@@ -173,7 +278,7 @@ float SQLiteStatement::SqlAggregateFuncResult(const char *countSql)
 {
 	float result;
 
-	Sql(countSql);
+	PrepareCached(countSql);
 	while(FetchRow())
 		result = static_cast<float>(GetColumnDouble(0));
 	
@@ -219,9 +324,24 @@ std::string SQLiteStatement::GetColumnString(int column) const
 	if(result == 0)
 		return "";
 
-	std::stringstream ss;
-	ss << result;
-	return ss.str();
+	return std::string(reinterpret_cast<const char*>(result), sqlite3_column_bytes(mStatement, column));
+}
+
+SQLiteTextView SQLiteStatement::GetColumnTextView(int column) const
+{
+	CheckStatement();
+	CheckColumnNumber(column, "GetColumnTextView()");
+
+	return ColumnTextView(column);
+}
+
+void SQLiteStatement::AppendColumnString(int column, std::string &buffer) const
+{
+	CheckStatement();
+	CheckColumnNumber(column, "AppendColumnString()");
+
+	SQLiteTextView text = ColumnTextView(column);
+	buffer.append(text.data, text.length);
 }
 
 double SQLiteStatement::GetColumnDouble(int column) const
@@ -280,6 +400,24 @@ const void *SQLiteStatement::GetColumnBlob(int column) const
 	return sqlite3_column_blob(mStatement, column);
 }
 
+SQLiteBlobView SQLiteStatement::GetColumnBlobView(int column) const
+{
+	CheckStatement();
+	CheckColumnNumber(column, "GetColumnBlobView()");
+
+	return ColumnBlobView(column);
+}
+
+void SQLiteStatement::AppendColumnBlob(int column, std::vector<unsigned char> &buffer) const
+{
+	CheckStatement();
+	CheckColumnNumber(column, "AppendColumnBlob()");
+
+	SQLiteBlobView blob = ColumnBlobView(column);
+	const unsigned char *data = static_cast<const unsigned char*>(blob.data);
+	buffer.insert(buffer.end(), data, data + blob.bytes);
+}
+
 int SQLiteStatement::GetColumnCount() const
 {
 	CheckStatement();
@@ -448,15 +586,28 @@ std::string SQLiteStatement::GetColumnString(const std::string &column) const
 {
 	AssignColumnNumberToColumnName();
 
-	const unsigned char *result = sqlite3_column_text(mStatement, GetAssignedColumnNumber(column));
+	int columnNumber = GetAssignedColumnNumber(column);
+	const unsigned char *result = sqlite3_column_text(mStatement, columnNumber);
 
 	// capture NULL results
 	if(result == 0)
 		return "";
 
-	std::stringstream ss;
-	ss << result;
-	return ss.str();
+	return std::string(reinterpret_cast<const char*>(result), sqlite3_column_bytes(mStatement, columnNumber));
+}
+
+SQLiteTextView SQLiteStatement::GetColumnTextView(const std::string &column) const
+{
+	AssignColumnNumberToColumnName();
+	return ColumnTextView(GetAssignedColumnNumber(column));
+}
+
+void SQLiteStatement::AppendColumnString(const std::string &column, std::string &buffer) const
+{
+	AssignColumnNumberToColumnName();
+
+	SQLiteTextView text = ColumnTextView(GetAssignedColumnNumber(column));
+	buffer.append(text.data, text.length);
 }
 
 double SQLiteStatement::GetColumnDouble(const std::string &column) const
@@ -501,6 +652,21 @@ const void *SQLiteStatement::GetColumnBlob(const std::string &column) const
 	return sqlite3_column_blob(mStatement, GetAssignedColumnNumber(column));
 }
 
+SQLiteBlobView SQLiteStatement::GetColumnBlobView(const std::string &column) const
+{
+	AssignColumnNumberToColumnName();
+	return ColumnBlobView(GetAssignedColumnNumber(column));
+}
+
+void SQLiteStatement::AppendColumnBlob(const std::string &column, std::vector<unsigned char> &buffer) const
+{
+	AssignColumnNumberToColumnName();
+
+	SQLiteBlobView blob = ColumnBlobView(GetAssignedColumnNumber(column));
+	const unsigned char *data = static_cast<const unsigned char*>(blob.data);
+	buffer.insert(buffer.end(), data, data + blob.bytes);
+}
+
 //------------------------------------------------------------------------------------
 // Bind...() Methods
 
@@ -640,65 +806,45 @@ void SQLiteStatement::ClearBindings() const
 void SQLiteStatement::Reset() const
 {
 	CheckStatement();
+	RecordStatementStatistics();
 
 	if(sqlite3_reset(mStatement) != SQLITE_OK)
 		KOMPEX_EXCEPT(sqlite3_errmsg(mDatabase->GetDatabaseHandle()));
 }
 
+SQLiteStatus SQLiteStatement::TryReset() const
+{
+	RecordStatementStatistics();
+	return GetStatus(sqlite3_reset(mStatement));
+}
+
 void SQLiteStatement::CommitTransaction() 
 {
-	if(!mTransactionSQL.empty() || !mTransactionSQL16.empty())
+	if(!mTransactionStatements.empty())
 	{
 		try
 		{
-			int i = 0;
-			// check wheter we have sql statements with different data types
-			if(!mTransactionSQL.empty() && !mTransactionSQL16.empty())
-			{
-				TTransactionSQL::iterator transIter;
-				TTransactionSQL16::iterator trans16Iter;
-
-				unsigned short transactions = mTransactionSQL.size() + mTransactionSQL16.size();
-
-				while(i < transactions)
-				{
-					transIter = mTransactionSQL.find(i);
-					if(transIter != mTransactionSQL.end())
-					{
-						SqlStatement(transIter->second.first);
-					}
-					else
-					{
-						trans16Iter = mTransactionSQL16.find(i);
-						if(trans16Iter != mTransactionSQL16.end())
-						{
-							SqlStatement(trans16Iter->second.first);
-						}					
-						else
-						{
-							KOMPEX_EXCEPT("CommitTransaction() transaction id not found");
-						}
-					}
-
-					++i;
-				}
-			}
-			else
+			// recurring statements are compiled only once thanks to the statement cache
+			for(std::vector<TransactionStatement>::const_iterator iter = mTransactionStatements.begin(); iter != mTransactionStatements.end(); ++iter)
 			{
-				// because we have only one data type, we can execute all sql statements from the filled container
-				if(!mTransactionSQL.empty())
+				switch(iter->kind)
 				{
-					for(TTransactionSQL::iterator transIter = mTransactionSQL.begin(); transIter != mTransactionSQL.end(); ++transIter)
-						SqlStatement(transIter->second.first);
-				}
-				else
-				{
-					for(TTransactionSQL16::iterator trans16Iter = mTransactionSQL16.begin(); trans16Iter != mTransactionSQL16.end(); ++trans16Iter)
-						SqlStatement(trans16Iter->second.first);
+					case TransactionStatement::REFERENCED_UTF8:
+						SqlStatementCached(iter->sql);
+						break;
+					case TransactionStatement::REFERENCED_UTF16:
+						SqlStatement(iter->sql16);
+						break;
+					case TransactionStatement::COPIED_UTF8:
+						SqlStatementCached(iter->sqlCopy.c_str());
+						break;
+					case TransactionStatement::COPIED_UTF16:
+						SqlStatement(iter->sql16Copy.c_str());
+						break;
 				}
 			}
 
-			SqlStatement("COMMIT;");
+			SqlStatementCached("COMMIT;");
 			CleanUpTransaction();
 		}
 		catch(SQLiteException &exception)
@@ -712,55 +858,53 @@ void SQLiteStatement::CommitTransaction()
 	}
 	else
 	{
-		SqlStatement("COMMIT;");
+		SqlStatementCached("COMMIT;");
 	}
-	mTransactionID = 0;
 }
 
 void SQLiteStatement::CleanUpTransaction()
 {
-	// clean up memory and container
-	for(TTransactionSQL::iterator transIter = mTransactionSQL.begin(); transIter != mTransactionSQL.end(); ++transIter)
-		DeleteTransactionSqlStr(transIter->second.second, transIter->second.first);
-	mTransactionSQL.clear();
-
-	for(TTransactionSQL16::iterator trans16Iter = mTransactionSQL16.begin(); trans16Iter != mTransactionSQL16.end(); ++trans16Iter)
-		DeleteTransactionSqlStr(trans16Iter->second.second, trans16Iter->second.first);
-	mTransactionSQL16.clear();
+	mTransactionStatements.clear();
 }
 
-void SQLiteStatement::BeginTransaction() 
+void SQLiteStatement::BeginTransaction(TransactionMode mode) 
 {
-	SqlStatement("BEGIN;");
+	// the statements are cached because transactions are started again and again
+	switch(mode)
+	{
+		case TRANSACTION_IMMEDIATE:
+			SqlStatementCached("BEGIN IMMEDIATE;");
+			break;
+		case TRANSACTION_EXCLUSIVE:
+			SqlStatementCached("BEGIN EXCLUSIVE;");
+			break;
+		default:
+			SqlStatementCached("BEGIN;");
+	}
+
 	CleanUpTransaction();
 }
 
 void SQLiteStatement::SecureTransaction(const char *sql)
 {
-	char *buffer = new char[strlen(sql) + 1];
-	strcpy(buffer, sql);
-	mTransactionSQL[mTransactionID++] = std::make_pair(buffer, true);
+	mTransactionStatements.push_back(TransactionStatement(std::string(sql)));
 }
 
 void SQLiteStatement::SecureTransaction(const std::string sql)
 {
-	char *buffer = new char[sql.length() + 1];
-	strcpy(buffer, sql.c_str());
-	mTransactionSQL[mTransactionID++] = std::make_pair(buffer, true);
+	mTransactionStatements.push_back(TransactionStatement(sql));
 }
 
 void SQLiteStatement::SecureTransaction(const wchar_t *sql) 
 {
-	wchar_t *buffer = new wchar_t[wcslen(sql) + 1];
-	wcscpy(buffer, sql);
-	mTransactionSQL16[mTransactionID++] = std::make_pair(buffer, true);
+	mTransactionStatements.push_back(TransactionStatement(std::wstring(sql)));
 }
 
 //------------------------------------------------------------------------------------
 template<class S, class T>
 T SQLiteStatement::GetColumnValue(S sql, T(Kompex::SQLiteStatement::*getColumnFunc)(int columnNumber)const, T defaultReturnValue)
 {
-	Sql(sql);
+	PrepareCached(sql);
 
 	T queryResult;
 
@@ -837,18 +981,24 @@ double SQLiteStatement::GetSqlResultDouble(const wchar_t *sql, double defaultRet
 const unsigned char *SQLiteStatement::SqlResultCString(const unsigned char *defaultReturnValue)
 {
 	const unsigned char *queryResult;
+	size_t length;
 
 	if(!FetchRow())
+	{
 		queryResult = defaultReturnValue;
+		length = queryResult ? strlen(reinterpret_cast<const char*>(queryResult)) : 0;
+	}
 	else
-		queryResult = SQLiteStatement::GetColumnCString(0);
-	
-	std::stringstream strStream;
-	strStream << queryResult;
-	std::string result = strStream.str();
+	{
+		SQLiteTextView text = GetColumnTextView(0);
+		queryResult = reinterpret_cast<const unsigned char*>(text.data);
+		length = text.length;
+	}
 
-	unsigned char *buffer = new unsigned char[result.length() + 1];
-	memcpy(buffer, result.c_str(), result.length() + 1);
+	unsigned char *buffer = new unsigned char[length + 1];
+	if(queryResult)
+		memcpy(buffer, queryResult, length);
+	buffer[length] = 0;
 
 	FreeQuery();
 
@@ -857,19 +1007,19 @@ const unsigned char *SQLiteStatement::SqlResultCString(const unsigned char *defa
 
 const unsigned char *SQLiteStatement::GetSqlResultCString(const std::string &sql, const unsigned char *defaultReturnValue) 
 {
-	Sql(sql);
+	PrepareCached(sql);
 	return SqlResultCString(defaultReturnValue);
 }
 
 const unsigned char *SQLiteStatement::GetSqlResultCString(const char *sql, const unsigned char *defaultReturnValue) 
 {
-	Sql(sql);
+	PrepareCached(sql);
 	return SqlResultCString(defaultReturnValue);
 }
 
 const unsigned char *SQLiteStatement::GetSqlResultCString(const wchar_t *sql, const unsigned char *defaultReturnValue) 
 {
-	Sql(sql);
+	PrepareCached(sql);
 	return SqlResultCString(defaultReturnValue);
 }
 
@@ -896,37 +1046,45 @@ wchar_t *SQLiteStatement::SqlResultString16(wchar_t *defaultReturnValue)
 
 wchar_t *SQLiteStatement::GetSqlResultString16(const std::string &sql, wchar_t *defaultReturnValue) 
 {
-	Sql(sql);
+	PrepareCached(sql);
 	return SqlResultString16(defaultReturnValue);
 }
 
 wchar_t *SQLiteStatement::GetSqlResultString16(const char *sql, wchar_t *defaultReturnValue) 
 {
-	Sql(sql);
+	PrepareCached(sql);
 	return SqlResultString16(defaultReturnValue);
 }
 
 wchar_t *SQLiteStatement::GetSqlResultString16(const wchar_t *sql, wchar_t *defaultReturnValue) 
 {
-	Sql(sql);
+	PrepareCached(sql);
 	return SqlResultString16(defaultReturnValue);
 }
 
 const void *SQLiteStatement::SqlResultBlob(const void *defaultReturnValue)
 {
 	const void *queryResult;
+	size_t bytes;
 
 	if(!FetchRow())
+	{
+		// the size of the default value is unknown - it is treated as zero-terminated data
 		queryResult = defaultReturnValue;
+		bytes = queryResult ? strlen(static_cast<const char*>(queryResult)) + 1 : 0;
+	}
 	else
-		queryResult = SQLiteStatement::GetColumnBlob(0);
-
-	std::stringstream strStream;
-	strStream << static_cast<const char *>(queryResult);
-	std::string result = strStream.str();
+	{
+		// the BLOB is copied completely, even if it contains zero bytes
+		SQLiteBlobView blob = GetColumnBlobView(0);
+		queryResult = blob.data;
+		bytes = blob.bytes;
+	}
 
-	char *buffer = new char[result.length() + 1];
-	memcpy(buffer, result.c_str(), result.length() + 1);
+	char *buffer = new char[bytes + 1];
+	if(queryResult)
+		memcpy(buffer, queryResult, bytes);
+	buffer[bytes] = 0;
 
 	FreeQuery();
 
@@ -935,19 +1093,19 @@ const void *SQLiteStatement::SqlResultBlob(const void *defaultReturnValue)
 
 const void *SQLiteStatement::GetSqlResultBlob(const std::string &sql, const void *defaultReturnValue) 
 {
-	Sql(sql);
+	PrepareCached(sql);
 	return SqlResultBlob(defaultReturnValue);
 }
 
 const void *SQLiteStatement::GetSqlResultBlob(const char *sql, const void *defaultReturnValue) 
 {
-	Sql(sql);
+	PrepareCached(sql);
 	return SqlResultBlob(defaultReturnValue);
 }
 
 const void *SQLiteStatement::GetSqlResultBlob(const wchar_t *sql, const void *defaultReturnValue) 
 {
-	Sql(sql);
+	PrepareCached(sql);
 	return SqlResultBlob(defaultReturnValue);
 }
 
@@ -962,35 +1120,30 @@ unsigned int SQLiteStatement::GetNumberOfRows()
 	return count;
 }
 
-void SQLiteStatement::CheckColumnNumber(int columnNumber, const std::string &functionName) const
+void SQLiteStatement::CheckColumnNumber(int columnNumber, const char *functionName) const
 {
+	// the function name is only copied into a string if the check fails
     if(columnNumber < 0 || columnNumber >= sqlite3_column_count(mStatement))
-        KOMPEX_EXCEPT(functionName + " column number does not exists");
+        KOMPEX_EXCEPT(std::string(functionName) + " column number does not exists");
 }
 
 //------------------------------------------------------------------------------------
 void SQLiteStatement::AssignColumnNumberToColumnName() const
 {
 	CheckStatement();
-	
-	// a previous executed SELECT query is necessary
-	if(!mIsColumnNumberAssignedToColumnName && sqlite3_column_count(mStatement) >= 0)
-	{
-		// delete old entries
-		mColumnNumberToColumnNameAssignment.erase(mColumnNumberToColumnNameAssignment.begin(), mColumnNumberToColumnNameAssignment.end());
-		
-		for(int i = 0; i < sqlite3_column_count(mStatement); ++i)
-			mColumnNumberToColumnNameAssignment[sqlite3_column_name(mStatement, i)] = i;
 
-		mIsColumnNumberAssignedToColumnName = true;
-    }
+	// the lookup table survives Reset() and is only rebuilt if the statement was recompiled with a different result set;
+	// a recompilation can only happen in the first sqlite3_step() of an execution, so the names are compared once per execution
+	if(!mColumnLookup.IsBuilt() || (!mIsColumnLookupChecked && !mColumnLookup.Matches(mStatement)))
+		mColumnLookup.Build(mStatement);
+	mIsColumnLookupChecked = true;
 }
 
 int SQLiteStatement::GetAssignedColumnNumber(const std::string &columnName) const
 {
-	std::map<std::string, int>::const_iterator iter = mColumnNumberToColumnNameAssignment.find(columnName);
+	int columnNumber = mColumnLookup.Find(columnName);
 
-	if(iter == mColumnNumberToColumnNameAssignment.end())
+	if(columnNumber == -1)
 	{
 		// if you don't catch the exception then we will return -1 so that the function sqlite3_column_*()
 		// will return a undefined value
@@ -998,7 +1151,13 @@ int SQLiteStatement::GetAssignedColumnNumber(const std::string &columnName) cons
 		return -1;
 	}
 
-	return iter->second;
+	return columnNumber;
+}
+
+int SQLiteStatement::GetColumnNumber(const std::string &columnName) const
+{
+	AssignColumnNumberToColumnName();
+	return GetAssignedColumnNumber(columnName);
 }
 
 std::string SQLiteStatement::Mprintf(const char *sql, ...)
@@ -0,0 +1,156 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "KompexSQLiteStatementCache.h"
+#include "KompexSQLiteException.h"
+
+namespace Kompex
+{
+
+SQLiteStatementCache::SQLiteStatementCache(unsigned int capacity):
+	mDatabaseHandle(0),
+	mCapacity(capacity),
+	mHits(0),
+	mMisses(0),
+	mEvictions(0)
+{
+}
+
+SQLiteStatementCache::~SQLiteStatementCache()
+{
+	Clear();
+}
+
+sqlite3_stmt *SQLiteStatementCache::Acquire(sqlite3 *databaseHandle, const char *sql, SQLiteColumnLookup &columnLookup)
+{
+	// the cached statements are useless if the connection has changed
+	if(databaseHandle != mDatabaseHandle)
+	{
+		Clear();
+		mDatabaseHandle = databaseHandle;
+	}
+
+	TEntryLookup::iterator lookupIter = mLookup.find(sql);
+	if(lookupIter != mLookup.end())
+	{
+		// the statement is in use now and must not be handed out twice
+		sqlite3_stmt *statement = lookupIter->second->statement;
+		columnLookup.Swap(lookupIter->second->columnLookup);
+		mAcquired[statement].swap(lookupIter->second->sql);
+		mEntries.erase(lookupIter->second);
+		mLookup.erase(lookupIter);
+		++mHits;
+		return statement;
+	}
+
+	++mMisses;
+	columnLookup.Clear();
+
+	sqlite3_stmt *statement = 0;
+	if(sqlite3_prepare_v2(databaseHandle, sql, -1, &statement, 0) != SQLITE_OK)
+	{
+		sqlite3_finalize(statement);
+		KOMPEX_EXCEPT(sqlite3_errmsg(databaseHandle));
+	}
+
+	if(!statement)
+		KOMPEX_EXCEPT("Acquire() SQL statement failed");
+
+	mAcquired[statement] = sql;
+	return statement;
+}
+
+void SQLiteStatementCache::Release(sqlite3_stmt *statement, SQLiteColumnLookup &columnLookup)
+{
+	if(!statement)
+		return;
+
+	// the statement is cached under the SQL text which was looked up by Acquire()
+	std::string sql;
+	TAcquiredLookup::iterator acquiredIter = mAcquired.find(statement);
+	if(acquiredIter != mAcquired.end())
+	{
+		sql.swap(acquiredIter->second);
+		mAcquired.erase(acquiredIter);
+	}
+	else
+	{
+		sql = sqlite3_sql(statement);
+	}
+
+	// statements of a foreign connection or a disabled cache will be destroyed
+	if(mCapacity == 0 || sqlite3_db_handle(statement) != mDatabaseHandle)
+	{
+		sqlite3_finalize(statement);
+		columnLookup.Clear();
+		return;
+	}
+
+	// the return value only repeats the error of the last sqlite3_step()
+	sqlite3_reset(statement);
+	sqlite3_clear_bindings(statement);
+
+	TEntryLookup::iterator lookupIter = mLookup.find(sql);
+	if(lookupIter != mLookup.end())
+	{
+		// the same SQL text was used by two statements at once - keep only one of them
+		sqlite3_finalize(statement);
+		columnLookup.Clear();
+		mEntries.splice(mEntries.begin(), mEntries, lookupIter->second);
+		return;
+	}
+
+	Shrink(mCapacity - 1);
+
+	mEntries.push_front(Entry());
+	Entry &entry = mEntries.front();
+	entry.sql = sql;
+	entry.statement = statement;
+	entry.columnLookup.Swap(columnLookup);
+	columnLookup.Clear();
+	mLookup[sql] = mEntries.begin();
+}
+
+void SQLiteStatementCache::Clear()
+{
+	for(TEntryList::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+		sqlite3_finalize(iter->statement);
+
+	mEntries.clear();
+	mLookup.clear();
+}
+
+void SQLiteStatementCache::SetCapacity(unsigned int capacity)
+{
+	mCapacity = capacity;
+	Shrink(mCapacity);
+}
+
+void SQLiteStatementCache::Shrink(unsigned int size)
+{
+	while(mEntries.size() > size)
+	{
+		Entry &entry = mEntries.back();
+		sqlite3_finalize(entry.statement);
+		mLookup.erase(entry.sql);
+		mEntries.pop_back();
+		++mEvictions;
+	}
+}
+
+}	// namespace Kompex
@@ -0,0 +1,101 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "KompexSQLiteStatementStatistics.h"
+
+namespace Kompex
+{
+
+SQLiteStatementStatistics::SQLiteStatementStatistics():
+	mIsEnabled(false)
+{
+}
+
+void SQLiteStatementStatistics::Record(const char *sql, uint64 steps, uint64 rows, int fullscanSteps, int sorts, int autoindexSteps, uint64 nanoseconds)
+{
+	if(!sql)
+		return;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	std::map<std::string, SQLiteStatementCounters>::iterator iter = mCounters.find(sql);
+	if(iter == mCounters.end())
+	{
+		SQLiteStatementCounters counters;
+		counters.sql = sql;
+		counters.executions = 0;
+		counters.steps = 0;
+		counters.rows = 0;
+		counters.fullscanSteps = 0;
+		counters.sorts = 0;
+		counters.autoindexSteps = 0;
+		counters.seconds = 0.0;
+		iter = mCounters.insert(std::make_pair(counters.sql, counters)).first;
+	}
+
+	SQLiteStatementCounters &counters = iter->second;
+	++counters.executions;
+	counters.steps += steps;
+	counters.rows += rows;
+	counters.fullscanSteps += fullscanSteps;
+	counters.sorts += sorts;
+	counters.autoindexSteps += autoindexSteps;
+	counters.seconds += nanoseconds / 1e9;
+}
+
+namespace
+{
+	bool IsSlower(const SQLiteStatementCounters &left, const SQLiteStatementCounters &right)
+	{
+		return left.seconds > right.seconds;
+	}
+}
+
+std::vector<SQLiteStatementCounters> SQLiteStatementStatistics::GetSnapshot(bool reset)
+{
+	std::vector<SQLiteStatementCounters> snapshot;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		snapshot.reserve(mCounters.size());
+		for(std::map<std::string, SQLiteStatementCounters>::const_iterator iter = mCounters.begin(); iter != mCounters.end(); ++iter)
+			snapshot.push_back(iter->second);
+
+		if(reset)
+			mCounters.clear();
+	}
+
+	std::sort(snapshot.begin(), snapshot.end(), IsSlower);
+	return snapshot;
+}
+
+void SQLiteStatementStatistics::Reset()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mCounters.clear();
+}
+
+size_t SQLiteStatementStatistics::GetSize() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mCounters.size();
+}
+
+}	// namespace Kompex
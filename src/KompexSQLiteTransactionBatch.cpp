@@ -0,0 +1,181 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <memory>
+
+#include "KompexSQLiteTransactionBatch.h"
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteException.h"
+#include "KompexSQLiteSavepoint.h"
+
+namespace Kompex
+{
+
+SQLiteTransactionBatch::SQLiteTransactionBatch(SQLiteDatabase *db):
+	mDatabase(db)
+{
+	if(!mDatabase)
+		KOMPEX_EXCEPT("SQLiteTransactionBatch() database pointer invalid");
+}
+
+SQLiteTransactionBatch::~SQLiteTransactionBatch()
+{
+	ReleaseStatements();
+}
+
+void SQLiteTransactionBatch::Add(const std::string &sql)
+{
+	AddEntry(GetStatementIndex(sql), mParameters.size());
+}
+
+void SQLiteTransactionBatch::Add(const std::string &sql, const std::vector<SQLiteValue> &parameters)
+{
+	unsigned int statementIndex = GetStatementIndex(sql);
+	size_t parameterOffset = mParameters.size();
+	mParameters.insert(mParameters.end(), parameters.begin(), parameters.end());
+	AddEntry(statementIndex, parameterOffset);
+}
+
+unsigned int SQLiteTransactionBatch::GetStatementIndex(const std::string &sql)
+{
+	std::map<std::string, unsigned int>::const_iterator iter = mStatementLookup.find(sql);
+	if(iter != mStatementLookup.end())
+		return iter->second;
+
+	Statement statement;
+	statement.sql = sql;
+	statement.statement = 0;
+	mStatements.push_back(statement);
+
+	unsigned int statementIndex = static_cast<unsigned int>(mStatements.size() - 1);
+	mStatementLookup[sql] = statementIndex;
+	return statementIndex;
+}
+
+void SQLiteTransactionBatch::AddEntry(unsigned int statementIndex, size_t parameterOffset)
+{
+	Entry entry;
+	entry.statementIndex = statementIndex;
+	entry.parameterOffset = parameterOffset;
+	entry.parameterCount = static_cast<unsigned int>(mParameters.size() - parameterOffset);
+	mEntries.push_back(entry);
+}
+
+void SQLiteTransactionBatch::Execute()
+{
+	if(mEntries.empty())
+		return;
+
+	sqlite3 *handle = mDatabase->GetDatabaseHandle();
+
+	// join an already running transaction of the connection; the savepoint allows to undo only the batch
+	bool isOwnTransaction = !!sqlite3_get_autocommit(handle);
+	std::unique_ptr<SQLiteSavepoint> savepoint;
+	if(isOwnTransaction)
+	{
+		if(sqlite3_exec(handle, "BEGIN", 0, 0, 0) != SQLITE_OK)
+			KOMPEX_EXCEPT(sqlite3_errmsg(handle));
+	}
+	else
+	{
+		savepoint.reset(new SQLiteSavepoint(mDatabase, "kompex_batch"));
+	}
+
+	std::string errMsg;
+	for(std::vector<Entry>::const_iterator iter = mEntries.begin(); iter != mEntries.end() && errMsg.empty(); ++iter)
+	{
+		Statement &statement = mStatements[iter->statementIndex];
+
+		// statements are compiled in execution order, so that they can use tables which were created by the batch
+		if(!statement.statement)
+		{
+			try
+			{
+				statement.statement = mDatabase->GetStatementCache().Acquire(handle, statement.sql.c_str(), statement.columnLookup);
+			}
+			catch(SQLiteException &exception)
+			{
+				errMsg = exception.GetErrorDescription();
+				break;
+			}
+		}
+
+		for(unsigned int i = 0; i < iter->parameterCount; ++i)
+		{
+			if(mParameters[iter->parameterOffset + i].Bind(statement.statement, static_cast<int>(i + 1)) != SQLITE_OK)
+			{
+				errMsg = sqlite3_errmsg(handle);
+				break;
+			}
+		}
+
+		if(errMsg.empty())
+		{
+			int rc = sqlite3_step(statement.statement);
+			if(rc != SQLITE_DONE && rc != SQLITE_ROW)
+				errMsg = sqlite3_errmsg(handle);
+		}
+
+		sqlite3_reset(statement.statement);
+		sqlite3_clear_bindings(statement.statement);
+	}
+
+	ReleaseStatements();
+	Clear();
+
+	if(!errMsg.empty())
+	{
+		// a joined transaction is rolled back to the savepoint by its destructor
+		if(isOwnTransaction)
+			sqlite3_exec(handle, "ROLLBACK", 0, 0, 0);
+		KOMPEX_EXCEPT(errMsg);
+	}
+
+	if(savepoint)
+	{
+		savepoint->Release();
+		return;
+	}
+
+	if(sqlite3_exec(handle, "COMMIT", 0, 0, 0) != SQLITE_OK)
+	{
+		errMsg = sqlite3_errmsg(handle);
+		sqlite3_exec(handle, "ROLLBACK", 0, 0, 0);
+		KOMPEX_EXCEPT(errMsg);
+	}
+}
+
+void SQLiteTransactionBatch::Clear()
+{
+	mEntries.clear();
+	mParameters.clear();
+}
+
+void SQLiteTransactionBatch::ReleaseStatements()
+{
+	for(std::vector<Statement>::iterator iter = mStatements.begin(); iter != mStatements.end(); ++iter)
+	{
+		if(iter->statement)
+		{
+			mDatabase->GetStatementCache().Release(iter->statement, iter->columnLookup);
+			iter->statement = 0;
+		}
+	}
+}
+
+}	// namespace Kompex
@@ -0,0 +1,206 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+
+#include "KompexSQLiteWalCheckpointer.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteException.h"
+
+namespace Kompex
+{
+
+SQLiteWalCheckpointer::SQLiteWalCheckpointer(SQLiteDatabase *db, int thresholdFrames, unsigned int idleTime, SQLiteDatabase::CheckpointMode idleMode, int busyTimeout):
+	mWriter(db),
+	mThresholdFrames(thresholdFrames),
+	mIdleTime(idleTime),
+	mIdleMode(idleMode),
+	mPageSize(0),
+	mPreviousAutoCheckpoint(0),
+	mIsCheckpointRequested(false),
+	mIsStopRequested(false),
+	mIsIdleCheckpointPending(false)
+{
+	if(!mWriter || !mWriter->GetDatabaseHandle())
+		KOMPEX_EXCEPT("SQLiteWalCheckpointer() database is not opened");
+
+	const char *filename = sqlite3_db_filename(mWriter->GetDatabaseHandle(), "main");
+	if(!filename || !*filename)
+		KOMPEX_EXCEPT("SQLiteWalCheckpointer() the WAL mode is not available for memory and temporary databases");
+
+	if(mWriter->GetJournalMode() != SQLiteDatabase::JOURNAL_WAL)
+		KOMPEX_EXCEPT("SQLiteWalCheckpointer() database is not in WAL mode");
+
+	mCheckpointDatabase.Open(filename, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, 0);
+	sqlite3_busy_timeout(mCheckpointDatabase.GetDatabaseHandle(), busyTimeout);
+
+	// the connection must read the database once, otherwise it does not know the WAL file and the checkpoints have no effect
+	SQLiteStatement stmt(&mCheckpointDatabase);
+	stmt.GetSqlResultInt("SELECT COUNT(*) FROM sqlite_master;");
+	mPageSize = stmt.GetSqlResultInt("PRAGMA page_size;");
+
+	// the automatic checkpoints of the writer are restored by the destructor
+	SQLiteStatement writerStmt(mWriter);
+	mPreviousAutoCheckpoint = writerStmt.GetSqlResultInt("PRAGMA wal_autocheckpoint;");
+
+	mStatistics.walFrames = 0;
+	mStatistics.walBytes = 0;
+	mStatistics.commits = 0;
+	mStatistics.passiveCheckpoints = 0;
+	mStatistics.idleCheckpoints = 0;
+	mStatistics.busyCheckpoints = 0;
+	mStatistics.checkpointedFrames = 0;
+	mStatistics.lastCheckpointSeconds = 0.0;
+	mStatistics.maxCheckpointSeconds = 0.0;
+	mStatistics.totalCheckpointSeconds = 0.0;
+	mLastCommitTime = std::chrono::steady_clock::now();
+
+	// replaces the automatic checkpoints of the writer
+	sqlite3_wal_hook(mWriter->GetDatabaseHandle(), &Kompex::SQLiteWalCheckpointer::WalHook, this);
+
+	mThread = std::thread(&SQLiteWalCheckpointer::Run, this);
+}
+
+SQLiteWalCheckpointer::~SQLiteWalCheckpointer()
+{
+	Stop();
+
+	// also removes the WAL hook
+	if(mWriter->GetDatabaseHandle())
+		sqlite3_wal_autocheckpoint(mWriter->GetDatabaseHandle(), mPreviousAutoCheckpoint);
+}
+
+void SQLiteWalCheckpointer::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsStopRequested = true;
+	}
+	mCondition.notify_one();
+
+	if(mThread.joinable())
+		mThread.join();
+}
+
+int SQLiteWalCheckpointer::WalHook(void *ptr, sqlite3 *, const char *, int walFrames)
+{
+	SQLiteWalCheckpointer *checkpointer = static_cast<SQLiteWalCheckpointer*>(ptr);
+
+	bool isNotificationNecessary = false;
+	{
+		std::lock_guard<std::mutex> lock(checkpointer->mMutex);
+		++checkpointer->mStatistics.commits;
+		checkpointer->mStatistics.walFrames = walFrames;
+		checkpointer->mLastCommitTime = std::chrono::steady_clock::now();
+		checkpointer->mIsIdleCheckpointPending = true;
+
+		if(walFrames >= checkpointer->mThresholdFrames && !checkpointer->mIsCheckpointRequested)
+		{
+			checkpointer->mIsCheckpointRequested = true;
+			isNotificationNecessary = true;
+		}
+	}
+
+	if(isNotificationNecessary)
+		checkpointer->mCondition.notify_one();
+
+	return SQLITE_OK;
+}
+
+void SQLiteWalCheckpointer::RequestCheckpoint()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsCheckpointRequested = true;
+	}
+	mCondition.notify_one();
+}
+
+void SQLiteWalCheckpointer::Run()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while(!mIsStopRequested)
+	{
+		if(!mIsCheckpointRequested)
+			mCondition.wait_for(lock, mIdleTime);
+		if(mIsStopRequested)
+			break;
+
+		SQLiteDatabase::CheckpointMode mode;
+		if(mIsCheckpointRequested)
+			mode = SQLiteDatabase::CHECKPOINT_PASSIVE;
+		else if(mIsIdleCheckpointPending && std::chrono::steady_clock::now() - mLastCommitTime >= mIdleTime)
+			mode = mIdleMode;
+		else
+			continue;
+
+		mIsCheckpointRequested = false;
+		lock.unlock();
+
+		// the writer continues committing while the checkpoint is running
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		int walFrames = 0;
+		int checkpointedFrames = 0;
+		bool isCompleted = false;
+		try
+		{
+			isCompleted = mCheckpointDatabase.WalCheckpoint(mode, &walFrames, &checkpointedFrames);
+		}
+		catch(SQLiteException &exception)
+		{
+			std::cerr << "SQLiteWalCheckpointer: checkpoint failed" << std::endl;
+			exception.Show();
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		lock.lock();
+		if(mode == SQLiteDatabase::CHECKPOINT_PASSIVE)
+			++mStatistics.passiveCheckpoints;
+		else
+			++mStatistics.idleCheckpoints;
+		if(!isCompleted)
+			++mStatistics.busyCheckpoints;
+
+		if(checkpointedFrames > 0)
+			mStatistics.checkpointedFrames += checkpointedFrames;
+		mStatistics.lastCheckpointSeconds = seconds;
+		mStatistics.totalCheckpointSeconds += seconds;
+		if(seconds > mStatistics.maxCheckpointSeconds)
+			mStatistics.maxCheckpointSeconds = seconds;
+
+		// the WAL file is restarted by the next writer, therefore nothing is left for the idle checkpoint
+		if(isCompleted && mode != SQLiteDatabase::CHECKPOINT_PASSIVE && std::chrono::steady_clock::now() - mLastCommitTime >= mIdleTime)
+		{
+			mIsIdleCheckpointPending = false;
+			if(mode == SQLiteDatabase::CHECKPOINT_TRUNCATE)
+				mStatistics.walFrames = 0;
+		}
+	}
+}
+
+SQLiteWalCheckpointerStatistics SQLiteWalCheckpointer::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	SQLiteWalCheckpointerStatistics statistics = mStatistics;
+	// WAL header (32 bytes) + frames with a header of 24 bytes each
+	statistics.walBytes = statistics.walFrames > 0 ? 32 + static_cast<int64>(statistics.walFrames) * (mPageSize + 24) : 0;
+	return statistics;
+}
+
+}	// namespace Kompex
@@ -0,0 +1,190 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "KompexSQLiteAllocator.h"
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	//! Exposes the size function of the allocator
+	class AllocatorProbe : public SQLiteAllocator
+	{
+	public:
+		using SQLiteAllocator::Size;
+	};
+
+	//! Returns true if the first bytes of the memory hold the pattern of FillPattern().
+	bool HasPattern(const void *memory, int bytes)
+	{
+		const unsigned char *data = static_cast<const unsigned char*>(memory);
+		for(int i = 0; i < bytes; ++i)
+		{
+			if(data[i] != static_cast<unsigned char>(i * 7))
+				return false;
+		}
+		return true;
+	}
+
+	void FillPattern(void *memory, int bytes)
+	{
+		unsigned char *data = static_cast<unsigned char*>(memory);
+		for(int i = 0; i < bytes; ++i)
+			data[i] = static_cast<unsigned char>(i * 7);
+	}
+
+	void TestRealloc()
+	{
+		// grows through several size classes into the large allocations and shrinks back
+		const int sizes[] = {10, 100, 1000, 5000, 8192, 9000, 20000, 3000, 50, 8};
+		int size = 10;
+		void *memory = sqlite3_malloc(size);
+		KOMPEX_CHECK(memory != 0);
+		FillPattern(memory, size);
+
+		for(size_t i = 1; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+		{
+			memory = sqlite3_realloc(memory, sizes[i]);
+			KOMPEX_CHECK(memory != 0);
+			if(!memory)
+				return;
+			KOMPEX_CHECK(AllocatorProbe::Size(memory) >= sizes[i]);
+			KOMPEX_CHECK(HasPattern(memory, size < sizes[i] ? size : sizes[i]));
+			size = sizes[i];
+			FillPattern(memory, size);
+		}
+		sqlite3_free(memory);
+	}
+
+	void TestForeignThreadFree()
+	{
+		// the blocks are allocated by one thread and freed by another one
+		std::vector<void*> blocks;
+		std::thread allocator([&blocks]()
+		{
+			for(int i = 0; i < 2000; ++i)
+			{
+				int size = 1 + (i * 37) % 10000;
+				void *memory = sqlite3_malloc(size);
+				FillPattern(memory, size);
+				blocks.push_back(memory);
+			}
+		});
+		allocator.join();
+
+		std::thread releaser([&blocks]()
+		{
+			for(size_t i = 0; i < blocks.size(); ++i)
+			{
+				int size = 1 + (static_cast<int>(i) * 37) % 10000;
+				KOMPEX_CHECK(HasPattern(blocks[i], size));
+				sqlite3_free(blocks[i]);
+			}
+		});
+		releaser.join();
+
+		// the freed blocks can be used again
+		std::thread user([]()
+		{
+			for(int i = 0; i < 2000; ++i)
+			{
+				void *memory = sqlite3_malloc(64);
+				FillPattern(memory, 64);
+				KOMPEX_CHECK(HasPattern(memory, 64));
+				sqlite3_free(memory);
+			}
+		});
+		user.join();
+	}
+
+	void TestDatabase()
+	{
+		SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		SQLiteStatement statement(&db);
+		statement.SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT)");
+		statement.SqlStatement("WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 1000) INSERT INTO t(name) SELECT replace(hex(zeroblob(x % 300)), '00', 'x') FROM c");
+		KOMPEX_CHECK(statement.GetSqlResultString("PRAGMA integrity_check;") == "ok");
+		int64 length = 0;
+		for(int x = 1; x <= 1000; ++x)
+			length += x % 300;
+		KOMPEX_CHECK(statement.GetSqlResultInt64("SELECT sum(length(name)) FROM t") == length);
+	}
+
+	void CheckBalancedStatistics()
+	{
+		// SQLite has freed all memory when it was shut down
+		std::vector<SQLiteAllocatorStatistics> statistics = SQLiteAllocator::GetStatistics();
+		uint64 allocations = 0;
+		bool isBalanced = true;
+		for(size_t i = 0; i < statistics.size(); ++i)
+		{
+			allocations += statistics[i].allocations;
+			if(statistics[i].allocations != statistics[i].frees)
+				isBalanced = false;
+		}
+		KOMPEX_CHECK(allocations > 0);
+		KOMPEX_CHECK(isBalanced);
+
+		// the pool memory and the large allocations are returned to the system
+		bool isReleased = true;
+		for(size_t i = 0; i < statistics.size(); ++i)
+		{
+			if(statistics[i].reservedBytes != 0)
+				isReleased = false;
+		}
+		KOMPEX_CHECK(isReleased);
+	}
+
+	void TestAllocator(SQLiteAllocator::AllocatorType type)
+	{
+		// the thread cache of the thread which shuts SQLite down reports its counters when the thread ends
+		std::thread thread([type]()
+		{
+			sqlite3_shutdown();
+			SQLiteAllocator::Install(type);
+			KOMPEX_CHECK(SQLiteAllocator::GetInstalledType() == type);
+			KOMPEX_CHECK(sqlite3_initialize() == SQLITE_OK);
+
+			TestRealloc();
+			TestForeignThreadFree();
+			TestDatabase();
+
+			sqlite3_shutdown();
+		});
+		thread.join();
+
+		CheckBalancedStatistics();
+	}
+}
+
+int main()
+{
+	TestAllocator(SQLiteAllocator::ALLOCATOR_POOL);
+	TestAllocator(SQLiteAllocator::ALLOCATOR_THREAD_CACHING);
+
+	SQLiteAllocator::Install(SQLiteAllocator::ALLOCATOR_SYSTEM);
+	KOMPEX_CHECK(SQLiteAllocator::GetInstalledType() == SQLiteAllocator::ALLOCATOR_SYSTEM);
+
+	return Test::Finish("KompexSQLiteAllocatorTest");
+}
@@ -0,0 +1,167 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteAsyncExecutor.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	// runs long enough to be interrupted
+	const char *longQuery = "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) SELECT count(*) FROM c";
+
+	//! Waits for the result and returns the error message or an empty string.
+	template<class T>
+	std::string GetError(SQLiteAsyncResult<T> &result)
+	{
+		try
+		{
+			result.Get();
+		}
+		catch(SQLiteException &exception)
+		{
+			return exception.GetErrorDescription();
+		}
+		return "";
+	}
+
+	bool Contains(const std::string &text, const char *part)
+	{
+		return text.find(part) != std::string::npos;
+	}
+
+	void TestRowCopies(SQLiteAsyncExecutor &executor)
+	{
+		std::vector<SQLiteValue> parameters;
+		parameters.push_back(SQLiteValue(42));
+		parameters.push_back(SQLiteValue(std::string("text")));
+		parameters.push_back(SQLiteValue(SQLiteBlobView("\0\1", 2)));
+		parameters.push_back(SQLiteValue());
+		parameters.push_back(SQLiteValue(0.5));
+
+		SQLiteAsyncResult<std::vector<SQLiteAsyncExecutor::Row> > result = executor.Query("SELECT ?, ?, ?, ?, ?", parameters);
+		std::vector<SQLiteAsyncExecutor::Row> rows = result.Get();
+		KOMPEX_CHECK(rows.size() == 1);
+		KOMPEX_CHECK(rows[0].size() == 5);
+		KOMPEX_CHECK(rows[0][0].GetInt64() == 42);
+		KOMPEX_CHECK(rows[0][1].GetType() == SQLITE_TEXT && rows[0][1].GetData() == "text");
+		KOMPEX_CHECK(rows[0][2].GetType() == SQLITE_BLOB && rows[0][2].GetData() == std::string("\0\1", 2));
+		KOMPEX_CHECK(rows[0][3].IsNull());
+		KOMPEX_CHECK(rows[0][4].GetDouble() == 0.5);
+
+		SQLiteAsyncResult<int> changes = executor.Execute("INSERT INTO t(value) VALUES(1), (2), (3)");
+		KOMPEX_CHECK(changes.Get() == 3);
+		KOMPEX_CHECK(executor.Query("SELECT value FROM t ORDER BY value").Get().size() == 3);
+	}
+
+	void TestErrors(SQLiteAsyncExecutor &executor)
+	{
+		SQLiteAsyncResult<std::vector<SQLiteAsyncExecutor::Row> > result = executor.Query("SELECT * FROM missing");
+		KOMPEX_CHECK(Contains(GetError(result), "no such table"));
+
+		SQLiteAsyncResult<int> failed = executor.Submit([](SQLiteDatabase &) -> int {KOMPEX_EXCEPT("task failed");});
+		KOMPEX_CHECK(GetError(failed) == "task failed");
+
+		// the executor keeps working after an error
+		KOMPEX_CHECK(executor.Query("SELECT 1").Get().size() == 1);
+	}
+
+	void TestDeadline(SQLiteAsyncExecutor &executor)
+	{
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		SQLiteAsyncResult<std::vector<SQLiteAsyncExecutor::Row> > result = executor.Query(longQuery, std::vector<SQLiteValue>(), 50);
+		KOMPEX_CHECK(Contains(GetError(result), "deadline"));
+		KOMPEX_CHECK(std::chrono::steady_clock::now() - startTime < std::chrono::seconds(5));
+	}
+
+	void TestCancel(SQLiteAsyncExecutor &executor)
+	{
+		// the first task blocks the worker thread, so that the query stays queued
+		std::promise<void> release;
+		std::shared_future<void> released = release.get_future().share();
+		SQLiteAsyncResult<void> blocker = executor.Submit([released](SQLiteDatabase &) {released.wait();});
+		SQLiteAsyncResult<std::vector<SQLiteAsyncExecutor::Row> > queued = executor.Query("SELECT 1");
+		SQLiteAsyncResult<std::vector<SQLiteAsyncExecutor::Row> > other = executor.Query("SELECT 2");
+		KOMPEX_CHECK(executor.GetQueueSize() >= 2);
+		queued.Cancel();
+		release.set_value();
+
+		KOMPEX_CHECK(GetError(blocker).empty());
+		KOMPEX_CHECK(Contains(GetError(queued), "cancelled"));
+		KOMPEX_CHECK(other.Get()[0][0].GetInt64() == 2);
+
+		// a running query is interrupted
+		SQLiteAsyncResult<std::vector<SQLiteAsyncExecutor::Row> > running = executor.Query(longQuery);
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		running.Cancel();
+		KOMPEX_CHECK(Contains(GetError(running), "cancelled"));
+	}
+
+	void TestStopWithQueuedTasks(SQLiteDatabase &db)
+	{
+		std::unique_ptr<SQLiteAsyncExecutor> executor(new SQLiteAsyncExecutor(&db));
+
+		std::promise<void> release;
+		std::shared_future<void> released = release.get_future().share();
+		std::shared_ptr<std::promise<void> > start = std::make_shared<std::promise<void> >();
+		std::future<void> started = start->get_future();
+		SQLiteAsyncResult<void> blocker = executor->Submit([released, start](SQLiteDatabase &) {start->set_value(); released.wait();});
+		started.wait();
+		std::vector<SQLiteAsyncResult<std::vector<SQLiteAsyncExecutor::Row> > > queued;
+		for(int i = 0; i < 3; ++i)
+			queued.push_back(executor->Query("SELECT 1"));
+
+		// the destructor waits for the running task and fails all queued tasks
+		std::thread releaser([&release]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			release.set_value();
+		});
+		executor.reset();
+		releaser.join();
+
+		KOMPEX_CHECK(GetError(blocker).empty());
+		for(size_t i = 0; i < queued.size(); ++i)
+			KOMPEX_CHECK(Contains(GetError(queued[i]), "stopped"));
+	}
+}
+
+int main()
+{
+	SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+	SQLiteStatement(&db).SqlStatement("CREATE TABLE t(value INTEGER)");
+	{
+		SQLiteAsyncExecutor executor(&db, 100);
+		TestRowCopies(executor);
+		TestErrors(executor);
+		TestDeadline(executor);
+		TestCancel(executor);
+	}
+	TestStopWithQueuedTasks(db);
+
+	return Test::Finish("KompexSQLiteAsyncExecutorTest");
+}
@@ -0,0 +1,162 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <vector>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteBulkInserter.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	std::vector<std::string> GetColumns()
+	{
+		std::vector<std::string> columns;
+		columns.push_back("id");
+		columns.push_back("name");
+		return columns;
+	}
+
+	int64 CountRows(SQLiteDatabase &db)
+	{
+		SQLiteStatement statement(&db);
+		return statement.GetSqlResultInt64("SELECT count(*) FROM t");
+	}
+
+	void TestMultiRowInsert()
+	{
+		SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		SQLiteStatement(&db).SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT)");
+
+		// 2 columns fill 500 rows per statement (limited by SQLITE_MAX_COMPOUND_SELECT or the number of variables)
+		SQLiteBulkInserter inserter(&db, "t", GetColumns(), 1000);
+		unsigned int rowsPerStatement = inserter.GetRowsPerStatement();
+		KOMPEX_CHECK(rowsPerStatement > 1);
+
+		unsigned int rowCount = 2 * 1000 + rowsPerStatement / 2;
+		for(unsigned int i = 0; i < rowCount; ++i)
+			inserter.InsertRow(i, "name");
+
+		// the commits happen after complete statements, i.e. after at least 1000 rows
+		KOMPEX_CHECK(inserter.GetCommitCount() == 2000 / ((1000 + rowsPerStatement - 1) / rowsPerStatement * rowsPerStatement));
+		inserter.Finish();
+		KOMPEX_CHECK(inserter.GetInsertedRows() == rowCount);
+		KOMPEX_CHECK(CountRows(db) == rowCount);
+
+		SQLiteStatement statement(&db);
+		KOMPEX_CHECK(statement.GetSqlResultInt64("SELECT sum(id) FROM t") == static_cast<int64>(rowCount) * (rowCount - 1) / 2);
+	}
+
+	void TestCommitByBytes()
+	{
+		SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		SQLiteStatement(&db).SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT)");
+
+		// every row has 8 + 50 bytes, i.e. the transaction is committed after every second row
+		SQLiteBulkInserter inserter(&db, "t", GetColumns(), 10000, 100, false);
+		KOMPEX_CHECK(inserter.GetRowsPerStatement() == 1);
+		for(int i = 0; i < 10; ++i)
+			inserter.InsertRow(i, std::string(50, 'x'));
+		KOMPEX_CHECK(inserter.GetCommitCount() == 5);
+
+		inserter.InsertRow(10, std::string(50, 'x'));
+		inserter.Finish();
+		KOMPEX_CHECK(inserter.GetCommitCount() == 6);
+		KOMPEX_CHECK(CountRows(db) == 11);
+	}
+
+	void TestFailedStatement()
+	{
+		SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		SQLiteStatement(&db).SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT)");
+
+		SQLiteBulkInserter inserter(&db, "t", GetColumns());
+		unsigned int rowsPerStatement = inserter.GetRowsPerStatement();
+
+		// a duplicate key in the second statement rolls back the transaction of the inserter
+		bool isThrown = false;
+		try
+		{
+			for(unsigned int i = 0; i < 2 * rowsPerStatement; ++i)
+				inserter.InsertRow(i == rowsPerStatement + 200 ? 0 : i, "name");
+		}
+		catch(SQLiteException &exception)
+		{
+			isThrown = true;
+			KOMPEX_CHECK(exception.GetString().find("UNIQUE") != std::string::npos);
+		}
+		KOMPEX_CHECK(isThrown);
+		KOMPEX_CHECK(inserter.GetInsertedRows() == 0);
+		KOMPEX_CHECK(CountRows(db) == 0);
+
+		// the inserter can be used again
+		for(unsigned int i = 0; i < rowsPerStatement + 10; ++i)
+			inserter.InsertRow(10000 + i, "name");
+		inserter.Finish();
+		KOMPEX_CHECK(inserter.GetInsertedRows() == rowsPerStatement + 10);
+		KOMPEX_CHECK(CountRows(db) == rowsPerStatement + 10);
+	}
+
+	void TestFailedFlush()
+	{
+		SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		SQLiteStatement statement(&db);
+		statement.SqlStatement("CREATE TABLE t(id INTEGER CHECK(id >= 0), name TEXT)");
+
+		// inside of a transaction of the caller the rows before the failed one stay and aren't written twice
+		statement.BeginTransaction();
+		{
+			SQLiteBulkInserter inserter(&db, "t", GetColumns());
+			inserter.InsertRow(1, "a");
+			inserter.InsertRow(-1, "b");
+			inserter.InsertRow(3, "c");
+			KOMPEX_CHECK_THROWS(inserter.Flush());
+			KOMPEX_CHECK(inserter.GetInsertedRows() == 1);
+
+			inserter.InsertRow(4, "d");
+			inserter.Finish();
+			KOMPEX_CHECK(inserter.GetInsertedRows() == 2);
+			KOMPEX_CHECK(inserter.GetCommitCount() == 0);
+		}
+		statement.CommitTransaction();
+		KOMPEX_CHECK(statement.GetSqlResultString("SELECT group_concat(id) FROM t") == "1,4");
+
+		// the transaction of the inserter is rolled back completely
+		statement.SqlStatement("DELETE FROM t");
+		SQLiteBulkInserter inserter(&db, "t", GetColumns());
+		inserter.InsertRow(1, "a");
+		inserter.InsertRow(-1, "b");
+		KOMPEX_CHECK_THROWS(inserter.Finish());
+		KOMPEX_CHECK(inserter.GetInsertedRows() == 0);
+		inserter.Finish();
+		KOMPEX_CHECK(CountRows(db) == 0);
+	}
+}
+
+int main()
+{
+	TestMultiRowInsert();
+	TestCommitByBytes();
+	TestFailedStatement();
+	TestFailedFlush();
+
+	return Test::Finish("KompexSQLiteBulkInserterTest");
+}
@@ -0,0 +1,143 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sstream>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteColumnLookup.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	sqlite3_stmt *Prepare(SQLiteDatabase &db, const std::string &sql)
+	{
+		sqlite3_stmt *statement = 0;
+		sqlite3_prepare_v2(db.GetDatabaseHandle(), sql.c_str(), -1, &statement, 0);
+		return statement;
+	}
+
+	void TestFind(SQLiteDatabase &db)
+	{
+		// more columns than the initial table size, so that the table grows and probes
+		std::ostringstream sql;
+		sql << "SELECT 0 AS c0";
+		for(int i = 1; i < 100; ++i)
+			sql << ", " << i << " AS c" << i;
+
+		sqlite3_stmt *statement = Prepare(db, sql.str());
+		SQLiteColumnLookup lookup;
+		KOMPEX_CHECK(!lookup.IsBuilt());
+		KOMPEX_CHECK(lookup.Find("c0") == -1);
+
+		lookup.Build(statement);
+		KOMPEX_CHECK(lookup.IsBuilt());
+		KOMPEX_CHECK(lookup.GetColumnCount() == 100);
+
+		bool isEveryColumnFound = true;
+		for(int i = 0; i < 100; ++i)
+		{
+			std::ostringstream name;
+			name << "c" << i;
+			isEveryColumnFound = isEveryColumnFound && lookup.Find(name.str()) == i;
+		}
+		KOMPEX_CHECK(isEveryColumnFound);
+		KOMPEX_CHECK(lookup.Find("c100") == -1);
+		KOMPEX_CHECK(lookup.Find("C1") == -1);
+		KOMPEX_CHECK(lookup.Find("") == -1);
+		KOMPEX_CHECK(lookup.Find("c1", 1) == -1);
+
+		lookup.Clear();
+		KOMPEX_CHECK(!lookup.IsBuilt());
+		KOMPEX_CHECK(lookup.Find("c1") == -1);
+		sqlite3_finalize(statement);
+	}
+
+	void TestDuplicateNames(SQLiteDatabase &db)
+	{
+		sqlite3_stmt *statement = Prepare(db, "SELECT 1 AS a, 2 AS b, 3 AS a, 4 AS \"\"");
+		SQLiteColumnLookup lookup;
+		lookup.Build(statement);
+		KOMPEX_CHECK(lookup.Find("a") == 2);
+		KOMPEX_CHECK(lookup.Find("b") == 1);
+		KOMPEX_CHECK(lookup.Find("") == 3);
+		KOMPEX_CHECK(lookup.Matches(statement));
+		sqlite3_finalize(statement);
+	}
+
+	void TestSwapAndMatches(SQLiteDatabase &db)
+	{
+		sqlite3_stmt *statement1 = Prepare(db, "SELECT 1 AS a, 2 AS b");
+		sqlite3_stmt *statement2 = Prepare(db, "SELECT 1 AS b, 2 AS a");
+		sqlite3_stmt *statement3 = Prepare(db, "SELECT 1 AS a");
+
+		SQLiteColumnLookup lookup1, lookup2;
+		KOMPEX_CHECK(!lookup1.Matches(statement1));
+		lookup1.Build(statement1);
+		KOMPEX_CHECK(lookup1.Matches(statement1));
+		KOMPEX_CHECK(!lookup1.Matches(statement2));
+		KOMPEX_CHECK(!lookup1.Matches(statement3));
+
+		lookup1.Swap(lookup2);
+		KOMPEX_CHECK(!lookup1.IsBuilt());
+		KOMPEX_CHECK(lookup2.Find("b") == 1);
+		KOMPEX_CHECK(lookup2.Matches(statement1));
+
+		sqlite3_finalize(statement1);
+		sqlite3_finalize(statement2);
+		sqlite3_finalize(statement3);
+	}
+
+	void TestSchemaChange(SQLiteDatabase &db)
+	{
+		SQLiteStatement statement(&db);
+		statement.SqlStatement("CREATE TABLE t(a INTEGER, b INTEGER)");
+		statement.SqlStatement("INSERT INTO t VALUES(1, 2)");
+
+		statement.SqlCached("SELECT * FROM t");
+		KOMPEX_CHECK(statement.FetchRow());
+		KOMPEX_CHECK(statement.GetColumnInt("b") == 2);
+		statement.FreeQuery();
+
+		// same column count, but the columns are swapped; the cached statement is recompiled by sqlite3_step()
+		statement.SqlStatement("DROP TABLE t");
+		statement.SqlStatement("CREATE TABLE t(b INTEGER, a INTEGER)");
+		statement.SqlStatement("INSERT INTO t VALUES(3, 4)");
+
+		statement.SqlCached("SELECT * FROM t");
+		KOMPEX_CHECK(statement.FetchRow());
+		KOMPEX_CHECK(statement.GetColumnInt("b") == 3);
+		KOMPEX_CHECK(statement.GetColumnInt("a") == 4);
+		KOMPEX_CHECK(statement.GetColumnNumber("a") == 1);
+		statement.FreeQuery();
+	}
+}
+
+int main()
+{
+	SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+
+	TestFind(db);
+	TestDuplicateNames(db);
+	TestSwapAndMatches(db);
+	TestSchemaChange(db);
+
+	return Test::Finish("KompexSQLiteColumnLookupTest");
+}
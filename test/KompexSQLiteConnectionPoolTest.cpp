@@ -0,0 +1,184 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteConnectionPool.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	const char *filename = "KompexSQLiteConnectionPoolTest.db";
+
+	void RemoveDatabaseFiles()
+	{
+		std::remove(filename);
+		std::remove((std::string(filename) + "-wal").c_str());
+		std::remove((std::string(filename) + "-shm").c_str());
+	}
+
+	void TestLeases(SQLiteConnectionPool &pool)
+	{
+		SQLiteConnectionPool::Lease lease = pool.AcquireReader();
+		KOMPEX_CHECK(lease.IsValid());
+		KOMPEX_CHECK(!lease.IsWriter());
+		KOMPEX_CHECK(pool.GetStatistics().readersInUse == 1);
+
+		// moving transfers the connection
+		SQLiteConnectionPool::Lease moved(std::move(lease));
+		KOMPEX_CHECK(!lease.IsValid());
+		KOMPEX_CHECK(moved.IsValid());
+		KOMPEX_CHECK(pool.GetStatistics().readersInUse == 1);
+
+		// the move assignment gives back the connection of the target
+		SQLiteConnectionPool::Lease writer = pool.AcquireWriter();
+		KOMPEX_CHECK(writer.IsWriter());
+		KOMPEX_CHECK(SQLiteStatement(writer.Get()).GetSqlResultInt("PRAGMA busy_timeout;") == 1000);
+		writer = std::move(moved);
+		KOMPEX_CHECK(!writer.IsWriter());
+		KOMPEX_CHECK(!pool.GetStatistics().isWriterInUse);
+
+		writer.Release();
+		KOMPEX_CHECK(!writer.IsValid());
+		KOMPEX_CHECK(pool.GetStatistics().readersInUse == 0);
+	}
+
+	void TestBlockingAcquire(SQLiteConnectionPool &pool)
+	{
+		std::vector<SQLiteConnectionPool::Lease> leases;
+		for(unsigned int i = 0; i < pool.GetReaderCount(); ++i)
+			leases.push_back(pool.AcquireReader());
+
+		// all connections are leased
+		SQLiteConnectionPool::Lease lease;
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		KOMPEX_CHECK(!pool.TryAcquireReader(lease, 30));
+		KOMPEX_CHECK(std::chrono::steady_clock::now() - startTime >= std::chrono::milliseconds(30));
+		KOMPEX_CHECK(!lease.IsValid());
+
+		SQLiteConnectionPool::Lease writer = pool.AcquireWriter();
+		KOMPEX_CHECK(!pool.TryAcquireWriter(lease, 10));
+		writer.Release();
+		KOMPEX_CHECK(pool.TryAcquireWriter(lease, 10));
+		lease.Release();
+
+		// a blocked thread gets the connection as soon as it is given back
+		uint64 waits = pool.GetStatistics().readerWaits;
+		std::atomic<bool> isAcquired(false);
+		std::thread thread([&]()
+		{
+			SQLiteConnectionPool::Lease reader = pool.AcquireReader();
+			isAcquired = reader.IsValid();
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(30));
+		KOMPEX_CHECK(!isAcquired);
+		leases.pop_back();
+		thread.join();
+		KOMPEX_CHECK(isAcquired);
+		KOMPEX_CHECK(pool.GetStatistics().readerWaits == waits + 1);
+	}
+
+	void TestWriterExclusivity(SQLiteConnectionPool &pool)
+	{
+		std::atomic<int> writersInside(0);
+		std::atomic<bool> isOverlapping(false);
+		std::vector<std::thread> threads;
+		for(int t = 0; t < 4; ++t)
+		{
+			threads.push_back(std::thread([&]()
+			{
+				for(int i = 0; i < 50; ++i)
+				{
+					SQLiteConnectionPool::Lease writer = pool.AcquireWriter();
+					if(++writersInside != 1)
+						isOverlapping = true;
+					SQLiteStatement statement(writer.Get());
+					statement.SqlStatement("INSERT INTO t(value) VALUES(1)");
+					--writersInside;
+				}
+			}));
+		}
+		for(size_t t = 0; t < threads.size(); ++t)
+			threads[t].join();
+
+		KOMPEX_CHECK(!isOverlapping);
+		SQLiteConnectionPool::Lease reader = pool.AcquireReader();
+		KOMPEX_CHECK(SQLiteStatement(reader.Get()).GetSqlResultInt("SELECT count(*) FROM t") == 200);
+	}
+
+	void TestConnectionReset(SQLiteConnectionPool &pool)
+	{
+		// a transaction which was left open is rolled back
+		{
+			SQLiteConnectionPool::Lease writer = pool.AcquireWriter();
+			SQLiteStatement statement(writer.Get());
+			statement.BeginTransaction();
+			statement.SqlStatement("INSERT INTO t(value) VALUES(2)");
+		}
+		{
+			SQLiteConnectionPool::Lease writer = pool.AcquireWriter();
+			KOMPEX_CHECK(sqlite3_get_autocommit(writer->GetDatabaseHandle()) != 0);
+			KOMPEX_CHECK(SQLiteStatement(writer.Get()).GetSqlResultInt("SELECT count(*) FROM t WHERE value = 2") == 0);
+		}
+
+		// a statement which wasn't reset doesn't keep its snapshot
+		std::vector<SQLiteConnectionPool::Lease> leases;
+		for(unsigned int i = 1; i < pool.GetReaderCount(); ++i)
+			leases.push_back(pool.AcquireReader());
+
+		sqlite3_stmt *statement = 0;
+		{
+			SQLiteConnectionPool::Lease reader = pool.AcquireReader();
+			KOMPEX_CHECK(sqlite3_prepare_v2(reader->GetDatabaseHandle(), "SELECT value FROM t", -1, &statement, 0) == SQLITE_OK);
+			KOMPEX_CHECK(sqlite3_step(statement) == SQLITE_ROW);
+		}
+		KOMPEX_CHECK(!sqlite3_stmt_busy(statement));
+
+		SQLiteStatement(pool.AcquireWriter().Get()).SqlStatement("INSERT INTO t(value) VALUES(3)");
+		{
+			SQLiteConnectionPool::Lease reader = pool.AcquireReader();
+			KOMPEX_CHECK(SQLiteStatement(reader.Get()).GetSqlResultInt("SELECT count(*) FROM t WHERE value = 3") == 1);
+		}
+		sqlite3_finalize(statement);
+	}
+}
+
+int main()
+{
+	RemoveDatabaseFiles();
+	{
+		SQLiteConnectionPool pool(filename, 2, 1000);
+		SQLiteStatement(pool.AcquireWriter().Get()).SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY, value INTEGER)");
+
+		TestLeases(pool);
+		TestBlockingAcquire(pool);
+		TestWriterExclusivity(pool);
+		TestConnectionReset(pool);
+	}
+	RemoveDatabaseFiles();
+
+	return Test::Finish("KompexSQLiteConnectionPoolTest");
+}
@@ -0,0 +1,97 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cstdio>
+#include <string>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteCountingVfs.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	const char *filename = "KompexSQLiteCountingVfsTest.db";
+	const int64 mmapSize = 16 * 1024 * 1024;
+
+	void CreateDatabase()
+	{
+		std::remove(filename);
+		SQLiteCountingVfs::ResetStatistics();
+
+		SQLiteDatabase db(filename, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, SQLiteCountingVfs::GetName());
+		SQLiteStatement statement(&db);
+		statement.SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY, payload BLOB)");
+		statement.SqlStatement("WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 500) INSERT INTO t(payload) SELECT zeroblob(1000) FROM c");
+
+		SQLiteIoStatistics statistics = SQLiteCountingVfs::GetStatistics();
+		KOMPEX_CHECK(statistics.writes > 0);
+		KOMPEX_CHECK(statistics.writeBytes >= 500 * 1000);
+	}
+
+	//! Reads the whole table with a new connection and returns the counters of the scan.
+	SQLiteIoStatistics ScanTable(int64 mmapBytes)
+	{
+		SQLiteDatabase db(filename, SQLITE_OPEN_READONLY, SQLiteCountingVfs::GetName());
+		db.SetMmapSize(mmapBytes);
+		KOMPEX_CHECK(db.GetMmapSize() == mmapBytes);
+
+		SQLiteCountingVfs::ResetStatistics();
+		SQLiteStatement statement(&db);
+		KOMPEX_CHECK(statement.GetSqlResultInt64("SELECT sum(length(payload)) FROM t") == 500 * 1000);
+		return SQLiteCountingVfs::GetStatistics();
+	}
+
+	void TestReadWithoutMmap()
+	{
+		SQLiteIoStatistics statistics = ScanTable(0);
+		KOMPEX_CHECK(statistics.reads > 100);
+		KOMPEX_CHECK(statistics.readBytes >= 500 * 1000);
+		KOMPEX_CHECK(statistics.mmapFetches == 0);
+		KOMPEX_CHECK(statistics.GetMmapRatio() == 0.0);
+	}
+
+	void TestReadWithMmap()
+	{
+		SQLiteIoStatistics statistics = ScanTable(mmapSize);
+		KOMPEX_CHECK(statistics.mmapFetches > 100);
+		KOMPEX_CHECK(statistics.mmapFetchBytes >= 500 * 1000);
+		KOMPEX_CHECK(statistics.mmapFetches > statistics.reads);
+		KOMPEX_CHECK(statistics.GetMmapRatio() > 0.9);
+		KOMPEX_CHECK(statistics.writes == 0);
+	}
+}
+
+int main()
+{
+	SQLiteCountingVfs::Register();
+	// further calls are ignored
+	SQLiteCountingVfs::Register();
+	KOMPEX_CHECK(sqlite3_vfs_find(SQLiteCountingVfs::GetName()) != 0);
+
+	CreateDatabase();
+	TestReadWithoutMmap();
+	TestReadWithMmap();
+
+	SQLiteCountingVfs::Unregister();
+	KOMPEX_CHECK(sqlite3_vfs_find(SQLiteCountingVfs::GetName()) == 0);
+	std::remove(filename);
+
+	return Test::Finish("KompexSQLiteCountingVfsTest");
+}
@@ -0,0 +1,64 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteDatabaseStatistics.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	void RunQueries(SQLiteDatabase &db)
+	{
+		SQLiteStatement statement(&db);
+		for(int i = 0; i < 100; ++i)
+			statement.GetSqlResultInt("SELECT count(*) FROM t WHERE id > 10");
+	}
+
+	void TestDeltaAfterReset()
+	{
+		SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		// some distributions build SQLite without default lookaside memory
+		db.SetLookaside(256, 100);
+		SQLiteStatement statement(&db);
+		statement.SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT)");
+		RunQueries(db);
+
+		// resetting the highwater marks must not reset the counters
+		SQLiteDatabaseStatistics earlier = db.GetStatistics(true);
+		RunQueries(db);
+		SQLiteDatabaseStatistics delta = db.GetStatistics(true).Delta(earlier);
+
+		KOMPEX_CHECK(delta.lookasideHits >= 0);
+		KOMPEX_CHECK(delta.lookasideMissSize >= 0);
+		KOMPEX_CHECK(delta.lookasideMissFull >= 0);
+		KOMPEX_CHECK(delta.cacheHits >= 0);
+		KOMPEX_CHECK(delta.cacheMisses >= 0);
+	}
+}
+
+int main()
+{
+	TestDeltaAfterReset();
+
+	return Test::Finish("KompexSQLiteDatabaseStatisticsTest");
+}
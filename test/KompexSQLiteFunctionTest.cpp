@@ -0,0 +1,78 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstddef>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	struct Sum
+	{
+		Sum(): sum(0) {}
+		void Step(unsigned long value) {sum += value;}
+		unsigned long Final() {return sum;}
+		unsigned long sum;
+	};
+
+	void TestArgumentTypes()
+	{
+		SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		db.CreateFunction("twice_long", [](long value) {return value * 2;});
+		db.CreateFunction("twice_unsigned", [](unsigned int value) {return value * 2;});
+		db.CreateFunction("twice_size", [](size_t value) {return value * 2;});
+		db.CreateFunction("twice_short", [](short value) {return static_cast<short>(value * 2);});
+		db.CreateFunction("half_float", [](float value) {return value / 2;});
+		db.CreateFunction("half_long_double", [](long double value) {return value / 2;});
+		db.CreateAggregateFunction("sum_unsigned_long", Sum());
+
+		SQLiteStatement statement(&db);
+		KOMPEX_CHECK(statement.GetSqlResultInt64("SELECT twice_long(3000000000)") == 6000000000LL);
+		KOMPEX_CHECK(statement.GetSqlResultInt64("SELECT twice_unsigned(21)") == 42);
+		KOMPEX_CHECK(statement.GetSqlResultInt64("SELECT twice_size(21)") == 42);
+		KOMPEX_CHECK(statement.GetSqlResultInt64("SELECT twice_short(-21)") == -42);
+		KOMPEX_CHECK(statement.GetSqlResultDouble("SELECT half_float(5)") == 2.5);
+		KOMPEX_CHECK(statement.GetSqlResultDouble("SELECT half_long_double(5)") == 2.5);
+		KOMPEX_CHECK(statement.GetSqlResultInt64("SELECT sum_unsigned_long(value) FROM (SELECT 1 AS value UNION ALL SELECT 2)") == 3);
+	}
+
+	void TestDeterministicDefault()
+	{
+		SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		db.CreateFunction("counter", []() {static int64 counter = 0; return ++counter;});
+		db.CreateFunction("pure_counter", []() {static int64 counter = 0; return ++counter;}, true);
+
+		// functions which aren't deterministic can't be used in an index expression
+		SQLiteStatement statement(&db);
+		statement.SqlStatement("CREATE TABLE t(value INTEGER)");
+		KOMPEX_CHECK_THROWS(SQLiteStatement(&db).SqlStatement("CREATE INDEX t_counter ON t(counter())"));
+		statement.SqlStatement("CREATE INDEX t_pure_counter ON t(pure_counter())");
+	}
+}
+
+int main()
+{
+	TestArgumentTypes();
+	TestDeterministicDefault();
+
+	return Test::Finish("KompexSQLiteFunctionTest");
+}
@@ -0,0 +1,105 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <future>
+#include <vector>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteGroupCommitWriter.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	const char *filename = "KompexSQLiteGroupCommitWriterTest.db";
+
+	void RemoveDatabaseFiles()
+	{
+		std::remove(filename);
+		std::remove((std::string(filename) + "-journal").c_str());
+	}
+
+	void TestFailingRequest()
+	{
+		SQLiteDatabase db(filename, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		{
+			SQLiteStatement statement(&db);
+			statement.SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT)");
+		}
+
+		SQLiteGroupCommitStatistics statistics;
+		{
+			// the delay collects all requests in one batch
+			SQLiteGroupCommitWriter writer(&db, 512, 100000);
+			std::vector<std::future<void> > results;
+			for(int i = 0; i < 10; ++i)
+				results.push_back(writer.SubmitStatement("INSERT INTO t VALUES(?, ?)", i, "row"));
+			// duplicate key - fails only its own request
+			results.push_back(writer.SubmitStatement("INSERT INTO t VALUES(?, ?)", 5, "duplicate"));
+
+			for(size_t i = 0; i < results.size() - 1; ++i)
+				results[i].get();
+			KOMPEX_CHECK_THROWS(results.back().get());
+
+			statistics = writer.GetStatistics();
+		}
+
+		KOMPEX_CHECK(statistics.requests == 11);
+		KOMPEX_CHECK(statistics.failedRequests == 1);
+		KOMPEX_CHECK(statistics.failedBatches == 0);
+		// one COMMIT duration per committed batch
+		KOMPEX_CHECK(statistics.commitLatencies.GetCount() == statistics.batches);
+
+		SQLiteStatement statement(&db);
+		KOMPEX_CHECK(statement.GetSqlResultInt("SELECT count(*) FROM t") == 10);
+	}
+
+	void TestFailingBatch()
+	{
+		// BEGIN IMMEDIATE of the writer fails, because another connection holds the write lock
+		SQLiteDatabase lockingDb(filename, SQLITE_OPEN_READWRITE, 0);
+		SQLiteStatement statement(&lockingDb);
+		statement.BeginTransaction(SQLiteStatement::TRANSACTION_IMMEDIATE);
+
+		SQLiteDatabase db(filename, SQLITE_OPEN_READWRITE, 0);
+		SQLiteGroupCommitStatistics statistics;
+		{
+			SQLiteGroupCommitWriter writer(&db);
+			std::future<void> result = writer.Submit("INSERT INTO t VALUES(100, 'row')");
+			KOMPEX_CHECK_THROWS(result.get());
+			statistics = writer.GetStatistics();
+		}
+		statement.RollbackTransaction();
+
+		KOMPEX_CHECK(statistics.failedBatches == 1);
+		KOMPEX_CHECK(statistics.commitLatencies.GetCount() == 0);
+	}
+}
+
+int main()
+{
+	RemoveDatabaseFiles();
+	TestFailingRequest();
+	TestFailingBatch();
+	RemoveDatabaseFiles();
+
+	return Test::Finish("KompexSQLiteGroupCommitWriterTest");
+}
@@ -0,0 +1,158 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLitePageCache.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	const size_t capacity = 64 * 1024;
+	const unsigned int shardCount = 4;
+
+	//! Gives the test access to the page cache methods.
+	struct PageCacheProbe: public SQLitePageCache
+	{
+		using SQLitePageCache::Create;
+		using SQLitePageCache::Fetch;
+		using SQLitePageCache::Unpin;
+		using SQLitePageCache::Destroy;
+	};
+
+	std::string GetFilename(int index)
+	{
+		std::ostringstream filename;
+		filename << "KompexSQLitePageCacheTest" << index << ".db";
+		return filename.str();
+	}
+
+	void TestRecycleFromOtherShard()
+	{
+		SQLitePageCache::ResetStatistics();
+		sqlite3_pcache *cache = PageCacheProbe::Create(1024, 16, 1);
+
+		// fill the memory region with pinned pages of shard 1
+		std::vector<sqlite3_pcache_page*> pages;
+		for(unsigned int key = 1; ; key += shardCount)
+		{
+			sqlite3_pcache_page *page = PageCacheProbe::Fetch(cache, key, 1);
+			if(!page)
+				break;
+			pages.push_back(page);
+		}
+		KOMPEX_CHECK(!pages.empty());
+		KOMPEX_CHECK(SQLitePageCache::GetStatistics().refusedFetches == 1);
+
+		// shard 0 has no page of its own, but the unpinned pages of shard 1 can be recycled
+		for(size_t i = 0; i < pages.size(); ++i)
+			PageCacheProbe::Unpin(cache, pages[i], 0);
+		KOMPEX_CHECK(PageCacheProbe::Fetch(cache, 0, 1) != 0);
+
+		SQLitePageCacheStatistics statistics = SQLitePageCache::GetStatistics();
+		KOMPEX_CHECK(statistics.refusedFetches == 1);
+		KOMPEX_CHECK(statistics.recycledPages == 1);
+		KOMPEX_CHECK(statistics.heapPages == 0);
+
+		PageCacheProbe::Destroy(cache);
+		statistics = SQLitePageCache::GetStatistics();
+		KOMPEX_CHECK(statistics.pages == 0);
+		KOMPEX_CHECK(statistics.usedBytes == 0);
+	}
+
+	void RunConnection(int index, int pageSize)
+	{
+		std::string filename = GetFilename(index);
+		std::remove(filename.c_str());
+		{
+			SQLiteDatabase db(filename, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+			SQLiteStatement statement(&db);
+			std::ostringstream pragma;
+			pragma << "PRAGMA page_size = " << pageSize << ";";
+			statement.SqlStatement(pragma.str());
+			statement.SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY, payload BLOB)");
+			statement.SqlStatement("CREATE INDEX t_payload ON t(payload)");
+
+			for(int batch = 0; batch < 20; ++batch)
+			{
+				statement.BeginTransaction();
+				for(int i = 0; i < 100; ++i)
+					statement.SqlStatement("INSERT INTO t(payload) VALUES(randomblob(300))");
+				statement.CommitTransaction();
+			}
+			statement.SqlStatement("UPDATE t SET payload = randomblob(500) WHERE id % 7 = 0");
+			statement.SqlStatement("DELETE FROM t WHERE id % 5 = 0");
+
+			KOMPEX_CHECK(statement.GetSqlResultString("PRAGMA integrity_check;") == "ok");
+			KOMPEX_CHECK(statement.GetSqlResultInt("SELECT count(*) FROM t") == 1600);
+		}
+		std::remove(filename.c_str());
+	}
+
+	void TestConcurrentConnections()
+	{
+		SQLitePageCache::ResetStatistics();
+
+		// the connections use different page sizes, so that slots of other sizes are recycled as well
+		const int pageSizes[] = {512, 1024, 4096, 8192};
+		std::vector<std::thread> threads;
+		for(int i = 0; i < 4; ++i)
+			threads.push_back(std::thread(&RunConnection, i, pageSizes[i]));
+		for(size_t i = 0; i < threads.size(); ++i)
+			threads[i].join();
+
+		SQLitePageCacheStatistics statistics = SQLitePageCache::GetStatistics();
+		KOMPEX_CHECK(statistics.capacity >= capacity);
+		KOMPEX_CHECK(statistics.fetches > 0);
+		KOMPEX_CHECK(statistics.hits > 0 && statistics.hits <= statistics.fetches);
+		KOMPEX_CHECK(statistics.createdPages > 0);
+		KOMPEX_CHECK(statistics.recycledPages > 0);
+		KOMPEX_CHECK(statistics.lockContentions <= statistics.lockAcquisitions);
+
+		// all connections are closed
+		KOMPEX_CHECK(statistics.pages == 0);
+		KOMPEX_CHECK(statistics.heapPages == 0);
+		KOMPEX_CHECK(statistics.usedBytes == 0);
+	}
+}
+
+int main()
+{
+	SQLitePageCache::Install(capacity, shardCount);
+	KOMPEX_CHECK(SQLitePageCache::IsInstalled());
+	KOMPEX_CHECK(sqlite3_initialize() == SQLITE_OK);
+
+	// SQLite is initialized, so the page cache can't be changed anymore
+	KOMPEX_CHECK_THROWS(SQLitePageCache::Uninstall());
+
+	TestRecycleFromOtherShard();
+	TestConcurrentConnections();
+
+	sqlite3_shutdown();
+	SQLitePageCache::Uninstall();
+	KOMPEX_CHECK(!SQLitePageCache::IsInstalled());
+
+	return Test::Finish("KompexSQLitePageCacheTest");
+}
@@ -0,0 +1,115 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KompexSQLiteProfiler.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	uint64 GetCollectedEvents(SQLiteProfiler &profiler)
+	{
+		std::vector<SQLiteProfileEntry> entries = profiler.GetTopStatements(0);
+		uint64 count = 0;
+		for(std::vector<SQLiteProfileEntry>::const_iterator iter = entries.begin(); iter != entries.end(); ++iter)
+			count += iter->count;
+		return count;
+	}
+
+	void TestNormalizeSql()
+	{
+		std::string first, second;
+		uint64 firstHash = SQLiteProfiler::NormalizeSql("SELECT name FROM user WHERE id = 1 AND name = 'a''b'", &first);
+		uint64 secondHash = SQLiteProfiler::NormalizeSql("select  name\n from USER where ID = 27 and NAME = 'x'", &second);
+		KOMPEX_CHECK(firstHash == secondHash);
+		KOMPEX_CHECK(first == second);
+		KOMPEX_CHECK(SQLiteProfiler::NormalizeSql("SELECT 1 FROM user") != SQLiteProfiler::NormalizeSql("SELECT 1 FROM users"));
+	}
+
+	void TestOverflow()
+	{
+		// the ring buffer holds 4 events, the other events are counted as lost
+		SQLiteProfiler profiler(3);
+		for(int i = 0; i < 10; ++i)
+			SQLiteProfiler::ProfileCallback(&profiler, "SELECT 1", 1000);
+		KOMPEX_CHECK(GetCollectedEvents(profiler) == 4);
+		KOMPEX_CHECK(profiler.GetLostEvents() == 6);
+
+		// the drained buffer is usable again
+		for(int i = 0; i < 3; ++i)
+			SQLiteProfiler::ProfileCallback(&profiler, "SELECT 1", 1000);
+		KOMPEX_CHECK(GetCollectedEvents(profiler) == 7);
+
+		profiler.Reset();
+		KOMPEX_CHECK(GetCollectedEvents(profiler) == 0);
+		KOMPEX_CHECK(profiler.GetLostEvents() == 0);
+	}
+
+	void TestConcurrentProducers()
+	{
+		const int threadCount = 4;
+		const int eventsPerThread = 100000;
+
+		// every thread writes into its own ring buffer while the events are collected concurrently
+		SQLiteProfiler profiler(256);
+		std::vector<std::thread> threads;
+		for(int t = 0; t < threadCount; ++t)
+		{
+			threads.push_back(std::thread([&profiler, t]()
+			{
+				for(int i = 0; i < eventsPerThread; ++i)
+				{
+					const char *sql = (i % 2) ? "SELECT * FROM t WHERE id = 1" : "INSERT INTO t VALUES(2)";
+					SQLiteProfiler::ProfileCallback(&profiler, sql, 1000 + (i + t) % 7);
+				}
+			}));
+		}
+
+		for(int i = 0; i < 1000; ++i)
+			profiler.Collect();
+		for(std::vector<std::thread>::iterator iter = threads.begin(); iter != threads.end(); ++iter)
+			iter->join();
+
+		// no event is counted twice or lost without being reported
+		KOMPEX_CHECK(GetCollectedEvents(profiler) + profiler.GetLostEvents() == static_cast<uint64>(threadCount * eventsPerThread));
+
+		// a partially written event would show up as unknown statement or with a wrong time
+		std::vector<SQLiteProfileEntry> entries = profiler.GetTopStatements(0);
+		KOMPEX_CHECK(entries.size() == 2);
+		for(std::vector<SQLiteProfileEntry>::const_iterator iter = entries.begin(); iter != entries.end(); ++iter)
+		{
+			KOMPEX_CHECK(!iter->sql.empty());
+			KOMPEX_CHECK(iter->maxTime >= 1000 && iter->maxTime <= 1006);
+			KOMPEX_CHECK(iter->totalTime >= iter->count * 1000 && iter->totalTime <= iter->count * 1006);
+		}
+	}
+}
+
+int main()
+{
+	TestNormalizeSql();
+	TestOverflow();
+	TestConcurrentProducers();
+
+	return Test::Finish("KompexSQLiteProfilerTest");
+}
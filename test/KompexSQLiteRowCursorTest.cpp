@@ -0,0 +1,98 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteRowCursor.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	void TestRows(SQLiteDatabase &db)
+	{
+		SQLiteStatement statement(&db);
+		statement.Sql("SELECT id, name, score FROM t WHERE id <= 2 ORDER BY id");
+
+		int64 idSum = 0;
+		std::string names;
+		SQLiteRowCursor<int64, SQLiteTextView, double> cursor(statement);
+		for(auto &row : cursor)
+		{
+			idSum += std::get<0>(row);
+			names += std::get<1>(row).ToString();
+		}
+		KOMPEX_CHECK(idSum == 3);
+		KOMPEX_CHECK(names == "ab");
+		statement.FreeQuery();
+	}
+
+	void TestNullText(SQLiteDatabase &db)
+	{
+		SQLiteStatement statement(&db);
+		statement.Sql("SELECT name, name FROM t WHERE id = 3");
+		SQLiteRowCursor<SQLiteTextView, std::string> cursor(statement);
+		KOMPEX_CHECK(cursor.Fetch());
+		KOMPEX_CHECK(std::get<0>(cursor.GetRow()).IsNull());
+		KOMPEX_CHECK(std::get<1>(cursor.GetRow()).empty());
+		statement.FreeQuery();
+	}
+
+	void TestIncompatibleLaterRow(SQLiteDatabase &db)
+	{
+		// the first row is numeric, the second row contains text
+		SQLiteStatement statement(&db);
+		statement.Sql("SELECT score FROM t WHERE id IN (1, 4) ORDER BY id");
+		SQLiteRowCursor<int> cursor(statement);
+		KOMPEX_CHECK(cursor.Fetch());
+		KOMPEX_CHECK_THROWS(cursor.Fetch());
+	}
+
+	void TestNullNumber(SQLiteDatabase &db)
+	{
+		SQLiteStatement statement(&db);
+		statement.Sql("SELECT score FROM t WHERE id = 3");
+		SQLiteRowCursor<double> cursor(statement);
+		KOMPEX_CHECK_THROWS(cursor.Fetch());
+	}
+
+	void TestColumnCount(SQLiteDatabase &db)
+	{
+		SQLiteStatement statement(&db);
+		statement.Sql("SELECT id, name FROM t");
+		KOMPEX_CHECK_THROWS(SQLiteRowCursor<int> cursor(statement));
+		statement.FreeQuery();
+	}
+}
+
+int main()
+{
+	SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+	SQLiteStatement statement(&db);
+	statement.SqlStatement("CREATE TABLE t(id INTEGER, name TEXT, score)");
+	statement.SqlStatement("INSERT INTO t VALUES(1, 'a', 1.5), (2, 'b', 2), (3, NULL, NULL), (4, 'd', 'high')");
+
+	TestRows(db);
+	TestNullText(db);
+	TestIncompatibleLaterRow(db);
+	TestNullNumber(db);
+	TestColumnCount(db);
+
+	return Test::Finish("KompexSQLiteRowCursorTest");
+}
@@ -0,0 +1,167 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	// the quote would break a concatenated ATTACH statement
+	const std::string originFilename = "KompexSQLite'SaveToFileTest.db";
+	const std::string sourceFilename = "KompexSQLiteSaveToFileTest-source.db";
+	const std::string targetFilename = "KompexSQLiteSaveToFileTest-target.db";
+
+	void RemoveDatabaseFiles(const std::string &filename)
+	{
+		std::remove(filename.c_str());
+		std::remove((filename + "-wal").c_str());
+		std::remove((filename + "-shm").c_str());
+		std::remove((filename + "-journal").c_str());
+		std::remove((filename + ".tmp").c_str());
+		std::remove((filename + ".tmp-journal").c_str());
+	}
+
+	std::string ReadFile(const std::string &filename)
+	{
+		std::ifstream file(filename.c_str(), std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	void WriteFile(const std::string &filename, const std::string &content)
+	{
+		std::ofstream file(filename.c_str(), std::ios::binary);
+		file << content;
+	}
+
+	void CreateOrigin(const std::string &filename)
+	{
+		SQLiteDatabase db(filename.c_str(), SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		SQLiteStatement statement(&db);
+		statement.SqlStatement("CREATE TABLE u(id INTEGER PRIMARY KEY, name TEXT)");
+		statement.SqlStatement("INSERT INTO u(name) VALUES('origin')");
+	}
+
+	void TestOriginWithQuote()
+	{
+		CreateOrigin(originFilename);
+		{
+			SQLiteDatabase db(originFilename.c_str(), SQLITE_OPEN_READWRITE, 0);
+			db.MoveDatabaseToMemoryIncremental();
+			SQLiteStatement statement(&db);
+			statement.SqlStatement("INSERT INTO u(name) VALUES('memory')");
+			db.SaveDatabaseFromMemoryToFileIncremental();
+
+			// the origin database is attached again after the swap
+			KOMPEX_CHECK(statement.GetSqlResultInt("SELECT count(*) FROM origin.u") == 2);
+		}
+
+		SQLiteDatabase db(originFilename.c_str(), SQLITE_OPEN_READONLY, 0);
+		SQLiteStatement statement(&db);
+		KOMPEX_CHECK(statement.GetSqlResultInt("SELECT count(*) FROM u") == 2);
+	}
+
+	void TestLeftOverWal()
+	{
+		// simulates a crashed process which left the WAL file of the target behind
+		std::string wal;
+		{
+			SQLiteDatabase db(targetFilename.c_str(), SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+			db.SetJournalMode(SQLiteDatabase::JOURNAL_WAL);
+			db.SetWalAutoCheckpoint(0);
+			SQLiteStatement statement(&db);
+			statement.SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY, payload BLOB)");
+			for(int i = 0; i < 20; ++i)
+				statement.SqlStatement("INSERT INTO t(payload) VALUES(zeroblob(4096))");
+			wal = ReadFile(targetFilename + "-wal");
+		}
+		KOMPEX_CHECK(!wal.empty());
+		WriteFile(targetFilename + "-wal", wal);
+
+		CreateOrigin(sourceFilename);
+		{
+			SQLiteDatabase db(sourceFilename.c_str(), SQLITE_OPEN_READWRITE, 0);
+			db.MoveDatabaseToMemoryIncremental();
+			db.SaveDatabaseFromMemoryToFileIncremental(targetFilename);
+		}
+
+		std::ifstream walFile((targetFilename + "-wal").c_str());
+		KOMPEX_CHECK(!walFile.is_open());
+
+		SQLiteDatabase db(targetFilename.c_str(), SQLITE_OPEN_READONLY, 0);
+		SQLiteStatement statement(&db);
+		KOMPEX_CHECK(statement.GetSqlResultString("PRAGMA integrity_check;") == "ok");
+		KOMPEX_CHECK(statement.GetSqlResultInt("SELECT count(*) FROM sqlite_master WHERE name = 't'") == 0);
+		KOMPEX_CHECK(statement.GetSqlResultInt("SELECT count(*) FROM u") == 1);
+	}
+
+	void TestLockedSource()
+	{
+		RemoveDatabaseFiles(sourceFilename);
+		CreateOrigin(sourceFilename);
+
+		SQLiteDatabase db(sourceFilename.c_str(), SQLITE_OPEN_READWRITE, 0);
+		SQLiteDatabase locker(sourceFilename.c_str(), SQLITE_OPEN_READWRITE, 0);
+		SQLiteStatement lockStatement(&locker);
+		lockStatement.SqlStatement("BEGIN EXCLUSIVE");
+
+		// the copy gives up instead of waiting for the lock forever
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		KOMPEX_CHECK_THROWS(db.MoveDatabaseToMemoryIncremental(256, 1, 0, 0, 50));
+		KOMPEX_CHECK(std::chrono::steady_clock::now() - startTime < std::chrono::seconds(5));
+
+		// the database stays on the file
+		lockStatement.SqlStatement("COMMIT");
+		SQLiteStatement statement(&db);
+		KOMPEX_CHECK(statement.GetSqlResultInt("SELECT count(*) FROM u") == 1);
+		SQLiteDatabase::BackupStatistics statistics = db.MoveDatabaseToMemoryIncremental(256, 1, 0, 0, 50);
+		KOMPEX_CHECK(statistics.busySteps == 0);
+		KOMPEX_CHECK(statement.GetSqlResultInt("SELECT count(*) FROM u") == 1);
+	}
+}
+
+int main()
+{
+	try
+	{
+		RemoveDatabaseFiles(originFilename);
+		RemoveDatabaseFiles(sourceFilename);
+		RemoveDatabaseFiles(targetFilename);
+		TestOriginWithQuote();
+		TestLeftOverWal();
+		TestLockedSource();
+	}
+	catch(SQLiteException &exception)
+	{
+		exception.Show();
+		++Test::GetFailureCount();
+	}
+
+	RemoveDatabaseFiles(originFilename);
+	RemoveDatabaseFiles(sourceFilename);
+	RemoveDatabaseFiles(targetFilename);
+	return Test::Finish("KompexSQLiteSaveToFileTest");
+}
@@ -0,0 +1,172 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <vector>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteSortKey.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	int Sign(int value)
+	{
+		return value < 0 ? -1 : (value > 0 ? 1 : 0);
+	}
+
+	SQLiteTextView View(const std::string &text)
+	{
+		return SQLiteTextView(text.data(), static_cast<int>(text.length()));
+	}
+
+	//! Returns texts which mix digit runs (with leading zeros) and other bytes, including bytes above 0x7F.
+	std::vector<std::string> CreateTexts()
+	{
+		static const char *const parts[] = {"", "a", "b", "0", "00", "1", "01", "9", "10", "099", "-", "/", ":", "A", "\xC3\xA9"};
+		const unsigned int partCount = sizeof(parts) / sizeof(parts[0]);
+
+		std::vector<std::string> texts;
+		unsigned int random = 12345;
+		for(int i = 0; i < 400; ++i)
+		{
+			std::string text;
+			for(int j = 0; j < 4; ++j)
+			{
+				random = random * 1103515245 + 12345;
+				text += parts[(random >> 16) % partCount];
+			}
+			texts.push_back(text);
+		}
+
+		// digit counts around the 255 limit of the short length encoding
+		texts.push_back("x" + std::string(254, '7'));
+		texts.push_back("x" + std::string(255, '7'));
+		texts.push_back("x" + std::string(256, '1'));
+		texts.push_back("x" + std::string(256, '1') + "y");
+		return texts;
+	}
+
+	void TestNaturalOrderKeys()
+	{
+		std::vector<std::string> texts = CreateTexts();
+		std::vector<std::string> keys;
+		for(size_t i = 0; i < texts.size(); ++i)
+			keys.push_back(SQLiteSortKey::NaturalOrder(View(texts[i])));
+
+		int mismatches = 0;
+		for(size_t i = 0; i < texts.size(); ++i)
+			for(size_t j = 0; j < texts.size(); ++j)
+				if(Sign(keys[i].compare(keys[j])) != SQLiteSortKey::CompareNaturalOrder(View(texts[i]), View(texts[j])))
+					++mismatches;
+		KOMPEX_CHECK(mismatches == 0);
+
+		KOMPEX_CHECK(SQLiteSortKey::CompareNaturalOrder(View("file2"), View("file10")) < 0);
+		KOMPEX_CHECK(SQLiteSortKey::CompareNaturalOrder(View("file007"), View("file7")) == 0);
+	}
+
+	void TestLocaleKeys(const std::locale &locale)
+	{
+		std::vector<std::string> texts = CreateTexts();
+		std::vector<std::string> keys;
+		for(size_t i = 0; i < texts.size(); ++i)
+			keys.push_back(SQLiteSortKey::Locale(View(texts[i]), locale));
+
+		int mismatches = 0;
+		for(size_t i = 0; i < texts.size(); ++i)
+			for(size_t j = 0; j < texts.size(); ++j)
+				if(Sign(keys[i].compare(keys[j])) != Sign(SQLiteSortKey::CompareLocale(View(texts[i]), View(texts[j]), locale)))
+					++mismatches;
+		KOMPEX_CHECK(mismatches == 0);
+	}
+
+	std::vector<std::string> GetNames(SQLiteStatement &statement, const std::string &sql)
+	{
+		std::vector<std::string> names;
+		statement.Sql(sql);
+		while(statement.FetchRow())
+			names.push_back(statement.GetColumnString(0));
+		statement.FreeQuery();
+		return names;
+	}
+
+	void TestSortKeyColumn()
+	{
+		SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		db.CreateSortKeyFunction("natural_key", &SQLiteSortKey::NaturalOrder);
+		db.CreateCollation("natural_order", &SQLiteSortKey::CompareNaturalOrder);
+		// the overloads for the global locale must be selectable without a lambda
+		db.CreateSortKeyFunction("locale_key", &SQLiteSortKey::Locale);
+		db.CreateCollation("locale_order", &SQLiteSortKey::CompareLocale);
+
+		std::vector<std::string> texts = CreateTexts();
+		SQLiteStatement statement(&db);
+		statement.SqlStatement("CREATE TABLE file(name TEXT)");
+		statement.BeginTransaction();
+		statement.Sql("INSERT INTO file(name) VALUES(?)");
+		for(size_t i = 0; i < texts.size() / 2; ++i)
+		{
+			statement.BindString(1, texts[i]);
+			statement.Execute();
+			statement.Reset();
+		}
+		statement.FreeQuery();
+		statement.CommitTransaction();
+
+		db.AddSortKeyColumn("file", "name", "name_key", "natural_key");
+		db.AddSortKeyColumn("file", "name", "locale_key", "locale_key", false);
+
+		// the triggers compute the keys of the rows which are inserted afterwards
+		statement.Sql("INSERT INTO file(name) VALUES(?)");
+		for(size_t i = texts.size() / 2; i < texts.size(); ++i)
+		{
+			statement.BindString(1, texts[i]);
+			statement.Execute();
+			statement.Reset();
+		}
+		statement.FreeQuery();
+
+		std::vector<std::string> byKey = GetNames(statement, "SELECT name FROM file ORDER BY name_key, rowid");
+		std::vector<std::string> byCollation = GetNames(statement, "SELECT name FROM file ORDER BY name COLLATE natural_order, rowid");
+		KOMPEX_CHECK(byKey.size() == texts.size());
+		KOMPEX_CHECK(byKey == byCollation);
+
+		byKey = GetNames(statement, "SELECT name FROM file ORDER BY locale_key, rowid");
+		byCollation = GetNames(statement, "SELECT name FROM file ORDER BY name COLLATE locale_order, rowid");
+		KOMPEX_CHECK(byKey == byCollation);
+	}
+}
+
+int main()
+{
+	TestNaturalOrderKeys();
+	TestLocaleKeys(std::locale::classic());
+	try
+	{
+		TestLocaleKeys(std::locale("en_US.UTF-8"));
+	}
+	catch(std::runtime_error&)
+	{
+		// the locale isn't installed
+	}
+	TestSortKeyColumn();
+
+	return Test::Finish("KompexSQLiteSortKeyTest");
+}
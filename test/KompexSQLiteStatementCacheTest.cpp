@@ -0,0 +1,137 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatementCache.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	void AcquireAndRelease(SQLiteStatementCache &cache, sqlite3 *handle, const char *sql)
+	{
+		SQLiteColumnLookup columnLookup;
+		sqlite3_stmt *statement = cache.Acquire(handle, sql, columnLookup);
+		cache.Release(statement, columnLookup);
+	}
+
+	void TestHitsAndMisses(sqlite3 *handle)
+	{
+		SQLiteStatementCache cache(4);
+		AcquireAndRelease(cache, handle, "SELECT 1");
+		AcquireAndRelease(cache, handle, "SELECT 1");
+		AcquireAndRelease(cache, handle, "SELECT 2");
+		KOMPEX_CHECK(cache.GetMisses() == 2);
+		KOMPEX_CHECK(cache.GetHits() == 1);
+		KOMPEX_CHECK(cache.GetSize() == 2);
+	}
+
+	void TestKeyIsCallerText(sqlite3 *handle)
+	{
+		// sqlite3_sql() cuts off the trailing whitespace and comment
+		SQLiteStatementCache cache(4);
+		AcquireAndRelease(cache, handle, "SELECT 1 -- comment\n");
+		AcquireAndRelease(cache, handle, "SELECT 1 -- comment\n");
+		AcquireAndRelease(cache, handle, "SELECT 1;  ");
+		AcquireAndRelease(cache, handle, "SELECT 1;  ");
+		KOMPEX_CHECK(cache.GetMisses() == 2);
+		KOMPEX_CHECK(cache.GetHits() == 2);
+		KOMPEX_CHECK(cache.GetSize() == 2);
+	}
+
+	void TestLeastRecentlyUsedEviction(sqlite3 *handle)
+	{
+		SQLiteStatementCache cache(2);
+		AcquireAndRelease(cache, handle, "SELECT 1");
+		AcquireAndRelease(cache, handle, "SELECT 2");
+		AcquireAndRelease(cache, handle, "SELECT 1");
+		AcquireAndRelease(cache, handle, "SELECT 3");
+		KOMPEX_CHECK(cache.GetEvictions() == 1);
+		KOMPEX_CHECK(cache.GetSize() == 2);
+
+		// "SELECT 2" was the least recently used statement
+		cache.ResetStatistics();
+		AcquireAndRelease(cache, handle, "SELECT 1");
+		AcquireAndRelease(cache, handle, "SELECT 3");
+		KOMPEX_CHECK(cache.GetHits() == 2);
+		AcquireAndRelease(cache, handle, "SELECT 2");
+		KOMPEX_CHECK(cache.GetMisses() == 1);
+
+		cache.SetCapacity(1);
+		KOMPEX_CHECK(cache.GetSize() == 1);
+	}
+
+	void TestStatementInUse(sqlite3 *handle)
+	{
+		// a handed out statement must not be handed out a second time
+		SQLiteStatementCache cache(4);
+		SQLiteColumnLookup columnLookup1, columnLookup2;
+		sqlite3_stmt *statement1 = cache.Acquire(handle, "SELECT 1", columnLookup1);
+		sqlite3_stmt *statement2 = cache.Acquire(handle, "SELECT 1", columnLookup2);
+		KOMPEX_CHECK(statement1 != statement2);
+		KOMPEX_CHECK(cache.GetMisses() == 2);
+
+		cache.Release(statement1, columnLookup1);
+		cache.Release(statement2, columnLookup2);
+		KOMPEX_CHECK(cache.GetSize() == 1);
+	}
+
+	void TestDisabledCache(sqlite3 *handle)
+	{
+		SQLiteStatementCache cache(0);
+		AcquireAndRelease(cache, handle, "SELECT 1");
+		AcquireAndRelease(cache, handle, "SELECT 1");
+		KOMPEX_CHECK(cache.GetMisses() == 2);
+		KOMPEX_CHECK(cache.GetSize() == 0);
+	}
+
+	void TestInvalidSql(sqlite3 *handle)
+	{
+		SQLiteStatementCache cache(4);
+		SQLiteColumnLookup columnLookup;
+		KOMPEX_CHECK_THROWS(cache.Acquire(handle, "SELEC 1", columnLookup));
+		KOMPEX_CHECK_THROWS(cache.Acquire(handle, "", columnLookup));
+		KOMPEX_CHECK(cache.GetSize() == 0);
+	}
+
+	void TestConnectionChange(sqlite3 *handle1, sqlite3 *handle2)
+	{
+		SQLiteStatementCache cache(4);
+		AcquireAndRelease(cache, handle1, "SELECT 1");
+		AcquireAndRelease(cache, handle2, "SELECT 1");
+		KOMPEX_CHECK(cache.GetMisses() == 2);
+		KOMPEX_CHECK(cache.GetSize() == 1);
+	}
+}
+
+int main()
+{
+	SQLiteDatabase db1(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+	SQLiteDatabase db2(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+
+	TestHitsAndMisses(db1.GetDatabaseHandle());
+	TestKeyIsCallerText(db1.GetDatabaseHandle());
+	TestLeastRecentlyUsedEviction(db1.GetDatabaseHandle());
+	TestStatementInUse(db1.GetDatabaseHandle());
+	TestDisabledCache(db1.GetDatabaseHandle());
+	TestInvalidSql(db1.GetDatabaseHandle());
+	TestConnectionChange(db1.GetDatabaseHandle(), db2.GetDatabaseHandle());
+
+	return Test::Finish("KompexSQLiteStatementCacheTest");
+}
@@ -0,0 +1,136 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <vector>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	const char *sortQuery = "SELECT a FROM t ORDER BY a";
+
+	//! Returns the counters of a SQL text; executions is 0 if the text wasn't recorded.
+	SQLiteStatementCounters FindCounters(const std::vector<SQLiteStatementCounters> &snapshot, const std::string &sql)
+	{
+		for(size_t i = 0; i < snapshot.size(); ++i)
+		{
+			if(snapshot[i].sql == sql)
+				return snapshot[i];
+		}
+
+		SQLiteStatementCounters counters = SQLiteStatementCounters();
+		return counters;
+	}
+
+	int FetchAll(SQLiteStatement &statement)
+	{
+		int rows = 0;
+		while(statement.FetchRow())
+			++rows;
+		return rows;
+	}
+
+	void TestAccumulation(SQLiteDatabase &db)
+	{
+		db.GetStatementStatistics().Reset();
+
+		// separate statements and a reused statement are accumulated per SQL text
+		for(int i = 0; i < 2; ++i)
+		{
+			SQLiteStatement statement(&db);
+			statement.Sql(sortQuery);
+			KOMPEX_CHECK(FetchAll(statement) == 100);
+		}
+		SQLiteStatement statement(&db);
+		statement.Sql(sortQuery);
+		FetchAll(statement);
+		statement.Reset();
+		FetchAll(statement);
+		statement.FreeQuery();
+
+		SQLiteStatementCounters counters = FindCounters(db.GetStatementStatistics().GetSnapshot(), sortQuery);
+		KOMPEX_CHECK(counters.executions == 4);
+		KOMPEX_CHECK(counters.rows == 400);
+		KOMPEX_CHECK(counters.steps == 404);
+		KOMPEX_CHECK(counters.sorts == 4);
+		KOMPEX_CHECK(counters.fullscanSteps > 0);
+		KOMPEX_CHECK(counters.seconds > 0.0);
+	}
+
+	void TestStatementStatus(SQLiteDatabase &db)
+	{
+		db.GetStatementStatistics().Reset();
+
+		// the statistics don't reset the SQLite counters
+		SQLiteStatement statement(&db);
+		statement.Sql(sortQuery);
+		FetchAll(statement);
+		statement.Reset();
+		KOMPEX_CHECK(statement.GetSortOperations() == 1);
+		FetchAll(statement);
+		statement.Reset();
+		KOMPEX_CHECK(statement.GetSortOperations() == 2);
+
+		// a reset by the user doesn't remove the counted sorts from the statistics
+		statement.FetchRow();
+		KOMPEX_CHECK(statement.GetStatementStatus(SQLITE_STMTSTATUS_SORT, true) == 3);
+		FetchAll(statement);
+		statement.FreeQuery();
+
+		SQLiteStatementCounters counters = FindCounters(db.GetStatementStatistics().GetSnapshot(), sortQuery);
+		KOMPEX_CHECK(counters.executions == 3);
+		KOMPEX_CHECK(counters.sorts == 3);
+	}
+
+	void TestSnapshotReset(SQLiteDatabase &db)
+	{
+		SQLiteStatement statement(&db);
+		statement.SqlStatement("SELECT count(*) FROM t");
+		KOMPEX_CHECK(db.GetStatementStatistics().GetSize() > 0);
+
+		std::vector<SQLiteStatementCounters> snapshot = db.GetStatementStatistics().GetSnapshot(true);
+		KOMPEX_CHECK(FindCounters(snapshot, "SELECT count(*) FROM t").executions == 1);
+		KOMPEX_CHECK(db.GetStatementStatistics().GetSize() == 0);
+		KOMPEX_CHECK(db.GetStatementStatistics().GetSnapshot().empty());
+
+		// disabled statistics don't record anything
+		db.GetStatementStatistics().SetEnabled(false);
+		statement.SqlStatement("SELECT count(*) FROM t");
+		KOMPEX_CHECK(db.GetStatementStatistics().GetSize() == 0);
+		db.GetStatementStatistics().SetEnabled(true);
+	}
+}
+
+int main()
+{
+	SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+	SQLiteStatement statement(&db);
+	statement.SqlStatement("CREATE TABLE t(a INTEGER)");
+	statement.SqlStatement("WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 100) INSERT INTO t SELECT (x * 37) % 101 FROM c");
+	db.GetStatementStatistics().SetEnabled(true);
+
+	TestAccumulation(db);
+	TestStatementStatus(db);
+	TestSnapshotReset(db);
+
+	return Test::Finish("KompexSQLiteStatementStatisticsTest");
+}
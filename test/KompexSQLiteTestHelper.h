@@ -0,0 +1,68 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KompexSQLiteTestHelper_H
+#define KompexSQLiteTestHelper_H
+
+#include <iostream>
+
+#include "KompexSQLiteException.h"
+
+namespace Kompex
+{
+	//! Minimal helpers for the test programs in test/.\n
+	//! Every test program is a standalone executable which returns 0 if all checks passed.
+	namespace Test
+	{
+		//! Returns the number of failed checks.
+		inline int &GetFailureCount()
+		{
+			static int failures = 0;
+			return failures;
+		}
+
+		//! Reports a failed check.
+		inline void Check(bool condition, const char *expression, const char *file, int line)
+		{
+			if(!condition)
+			{
+				std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+				++GetFailureCount();
+			}
+		}
+
+		//! Prints the result of the test program and returns the exit code.
+		inline int Finish(const char *testName)
+		{
+			std::cout << testName << ": " << (GetFailureCount() == 0 ? "passed" : "FAILED") << std::endl;
+			return GetFailureCount() == 0 ? 0 : 1;
+		}
+	}
+};
+
+//! Checks a condition.
+#define KOMPEX_CHECK(condition) Kompex::Test::Check((condition), #condition, __FILE__, __LINE__)
+//! Checks that a statement throws a SQLiteException.
+#define KOMPEX_CHECK_THROWS(statement) \
+	do { \
+		bool isThrown = false; \
+		try {statement;} catch(Kompex::SQLiteException &) {isThrown = true;} \
+		Kompex::Test::Check(isThrown, #statement " throws", __FILE__, __LINE__); \
+	} while(0)
+
+#endif // KompexSQLiteTestHelper_H
@@ -0,0 +1,145 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteTransactionBatch.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	int CountRows(SQLiteDatabase &db)
+	{
+		SQLiteStatement statement(&db);
+		return static_cast<int>(statement.SqlAggregateFuncResult("SELECT count(*) FROM t"));
+	}
+
+	void TestExecute(SQLiteDatabase &db)
+	{
+		SQLiteTransactionBatch batch(&db);
+		batch.AddStatement("INSERT INTO t VALUES(?)", 1);
+		batch.AddStatement("INSERT INTO t VALUES(?)", 2);
+		batch.Add("DELETE FROM t WHERE id = 1");
+		KOMPEX_CHECK(batch.GetSize() == 3);
+		KOMPEX_CHECK(batch.GetDistinctStatementCount() == 2);
+		batch.Execute();
+		KOMPEX_CHECK(batch.GetSize() == 0);
+		KOMPEX_CHECK(CountRows(db) == 1);
+
+		// the statements come from the statement cache and are reused
+		batch.AddStatement("INSERT INTO t VALUES(?)", 3);
+		uint64 hits = db.GetStatementCache().GetHits();
+		batch.Execute();
+		KOMPEX_CHECK(db.GetStatementCache().GetHits() == hits + 1);
+		KOMPEX_CHECK(CountRows(db) == 2);
+	}
+
+	void TestRollback(SQLiteDatabase &db)
+	{
+		SQLiteTransactionBatch batch(&db);
+		batch.AddStatement("INSERT INTO t VALUES(?)", 10);
+		batch.AddStatement("INSERT INTO t VALUES(?)", 10);
+		KOMPEX_CHECK_THROWS(batch.Execute());
+		KOMPEX_CHECK(CountRows(db) == 2);
+		KOMPEX_CHECK(sqlite3_get_autocommit(db.GetDatabaseHandle()));
+
+		batch.Add("INSERT INTO missing_table VALUES(1)");
+		KOMPEX_CHECK_THROWS(batch.Execute());
+		KOMPEX_CHECK(batch.GetSize() == 0);
+	}
+
+	void TestJoinedTransaction(SQLiteDatabase &db)
+	{
+		SQLiteStatement statement(&db);
+		statement.BeginTransaction();
+		statement.SqlStatement("INSERT INTO t VALUES(20)");
+
+		// only the statements of the failed batch are rolled back
+		SQLiteTransactionBatch batch(&db);
+		batch.AddStatement("INSERT INTO t VALUES(?)", 21);
+		batch.AddStatement("INSERT INTO t VALUES(?)", 20);
+		KOMPEX_CHECK_THROWS(batch.Execute());
+		KOMPEX_CHECK(!sqlite3_get_autocommit(db.GetDatabaseHandle()));
+		KOMPEX_CHECK(CountRows(db) == 3);
+
+		batch.AddStatement("INSERT INTO t VALUES(?)", 22);
+		batch.Execute();
+		statement.CommitTransaction();
+		KOMPEX_CHECK(CountRows(db) == 4);
+	}
+
+	void TestSecureTransaction(SQLiteDatabase &db)
+	{
+		// the copied UTF-8 and UTF-16 statements outlive the caller's strings;
+		// the wchar_t functions pass UTF-16 to SQLite, i.e. they work only with a 2 byte wchar_t
+		SQLiteStatement statement(&db);
+		statement.BeginTransaction();
+		{
+			std::string sql = "INSERT INTO t VALUES(30)";
+			statement.SecureTransaction(sql.c_str());
+			if(sizeof(wchar_t) == 2)
+			{
+				std::wstring sql16 = L"INSERT INTO t VALUES(31)";
+				statement.SecureTransaction(sql16.c_str());
+			}
+		}
+		statement.CommitTransaction();
+		KOMPEX_CHECK(CountRows(db) == (sizeof(wchar_t) == 2 ? 6 : 5));
+	}
+
+	void TestConnectionChange()
+	{
+		const char *filename = "KompexSQLiteTransactionBatchTest.db";
+		std::remove(filename);
+		{
+			SQLiteDatabase db(filename, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+			SQLiteStatement statement(&db);
+			statement.SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY)");
+
+			SQLiteTransactionBatch batch(&db);
+			batch.AddStatement("INSERT INTO t VALUES(?)", 1);
+			batch.Execute();
+
+			// the batch must not keep statements of the closed file connection
+			db.MoveDatabaseToMemory();
+			batch.AddStatement("INSERT INTO t VALUES(?)", 2);
+			batch.Execute();
+			KOMPEX_CHECK(CountRows(db) == 2);
+		}
+		std::remove(filename);
+	}
+}
+
+int main()
+{
+	SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+	SQLiteStatement statement(&db);
+	statement.SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY)");
+
+	TestExecute(db);
+	TestRollback(db);
+	TestJoinedTransaction(db);
+	TestSecureTransaction(db);
+	TestConnectionChange();
+
+	return Test::Finish("KompexSQLiteTransactionBatchTest");
+}
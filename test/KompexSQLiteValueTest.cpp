@@ -0,0 +1,80 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <vector>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteBulkInserter.h"
+#include "KompexSQLiteValue.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	void TestValueTypes()
+	{
+		KOMPEX_CHECK(SQLiteValue().IsNull());
+		KOMPEX_CHECK(SQLiteValue(42).GetType() == SQLITE_INTEGER);
+		KOMPEX_CHECK(SQLiteValue(42L).GetInt64() == 42);
+		KOMPEX_CHECK(SQLiteValue(42U).GetInt64() == 42);
+		KOMPEX_CHECK(SQLiteValue(static_cast<size_t>(42)).GetInt64() == 42);
+		KOMPEX_CHECK(SQLiteValue(static_cast<short>(-7)).GetInt64() == -7);
+		KOMPEX_CHECK(SQLiteValue(static_cast<int64>(1) << 40).GetInt64() == static_cast<int64>(1) << 40);
+		KOMPEX_CHECK(SQLiteValue(true).GetInt64() == 1);
+		KOMPEX_CHECK(SQLiteValue(false).GetInt64() == 0);
+		KOMPEX_CHECK(SQLiteValue(1.5).GetType() == SQLITE_FLOAT);
+		KOMPEX_CHECK(SQLiteValue(1.5f).GetDouble() == 1.5);
+		KOMPEX_CHECK(SQLiteValue("text").GetData() == "text");
+		KOMPEX_CHECK(SQLiteValue(static_cast<const char*>(0)).IsNull());
+		KOMPEX_CHECK(SQLiteValue(std::string("text")).GetType() == SQLITE_TEXT);
+		KOMPEX_CHECK(SQLiteValue(SQLiteTextView()).IsNull());
+		KOMPEX_CHECK(SQLiteValue(SQLiteBlobView("\0x", 2)).GetData() == std::string("\0x", 2));
+	}
+
+	void TestBulkInserterTypes(SQLiteDatabase &db)
+	{
+		std::vector<std::string> columns;
+		columns.push_back("a");
+		columns.push_back("b");
+		columns.push_back("c");
+
+		std::vector<int> values(3);
+		SQLiteBulkInserter inserter(&db, "t", columns);
+		inserter.InsertRow(values.size(), 2L, 0.5f);
+		inserter.Insert(std::make_tuple(7U, static_cast<unsigned char>(8), 9.0));
+		inserter.Finish();
+		KOMPEX_CHECK(inserter.GetInsertedRows() == 2);
+
+		SQLiteStatement statement(&db);
+		KOMPEX_CHECK(statement.SqlAggregateFuncResult("SELECT sum(a) + sum(b) + sum(c) FROM t") == 29.5f);
+	}
+}
+
+int main()
+{
+	SQLiteDatabase db(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+	SQLiteStatement statement(&db);
+	statement.SqlStatement("CREATE TABLE t(a INTEGER, b INTEGER, c REAL)");
+
+	TestValueTypes();
+	TestBulkInserterTypes(db);
+
+	return Test::Finish("KompexSQLiteValueTest");
+}
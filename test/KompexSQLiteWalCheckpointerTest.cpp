@@ -0,0 +1,77 @@
+/*
+    This file is part of Kompex SQLite Wrapper.
+	Copyright (c) 2008-2013 Sven Broeske
+
+    Kompex SQLite Wrapper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Kompex SQLite Wrapper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Kompex SQLite Wrapper. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+
+#include "KompexSQLiteDatabase.h"
+#include "KompexSQLiteStatement.h"
+#include "KompexSQLiteWalCheckpointer.h"
+#include "KompexSQLiteTestHelper.h"
+
+using namespace Kompex;
+
+namespace
+{
+	const char *filename = "KompexSQLiteWalCheckpointerTest.db";
+
+	void RemoveDatabaseFiles()
+	{
+		std::remove(filename);
+		std::remove((std::string(filename) + "-wal").c_str());
+		std::remove((std::string(filename) + "-shm").c_str());
+	}
+
+	void TestCheckpoints()
+	{
+		SQLiteDatabase db(filename, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		db.SetJournalMode(SQLiteDatabase::JOURNAL_WAL);
+		db.SetWalAutoCheckpoint(250);
+
+		SQLiteStatement statement(&db);
+		statement.SqlStatement("CREATE TABLE t(id INTEGER PRIMARY KEY, payload BLOB)");
+		{
+			SQLiteWalCheckpointer checkpointer(&db, 10, 50);
+			for(int i = 0; i < 100; ++i)
+				statement.SqlStatement("INSERT INTO t(payload) VALUES(zeroblob(4096))");
+			KOMPEX_CHECK(checkpointer.GetStatistics().commits >= 100);
+		}
+
+		// the automatic checkpoint setting of the writer is restored
+		KOMPEX_CHECK(statement.GetSqlResultInt("PRAGMA wal_autocheckpoint;") == 250);
+	}
+
+	void TestNoWalMode()
+	{
+		SQLiteDatabase db(filename, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		db.SetJournalMode(SQLiteDatabase::JOURNAL_DELETE);
+		KOMPEX_CHECK_THROWS(SQLiteWalCheckpointer checkpointer(&db));
+
+		SQLiteDatabase memoryDb(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, 0);
+		KOMPEX_CHECK_THROWS(SQLiteWalCheckpointer checkpointer(&memoryDb));
+	}
+}
+
+int main()
+{
+	RemoveDatabaseFiles();
+	TestCheckpoints();
+	TestNoWalMode();
+	RemoveDatabaseFiles();
+
+	return Test::Finish("KompexSQLiteWalCheckpointerTest");
+}